@@ -0,0 +1,183 @@
+#include "bar_aggregator.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // 北京时间 UTC+8
+    constexpr int64_t kExchangeUtcOffsetNanos = 8 * 3600 * 1000000000LL;
+}
+
+lueing::BarAggregator::BarAggregator(size_t max_instruments, std::vector<int32_t> periods, size_t capacity)
+    : max_instruments_(max_instruments), periods_(std::move(periods)), capacity_(capacity),
+      books_(new std::atomic<Book *>[max_instruments]())
+{
+}
+
+lueing::BarAggregator::~BarAggregator()
+{
+    for (size_t i = 0; i < max_instruments_; i++)
+    {
+        delete books_[i].load(std::memory_order_relaxed);
+    }
+}
+
+bool lueing::BarAggregator::Reserve(InstrumentHandle handle)
+{
+    if (handle >= max_instruments_)
+    {
+        return false;
+    }
+    if (nullptr == books_[handle].load(std::memory_order_acquire))
+    {
+        Book *book = new Book();
+        for (int32_t period : periods_)
+        {
+            book->series.emplace_back(new Series(period, capacity_));
+        }
+        books_[handle].store(book, std::memory_order_release);
+    }
+    return true;
+}
+
+void lueing::BarAggregator::Update(const Tick &tick)
+{
+    Book *book = tick.instrument < max_instruments_ ? books_[tick.instrument].load(std::memory_order_acquire) : nullptr;
+    if (nullptr == book || tick.exchange_time <= 0 || tick.last_price <= 0)
+    {
+        return;
+    }
+
+    // 累计量转为增量, 首条行情只作为基准
+    int64_t volume = 0;
+    double turnover = 0;
+    if (book->seeded)
+    {
+        volume = tick.volume - book->last_volume;
+        turnover = tick.turnover - book->last_turnover;
+        if (volume < 0)
+        {
+            volume = tick.volume;
+            turnover = tick.turnover;
+        }
+    }
+    book->seeded = true;
+    book->last_volume = tick.volume;
+    book->last_turnover = tick.turnover;
+
+    for (auto &series : book->series)
+    {
+        Bar &bar = series->building;
+        int64_t begin = BeginTime(tick.exchange_time, series->period_ns);
+        bool open = 0 != series->sequence.load(std::memory_order_relaxed);
+        if (!open || begin > bar.begin_time)
+        {
+            // 无成交的行情不开启新 K 线
+            if (0 == volume)
+            {
+                continue;
+            }
+            if (open)
+            {
+                series->history.Push(bar);
+            }
+            bar.instrument = tick.instrument;
+            bar.period = series->period;
+            bar.begin_time = begin;
+            bar.open = tick.last_price;
+            bar.high = tick.last_price;
+            bar.low = tick.last_price;
+            bar.volume = 0;
+            bar.turnover = 0;
+            bar.ticks = 0;
+        }
+        // 时间回退的行情并入当前 K 线
+        bar.high = std::max(bar.high, tick.last_price);
+        bar.low = std::min(bar.low, tick.last_price);
+        bar.close = tick.last_price;
+        bar.volume += volume;
+        bar.turnover += turnover;
+        bar.open_interest = tick.open_interest;
+        bar.ticks++;
+        Publish(*series);
+    }
+}
+
+bool lueing::BarAggregator::Current(InstrumentHandle handle, int32_t period, Bar &out) const
+{
+    const Series *series = Find(handle, period);
+    if (nullptr == series)
+    {
+        return false;
+    }
+    for (;;)
+    {
+        uint64_t begin = series->sequence.load(std::memory_order_acquire);
+        if (0 == begin)
+        {
+            return false;
+        }
+        if (begin & 1)
+        {
+            continue;
+        }
+        std::memcpy(static_cast<void *>(&out), &series->current, sizeof(Bar));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (series->sequence.load(std::memory_order_relaxed) == begin)
+        {
+            return true;
+        }
+    }
+}
+
+size_t lueing::BarAggregator::Last(InstrumentHandle handle, int32_t period, size_t count, std::vector<Bar> &out) const
+{
+    const Series *series = Find(handle, period);
+    if (nullptr == series)
+    {
+        return 0;
+    }
+    size_t size = out.size();
+    uint64_t head = series->history.Head();
+    series->history.ReadFrom(head > count ? head - count : 0, out);
+    return out.size() - size;
+}
+
+uint64_t lueing::BarAggregator::Completed(InstrumentHandle handle, int32_t period) const
+{
+    const Series *series = Find(handle, period);
+    return nullptr == series ? 0 : series->history.Head();
+}
+
+int64_t lueing::BarAggregator::BeginTime(int64_t time, int64_t period_ns)
+{
+    int64_t local = time + kExchangeUtcOffsetNanos;
+    return local - local % period_ns - kExchangeUtcOffsetNanos;
+}
+
+const lueing::BarAggregator::Series *lueing::BarAggregator::Find(InstrumentHandle handle, int32_t period) const
+{
+    const Book *book = handle < max_instruments_ ? books_[handle].load(std::memory_order_acquire) : nullptr;
+    if (nullptr == book)
+    {
+        return nullptr;
+    }
+    for (const auto &series : book->series)
+    {
+        if (series->period == period)
+        {
+            return series.get();
+        }
+    }
+    return nullptr;
+}
+
+void lueing::BarAggregator::Publish(Series &series)
+{
+    uint64_t sequence = series.sequence.load(std::memory_order_relaxed);
+    // 首次发布从 0 开始, 保证发布后序号非 0
+    series.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(static_cast<void *>(&series.current), &series.building, sizeof(Bar));
+    series.sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,103 @@
+#include <cstring>
+#include <vector>
+#include "gtest/gtest.h"
+#include "bar_aggregator.h"
+
+namespace {
+    lueing::Tick MakeTick(const char *date, const char *time, int millisec, double price, int volume)
+    {
+        lueing::Tick tick{};
+        tick.instrument = 0;
+        tick.exchange_time = lueing::ExchangeNanos(date, time, millisec);
+        tick.last_price = price;
+        tick.volume = volume;
+        tick.turnover = volume * 10.0;
+        return tick;
+    }
+}
+
+TEST(BarAggregatorTest, MinuteBarsFromCumulativeVolume)
+{
+    lueing::BarAggregator bars(4, {60}, 8);
+    ASSERT_TRUE(bars.Reserve(0));
+    bars.Update(MakeTick("20250224", "09:00:00", 0, 10, 100));
+    bars.Update(MakeTick("20250224", "09:00:10", 0, 11, 105));
+    bars.Update(MakeTick("20250224", "09:00:59", 500, 12, 110));
+    bars.Update(MakeTick("20250224", "09:01:00", 0, 9, 111));
+
+    // 首条行情只作为累计量基准
+    std::vector<lueing::Bar> completed;
+    ASSERT_EQ(bars.Last(0, 60, 10, completed), 1u);
+    EXPECT_EQ(completed[0].begin_time, lueing::ExchangeNanos("20250224", "09:00:00", 0));
+    EXPECT_EQ(completed[0].open, 11);
+    EXPECT_EQ(completed[0].high, 12);
+    EXPECT_EQ(completed[0].low, 11);
+    EXPECT_EQ(completed[0].close, 12);
+    EXPECT_EQ(completed[0].volume, 10);
+    EXPECT_DOUBLE_EQ(completed[0].turnover, 100);
+    EXPECT_EQ(completed[0].ticks, 2);
+
+    lueing::Bar current{};
+    ASSERT_TRUE(bars.Current(0, 60, current));
+    EXPECT_EQ(current.begin_time, lueing::ExchangeNanos("20250224", "09:01:00", 0));
+    EXPECT_EQ(current.open, 9);
+    EXPECT_EQ(current.volume, 1);
+
+    // 收盘后无成交的快照不开启新 K 线
+    bars.Update(MakeTick("20250224", "15:00:00", 500, 9, 111));
+    EXPECT_EQ(bars.Completed(0, 60), 1u);
+
+    // 累计量回退时按新的累计量计
+    bars.Update(MakeTick("20250225", "09:00:01", 0, 8, 3));
+    ASSERT_TRUE(bars.Current(0, 60, current));
+    EXPECT_EQ(current.volume, 3);
+    EXPECT_EQ(bars.Completed(0, 60), 2u);
+}
+
+TEST(BarAggregatorTest, NightSessionAlignsToNaturalDay)
+{
+    lueing::BarAggregator bars(4, {1, 300}, 8);
+    ASSERT_TRUE(bars.Reserve(0));
+    // 大商所周一交易日的夜盘, ActionDay 填写为交易日, 实际为上周五晚
+    CThostFtdcDepthMarketDataField field{};
+    strcpy(field.TradingDay, "20250224");
+    strcpy(field.ActionDay, "20250224");
+    strcpy(field.UpdateTime, "21:03:30");
+    lueing::Tick tick{};
+    tick.exchange_time = lueing::ExchangeNanos(field);
+    tick.last_price = 10;
+    tick.volume = 1;
+    bars.Update(tick);
+    tick.volume = 2;
+    bars.Update(tick);
+
+    lueing::Bar current{};
+    ASSERT_TRUE(bars.Current(0, 300, current));
+    EXPECT_EQ(current.begin_time, lueing::ExchangeNanos("20250221", "21:00:00", 0));
+    ASSERT_TRUE(bars.Current(0, 1, current));
+    EXPECT_EQ(current.begin_time, lueing::ExchangeNanos("20250221", "21:03:30", 0));
+    EXPECT_FALSE(bars.Current(1, 1, current));
+    EXPECT_FALSE(bars.Current(0, 60, current));
+}
+
+TEST(BarAggregatorTest, LastBarsKeepsMostRecent)
+{
+    lueing::BarAggregator bars(1, {1}, 4);
+    ASSERT_TRUE(bars.Reserve(0));
+    EXPECT_FALSE(bars.Reserve(1));
+    char time[9];
+    for (int i = 0; i < 11; i++)
+    {
+        snprintf(time, sizeof(time), "10:00:%02d", i);
+        bars.Update(MakeTick("20250224", time, 0, 100 + i, i));
+    }
+    // 首条为基准, 9 根已完成, 环形缓冲区只保留最近 4 根
+    EXPECT_EQ(bars.Completed(0, 1), 9u);
+    std::vector<lueing::Bar> completed;
+    ASSERT_EQ(bars.Last(0, 1, 2, completed), 2u);
+    EXPECT_EQ(completed[0].close, 108);
+    EXPECT_EQ(completed[1].close, 109);
+    completed.clear();
+    EXPECT_EQ(bars.Last(0, 1, 100, completed), 4u);
+    EXPECT_EQ(completed.front().close, 106);
+}
@@ -42,6 +42,29 @@ lueing::CtpConfigPtr lueing::CreateCtpConfig(const std::string& yaml_file)
 
     // connect to hq
     config->front_hq_address = yaml["connect_info"]["front_hq_address"].as<std::string>();
+    if (yaml["connect_info"]["front_hq_addresses"])
+    {
+        config->front_hq_addresses = yaml["connect_info"]["front_hq_addresses"].as<std::vector<std::string>>();
+    }
+    if (config->front_hq_addresses.empty())
+    {
+        config->front_hq_addresses = {config->front_hq_address};
+    }
+    config->hq_transport = "tcp";
+    config->hq_multicast_topic = 0;
+    if (yaml["connect_info"]["hq_transport"])
+    {
+        config->hq_transport = yaml["connect_info"]["hq_transport"].as<std::string>();
+    }
+    if (yaml["connect_info"]["hq_multicast_topic"])
+    {
+        config->hq_multicast_topic = yaml["connect_info"]["hq_multicast_topic"].as<int>();
+    }
+    if ("tcp" != config->hq_transport && "udp" != config->hq_transport && "multicast" != config->hq_transport)
+    {
+        std::cerr << "Unknown hq_transport: " << config->hq_transport << ", fallback to tcp" << std::endl;
+        config->hq_transport = "tcp";
+    }
     // connect to trade
     config->front_trade_address = yaml["connect_info"]["front_trade_address"].as<std::string>();
     // level1 hq services
@@ -54,18 +77,182 @@ lueing::CtpConfigPtr lueing::CreateCtpConfig(const std::string& yaml_file)
         config->level1_hq_services = {};
     }
 
+    // market data storage
+    config->max_instruments = 1024;
+    config->tick_history_ticks = 4096;
+    config->tick_history_minutes = 0;
+    config->tick_history_memory_mb = 0;
+    config->dispatch_threads = 2;
+    config->dispatch_queue_capacity = 1024;
+    config->bar_periods = {1, 60, 300};
+    config->bar_capacity = 1024;
+    if (yaml["market_data"])
+    {
+        if (yaml["market_data"]["max_instruments"])
+        {
+            config->max_instruments = yaml["market_data"]["max_instruments"].as<size_t>();
+        }
+        // tick_ring_capacity 为旧配置名
+        if (yaml["market_data"]["tick_ring_capacity"])
+        {
+            config->tick_history_ticks = yaml["market_data"]["tick_ring_capacity"].as<size_t>();
+        }
+        if (yaml["market_data"]["tick_history_ticks"])
+        {
+            config->tick_history_ticks = yaml["market_data"]["tick_history_ticks"].as<size_t>();
+        }
+        if (yaml["market_data"]["tick_history_minutes"])
+        {
+            config->tick_history_minutes = yaml["market_data"]["tick_history_minutes"].as<int>();
+        }
+        if (yaml["market_data"]["tick_history_memory_mb"])
+        {
+            config->tick_history_memory_mb = yaml["market_data"]["tick_history_memory_mb"].as<size_t>();
+        }
+        if (yaml["market_data"]["dispatch_threads"])
+        {
+            config->dispatch_threads = yaml["market_data"]["dispatch_threads"].as<size_t>();
+        }
+        if (yaml["market_data"]["dispatch_queue_capacity"])
+        {
+            config->dispatch_queue_capacity = yaml["market_data"]["dispatch_queue_capacity"].as<size_t>();
+        }
+        if (yaml["market_data"]["bar_periods"])
+        {
+            config->bar_periods = yaml["market_data"]["bar_periods"].as<std::vector<int32_t>>();
+            // 周期用作取模的除数, 在行情线程上除零会直接崩溃
+            for (int32_t period : config->bar_periods)
+            {
+                if (period <= 0)
+                {
+                    std::cerr << "Invalid market_data.bar_periods: " << period << ", period must be positive"
+                              << std::endl;
+                    exit(1);
+                }
+            }
+        }
+        if (yaml["market_data"]["bar_capacity"])
+        {
+            config->bar_capacity = yaml["market_data"]["bar_capacity"].as<size_t>();
+        }
+    }
+    config->instruments = std::make_shared<InstrumentRegistry>(config->max_instruments);
+
+    // market data journal
+    config->journal_enabled = false;
+    config->journal_directory = "./journal/";
+    config->journal_records_per_file = 1 << 20;
+    config->journal_flush_interval_ms = 200;
+    config->journal_overflow_capacity = 16384;
+    if (yaml["journal"])
+    {
+        if (yaml["journal"]["enabled"])
+        {
+            config->journal_enabled = yaml["journal"]["enabled"].as<bool>();
+        }
+        if (yaml["journal"]["directory"])
+        {
+            config->journal_directory = yaml["journal"]["directory"].as<std::string>();
+        }
+        if (yaml["journal"]["records_per_file"])
+        {
+            config->journal_records_per_file = yaml["journal"]["records_per_file"].as<size_t>();
+        }
+        if (yaml["journal"]["flush_interval_ms"])
+        {
+            config->journal_flush_interval_ms = yaml["journal"]["flush_interval_ms"].as<int>();
+        }
+        if (yaml["journal"]["overflow_capacity"])
+        {
+            config->journal_overflow_capacity = yaml["journal"]["overflow_capacity"].as<size_t>();
+        }
+    }
+
+    // market data replay
+    config->replay_enabled = false;
+    config->replay_directory = config->journal_directory;
+    config->replay_trading_day = "";
+    config->replay_speed = 1.0;
+    if (yaml["replay"])
+    {
+        if (yaml["replay"]["enabled"])
+        {
+            config->replay_enabled = yaml["replay"]["enabled"].as<bool>();
+        }
+        if (yaml["replay"]["directory"])
+        {
+            config->replay_directory = yaml["replay"]["directory"].as<std::string>();
+        }
+        if (yaml["replay"]["trading_day"])
+        {
+            config->replay_trading_day = yaml["replay"]["trading_day"].as<std::string>();
+        }
+        if (yaml["replay"]["speed"])
+        {
+            config->replay_speed = yaml["replay"]["speed"].as<double>();
+        }
+    }
+
     // limit
     config->fake_x = yaml["limit"]["fake_x"].as<int>();
+    config->fake_latency_us = 0;
+    if (yaml["limit"]["fake_latency_us"])
+    {
+        config->fake_latency_us = yaml["limit"]["fake_latency_us"].as<int>();
+    }
     config->stop_loss = yaml["limit"]["stop_loss"].as<float>();
     config->stop_profit = yaml["limit"]["stop_profit"].as<float>();
     config->amt = yaml["limit"]["amt"].as<int>();
     config->x_times = yaml["limit"]["x_times"].as<int>();
+    config->max_position = 0;
+    config->max_deviation = 0;
+    if (yaml["limit"]["max_position"])
+    {
+        config->max_position = yaml["limit"]["max_position"].as<int>();
+    }
+    if (yaml["limit"]["max_deviation"])
+    {
+        config->max_deviation = yaml["limit"]["max_deviation"].as<double>();
+    }
+
+    // instrument master
+    config->instrument_cache_directory = "./instruments/";
+    if (yaml["instrument_cache"] && yaml["instrument_cache"]["directory"])
+    {
+        config->instrument_cache_directory = yaml["instrument_cache"]["directory"].as<std::string>();
+    }
+
+    // flow_control
+    config->order_rate = 0;
+    config->order_burst = 1;
+    config->query_rate = 1;
+    if (yaml["flow_control"])
+    {
+        if (yaml["flow_control"]["order_rate"])
+        {
+            config->order_rate = yaml["flow_control"]["order_rate"].as<double>();
+        }
+        if (yaml["flow_control"]["order_burst"])
+        {
+            config->order_burst = yaml["flow_control"]["order_burst"].as<int>();
+        }
+        if (yaml["flow_control"]["query_rate"])
+        {
+            config->query_rate = yaml["flow_control"]["query_rate"].as<double>();
+        }
+    }
 
     std::cout << "交易是否模拟: \t" << (config->fake_x > 0 ? "是" : "否") << std::endl;
+    std::cout << "模拟撮合延迟(us): \t" << config->fake_latency_us << std::endl;
     std::cout << "止损百分比: \t" << config->stop_loss << std::endl;
     std::cout << "止盈百分比: \t" << config->stop_profit << std::endl;
     std::cout << "单笔交易限制手数: \t" << config->amt << std::endl;
     std::cout << "日交易总次数: \t" << config->x_times << std::endl;
+    std::cout << "单合约持仓上限: \t" << config->max_position << std::endl;
+    std::cout << "价格偏离上限(%): \t" << config->max_deviation << std::endl;
+    std::cout << "每秒报单数: \t" << config->order_rate << std::endl;
+    std::cout << "每秒查询数: \t" << config->query_rate << std::endl;
+    std::cout << "合约缓存目录: \t" << config->instrument_cache_directory << std::endl;
 
     return config;
 }
@@ -0,0 +1,111 @@
+#include "conflator.h"
+
+#include <algorithm>
+
+lueing::TickConflator::TickConflator(size_t max_instruments, const QuoteTable &quotes)
+    : max_instruments_(max_instruments), quotes_(quotes), routes_(new std::atomic<ReaderList *>[max_instruments]())
+{
+}
+
+lueing::TickConflator::~TickConflator()
+{
+    for (size_t i = 0; i < max_instruments_; i++)
+    {
+        delete routes_[i].load(std::memory_order_relaxed);
+    }
+}
+
+lueing::SubscriberId lueing::TickConflator::Register(const std::vector<InstrumentHandle> &handles)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    auto id = static_cast<SubscriberId>(readers_.size());
+    readers_.emplace_back(new Reader(id, max_instruments_, std::max<size_t>(handles.size(), 1)));
+    reader_handles_.push_back(handles);
+    Reader *reader = readers_.back().get();
+    for (InstrumentHandle handle : handles)
+    {
+        if (handle >= max_instruments_)
+        {
+            continue;
+        }
+        ReaderList *current = routes_[handle].load(std::memory_order_acquire);
+        auto *routes = nullptr == current ? new ReaderList() : new ReaderList(*current);
+        if (std::find(routes->begin(), routes->end(), reader) == routes->end())
+        {
+            routes->push_back(reader);
+        }
+        Publish(handle, routes);
+    }
+    return id;
+}
+
+void lueing::TickConflator::Unregister(SubscriberId id)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    if (id >= readers_.size() || !readers_[id]->active.load())
+    {
+        return;
+    }
+    Reader *reader = readers_[id].get();
+    reader->active.store(false);
+    for (InstrumentHandle handle : reader_handles_[id])
+    {
+        if (handle >= max_instruments_)
+        {
+            continue;
+        }
+        ReaderList *current = routes_[handle].load(std::memory_order_acquire);
+        if (nullptr == current)
+        {
+            continue;
+        }
+        auto *routes = new ReaderList(*current);
+        routes->erase(std::remove(routes->begin(), routes->end(), reader), routes->end());
+        Publish(handle, routes);
+    }
+}
+
+size_t lueing::TickConflator::Poll(SubscriberId id, std::vector<Tick> &out, size_t max)
+{
+    Reader *reader;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        if (id >= readers_.size())
+        {
+            return 0;
+        }
+        reader = readers_[id].get();
+    }
+    size_t count = 0;
+    InstrumentHandle handle;
+    while (count < max && reader->active.load(std::memory_order_relaxed) && reader->pending.TryPop(handle))
+    {
+        // 先清除标志再读行情, 读取期间到达的行情会重新入队, 不会丢失
+        reader->dirty[handle].exchange(false, std::memory_order_acq_rel);
+        Tick tick;
+        uint64_t version;
+        if (quotes_.Read(handle, tick, version) && version != reader->seen[handle])
+        {
+            reader->seen[handle] = version;
+            out.push_back(tick);
+            count++;
+        }
+    }
+    return count;
+}
+
+uint64_t lueing::TickConflator::Conflated(SubscriberId id) const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    return id < readers_.size() ? readers_[id]->conflated.load() : 0;
+}
+
+void lueing::TickConflator::Publish(InstrumentHandle handle, ReaderList *routes)
+{
+    ReaderList *previous = routes_[handle].exchange(routes, std::memory_order_acq_rel);
+    if (nullptr != previous)
+    {
+        // CTP 回调线程可能仍在遍历旧列表, 延迟到析构时释放
+        retired_routes_.emplace_back(previous);
+    }
+}
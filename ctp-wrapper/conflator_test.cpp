@@ -0,0 +1,124 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "conflator.h"
+
+namespace {
+    lueing::Tick MakeTick(uint32_t instrument, int volume)
+    {
+        lueing::Tick tick{};
+        tick.instrument = instrument;
+        tick.volume = volume;
+        return tick;
+    }
+}
+
+TEST(ConflatorTest, PollReturnsLatestPerInstrument)
+{
+    lueing::QuoteTable quotes(8);
+    lueing::TickConflator conflator(8, quotes);
+    auto slow = conflator.Register({1, 2});
+    auto other = conflator.Register({3});
+
+    // 合约 1 连续三笔, 合约 2 一笔, 合约 4 无人订阅
+    for (int volume = 1; volume <= 3; volume++)
+    {
+        quotes.Publish(1, MakeTick(1, volume));
+        conflator.Mark(1);
+    }
+    quotes.Publish(2, MakeTick(2, 10));
+    conflator.Mark(2);
+    quotes.Publish(4, MakeTick(4, 10));
+    conflator.Mark(4);
+
+    std::vector<lueing::Tick> ticks;
+    ASSERT_EQ(conflator.Poll(slow, ticks), 2u);
+    EXPECT_EQ(ticks[0].instrument, 1u);
+    EXPECT_EQ(ticks[0].volume, 3);
+    EXPECT_EQ(ticks[1].instrument, 2u);
+    EXPECT_EQ(conflator.Conflated(slow), 2u);
+    EXPECT_EQ(conflator.Poll(other, ticks), 0u);
+
+    // 读取之后的新行情重新入队
+    ticks.clear();
+    EXPECT_EQ(conflator.Poll(slow, ticks), 0u);
+    quotes.Publish(2, MakeTick(2, 11));
+    conflator.Mark(2);
+    ASSERT_EQ(conflator.Poll(slow, ticks, 1), 1u);
+    EXPECT_EQ(ticks[0].volume, 11);
+
+    conflator.Unregister(slow);
+    conflator.Mark(1);
+    EXPECT_EQ(conflator.Poll(slow, ticks), 0u);
+}
+
+TEST(ConflatorTest, PollSkipsAlreadyReadVersion)
+{
+    lueing::QuoteTable quotes(4);
+    lueing::TickConflator conflator(4, quotes);
+    auto id = conflator.Register({1});
+
+    // 第二笔行情已发布但尚未标记时读取, 读到的已是最新行情
+    quotes.Publish(1, MakeTick(1, 1));
+    conflator.Mark(1);
+    quotes.Publish(1, MakeTick(1, 2));
+    std::vector<lueing::Tick> ticks;
+    ASSERT_EQ(conflator.Poll(id, ticks), 1u);
+    EXPECT_EQ(ticks[0].volume, 2);
+
+    // 随后到达的标记不再重复返回同一笔行情
+    conflator.Mark(1);
+    ticks.clear();
+    EXPECT_EQ(conflator.Poll(id, ticks), 0u);
+
+    quotes.Publish(1, MakeTick(1, 3));
+    conflator.Mark(1);
+    ASSERT_EQ(conflator.Poll(id, ticks), 1u);
+    EXPECT_EQ(ticks[0].volume, 3);
+}
+
+TEST(ConflatorTest, ConcurrentReaderNeverMissesLatest)
+{
+    lueing::QuoteTable quotes(4);
+    lueing::TickConflator conflator(4, quotes);
+    auto id = conflator.Register({0, 1, 2, 3});
+    constexpr int kTicks = 100000;
+    std::atomic_bool done{false};
+    int last[4] = {0, 0, 0, 0};
+
+    std::thread reader([&] {
+        std::vector<lueing::Tick> ticks;
+        while (!done.load())
+        {
+            ticks.clear();
+            conflator.Poll(id, ticks);
+            for (const auto &tick : ticks)
+            {
+                // 每个合约读到的行情严格递增, 同一笔行情不会读到两次
+                EXPECT_GT(tick.volume, last[tick.instrument]);
+                last[tick.instrument] = tick.volume;
+            }
+        }
+        ticks.clear();
+        conflator.Poll(id, ticks);
+        for (const auto &tick : ticks)
+        {
+            last[tick.instrument] = tick.volume;
+        }
+    });
+    for (int i = 1; i <= kTicks; i++)
+    {
+        uint32_t instrument = i % 4;
+        quotes.Publish(instrument, MakeTick(instrument, i));
+        conflator.Mark(instrument);
+    }
+    done.store(true);
+    reader.join();
+
+    // 最后一次读取一定能看到每个合约的最新行情
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(last[i], kTicks - (kTicks - i) % 4);
+    }
+}
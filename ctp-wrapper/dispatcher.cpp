@@ -0,0 +1,264 @@
+#include "dispatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <spdlog/spdlog.h>
+
+namespace {
+    // 每轮每个订阅者最多处理的行情条数, 避免单个订阅者独占分发线程
+    constexpr int kDrainBatch = 64;
+}
+
+lueing::TickDispatcher::TickDispatcher(size_t max_instruments, size_t workers, size_t queue_capacity)
+    : max_instruments_(max_instruments), queue_capacity_(queue_capacity),
+      routes_(new std::atomic<SubscriberList *>[max_instruments]())
+{
+    workers = std::min<size_t>(std::max<size_t>(workers, 1), 64);
+    for (size_t i = 0; i < workers; i++)
+    {
+        workers_.emplace_back(new Worker());
+    }
+    for (auto &worker : workers_)
+    {
+        Worker *w = worker.get();
+        w->thread = std::thread([this, w] { Run(*w); });
+    }
+}
+
+lueing::TickDispatcher::~TickDispatcher()
+{
+    running_.store(false);
+    for (auto &worker : workers_)
+    {
+        {
+            std::unique_lock<std::mutex> lock(worker->lock);
+            worker->signaled = true;
+        }
+        worker->condition.notify_one();
+    }
+    for (auto &worker : workers_)
+    {
+        worker->thread.join();
+    }
+    for (size_t i = 0; i < max_instruments_; i++)
+    {
+        delete routes_[i].load(std::memory_order_relaxed);
+    }
+}
+
+lueing::SubscriberId lueing::TickDispatcher::Register(const std::vector<InstrumentHandle> &handles,
+                                                      TickCallback callback)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    auto id = static_cast<SubscriberId>(subscribers_.size());
+    size_t worker = id % workers_.size();
+    subscribers_.emplace_back(new Subscriber(id, worker, std::move(callback), queue_capacity_));
+    subscriber_handles_.push_back(handles);
+    Subscriber *subscriber = subscribers_.back().get();
+    {
+        std::unique_lock<std::mutex> worker_lock(workers_[worker]->lock);
+        workers_[worker]->subscribers.push_back(subscriber);
+    }
+    for (InstrumentHandle handle : handles)
+    {
+        if (handle >= max_instruments_)
+        {
+            continue;
+        }
+        SubscriberList *current = routes_[handle].load(std::memory_order_acquire);
+        auto *routes = nullptr == current ? new SubscriberList() : new SubscriberList(*current);
+        if (std::find(routes->begin(), routes->end(), subscriber) == routes->end())
+        {
+            routes->push_back(subscriber);
+        }
+        Publish(handle, routes);
+    }
+    return id;
+}
+
+lueing::SubscriberId lueing::TickDispatcher::Register(const std::vector<InstrumentHandle> &handles,
+                                                      TickHandler *handler)
+{
+    return Register(handles, [handler](const Tick &tick) { handler->OnTick(tick); });
+}
+
+void lueing::TickDispatcher::Unregister(SubscriberId id)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    if (id >= subscribers_.size() || !subscribers_[id]->active.load())
+    {
+        return;
+    }
+    Subscriber *subscriber = subscribers_[id].get();
+    subscriber->active.store(false);
+    for (InstrumentHandle handle : subscriber_handles_[id])
+    {
+        if (handle >= max_instruments_)
+        {
+            continue;
+        }
+        SubscriberList *current = routes_[handle].load(std::memory_order_acquire);
+        if (nullptr == current)
+        {
+            continue;
+        }
+        auto *routes = new SubscriberList(*current);
+        routes->erase(std::remove(routes->begin(), routes->end(), subscriber), routes->end());
+        Publish(handle, routes);
+    }
+    Worker &worker = *workers_[subscriber->worker];
+    {
+        std::unique_lock<std::mutex> worker_lock(worker.lock);
+        worker.subscribers.erase(std::remove(worker.subscribers.begin(), worker.subscribers.end(), subscriber),
+                                 worker.subscribers.end());
+    }
+    // 等待正在执行的回调结束
+    std::unique_lock<std::mutex> drain_lock(worker.drain_lock);
+}
+
+void lueing::TickDispatcher::Dispatch(const Tick &tick)
+{
+    if (tick.instrument >= max_instruments_)
+    {
+        return;
+    }
+    const SubscriberList *routes = routes_[tick.instrument].load(std::memory_order_acquire);
+    if (nullptr == routes)
+    {
+        return;
+    }
+    uint64_t wake = 0;
+    for (Subscriber *subscriber : *routes)
+    {
+        if (subscriber->queue.TryPush(tick))
+        {
+            wake |= 1ULL << subscriber->worker;
+        }
+        else
+        {
+            subscriber->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    for (size_t i = 0; wake; i++, wake >>= 1)
+    {
+        if (wake & 1)
+        {
+            Wake(*workers_[i]);
+        }
+    }
+}
+
+uint64_t lueing::TickDispatcher::Delivered(SubscriberId id) const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    return id < subscribers_.size() ? subscribers_[id]->delivered.load() : 0;
+}
+
+uint64_t lueing::TickDispatcher::Dropped(SubscriberId id) const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    return id < subscribers_.size() ? subscribers_[id]->dropped.load() : 0;
+}
+
+lueing::LatencySummary lueing::TickDispatcher::HandoffLatency(SubscriberId id) const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    if (INVALID_SUBSCRIBER != id)
+    {
+        return id < subscribers_.size() ? subscribers_[id]->handoff.Summary() : LatencySummary{};
+    }
+    LatencyHistogram merged;
+    for (const auto &subscriber : subscribers_)
+    {
+        merged.Merge(subscriber->handoff);
+    }
+    return merged.Summary();
+}
+
+void lueing::TickDispatcher::Run(Worker &worker)
+{
+    SubscriberList subscribers;
+    while (running_.load())
+    {
+        {
+            std::unique_lock<std::mutex> lock(worker.lock);
+            subscribers = worker.subscribers;
+        }
+        bool worked;
+        {
+            std::unique_lock<std::mutex> drain_lock(worker.drain_lock);
+            worked = Drain(subscribers);
+        }
+        if (worked)
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(worker.lock);
+        worker.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool pending = std::any_of(worker.subscribers.begin(), worker.subscribers.end(),
+                                   [](const Subscriber *subscriber) { return !subscriber->queue.Empty(); });
+        if (!pending)
+        {
+            worker.condition.wait_for(lock, std::chrono::milliseconds(100), [this, &worker] {
+                return worker.signaled || !running_.load();
+            });
+        }
+        worker.signaled = false;
+        worker.sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+bool lueing::TickDispatcher::Drain(const SubscriberList &subscribers)
+{
+    bool worked = false;
+    Tick tick;
+    for (Subscriber *subscriber : subscribers)
+    {
+        for (int i = 0; i < kDrainBatch && subscriber->active.load(std::memory_order_relaxed); i++)
+        {
+            if (!subscriber->queue.TryPop(tick))
+            {
+                break;
+            }
+            worked = true;
+            subscriber->handoff.Record(MonotonicNanos() - tick.local_time);
+            try
+            {
+                subscriber->callback(tick);
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::error("[行情分发] 订阅者 {} 回调异常: {}", subscriber->id, e.what());
+            }
+            subscriber->delivered.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return worked;
+}
+
+void lueing::TickDispatcher::Wake(Worker &worker)
+{
+    // 与 Run 中设置 sleeping 后检查队列配对, 避免丢失唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!worker.sleeping.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(worker.lock);
+        worker.signaled = true;
+    }
+    worker.condition.notify_one();
+}
+
+void lueing::TickDispatcher::Publish(InstrumentHandle handle, SubscriberList *routes)
+{
+    SubscriberList *previous = routes_[handle].exchange(routes, std::memory_order_acq_rel);
+    if (nullptr != previous)
+    {
+        // CTP 回调线程可能仍在遍历旧列表, 延迟到析构时释放
+        retired_routes_.emplace_back(previous);
+    }
+}
@@ -0,0 +1,86 @@
+#include <thread>
+#include "gtest/gtest.h"
+#include "dispatcher.h"
+
+namespace {
+    void WaitUntil(const std::function<bool()> &predicate)
+    {
+        for (int i = 0; i < 500 && !predicate(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+}
+
+TEST(DispatcherTest, DeliverOnlySubscribedInstruments)
+{
+    lueing::TickDispatcher dispatcher(8, 2, 64);
+    std::atomic_int ag{0};
+    std::atomic_int all{0};
+
+    auto ag_id = dispatcher.Register({1}, [&ag](const lueing::Tick &tick) {
+        EXPECT_EQ(tick.instrument, 1u);
+        ag++;
+    });
+    dispatcher.Register({1, 2}, [&all](const lueing::Tick &tick) { all++; });
+
+    lueing::Tick tick{};
+    for (uint32_t i = 0; i < 30; i++)
+    {
+        tick.instrument = i % 3;
+        dispatcher.Dispatch(tick);
+    }
+    WaitUntil([&] { return 10 == ag.load() && 20 == all.load(); });
+    EXPECT_EQ(ag.load(), 10);
+    EXPECT_EQ(all.load(), 20);
+    EXPECT_EQ(dispatcher.Delivered(ag_id), 10u);
+    EXPECT_EQ(dispatcher.HandoffLatency(ag_id).count, 10u);
+    EXPECT_EQ(dispatcher.HandoffLatency(INVALID_SUBSCRIBER).count, 30u);
+
+    dispatcher.Unregister(ag_id);
+    tick.instrument = 1;
+    dispatcher.Dispatch(tick);
+    WaitUntil([&] { return 21 == all.load(); });
+    EXPECT_EQ(ag.load(), 10);
+    EXPECT_EQ(all.load(), 21);
+}
+
+TEST(DispatcherTest, DropWhenQueueFull)
+{
+    lueing::TickDispatcher dispatcher(2, 1, 4);
+    std::mutex gate;
+    std::atomic_int seen{0};
+    gate.lock();
+
+    auto id = dispatcher.Register({0}, [&](const lueing::Tick &tick) {
+        std::unique_lock<std::mutex> lock(gate);
+        seen++;
+    });
+
+    lueing::Tick tick{};
+    tick.instrument = 0;
+    for (int i = 0; i < 20; i++)
+    {
+        dispatcher.Dispatch(tick);
+    }
+    gate.unlock();
+    WaitUntil([&] { return seen.load() + dispatcher.Dropped(id) == 20u; });
+    EXPECT_GT(dispatcher.Dropped(id), 0u);
+    EXPECT_EQ(seen.load() + dispatcher.Dropped(id), 20u);
+}
+
+TEST(DispatcherTest, HandlerObject)
+{
+    struct Counter : lueing::TickHandler {
+        std::atomic_int ticks{0};
+
+        void OnTick(const lueing::Tick &tick) override { ticks++; }
+    } counter;
+
+    lueing::TickDispatcher dispatcher(2, 1, 16);
+    dispatcher.Register({0}, &counter);
+    lueing::Tick tick{};
+    dispatcher.Dispatch(tick);
+    WaitUntil([&] { return 1 == counter.ticks.load(); });
+    EXPECT_EQ(counter.ticks.load(), 1);
+}
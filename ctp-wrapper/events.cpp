@@ -4,7 +4,7 @@
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 
-lueing::Events::Events()
+lueing::Events::Events(size_t max_handles) : max_handles_(max_handles)
 {
 }
 
@@ -35,9 +35,41 @@ void lueing::Events::Wait(const std::string &event_name, const std::string &wait
 void lueing::Events::Notify(const std::string &event_name)
 {
     std::unique_lock<std::mutex> lock(lock_);
-    for (const auto &waiter : event_waiters_[event_name])
+    event_waiters_[event_name].clear();
+    condition_lock_.notify_all();
+}
+
+bool lueing::Events::Wait(InstrumentHandle handle)
+{
+    if (handle >= max_handles_)
     {
-        event_waiters_[event_name].erase(waiter);
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(lock_);
+    if (handle >= generations_.size())
+    {
+        generations_.resize(handle + 1, 0);
+        waiting_.resize(handle + 1, 0);
+    }
+    uint64_t generation = generations_[handle];
+    waiting_[handle]++;
+    condition_lock_.wait(lock, [this, handle, generation] {
+        return generations_[handle] != generation;
+    });
+    waiting_[handle]--;
+    return true;
+}
+
+void lueing::Events::Notify(InstrumentHandle handle)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    if (handle >= generations_.size())
+    {
+        return;
+    }
+    generations_[handle]++;
+    if (waiting_[handle] > 0)
+    {
+        condition_lock_.notify_all();
     }
-    condition_lock_.notify_all();
 }
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <thread>
 #include "gtest/gtest.h"
 #include "events.h"
@@ -13,4 +14,36 @@ TEST(EventsTest, WaitOnce)
 
     events.WaitOnce("event1");
     std::cout << "WaitOnce" << std::endl;
-}
\ No newline at end of file
+    t.join();
+}
+
+TEST(EventsTest, WaitHandle)
+{
+    lueing::Events events;
+    std::atomic_bool woken{false};
+
+    std::thread t([&events, &woken] {
+        events.Wait(3);
+        woken.store(true);
+    });
+
+    // 等待线程进入等待后再通知; 未订阅的句柄不影响等待者
+    while (!woken.load())
+    {
+        events.Notify(7);
+        events.Notify(3);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    t.join();
+    EXPECT_TRUE(woken.load());
+}
+
+TEST(EventsTest, WaitInvalidHandle)
+{
+    lueing::Events events(16);
+
+    // 无效句柄与超出上限的句柄立即返回, 不扩容也不阻塞
+    EXPECT_FALSE(events.Wait(INVALID_INSTRUMENT));
+    EXPECT_FALSE(events.Wait(16));
+    events.Notify(INVALID_INSTRUMENT);
+}
@@ -0,0 +1,259 @@
+#include "governor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+#include "tick.h"
+
+lueing::TokenBucket::TokenBucket(double rate, double burst)
+    : rate_(rate), burst_(std::max(burst, 1.0)), tokens_(std::max(burst, 1.0))
+{
+}
+
+int64_t lueing::TokenBucket::Wait(int64_t now)
+{
+    if (now < blocked_until_)
+    {
+        return blocked_until_ - now;
+    }
+    if (rate_ <= 0)
+    {
+        return 0;
+    }
+    if (0 != refilled_ && now > refilled_)
+    {
+        tokens_ = std::min(burst_, tokens_ + static_cast<double>(now - refilled_) * rate_ / 1e9);
+    }
+    refilled_ = std::max(refilled_, now);
+    if (tokens_ >= 1)
+    {
+        return 0;
+    }
+    return static_cast<int64_t>(std::ceil((1 - tokens_) * 1e9 / rate_));
+}
+
+void lueing::TokenBucket::Block(int64_t until)
+{
+    tokens_ = 0;
+    blocked_until_ = until;
+    refilled_ = until;
+}
+
+lueing::RequestGovernor::RequestGovernor(double order_rate, double order_burst, double query_rate)
+    : lanes_{{order_rate, order_burst}, {query_rate, 1}}
+{
+    worker_ = std::thread([this] { Run(); });
+}
+
+lueing::RequestGovernor::~RequestGovernor()
+{
+    Stop();
+}
+
+void lueing::RequestGovernor::Stop()
+{
+    // 排队中的请求取出后在锁外调用 failure, failure 可以再次提交 (得到 GOVERNOR_STOPPED)
+    std::vector<Pending> dropped;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        running_ = false;
+        for (Lane &lane : lanes_)
+        {
+            std::move(lane.queue.begin(), lane.queue.end(), std::back_inserter(dropped));
+            lane.queue.clear();
+        }
+    }
+    condition_.notify_all();
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+    for (Pending &pending : dropped)
+    {
+        if (pending.failure)
+        {
+            pending.failure(GOVERNOR_STOPPED);
+        }
+    }
+}
+
+int lueing::RequestGovernor::Admit(size_t index, int64_t now)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    if (!running_)
+    {
+        return GOVERNOR_STOPPED;
+    }
+    Lane &lane = lanes_[index];
+    int64_t wait = 0;
+    // 有排队或在途时直接发送会越过之前的请求, 一律排队
+    if (!lane.queue.empty() || !Ready(index, now, wait))
+    {
+        return GOVERNOR_QUEUE;
+    }
+    lane.bucket.Take();
+    lane.in_flight++;
+    return 0;
+}
+
+int lueing::RequestGovernor::Enqueue(size_t index, Pending pending)
+{
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        if (!running_)
+        {
+            return GOVERNOR_STOPPED;
+        }
+        lanes_[index].queue.push_back(std::move(pending));
+    }
+    condition_.notify_all();
+    return 0;
+}
+
+void lueing::RequestGovernor::Sent(size_t index, int64_t submit_time, int result)
+{
+    Lane &lane = lanes_[index];
+    bool queued;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        lane.in_flight--;
+        queued = !lane.queue.empty();
+    }
+    if (queued)
+    {
+        condition_.notify_all();
+    }
+    lane.wait.Record(MonotonicNanos() - submit_time);
+    (0 == result ? lane.sent : lane.failed).fetch_add(1, std::memory_order_relaxed);
+}
+
+bool lueing::RequestGovernor::Ready(size_t index, int64_t now, int64_t &wait)
+{
+    wait = INT64_MAX;
+    for (size_t i = 0; i < index; i++)
+    {
+        // 高优先级类别有排队, 由其令牌桶决定唤醒时刻
+        if (!lanes_[i].queue.empty())
+        {
+            return false;
+        }
+    }
+    if (lanes_[index].in_flight > 0)
+    {
+        // 在途请求完成 (Complete/Sent) 时唤醒
+        return false;
+    }
+    wait = lanes_[index].bucket.Wait(now);
+    return 0 == wait;
+}
+
+void lueing::RequestGovernor::Run()
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    while (running_)
+    {
+        int64_t now = MonotonicNanos();
+        int64_t wait = INT64_MAX;
+        size_t chosen = GOVERNOR_CLASSES;
+        for (size_t i = 0; i < GOVERNOR_CLASSES; i++)
+        {
+            int64_t lane_wait = INT64_MAX;
+            if (lanes_[i].queue.empty())
+            {
+                continue;
+            }
+            if (Ready(i, now, lane_wait))
+            {
+                chosen = i;
+                break;
+            }
+            wait = std::min(wait, lane_wait);
+        }
+        if (GOVERNOR_CLASSES == chosen)
+        {
+            if (INT64_MAX == wait)
+            {
+                condition_.wait(lock);
+            }
+            else
+            {
+                condition_.wait_for(lock, std::chrono::nanoseconds(wait));
+            }
+            continue;
+        }
+        Lane &lane = lanes_[chosen];
+        lane.bucket.Take();
+        lane.in_flight++;
+        Pending pending = std::move(lane.queue.front());
+        lane.queue.pop_front();
+        lock.unlock();
+        Complete(lane, pending, pending.send());
+        lock.lock();
+    }
+}
+
+void lueing::RequestGovernor::Complete(Lane &lane, Pending &pending, int result)
+{
+    bool throttled = GOVERNOR_THROTTLED_PENDING == result || GOVERNOR_THROTTLED_RATE == result;
+    bool retry = throttled && pending.retries < GOVERNOR_MAX_RETRIES;
+    bool queued;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        lane.in_flight--;
+        if (retry && !running_)
+        {
+            // 已停止, 不再重试
+            retry = false;
+            result = GOVERNOR_STOPPED;
+        }
+        if (retry)
+        {
+            // 按一个令牌的间隔退避, 放回队首保持原有顺序
+            pending.retries++;
+            lane.throttled.fetch_add(1, std::memory_order_relaxed);
+            double rate = lane.bucket.Rate();
+            int64_t backoff = rate > 0 ? static_cast<int64_t>(1e9 / rate) : GOVERNOR_RETRY_NANOS;
+            lane.bucket.Block(MonotonicNanos() + backoff);
+            lane.queue.push_front(std::move(pending));
+        }
+        queued = !lane.queue.empty();
+    }
+    if (queued)
+    {
+        condition_.notify_all();
+    }
+    if (retry)
+    {
+        return;
+    }
+    lane.wait.Record(MonotonicNanos() - pending.submit_time);
+    if (0 == result)
+    {
+        lane.sent.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    lane.failed.fetch_add(1, std::memory_order_relaxed);
+    if (pending.failure)
+    {
+        pending.failure(result);
+    }
+}
+
+lueing::GovernorStats lueing::RequestGovernor::Stats(RequestClass request_class) const
+{
+    const Lane &lane = lanes_[static_cast<size_t>(request_class)];
+    GovernorStats stats{};
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        stats.depth = lane.queue.size();
+    }
+    stats.sent = lane.sent.load(std::memory_order_relaxed);
+    stats.throttled = lane.throttled.load(std::memory_order_relaxed);
+    stats.failed = lane.failed.load(std::memory_order_relaxed);
+    stats.wait = lane.wait.Summary();
+    return stats;
+}
@@ -0,0 +1,186 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "governor.h"
+
+namespace {
+    // 按发送顺序记录请求名
+    class Recorder {
+    public:
+        lueing::RequestSender Sender(const std::string &name, int result = 0)
+        {
+            return [this, name, result]() {
+                std::lock_guard<std::mutex> lock(lock_);
+                sent_.push_back(name);
+                return result;
+            };
+        }
+
+        std::vector<std::string> Sent()
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            return sent_;
+        }
+
+        bool WaitFor(size_t count)
+        {
+            for (int i = 0; i < 3000 && Sent().size() < count; i++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return Sent().size() >= count;
+        }
+
+    private:
+        std::mutex lock_;
+        std::vector<std::string> sent_;
+    };
+}
+
+TEST(RequestGovernorTest, queries_are_paced_by_token_bucket)
+{
+    lueing::RequestGovernor governor(0, 1, 20);
+    Recorder recorder;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(0, governor.Submit(lueing::RequestClass::Query, recorder.Sender("q" + std::to_string(i))));
+    }
+    // 第一笔直接发出, 其余排队
+    EXPECT_EQ(1u, recorder.Sent().size());
+    EXPECT_EQ(2u, governor.Stats(lueing::RequestClass::Query).depth);
+    ASSERT_TRUE(recorder.WaitFor(3));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(95));
+    lueing::GovernorStats stats = governor.Stats(lueing::RequestClass::Query);
+    EXPECT_EQ(0u, stats.depth);
+    EXPECT_EQ(3u, stats.sent);
+    EXPECT_EQ(3u, stats.wait.count);
+    EXPECT_GE(stats.wait.max, 90 * 1000 * 1000LL);
+}
+
+TEST(RequestGovernorTest, orders_preempt_queued_queries)
+{
+    lueing::RequestGovernor governor(20, 1, 100);
+    Recorder recorder;
+    governor.Submit(lueing::RequestClass::Order, recorder.Sender("o1"));
+    governor.Submit(lueing::RequestClass::Order, recorder.Sender("o2"));
+    // 查询有令牌, 但报单在排队, 查询须等报单全部发出
+    governor.Submit(lueing::RequestClass::Query, recorder.Sender("q1"));
+    governor.Submit(lueing::RequestClass::Order, recorder.Sender("o3"));
+    ASSERT_TRUE(recorder.WaitFor(4));
+    EXPECT_EQ((std::vector<std::string>{"o1", "o2", "o3", "q1"}), recorder.Sent());
+}
+
+TEST(RequestGovernorTest, throttled_requests_are_retried)
+{
+    lueing::RequestGovernor governor(0, 1, 1);
+    std::vector<int> results{GOVERNOR_THROTTLED_RATE, GOVERNOR_THROTTLED_PENDING, 0};
+    std::atomic_int calls{0};
+    std::atomic_int failures{0};
+    auto sender = [&]() { return results[calls.fetch_add(1)]; };
+    EXPECT_EQ(0, governor.Submit(lueing::RequestClass::Order, sender, [&](int) { failures++; }));
+    for (int i = 0; i < 1000 && calls.load() < 3; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(3, calls.load());
+    EXPECT_EQ(0, failures.load());
+    lueing::GovernorStats stats = governor.Stats(lueing::RequestClass::Order);
+    EXPECT_EQ(2u, stats.throttled);
+    EXPECT_EQ(1u, stats.sent);
+
+    // 其他错误不重试: 直接发送时由返回值告知, 排队后发送时调用 failure
+    Recorder recorder;
+    EXPECT_EQ(-1, governor.Submit(lueing::RequestClass::Query, recorder.Sender("q1", -1)));
+    governor.Submit(lueing::RequestClass::Query, recorder.Sender("q2", -1), [&](int result) {
+        EXPECT_EQ(-1, result);
+        failures++;
+    });
+    ASSERT_TRUE(recorder.WaitFor(2));
+    for (int i = 0; i < 1000 && 0 == failures.load(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(1, failures.load());
+    EXPECT_EQ(2u, governor.Stats(lueing::RequestClass::Query).failed);
+}
+
+TEST(RequestGovernorTest, requests_wait_for_in_flight_request)
+{
+    lueing::RequestGovernor governor(0, 1, 0);
+    Recorder recorder;
+    std::atomic_bool sending{false};
+    std::atomic_bool release{false};
+    std::atomic_int attempts{0};
+    // 报单正在发送且随后被柜台流控, 期间提交的撤单不能越过它
+    std::thread insert([&]() {
+        governor.Submit(lueing::RequestClass::Order, [&]() {
+            recorder.Sender("insert")();
+            if (0 == attempts.fetch_add(1))
+            {
+                sending = true;
+                while (!release.load())
+                {
+                    std::this_thread::yield();
+                }
+                return GOVERNOR_THROTTLED_RATE;
+            }
+            return 0;
+        });
+    });
+    while (!sending.load())
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(0, governor.Submit(lueing::RequestClass::Order, recorder.Sender("cancel")));
+    EXPECT_EQ(1u, governor.Stats(lueing::RequestClass::Order).depth);
+    release = true;
+    insert.join();
+    ASSERT_TRUE(recorder.WaitFor(3));
+    EXPECT_EQ((std::vector<std::string>{"insert", "insert", "cancel"}), recorder.Sent());
+}
+
+TEST(RequestGovernorTest, stop_fails_queued_requests)
+{
+    lueing::RequestGovernor governor(0, 1, 0);
+    Recorder recorder;
+    std::atomic_bool sending{false};
+    std::atomic_bool release{false};
+    std::vector<int> failures;
+    std::mutex lock;
+    auto failure = [&](int result) {
+        std::lock_guard<std::mutex> guard(lock);
+        failures.push_back(result);
+    };
+    // 正在发送的报单随后被柜台流控, 期间提交的报单与查询排队
+    std::thread insert([&]() {
+        governor.Submit(lueing::RequestClass::Order, [&]() {
+            sending = true;
+            while (!release.load())
+            {
+                std::this_thread::yield();
+            }
+            return GOVERNOR_THROTTLED_RATE;
+        }, failure);
+    });
+    while (!sending.load())
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(0, governor.Submit(lueing::RequestClass::Order, recorder.Sender("o1"), failure));
+    EXPECT_EQ(0, governor.Submit(lueing::RequestClass::Query, recorder.Sender("q1"), failure));
+    // 停止后排队的请求不再发出, 各自以 GOVERNOR_STOPPED 得知; 被流控的在途请求不再重试
+    governor.Stop();
+    EXPECT_EQ(0u, governor.Stats(lueing::RequestClass::Order).depth);
+    EXPECT_EQ((std::vector<int>{GOVERNOR_STOPPED, GOVERNOR_STOPPED}), failures);
+    release = true;
+    insert.join();
+    EXPECT_EQ((std::vector<int>{GOVERNOR_STOPPED, GOVERNOR_STOPPED, GOVERNOR_STOPPED}), failures);
+    EXPECT_TRUE(recorder.Sent().empty());
+    EXPECT_EQ(GOVERNOR_STOPPED, governor.Submit(lueing::RequestClass::Order, recorder.Sender("o2"), failure));
+}
@@ -5,10 +5,12 @@
 #include <fmt/ranges.h>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <utility>
 #include "lueing_os.h"
 
-lueing::CtpHq::CtpHq(CtpConfigPtr config) : hq_handler_(std::move(config))
+lueing::CtpHq::CtpHq(CtpConfigPtr config, MdApiFactory factory)
+    : hq_handler_(config, std::move(factory)), instruments_(config->instruments), instruments_booked_(config->max_instruments)
 {
     hq_handler_.CreateHqContext();
 }
@@ -17,176 +19,737 @@ lueing::CtpHq::~CtpHq()
 = default;
 
 int lueing::CtpHq::SubscribeMarketData(const std::string &instrument, const std::string &subscriber)
+{
+    return SubscribeMarketData(std::vector<std::string>{instrument}, subscriber);
+}
+
+int lueing::CtpHq::UnSubscribeMarketData(const std::string &instrument, const std::string &subscriber)
+{
+    return UnSubscribeMarketData(std::vector<std::string>{instrument}, subscriber);
+}
+
+int lueing::CtpHq::SubscribeMarketData(const std::vector<std::string> &instruments, const std::string &subscriber)
 {
     std::unique_lock<std::mutex> lock(lock_);
-    if (instruments_booked_.contains(instrument))
+    std::vector<InstrumentHandle> pending;
+    // 出错返回前归还未登记订阅者的合约预分配的行情块, 已有订阅者的合约不受影响
+    auto release = [this](const std::vector<InstrumentHandle> &handles, size_t begin) {
+        for (size_t i = begin; i < handles.size(); i++)
+        {
+            if (instruments_booked_[handles[i]].empty())
+            {
+                hq_handler_.ReleaseHistory(handles[i]);
+            }
+        }
+    };
+    for (const auto &instrument : instruments)
     {
-        instruments_booked_[instrument].insert(subscriber);
-        return 0;
+        InstrumentHandle handle = instruments_->Intern(instrument);
+        // 订阅前预分配行情块, 回调线程只做查找
+        if (INVALID_INSTRUMENT == handle || nullptr == hq_handler_.MarketData().Reserve(handle)
+            || !hq_handler_.Bars().Reserve(handle) || !hq_handler_.Stats().Reserve(handle))
+        {
+            spdlog::error(fmt::format("[行情接口][订阅行情] 合约数量超出上限或合约名非法: {}", instrument));
+            if (INVALID_INSTRUMENT != handle && handle < instruments_booked_.size())
+            {
+                pending.push_back(handle);
+            }
+            release(pending, 0);
+            return -1;
+        }
+        if (!instruments_booked_[handle].empty())
+        {
+            instruments_booked_[handle].insert(subscriber);
+        }
+        else if (std::find(pending.begin(), pending.end(), handle) == pending.end())
+        {
+            pending.push_back(handle);
+        }
     }
-    char *instruments_pptr[1] = {const_cast<char *>(instrument.c_str())};
-    int result = hq_handler_.GetUserMdApi()->SubscribeMarketData(instruments_pptr, 1);
 
-    if (0 == result)
+    for (size_t begin = 0; begin < pending.size(); begin += HQ_SUBSCRIBE_BATCH)
     {
-        instruments_booked_[instrument].insert(subscriber);
-        spdlog::info(fmt::format("[行情接口][订阅行情] 请求成功!"));
+        size_t end = std::min(pending.size(), begin + HQ_SUBSCRIBE_BATCH);
+        std::vector<char *> instruments_pptr;
+        for (size_t i = begin; i < end; i++)
+        {
+            instruments_pptr.push_back(const_cast<char *>(instruments_->Instrument(pending[i])));
+            hq_handler_.SetSubscribeStatus(pending[i], SubscribeStatus::Pending, 0);
+        }
+        int result = hq_handler_.SubscribeMarketData(instruments_pptr.data(), static_cast<int>(instruments_pptr.size()));
+        if (0 != result)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                hq_handler_.SetSubscribeStatus(pending[i], SubscribeStatus::None, 0);
+            }
+            spdlog::info(fmt::format("[行情接口][订阅行情] 请求失败，错误序号=[{}]", result));
+            // 之前的批次已登记, 只归还本批及之后未发出的合约
+            release(pending, begin);
+            return result;
+        }
+        for (size_t i = begin; i < end; i++)
+        {
+            instruments_booked_[pending[i]].insert(subscriber);
+        }
+        spdlog::info(fmt::format("[行情接口][订阅行情] 请求成功! 合约数: {}", end - begin));
     }
-    else
+    return 0;
+}
+
+int lueing::CtpHq::UnSubscribeMarketData(const std::vector<std::string> &instruments, const std::string &subscriber)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    std::vector<InstrumentHandle> pending;
+    for (const auto &instrument : instruments)
+    {
+        InstrumentHandle handle = instruments_->Find(instrument);
+        if (INVALID_INSTRUMENT == handle || instruments_booked_[handle].empty())
+        {
+            continue;
+        }
+        // 不是最后一位订阅者
+        if (instruments_booked_[handle].size() > 1)
+        {
+            instruments_booked_[handle].erase(subscriber);
+            continue;
+        }
+        // 最后一位订阅者, 并且就是当前订阅者
+        if (instruments_booked_[handle].contains(subscriber)
+            && std::find(pending.begin(), pending.end(), handle) == pending.end())
+        {
+            pending.push_back(handle);
+        }
+    }
+
+    for (size_t begin = 0; begin < pending.size(); begin += HQ_SUBSCRIBE_BATCH)
     {
-        spdlog::info(fmt::format("[行情接口][订阅行情] 请求失败，错误序号=[{}]", result));
+        size_t end = std::min(pending.size(), begin + HQ_SUBSCRIBE_BATCH);
+        std::vector<char *> instruments_pptr;
+        for (size_t i = begin; i < end; i++)
+        {
+            instruments_pptr.push_back(const_cast<char *>(instruments_->Instrument(pending[i])));
+        }
+        int result = hq_handler_.UnSubscribeMarketData(instruments_pptr.data(), static_cast<int>(instruments_pptr.size()));
+        if (0 != result)
+        {
+            spdlog::info(fmt::format("[行情接口][取消订阅] 请求失败，错误序号=[{}]", result));
+            return result;
+        }
+        for (size_t i = begin; i < end; i++)
+        {
+            instruments_booked_[pending[i]].erase(subscriber);
+            // 已无订阅者, 行情块归还到块池
+            hq_handler_.ReleaseHistory(pending[i]);
+        }
+        spdlog::info(fmt::format("[行情接口][取消订阅] 请求成功! 合约数: {}", end - begin));
     }
-    return result;
+    return 0;
 }
 
-int lueing::CtpHq::UnSubscribeMarketData(const std::string &instrument, const std::string &subscriber)
+lueing::SubscribeStatus lueing::CtpHq::SubscriptionStatus(const std::string &instrument, int *error_id)
 {
-    std::unique_lock<std::mutex> lock(lock_);
-    int result = 0;
-    if (!instruments_booked_.contains(instrument))
+    return hq_handler_.GetSubscribeStatus(instruments_->Find(instrument), error_id);
+}
+
+void lueing::CtpHq::WaitForData(const std::string &instrument, const std::string &subscriber)
+{
+    InstrumentHandle handle = instruments_->Find(instrument);
+    if (INVALID_INSTRUMENT == handle)
+    {
+        handle = instruments_->Intern(instrument);
+    }
+    if (!hq_handler_.GetEvents().Wait(handle))
     {
-        return result;
+        spdlog::error(fmt::format("[行情接口][等待数据] 合约无法登记: {}, 订阅者: {}", instrument, subscriber));
     }
-    // 不是最后一位订阅者
-    if (instruments_booked_[instrument].size() > 1)
+}
+
+lueing::SubscriberId lueing::CtpHq::AddTickHandler(const std::vector<std::string> &instruments,
+                                                   const std::string &subscriber, TickCallback callback)
+{
+    if (0 != SubscribeMarketData(instruments, subscriber))
     {
-        instruments_booked_[instrument].erase(subscriber);
-        return result;
+        UnSubscribeMarketData(instruments, subscriber);
+        return INVALID_SUBSCRIBER;
     }
-    // 最后一位订阅者, 并且就是当前订阅者
-    if (instruments_booked_[instrument].contains(subscriber))
+    std::vector<InstrumentHandle> handles;
+    for (const auto &instrument : instruments)
     {
-        char *instruments_pptr[1] = {const_cast<char *>(instrument.c_str())};
-        result = hq_handler_.GetUserMdApi()->UnSubscribeMarketData(instruments_pptr, 1);
+        handles.push_back(instruments_->Find(instrument));
+    }
+    SubscriberId id = hq_handler_.Dispatcher().Register(handles, std::move(callback));
+    std::unique_lock<std::mutex> lock(lock_);
+    tick_handlers_[id] = std::make_pair(subscriber, instruments);
+    return id;
+}
 
-        if (0 == result)
-        {
-            instruments_booked_[instrument].erase(subscriber);
-            spdlog::info(fmt::format("[行情接口][订阅行情] 请求成功!"));
-        }
-        else
+lueing::SubscriberId lueing::CtpHq::AddTickHandler(const std::vector<std::string> &instruments,
+                                                   const std::string &subscriber, TickHandler *handler)
+{
+    return AddTickHandler(instruments, subscriber, [handler](const Tick &tick) { handler->OnTick(tick); });
+}
+
+void lueing::CtpHq::RemoveTickHandler(SubscriberId id)
+{
+    std::pair<std::string, std::vector<std::string>> registration;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        auto it = tick_handlers_.find(id);
+        if (it == tick_handlers_.end())
         {
-            spdlog::info(fmt::format("[行情接口][订阅行情] 请求失败，错误序号=[{}]", result));
+            return;
         }
+        registration = std::move(it->second);
+        tick_handlers_.erase(it);
     }
+    hq_handler_.Dispatcher().Unregister(id);
+    UnSubscribeMarketData(registration.second, registration.first);
+}
 
-    return result;
+lueing::SubscriberId lueing::CtpHq::AddConflatedReader(const std::vector<std::string> &instruments,
+                                                       const std::string &subscriber)
+{
+    if (0 != SubscribeMarketData(instruments, subscriber))
+    {
+        UnSubscribeMarketData(instruments, subscriber);
+        return INVALID_SUBSCRIBER;
+    }
+    std::vector<InstrumentHandle> handles;
+    for (const auto &instrument : instruments)
+    {
+        handles.push_back(instruments_->Find(instrument));
+    }
+    SubscriberId id = hq_handler_.Conflator().Register(handles);
+    std::unique_lock<std::mutex> lock(lock_);
+    conflated_readers_[id] = std::make_pair(subscriber, instruments);
+    return id;
 }
 
-void lueing::CtpHq::WaitForData(const std::string &instrument, const std::string &subscriber)
+void lueing::CtpHq::RemoveConflatedReader(SubscriberId id)
 {
-    hq_handler_.GetEvents().Wait(instrument, subscriber);
+    std::pair<std::string, std::vector<std::string>> registration;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        auto it = conflated_readers_.find(id);
+        if (it == conflated_readers_.end())
+        {
+            return;
+        }
+        registration = std::move(it->second);
+        conflated_readers_.erase(it);
+    }
+    hq_handler_.Conflator().Unregister(id);
+    UnSubscribeMarketData(registration.second, registration.first);
 }
 
 void lueing::CtpHqHandler::CreateHqContext()
 {
 #define HQ_FLOW_PATH "./flow-hq/"
 
-    if (!lueing::filesystem::FilesExists(HQ_FLOW_PATH))
+    if (config_->replay_enabled)
     {
-        lueing::filesystem::Mkdirs(HQ_FLOW_PATH);
+        // 回放接口按 CTP 行情 API 的方式回调, 之后的流程与实盘一致
+        fronts_.emplace_back(new CtpHqFront(*this, 0, config_->replay_directory));
+        fronts_[0]->Connect(new ReplayMdApi(config_->replay_directory, config_->replay_trading_day,
+                                            config_->replay_speed));
     }
-
-    user_md_api_ = CThostFtdcMdApi::CreateFtdcMdApi(HQ_FLOW_PATH, false, false);
-    user_md_api_->RegisterSpi(this);
-    user_md_api_->RegisterFront(const_cast<char *>(config_->front_hq_address.c_str()));
-    // => 触发 OnFrontConnected
-    user_md_api_->Init();
-    events_.WaitOnce(EVENT_LOGIN);
+    else
+    {
+        for (size_t i = 0; i < config_->front_hq_addresses.size(); i++)
+        {
+            // 每个 API 实例需要独立的流文件目录
+            std::string flow_path = 0 == i ? HQ_FLOW_PATH : fmt::format("{}{}/", HQ_FLOW_PATH, i);
+            if (!lueing::filesystem::FilesExists(flow_path))
+            {
+                lueing::filesystem::Mkdirs(flow_path);
+            }
+            fronts_.emplace_back(new CtpHqFront(*this, i, config_->front_hq_addresses[i]));
+        }
+        bool udp = "tcp" != config_->hq_transport;
+        bool multicast = "multicast" == config_->hq_transport;
+        for (auto &front : fronts_)
+        {
+            std::string flow_path = 0 == front->Index() ? HQ_FLOW_PATH : fmt::format("{}{}/", HQ_FLOW_PATH, front->Index());
+            CThostFtdcMdApi *api = api_factory_ ? api_factory_(flow_path.c_str(), udp, multicast)
+                                                : CThostFtdcMdApi::CreateFtdcMdApi(flow_path.c_str(), udp, multicast);
+            // => 触发 OnFrontConnected
+            front->Connect(api);
+        }
+        spdlog::info(fmt::format("[行情接口][连接中...] 传输方式: {}, 前置数: {}", config_->hq_transport, fronts_.size()));
+    }
+    // 任一前置登录成功即可开始订阅, 其余前置登录后自动补订
+    std::unique_lock<std::mutex> lock(login_lock_);
+    login_condition_.wait(lock, [this] { return logged_in_; });
 }
 
-lueing::CtpHqHandler::CtpHqHandler(CtpConfigPtr config) : config_(std::move(config))
+lueing::CtpHqHandler::CtpHqHandler(CtpConfigPtr config, MdApiFactory factory)
+    : config_(std::move(config)), api_factory_(std::move(factory)), events_(config_->max_instruments),
+      instruments_(config_->instruments),
+      market_data_(config_->max_instruments, config_->tick_history_ticks,
+                   static_cast<int64_t>(config_->tick_history_minutes) * 60 * 1000000000LL,
+                   config_->tick_history_memory_mb << 20), quotes_(config_->max_instruments),
+      bars_(config_->max_instruments, config_->bar_periods, config_->bar_capacity),
+      stats_(config_->max_instruments, config_->instruments),
+      dispatcher_(config_->max_instruments, config_->dispatch_threads, config_->dispatch_queue_capacity),
+      conflator_(config_->max_instruments, quotes_), multicast_(config_->instruments),
+      subscribe_status_(new std::atomic<int64_t>[config_->max_instruments]()),
+      guards_(new PublishGuard[config_->max_instruments])
 {
+    // 回放时不再重复记录行情
+    if (config_->journal_enabled && !config_->replay_enabled)
+    {
+        journal_ = std::make_unique<TickJournal>(config_->journal_directory, config_->journal_records_per_file,
+                                                 config_->journal_flush_interval_ms,
+                                                 config_->journal_overflow_capacity);
+    }
 }
 
 lueing::CtpHqHandler::~CtpHqHandler()
 {
-    if (nullptr != user_md_api_)
+    for (auto &front : fronts_)
     {
-        user_md_api_->Release();
-        user_md_api_ = nullptr;
+        if (nullptr != front->api_)
+        {
+            front->api_->Release();
+            front->api_ = nullptr;
+        }
     }
 }
 
-void lueing::CtpHqHandler::OnFrontConnected()
+int lueing::CtpHqHandler::SubscribeMarketData(char *instruments[], int count)
 {
-    ReqUserLogin();
+    int result = 0;
+    bool sent = false;
+    for (auto &front : fronts_)
+    {
+        if (!front->LoggedIn())
+        {
+            continue;
+        }
+        int code = front->Api()->SubscribeMarketData(instruments, count);
+        if (0 == code)
+        {
+            sent = true;
+        }
+        else
+        {
+            spdlog::warn(fmt::format("[行情接口][订阅行情] 前置 {} 请求失败，错误序号=[{}]", front->Address(), code));
+            result = code;
+        }
+    }
+    // 至少一个前置请求成功即视为成功; 全部未登录时等待登录后补订
+    return sent ? 0 : result;
 }
 
-void lueing::CtpHqHandler::OnFrontDisconnected(int nReason)
+int lueing::CtpHqHandler::UnSubscribeMarketData(char *instruments[], int count)
 {
-    spdlog::warn(fmt::format("[行情接口][断开...], 错误码: {}", nReason));
+    int result = 0;
+    bool sent = false;
+    for (auto &front : fronts_)
+    {
+        if (!front->LoggedIn())
+        {
+            continue;
+        }
+        int code = front->Api()->UnSubscribeMarketData(instruments, count);
+        if (0 == code)
+        {
+            sent = true;
+        }
+        else
+        {
+            result = code;
+        }
+    }
+    return sent ? 0 : result;
 }
 
-void lueing::CtpHqHandler::OnHeartBeatWarning(int nTimeLapse)
+std::vector<lueing::FrontSummary> lueing::CtpHqHandler::Fronts() const
 {
+    std::vector<FrontSummary> fronts;
+    for (const auto &front : fronts_)
+    {
+        fronts.push_back(front->Summary());
+    }
+    return fronts;
 }
 
-void lueing::CtpHqHandler::OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+void lueing::CtpHqHandler::OnLogin(CtpHqFront &front, CThostFtdcRspUserLoginField *pRspUserLogin,
+                                   CThostFtdcRspInfoField *pRspInfo)
 {
-    if (pRspInfo->ErrorID != 0)
+    if (nullptr != pRspInfo && pRspInfo->ErrorID != 0)
     {
-        spdlog::info(fmt::format("[行情接口][登录中...] 登录失败, 错误码: {}, 错误信息: {}", pRspInfo->ErrorID,
-                                 iconv_.GBK2UTF8(pRspInfo->ErrorMsg)));
-        exit(1);
+        spdlog::info(fmt::format("[行情接口][登录中...] 前置 {} 登录失败, 错误码: {}, 错误信息: {}", front.Address(),
+                                 pRspInfo->ErrorID, iconv_.GBK2UTF8(pRspInfo->ErrorMsg)));
+        front.login_failed_.store(true, std::memory_order_release);
+        // 全部前置都登录失败时无法继续, CreateHqContext 也不会再被唤醒
+        size_t failed = 0;
+        for (const auto &other : fronts_)
+        {
+            failed += other->login_failed_.load(std::memory_order_acquire) ? 1 : 0;
+        }
+        if (failed == fronts_.size())
+        {
+            spdlog::error(fmt::format("[行情接口][登录中...] 全部 {} 个前置登录失败", fronts_.size()));
+            exit(1);
+        }
+        return;
+    }
+    front.login_failed_.store(false, std::memory_order_release);
+    spdlog::info(fmt::format("[行情接口][登录中...] 前置 {} 登录成功, 交易日: {}", front.Address(),
+                             pRspUserLogin->TradingDay));
+    if (journal_)
+    {
+        journal_->Prepare(pRspUserLogin->TradingDay);
     }
-    spdlog::info(fmt::format("[行情接口][登录中...] 登录成功, 交易日: {}", pRspUserLogin->TradingDay));
+
+    // 补订已订阅的合约: 前置晚于其他前置登录, 或断线重连后
+    std::vector<char *> pending;
+    size_t size = instruments_->Size();
+    for (size_t i = 0; i < size && i < config_->max_instruments; i++)
+    {
+        SubscribeStatus status = GetSubscribeStatus(static_cast<InstrumentHandle>(i), nullptr);
+        if (SubscribeStatus::Pending == status || SubscribeStatus::Subscribed == status)
+        {
+            pending.push_back(const_cast<char *>(instruments_->Instrument(static_cast<InstrumentHandle>(i))));
+        }
+    }
+    front.logged_in_.store(true, std::memory_order_release);
+    if ("multicast" == config_->hq_transport)
+    {
+        front.ReqQryMulticastInstrument(config_->hq_multicast_topic);
+    }
+    for (size_t begin = 0; begin < pending.size(); begin += HQ_SUBSCRIBE_BATCH)
+    {
+        int count = static_cast<int>(std::min<size_t>(HQ_SUBSCRIBE_BATCH, pending.size() - begin));
+        front.Api()->SubscribeMarketData(pending.data() + begin, count);
+    }
+    if (!pending.empty())
+    {
+        spdlog::info(fmt::format("[行情接口][订阅行情] 前置 {} 补订合约数: {}", front.Address(), pending.size()));
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(login_lock_);
+        logged_in_ = true;
+    }
+    login_condition_.notify_all();
     events_.NotifyOnce(EVENT_LOGIN);
 }
 
-void lueing::CtpHqHandler::OnRspUserLogout(CThostFtdcUserLogoutField *pUserLogout, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+void lueing::CtpHqHandler::OnRspSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument,
+                                              CThostFtdcRspInfoField *pRspInfo)
 {
+    if (nullptr == pSpecificInstrument)
+    {
+        return;
+    }
+    InstrumentHandle handle = instruments_->Find(pSpecificInstrument->InstrumentID);
+    if (nullptr != pRspInfo && 0 != pRspInfo->ErrorID)
+    {
+        SetSubscribeStatus(handle, SubscribeStatus::Failed, pRspInfo->ErrorID);
+        spdlog::error(fmt::format("[行情接口][订阅行情] 合约: {} 订阅失败, 错误码: {}, 错误信息: {}",
+                                  pSpecificInstrument->InstrumentID, pRspInfo->ErrorID,
+                                  iconv_.GBK2UTF8(pRspInfo->ErrorMsg)));
+        return;
+    }
+    SetSubscribeStatus(handle, SubscribeStatus::Subscribed, 0);
 }
 
-void lueing::CtpHqHandler::OnRspQryMulticastInstrument(CThostFtdcMulticastInstrumentField *pMulticastInstrument, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+void lueing::CtpHqHandler::OnRspUnSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument,
+                                                CThostFtdcRspInfoField *pRspInfo)
 {
+    if (nullptr == pSpecificInstrument)
+    {
+        return;
+    }
+    InstrumentHandle handle = instruments_->Find(pSpecificInstrument->InstrumentID);
+    if (nullptr != pRspInfo && 0 != pRspInfo->ErrorID)
+    {
+        spdlog::error(fmt::format("[行情接口][取消订阅] 合约: {} 取消订阅失败, 错误码: {}, 错误信息: {}",
+                                  pSpecificInstrument->InstrumentID, pRspInfo->ErrorID,
+                                  iconv_.GBK2UTF8(pRspInfo->ErrorMsg)));
+        return;
+    }
+    SetSubscribeStatus(handle, SubscribeStatus::None, 0);
 }
 
-void lueing::CtpHqHandler::OnRspError(CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+void lueing::CtpHqHandler::ReleaseHistory(InstrumentHandle handle)
 {
+    if (handle >= config_->max_instruments)
+    {
+        return;
+    }
+    // 与回调线程的写入串行化
+    PublishGuard &guard = guards_[handle];
+    while (guard.busy.exchange(true, std::memory_order_acquire))
+    {
+    }
+    market_data_.Release(handle);
+    guard.busy.store(false, std::memory_order_release);
 }
 
-void lueing::CtpHqHandler::OnRspSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+bool lueing::CtpHqHandler::AddObserver(MarketDataObserver *observer)
 {
+    std::unique_lock<std::mutex> lock(observer_lock_);
+    for (auto &slot : observers_)
+    {
+        if (nullptr == slot.load(std::memory_order_relaxed))
+        {
+            slot.store(observer, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+void lueing::CtpHqHandler::RemoveObserver(MarketDataObserver *observer)
+{
+    std::unique_lock<std::mutex> lock(observer_lock_);
+    bool found = false;
+    for (auto &slot : observers_)
+    {
+        if (observer == slot.load(std::memory_order_relaxed))
+        {
+            slot.store(nullptr, std::memory_order_release);
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        return;
+    }
+    // 观察者只在发布锁内调用, 每个合约的发布锁空闲过一次后, 进行中的调用均已结束
+    for (size_t i = 0; i < config_->max_instruments; i++)
+    {
+        while (guards_[i].busy.load(std::memory_order_acquire))
+        {
+        }
+    }
 }
 
-void lueing::CtpHqHandler::OnRspUnSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+void lueing::CtpHqHandler::SetSubscribeStatus(InstrumentHandle handle, SubscribeStatus status, int error_id)
 {
+    if (handle >= config_->max_instruments)
+    {
+        return;
+    }
+    // 高 32 位为错误码, 低 32 位为状态
+    int64_t value = (static_cast<int64_t>(error_id) << 32) | static_cast<uint32_t>(status);
+    subscribe_status_[handle].store(value, std::memory_order_release);
 }
 
-void lueing::CtpHqHandler::OnRspSubForQuoteRsp(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+lueing::SubscribeStatus lueing::CtpHqHandler::GetSubscribeStatus(InstrumentHandle handle, int *error_id) const
 {
+    int64_t value = handle < config_->max_instruments ? subscribe_status_[handle].load(std::memory_order_acquire) : 0;
+    if (nullptr != error_id)
+    {
+        *error_id = static_cast<int>(value >> 32);
+    }
+    return static_cast<SubscribeStatus>(static_cast<uint32_t>(value));
 }
 
-void lueing::CtpHqHandler::OnRspUnSubForQuoteRsp(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+void lueing::CtpHqHandler::OnRtnDepthMarketData(CtpHqFront &front, CThostFtdcDepthMarketDataField *pDepthMarketData)
 {
+    if (nullptr == pDepthMarketData)
+    {
+        return;
+    }
+    // 先打本地时间戳, 再做其他处理
+    int64_t local_time = MonotonicNanos();
+    int64_t receive_time = WallClockNanos();
+    InstrumentHandle handle = instruments_->Find(pDepthMarketData->InstrumentID);
+    TickHistory *history = market_data_.At(handle);
+    if (nullptr == history)
+    {
+        return;
+    }
+    Tick tick;
+    ToTick(*pDepthMarketData, handle, local_time, tick);
+    front.received_.fetch_add(1, std::memory_order_relaxed);
+    if (0 != tick.exchange_time)
+    {
+        front.latency_.Record(receive_time - tick.exchange_time);
+    }
+
+    // 同一合约的发布串行化; 不同前置的回调线程只在同一合约上竞争
+    PublishGuard &guard = guards_[handle];
+    while (guard.busy.exchange(true, std::memory_order_acquire))
+    {
+    }
+    // 取消订阅时行情历史在发布锁内回收, 取得锁后再确认
+    if (market_data_.At(handle) != history)
+    {
+        guard.busy.store(false, std::memory_order_release);
+        return;
+    }
+    if (fronts_.size() > 1)
+    {
+        // 按 (UpdateTime.UpdateMillisec, Volume) 去重, 只发布最先到达的副本, 比已发布行情更早的也丢弃
+        if (tick.exchange_time < guard.exchange_time
+            || (tick.exchange_time == guard.exchange_time && tick.volume <= guard.volume))
+        {
+            if (tick.exchange_time == guard.exchange_time && tick.volume == guard.volume)
+            {
+                front.lag_.Record(local_time - guard.local_time);
+            }
+            guard.busy.store(false, std::memory_order_release);
+            return;
+        }
+    }
+    guard.exchange_time = tick.exchange_time;
+    guard.volume = tick.volume;
+    guard.local_time = local_time;
+    front.won_.fetch_add(1, std::memory_order_relaxed);
+
+    if (journal_)
+    {
+        // 行情日志只有一个写入位置, 多前置时跨合约加锁
+        while (journal_busy_.exchange(true, std::memory_order_acquire))
+        {
+        }
+        journal_->Append(*pDepthMarketData, receive_time);
+        journal_busy_.store(false, std::memory_order_release);
+    }
+    history->Push(tick);
+    quotes_.Publish(handle, tick);
+    bars_.Update(tick);
+    if (0 != tick.exchange_time)
+    {
+        stats_.Record(handle, receive_time - tick.exchange_time);
+    }
+    dispatcher_.Dispatch(tick);
+    conflator_.Mark(handle);
+    for (auto &slot : observers_)
+    {
+        MarketDataObserver *observer = slot.load(std::memory_order_acquire);
+        if (nullptr != observer)
+        {
+            observer->OnMarketData(*pDepthMarketData, tick);
+        }
+    }
+    guard.busy.store(false, std::memory_order_release);
+
+    // 行情带有交易所代码时补齐注册表, 用于按交易所汇总延迟; 每个合约只发生一次
+    if (0 != pDepthMarketData->ExchangeID[0] && 0 == instruments_->Exchange(handle)[0])
+    {
+        instruments_->Intern(pDepthMarketData->InstrumentID, pDepthMarketData->ExchangeID);
+    }
+    events_.Notify(handle);
 }
 
-void lueing::CtpHqHandler::OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *pDepthMarketData)
+void lueing::CtpHqHandler::OnRspQryMulticastInstrument(CtpHqFront &front,
+                                                       CThostFtdcMulticastInstrumentField *pMulticastInstrument,
+                                                       CThostFtdcRspInfoField *pRspInfo, bool bIsLast)
 {
-    if (pDepthMarketData)
+    if (nullptr != pRspInfo && 0 != pRspInfo->ErrorID)
     {
-        std::unique_lock<std::mutex> lock(market_data_lock_);
-        std::string instrument = pDepthMarketData->InstrumentID;
-        market_data_[instrument].push_back(*pDepthMarketData);
-        events_.Notify(instrument);
+        spdlog::error(fmt::format("[行情接口][组播合约] 前置 {} 查询失败, 错误码: {}, 错误信息: {}", front.Address(),
+                                  pRspInfo->ErrorID, iconv_.GBK2UTF8(pRspInfo->ErrorMsg)));
+        return;
+    }
+    if (nullptr != pMulticastInstrument && 0 != pMulticastInstrument->InstrumentID[0]
+        && !multicast_.Add(*pMulticastInstrument))
+    {
+        spdlog::warn(fmt::format("[行情接口][组播合约] 合约代码过长, 忽略: {}", pMulticastInstrument->InstrumentID));
+    }
+    if (bIsLast)
+    {
+        spdlog::info(fmt::format("[行情接口][组播合约] 前置 {} 查询完成, 组播合约数: {}", front.Address(),
+                                 multicast_.Size()));
     }
 }
 
-void lueing::CtpHqHandler::OnRtnForQuoteRsp(CThostFtdcForQuoteRspField *pForQuoteRsp)
+lueing::CtpHqFront::CtpHqFront(CtpHqHandler &handler, size_t index, std::string address)
+    : handler_(handler), index_(index), address_(std::move(address))
+{
+}
+
+lueing::CtpHqFront::~CtpHqFront() = default;
+
+void lueing::CtpHqFront::Connect(CThostFtdcMdApi *api)
 {
+    api_ = api;
+    api_->RegisterSpi(this);
+    api_->RegisterFront(const_cast<char *>(address_.c_str()));
+    api_->Init();
+}
+
+lueing::FrontSummary lueing::CtpHqFront::Summary() const
+{
+    FrontSummary summary;
+    summary.address = address_;
+    summary.logged_in = LoggedIn();
+    summary.received = received_.load(std::memory_order_relaxed);
+    summary.won = won_.load(std::memory_order_relaxed);
+    summary.win_rate = 0 == summary.received ? 0 : static_cast<double>(summary.won) / static_cast<double>(summary.received);
+    summary.latency = latency_.Summary();
+    summary.lag = lag_.Summary();
+    return summary;
+}
+
+void lueing::CtpHqFront::OnFrontConnected()
+{
+    ReqUserLogin();
+}
+
+void lueing::CtpHqFront::OnFrontDisconnected(int nReason)
+{
+    logged_in_.store(false, std::memory_order_release);
+    spdlog::warn(fmt::format("[行情接口][断开...] 前置: {}, 错误码: {}", address_, nReason));
+}
+
+void lueing::CtpHqFront::OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo,
+                                        int nRequestID, bool bIsLast)
+{
+    handler_.OnLogin(*this, pRspUserLogin, pRspInfo);
+}
+
+void lueing::CtpHqFront::OnRspSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument,
+                                            CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+{
+    handler_.OnRspSubMarketData(pSpecificInstrument, pRspInfo);
+}
+
+void lueing::CtpHqFront::OnRspUnSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument,
+                                              CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+{
+    handler_.OnRspUnSubMarketData(pSpecificInstrument, pRspInfo);
+}
+
+void lueing::CtpHqFront::OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *pDepthMarketData)
+{
+    handler_.OnRtnDepthMarketData(*this, pDepthMarketData);
+}
+
+void lueing::CtpHqFront::OnRspQryMulticastInstrument(CThostFtdcMulticastInstrumentField *pMulticastInstrument,
+                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
+{
+    handler_.OnRspQryMulticastInstrument(*this, pMulticastInstrument, pRspInfo, bIsLast);
+}
+
+void lueing::CtpHqFront::ReqQryMulticastInstrument(int topic_id)
+{
+    CThostFtdcQryMulticastInstrumentField request{};
+    request.TopicID = topic_id;
+    int result_code = api_->ReqQryMulticastInstrument(&request, handler_.config_->hq_request_id.fetch_add(1));
+    if (0 != result_code)
+    {
+        spdlog::warn(fmt::format("[行情接口][组播合约] 前置 {} 查询调用失败, 返回码: {}", address_, result_code));
+    }
 }
 
-void lueing::CtpHqHandler::ReqUserLogin()
+void lueing::CtpHqFront::ReqUserLogin()
 {
-    int result_code = user_md_api_->ReqUserLogin(&config_->m_userPrincipal, config_->hq_request_id.fetch_add(1));
+    int result_code = api_->ReqUserLogin(&handler_.config_->m_userPrincipal, handler_.config_->hq_request_id.fetch_add(1));
     if (0 == result_code)
     {
-        spdlog::info(fmt::format("[行情接口][登录中...] 登录调用成功!"));
+        spdlog::info(fmt::format("[行情接口][登录中...] 前置 {} 登录调用成功!", address_));
     }
     else
     {
-        spdlog::info(fmt::format("[行情接口][登录中...] 登录调用失败, 返回码: {}", result_code));
+        spdlog::info(fmt::format("[行情接口][登录中...] 前置 {} 登录调用失败, 返回码: {}", address_, result_code));
     }
 }
 
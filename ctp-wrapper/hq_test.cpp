@@ -1,9 +1,170 @@
 //
 // Created by crazy on 2025/2/19.
 //
+#include <cstring>
+#include <deque>
+#include <set>
+#include <thread>
 #include "gtest/gtest.h"
 #include "hq.h"
 
+namespace {
+    void WaitUntil(const std::function<bool()> &predicate)
+    {
+        for (int i = 0; i < 500 && !predicate(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    // 本地行情接口: 不连接前置, 在独立线程上按 CTP 的方式回调, 用于离线测试接收链路
+    class LocalMdApi final : public CThostFtdcMdApi {
+    public:
+        LocalMdApi(bool udp, bool multicast, bool fail_login = false, bool fail_subscribe = false)
+            : udp_(udp), multicast_(multicast), fail_login_(fail_login), fail_subscribe_(fail_subscribe)
+        {
+            worker_ = std::thread([this] { Run(); });
+        }
+
+        ~LocalMdApi()
+        {
+            {
+                std::unique_lock<std::mutex> lock(lock_);
+                running_ = false;
+            }
+            condition_.notify_all();
+            worker_.join();
+        }
+
+        void Release() override { delete this; }
+
+        void Init() override { Post([this] { spi_->OnFrontConnected(); }); }
+
+        int Join() override { return 0; }
+
+        const char *GetTradingDay() override { return "20250224"; }
+
+        void RegisterFront(char *pszFrontAddress) override {}
+
+        void RegisterNameServer(char *pszNsAddress) override {}
+
+        void RegisterFensUserInfo(CThostFtdcFensUserInfoField *pFensUserInfo) override {}
+
+        void RegisterSpi(CThostFtdcMdSpi *pSpi) override { spi_ = pSpi; }
+
+        int SubscribeMarketData(char *ppInstrumentID[], int nCount) override
+        {
+            if (fail_subscribe_)
+            {
+                return -2;
+            }
+            for (int i = 0; i < nCount; i++)
+            {
+                CThostFtdcSpecificInstrumentField field{};
+                strcpy(field.InstrumentID, ppInstrumentID[i]);
+                Post([this, field]() mutable { spi_->OnRspSubMarketData(&field, nullptr, 0, true); });
+            }
+            return 0;
+        }
+
+        int UnSubscribeMarketData(char *ppInstrumentID[], int nCount) override { return 0; }
+
+        int SubscribeForQuoteRsp(char *ppInstrumentID[], int nCount) override { return 0; }
+
+        int UnSubscribeForQuoteRsp(char *ppInstrumentID[], int nCount) override { return 0; }
+
+        int ReqUserLogin(CThostFtdcReqUserLoginField *pReqUserLoginField, int nRequestID) override
+        {
+            Post([this] {
+                CThostFtdcRspUserLoginField field{};
+                CThostFtdcRspInfoField info{};
+                strcpy(field.TradingDay, GetTradingDay());
+                if (fail_login_)
+                {
+                    info.ErrorID = 3;
+                    strcpy(info.ErrorMsg, "CTP:LoginError");
+                }
+                spi_->OnRspUserLogin(&field, &info, 0, true);
+            });
+            return 0;
+        }
+
+        int ReqUserLogout(CThostFtdcUserLogoutField *pUserLogout, int nRequestID) override { return 0; }
+
+        int ReqQryMulticastInstrument(CThostFtdcQryMulticastInstrumentField *pQryMulticastInstrument,
+                                      int nRequestID) override
+        {
+            int topic_id = pQryMulticastInstrument->TopicID;
+            Post([this, topic_id] {
+                const char *instruments[] = {"ag2504", "au2506"};
+                for (int i = 0; i < 2; i++)
+                {
+                    CThostFtdcMulticastInstrumentField field{};
+                    field.TopicID = topic_id;
+                    field.InstrumentNo = i + 1;
+                    strcpy(field.InstrumentID, instruments[i]);
+                    spi_->OnRspQryMulticastInstrument(&field, nullptr, 0, 1 == i);
+                }
+            });
+            return 0;
+        }
+
+    public:
+        void Push(const char *instrument, const char *time, int volume)
+        {
+            CThostFtdcDepthMarketDataField field{};
+            strcpy(field.TradingDay, GetTradingDay());
+            strcpy(field.ActionDay, GetTradingDay());
+            strcpy(field.InstrumentID, instrument);
+            strcpy(field.UpdateTime, time);
+            field.LastPrice = 100 + volume;
+            field.Volume = volume;
+            Post([this, field]() mutable { spi_->OnRtnDepthMarketData(&field); });
+        }
+
+        const bool udp_;
+        const bool multicast_;
+        const bool fail_login_;
+        const bool fail_subscribe_;
+
+    private:
+        void Post(std::function<void()> task)
+        {
+            {
+                std::unique_lock<std::mutex> lock(lock_);
+                tasks_.push_back(std::move(task));
+            }
+            condition_.notify_all();
+        }
+
+        void Run()
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            while (running_ || !tasks_.empty())
+            {
+                if (tasks_.empty())
+                {
+                    condition_.wait(lock);
+                    continue;
+                }
+                auto task = std::move(tasks_.front());
+                tasks_.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+        }
+
+    private:
+        CThostFtdcMdSpi *spi_ = nullptr;
+        std::mutex lock_;
+        std::condition_variable condition_;
+        std::deque<std::function<void()>> tasks_;
+        bool running_ = true;
+        std::thread worker_;
+    };
+}
+
 TEST(HQTest, main) {
     auto config = lueing::CreateCtpConfig("config-sample.yaml");
     lueing::CtpHq ctp(config);
@@ -14,11 +175,191 @@ TEST(HQTest, main) {
     {
         ctp.WaitForData("ag2504", "test01");
         auto &data = ctp.MarketData();
-        EXPECT_TRUE(!data.empty());
-        std::cout << "data.size is :" << data.size() << " price:" << data["ag2504"].front().LastPrice << std::endl;
+        EXPECT_TRUE(!data.Empty());
+        lueing::Tick tick{};
+        EXPECT_TRUE(ctp.Latest("ag2504", tick));
+        std::cout << "data.size is :" << data.At(tick.instrument)->Head() << " price:" << tick.last_price << std::endl;
     }
 }
 
+TEST(HQTest, batch_subscribe) {
+    auto config = lueing::CreateCtpConfig("config-sample.yaml");
+    lueing::CtpHq ctp(config);
+
+    EXPECT_EQ(ctp.SubscribeMarketData(std::vector<std::string>{"ag2504", "au2506", "cu2505"}, "test03"), 0);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    EXPECT_EQ(ctp.SubscriptionStatus("ag2504"), lueing::SubscribeStatus::Subscribed);
+    EXPECT_EQ(ctp.UnSubscribeMarketData(std::vector<std::string>{"ag2504", "au2506", "cu2505"}, "test03"), 0);
+}
+
+TEST(HQTest, tick_handler) {
+    auto config = lueing::CreateCtpConfig("config-sample.yaml");
+    lueing::CtpHq ctp(config);
+    std::atomic_int ticks{0};
+
+    auto id = ctp.AddTickHandler({"ag2504"}, "test02", [&ticks](const lueing::Tick &tick) {
+        std::cout << "tick price:" << tick.last_price << std::endl;
+        ticks++;
+    });
+    EXPECT_NE(id, INVALID_SUBSCRIBER);
+    while (ticks.load() < 10)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ctp.RemoveTickHandler(id);
+}
+
+TEST(HQTest, redundant_fronts) {
+    auto config = lueing::CreateCtpConfig("config-sample.yaml");
+    config->front_hq_addresses = {config->front_hq_address, config->front_hq_address};
+    lueing::CtpHq ctp(config);
+    std::atomic_int ticks{0};
+
+    // 记录发布出来的每一笔行情的时间戳
+    struct RecordingObserver : public lueing::MarketDataObserver {
+        std::mutex lock;
+        std::vector<std::string> updates;
+
+        void OnMarketData(const CThostFtdcDepthMarketDataField &field, const lueing::Tick &tick) override
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            updates.push_back(std::string(field.UpdateTime) + "." + std::to_string(field.UpdateMillisec));
+        }
+    } observer;
+    ASSERT_TRUE(ctp.AddObserver(&observer));
+    auto id = ctp.AddTickHandler({"ag2504"}, "test05", [&ticks](const lueing::Tick &tick) { ticks++; });
+    while (ticks.load() < 10)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ctp.RemoveObserver(&observer);
+    ctp.RemoveTickHandler(id);
+    for (const auto &front : ctp.Fronts())
+    {
+        std::cout << front.address << " received:" << front.received << " win rate:" << front.win_rate
+                  << " p50:" << front.latency.p50 << std::endl;
+    }
+    EXPECT_EQ(ctp.Fronts().size(), 2u);
+    // 两个会话收到相同的行情, 每笔恰好发布一次
+    std::set<std::string> unique(observer.updates.begin(), observer.updates.end());
+    EXPECT_EQ(unique.size(), observer.updates.size());
+    EXPECT_GE(observer.updates.size(), 10u);
+}
+
+TEST(HQTest, multicast_local_api) {
+    auto config = lueing::CreateCtpConfig("config-sample.yaml");
+    config->hq_transport = "multicast";
+    config->hq_multicast_topic = 1001;
+    LocalMdApi *api = nullptr;
+    lueing::CtpHq ctp(config, [&api](const char *flow_path, bool udp, bool multicast) {
+        api = new LocalMdApi(udp, multicast);
+        return api;
+    });
+    ASSERT_NE(api, nullptr);
+    EXPECT_TRUE(api->udp_);
+    EXPECT_TRUE(api->multicast_);
+
+    // 登录后查询组播合约, 未订阅的合约不占用注册表
+    WaitUntil([&] { return 2 == ctp.MulticastInstruments().Size(); });
+    ASSERT_EQ(ctp.MulticastInstruments().Size(), 2u);
+    EXPECT_EQ(ctp.Instruments().Find("au2506"), INVALID_INSTRUMENT);
+    EXPECT_EQ(ctp.MulticastInstruments().Find(1002, 2), INVALID_INSTRUMENT);
+
+    // 组播推送全部合约, 只保留已订阅的; 订阅后合约编号映射到本地句柄
+    EXPECT_EQ(ctp.SubscribeMarketData("ag2504", "test06"), 0);
+    EXPECT_EQ(ctp.MulticastInstruments().Find(1001, 1), ctp.Instruments().Find("ag2504"));
+    EXPECT_NE(ctp.MulticastInstruments().Find(1001, 1), INVALID_INSTRUMENT);
+    WaitUntil([&] { return lueing::SubscribeStatus::Subscribed == ctp.SubscriptionStatus("ag2504"); });
+    api->Push("au2506", "09:00:00", 1);
+    api->Push("ag2504", "09:00:00", 1);
+    lueing::Tick tick{};
+    WaitUntil([&] { return ctp.Latest("ag2504", tick); });
+    EXPECT_EQ(tick.volume, 1);
+    EXPECT_FALSE(ctp.Latest("au2506", tick));
+}
+
+TEST(HQTest, redundant_local_fronts) {
+    auto config = lueing::CreateCtpConfig("config-sample.yaml");
+    config->front_hq_addresses = {"tcp://front-a", "tcp://front-b"};
+    std::vector<LocalMdApi *> apis;
+    lueing::CtpHq ctp(config, [&apis](const char *flow_path, bool udp, bool multicast) {
+        apis.push_back(new LocalMdApi(udp, multicast));
+        return apis.back();
+    });
+    ASSERT_EQ(apis.size(), 2u);
+    EXPECT_FALSE(apis[0]->udp_);
+    WaitUntil([&] { return ctp.Fronts()[0].logged_in && ctp.Fronts()[1].logged_in; });
+
+    std::atomic_int ticks{0};
+    auto id = ctp.AddTickHandler({"ag2504"}, "test07", [&ticks](const lueing::Tick &tick) { ticks++; });
+    // 接收路径上的观察者同样只看到去重后的行情
+    struct CountingObserver : public lueing::MarketDataObserver {
+        std::atomic_int count{0};
+
+        void OnMarketData(const CThostFtdcDepthMarketDataField &field, const lueing::Tick &tick) override { count++; }
+    } observer;
+    ASSERT_TRUE(ctp.AddObserver(&observer));
+    // 同一笔行情从两个前置到达, 只发布一次; 较旧的行情不覆盖
+    apis[0]->Push("ag2504", "09:00:00", 1);
+    apis[1]->Push("ag2504", "09:00:00", 1);
+    apis[1]->Push("ag2504", "09:00:01", 2);
+    apis[0]->Push("ag2504", "09:00:01", 2);
+    apis[0]->Push("ag2504", "09:00:00", 1);
+    WaitUntil([&] { return ctp.Fronts()[0].received + ctp.Fronts()[1].received == 5; });
+    WaitUntil([&] { return 2 == ticks.load(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(ticks.load(), 2);
+    EXPECT_EQ(ctp.Fronts()[0].won + ctp.Fronts()[1].won, 2u);
+    EXPECT_EQ(observer.count.load(), 2);
+    ctp.RemoveObserver(&observer);
+    lueing::Tick tick{};
+    ASSERT_TRUE(ctp.Latest("ag2504", tick));
+    EXPECT_EQ(tick.volume, 2);
+    ctp.RemoveTickHandler(id);
+}
+
+TEST(HQTest, login_survives_one_failed_front) {
+    auto config = lueing::CreateCtpConfig("config-sample.yaml");
+    config->front_hq_addresses = {"tcp://front-a", "tcp://front-b"};
+    std::vector<LocalMdApi *> apis;
+    // 第一个前置登录失败, 另一个前置登录成功后即可使用
+    lueing::CtpHq ctp(config, [&apis](const char *flow_path, bool udp, bool multicast) {
+        apis.push_back(new LocalMdApi(udp, multicast, apis.empty()));
+        return apis.back();
+    });
+    WaitUntil([&] { return ctp.Fronts()[1].logged_in; });
+    EXPECT_FALSE(ctp.Fronts()[0].logged_in);
+    EXPECT_TRUE(ctp.Fronts()[1].logged_in);
+}
+
+TEST(HQTest, failed_subscribe_releases_history) {
+    auto config = lueing::CreateCtpConfig("config-sample.yaml");
+    LocalMdApi *api = nullptr;
+    lueing::CtpHq ctp(config, [&api](const char *flow_path, bool udp, bool multicast) {
+        api = new LocalMdApi(udp, multicast, false, true);
+        return api;
+    });
+    WaitUntil([&] { return ctp.Fronts()[0].logged_in; });
+    ASSERT_TRUE(ctp.Fronts()[0].logged_in);
+    // 请求未能发出时归还预分配的行情块, 合约不算已订阅
+    EXPECT_NE(ctp.SubscribeMarketData(std::vector<std::string>{"ag2504", "au2506"}, "test08"), 0);
+    EXPECT_EQ(ctp.MarketData().Size(), 0u);
+    EXPECT_EQ(ctp.MarketData().At(ctp.Instruments().Find("ag2504")), nullptr);
+    EXPECT_EQ(ctp.SubscriptionStatus("au2506"), lueing::SubscribeStatus::None);
+}
+
+TEST(HQDeathTest, all_fronts_fail_login) {
+    ::testing::GTEST_FLAG(death_test_style) = "threadsafe";
+    auto config = lueing::CreateCtpConfig("config-sample.yaml");
+    config->front_hq_addresses = {"tcp://front-a", "tcp://front-b"};
+    // 全部前置登录失败时退出, 不会一直等待登录
+    EXPECT_EXIT({
+        lueing::CtpHq ctp(config, [](const char *flow_path, bool udp, bool multicast) {
+            return new LocalMdApi(udp, multicast, true);
+        });
+    }, ::testing::ExitedWithCode(1), "");
+}
+
 TEST(HQTest, level1) {
     auto config = lueing::CreateCtpConfig("config-sample.yaml");
     std::vector<lueing::Quote> out_quotes;
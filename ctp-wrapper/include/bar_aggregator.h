@@ -0,0 +1,101 @@
+#ifndef LUEING_CTP_BAR_AGGREGATOR_H
+#define LUEING_CTP_BAR_AGGREGATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "instrument.h"
+#include "tick.h"
+#include "tick_ring.h"
+
+namespace lueing {
+    // K 线, 成交量与成交额为周期内的增量
+    struct Bar {
+        uint32_t instrument;            // 合约句柄
+        int32_t period;                 // 周期, 秒
+        int64_t begin_time;             // 起始时间, 交易所 epoch 纳秒, 按北京时间对齐
+        double open;
+        double high;
+        double low;
+        double close;
+        int64_t volume;
+        double turnover;
+        double open_interest;           // 周期内最后一笔行情的持仓量
+        int32_t ticks;                  // 参与聚合的行情条数
+    };
+
+    typedef TickRing<Bar> BarRing;
+
+    // 增量 K 线聚合, 挂在行情接收路径上, 每条行情 O(周期数) 更新
+    // 每个合约每个周期: 已完成的 K 线存放在环形缓冲区, 当前 K 线由顺序锁发布; 读线程均无锁
+    // CTP 的累计成交量/成交额在此转换为增量, 订阅后的首条行情只作为基准;
+    // 累计量回退 (新交易日、重连) 时按当日累计量重新计
+    // 时间取 Tick::exchange_time, 已修正夜盘 ActionDay; 只有带成交的行情才会开启新 K 线,
+    // 收盘后推送的无成交快照不会产生新 K 线
+    class BarAggregator {
+    private:
+        struct Series {
+            const int32_t period;
+            const int64_t period_ns;
+            BarRing history;
+            // 当前 K 线的顺序锁, 偶数: 稳定; 奇数: 正在写入; 0: 尚无 K 线
+            std::atomic<uint64_t> sequence{0};
+            Bar current{};
+            // 仅写线程访问
+            Bar building{};
+
+            Series(int32_t period, size_t capacity)
+                : period(period), period_ns(static_cast<int64_t>(period) * 1000000000LL), history(capacity) {}
+        };
+
+        struct Book {
+            // 仅写线程访问, 上一条行情的累计量
+            bool seeded = false;
+            int32_t last_volume = 0;
+            double last_turnover = 0;
+            std::vector<std::unique_ptr<Series>> series;
+        };
+
+    public:
+        // periods 为周期秒数, capacity 为每个周期保留的已完成 K 线条数
+        BarAggregator(size_t max_instruments, std::vector<int32_t> periods, size_t capacity);
+
+        ~BarAggregator();
+
+    public:
+        // 为合约分配 K 线存储, 在订阅时调用 (调用方负责串行化); 句柄越界时返回 false
+        bool Reserve(InstrumentHandle handle);
+
+        // 聚合一条行情, 仅限 CTP 回调线程调用; 未分配存储的合约直接忽略
+        void Update(const Tick &tick);
+
+        // 读取当前 (未完成) 的 K 线, 尚无 K 线时返回 false
+        bool Current(InstrumentHandle handle, int32_t period, Bar &out) const;
+
+        // 读取最近 count 根已完成的 K 线, 按时间升序追加到 out, 返回读到的条数
+        size_t Last(InstrumentHandle handle, int32_t period, size_t count, std::vector<Bar> &out) const;
+
+        // 已完成的 K 线条数
+        uint64_t Completed(InstrumentHandle handle, int32_t period) const;
+
+        const std::vector<int32_t> &Periods() const { return periods_; }
+
+        // K 线起始时间: 按北京时间将 time 向下对齐到周期
+        static int64_t BeginTime(int64_t time, int64_t period_ns);
+
+    private:
+        const Series *Find(InstrumentHandle handle, int32_t period) const;
+
+        static void Publish(Series &series);
+
+    private:
+        const size_t max_instruments_;
+        const std::vector<int32_t> periods_;
+        const size_t capacity_;
+        std::unique_ptr<std::atomic<Book *>[]> books_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_BAR_AGGREGATOR_H
@@ -0,0 +1,124 @@
+#ifndef LUEING_CTP_BOUNDED_QUEUE_H
+#define LUEING_CTP_BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace lueing {
+    // 定长无锁多生产者多消费者队列 (Vyukov), 入队出队均不分配内存、不阻塞, 满时 TryPush 返回 false
+    template<typename T>
+    class BoundedQueue {
+        static_assert(std::is_trivially_copyable<T>::value, "BoundedQueue requires trivially copyable elements");
+
+    private:
+        struct Cell {
+            std::atomic<uint64_t> sequence;
+            T value;
+        };
+
+    public:
+        explicit BoundedQueue(size_t capacity) : capacity_(RoundUp(capacity)), mask_(capacity_ - 1),
+                                                 cells_(new Cell[capacity_])
+        {
+            for (size_t i = 0; i < capacity_; i++)
+            {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        BoundedQueue(const BoundedQueue &) = delete;
+
+        BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    public:
+        size_t Capacity() const { return capacity_; }
+
+        bool TryPush(const T &value)
+        {
+            uint64_t position = tail_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell &cell = cells_[position & mask_];
+                uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+                if (0 == diff)
+                {
+                    if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        cell.value = value;
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = tail_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool TryPop(T &out)
+        {
+            uint64_t position = head_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell &cell = cells_[position & mask_];
+                uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(position + 1);
+                if (0 == diff)
+                {
+                    if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        out = cell.value;
+                        cell.sequence.store(position + capacity_, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = head_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // 近似长度, 仅用于统计
+        size_t Size() const
+        {
+            uint64_t tail = tail_.load(std::memory_order_relaxed);
+            uint64_t head = head_.load(std::memory_order_relaxed);
+            return tail > head ? static_cast<size_t>(tail - head) : 0;
+        }
+
+        bool Empty() const { return 0 == Size(); }
+
+    private:
+        static size_t RoundUp(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            return size;
+        }
+
+    private:
+        const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+        alignas(64) std::atomic<uint64_t> tail_{0};
+        alignas(64) std::atomic<uint64_t> head_{0};
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_BOUNDED_QUEUE_H
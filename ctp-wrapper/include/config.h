@@ -6,6 +6,7 @@
 #include <memory>
 #include <vector>
 #include "ThostFtdcUserApiStruct.h"
+#include "instrument.h"
 
 namespace lueing
 {
@@ -14,16 +15,65 @@ namespace lueing
         CThostFtdcReqAuthenticateField m_clientPrincipal;
         CThostFtdcReqUserLoginField m_userPrincipal;
         std::string front_hq_address;
+        // 行情前置列表, 多个前置同时接收, 同一笔行情只发布最先到达的副本; 默认只有 front_hq_address
+        std::vector<std::string> front_hq_addresses;
+        // 行情传输方式: tcp / udp / multicast, 对应 CreateFtdcMdApi 的 bIsUsingUdp/bIsMulticast
+        std::string hq_transport;
+        // 组播模式下查询组播合约的主题号, 0 为全部主题
+        int hq_multicast_topic;
         std::string front_trade_address;
         std::atomic_int32_t hq_request_id;
         std::atomic_int32_t tx_request_id;
 
         std::vector<std::string> level1_hq_services;
         int fake_x;
+        // 模拟交易时报单、撤单到达撮合的延迟 (微秒)
+        int fake_latency_us;
         float stop_loss;
         float stop_profit;
         int amt;
         int x_times;
+        // 单个合约单个方向的最大持仓 (含在途开仓), 0 为不限
+        int max_position;
+        // 报单价格偏离最新价的最大百分比, 0 为不检查
+        double max_deviation;
+
+        // 交易请求流控: 报单 (含撤单) 与查询的每秒请求数, 0 为不限速
+        double order_rate;
+        int order_burst;
+        double query_rate;
+
+        // 行情存储
+        size_t max_instruments;
+        // 每个合约至少保留的最近行情条数
+        size_t tick_history_ticks;
+        // 只保留最近若干分钟的行情, 0 为不限
+        int tick_history_minutes;
+        // 行情历史的内存上限 (MB), 0 为按 max_instruments * tick_history_ticks 计
+        size_t tick_history_memory_mb;
+        size_t dispatch_threads;
+        size_t dispatch_queue_capacity;
+        std::vector<int32_t> bar_periods;
+        size_t bar_capacity;
+
+        // 行情日志
+        bool journal_enabled;
+        std::string journal_directory;
+        size_t journal_records_per_file;
+        int journal_flush_interval_ms;
+        size_t journal_overflow_capacity;
+
+        // 行情回放, 启用时以行情日志代替 CTP 行情前置
+        bool replay_enabled;
+        std::string replay_directory;
+        std::string replay_trading_day;
+        double replay_speed;
+
+        // 合约主数据缓存目录, 每个交易日一个文件
+        std::string instrument_cache_directory;
+
+        // 行情与交易共享的合约注册表
+        InstrumentRegistryPtr instruments;
     };
     typedef struct CtpConfig CtpConfig;
     typedef std::shared_ptr<CtpConfig> CtpConfigPtr;
@@ -0,0 +1,98 @@
+#ifndef LUEING_CTP_CONFLATOR_H
+#define LUEING_CTP_CONFLATOR_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "dispatcher.h"
+#include "instrument.h"
+#include "quote_table.h"
+#include "tick.h"
+
+namespace lueing {
+    // 合并模式的行情读取: 慢速订阅者 (界面、风控看板) 每次读取只拿到各合约自上次读取以来的最新行情
+    // 每个订阅者一个脏合约集合: 标志位 + 待读合约队列, 每个合约在队列中至多出现一次, 队列不会溢出
+    // Mark 在 CTP 回调线程调用, 对每个订阅者只做一次原子交换, 合约已在集合中时不再入队;
+    // 行情本身从 QuoteTable 读取, 慢速订阅者读多少都不会增加接收路径的开销
+    class TickConflator {
+    private:
+        struct Reader {
+            SubscriberId id;
+            std::unique_ptr<std::atomic_bool[]> dirty;
+            // 各合约上次读到的行情版本, 仅读线程访问
+            std::unique_ptr<uint64_t[]> seen;
+            BoundedQueue<InstrumentHandle> pending;
+            std::atomic_bool active{true};
+            std::atomic<uint64_t> conflated{0};
+
+            Reader(SubscriberId id, size_t max_instruments, size_t handles)
+                : id(id), dirty(new std::atomic_bool[max_instruments]()), seen(new uint64_t[max_instruments]()),
+                  pending(handles) {}
+        };
+
+        typedef std::vector<Reader *> ReaderList;
+
+    public:
+        TickConflator(size_t max_instruments, const QuoteTable &quotes);
+
+        ~TickConflator();
+
+    public:
+        // 注册合并模式的订阅者, 返回订阅者序号
+        SubscriberId Register(const std::vector<InstrumentHandle> &handles);
+
+        // 注销订阅者, 之后 Poll 不再返回行情
+        void Unregister(SubscriberId id);
+
+        // 标记合约有新行情, 仅限 CTP 回调线程调用, 须在 QuoteTable::Publish 之后
+        void Mark(InstrumentHandle handle)
+        {
+            if (handle >= max_instruments_)
+            {
+                return;
+            }
+            const ReaderList *routes = routes_[handle].load(std::memory_order_acquire);
+            if (nullptr == routes)
+            {
+                return;
+            }
+            for (Reader *reader : *routes)
+            {
+                if (reader->dirty[handle].exchange(true, std::memory_order_acq_rel))
+                {
+                    reader->conflated.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    reader->pending.TryPush(handle);
+                }
+            }
+        }
+
+        // 读取自上次读取以来有更新的合约的最新行情, 追加到 out, 最多 max 条, 返回读到的条数
+        // 同一版本的行情只返回一次: 行情先于标记发布, 上次读取可能已读到本次标记对应的行情
+        // 同一订阅者同一时刻只能有一个线程读取
+        size_t Poll(SubscriberId id, std::vector<Tick> &out, size_t max = SIZE_MAX);
+
+        // 被合并 (跳过) 的行情条数
+        uint64_t Conflated(SubscriberId id) const;
+
+    private:
+        void Publish(InstrumentHandle handle, ReaderList *routes);
+
+    private:
+        const size_t max_instruments_;
+        const QuoteTable &quotes_;
+        // 每个合约的订阅者列表, 写时复制, 旧列表与已注销的订阅者在析构时释放
+        std::unique_ptr<std::atomic<ReaderList *>[]> routes_;
+        std::vector<std::unique_ptr<ReaderList>> retired_routes_;
+        std::vector<std::unique_ptr<Reader>> readers_;
+        std::vector<std::vector<InstrumentHandle>> reader_handles_;
+        mutable std::mutex lock_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_CONFLATOR_H
@@ -0,0 +1,112 @@
+#ifndef LUEING_CTP_DISPATCHER_H
+#define LUEING_CTP_DISPATCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "instrument.h"
+#include "latency.h"
+#include "tick.h"
+
+namespace lueing {
+#define INVALID_SUBSCRIBER 0xFFFFFFFFu
+
+    typedef uint32_t SubscriberId;
+    typedef std::function<void(const Tick &)> TickCallback;
+
+    // 行情处理对象, 与 TickCallback 二选一
+    class TickHandler {
+    public:
+        virtual ~TickHandler() = default;
+
+        virtual void OnTick(const Tick &tick) = 0;
+    };
+
+    // 行情推送分发: 订阅者按合约注册回调, 每个订阅者一个无锁队列, 由固定的分发线程回调
+    // Dispatch 在 CTP 回调线程调用, 只投递给订阅了该合约的订阅者, 不加锁、不分配内存、不阻塞
+    // 订阅者队列满时丢弃并计数, 不会拖慢行情接收
+    class TickDispatcher {
+    private:
+        struct Subscriber {
+            SubscriberId id;
+            size_t worker;
+            TickCallback callback;
+            BoundedQueue<Tick> queue;
+            std::atomic_bool active{true};
+            std::atomic<uint64_t> delivered{0};
+            std::atomic<uint64_t> dropped{0};
+            // CTP 回调线程收到行情到分发线程回调之间的延迟
+            LatencyHistogram handoff;
+
+            Subscriber(SubscriberId id, size_t worker, TickCallback callback, size_t queue_capacity)
+                : id(id), worker(worker), callback(std::move(callback)), queue(queue_capacity) {}
+        };
+
+        typedef std::vector<Subscriber *> SubscriberList;
+
+        struct Worker {
+            std::thread thread;
+            std::mutex lock;
+            // 分发期间持有, Unregister 借此等待正在执行的回调结束
+            std::mutex drain_lock;
+            std::condition_variable condition;
+            std::atomic_bool sleeping{false};
+            bool signaled = false;
+            SubscriberList subscribers;
+        };
+
+    public:
+        TickDispatcher(size_t max_instruments, size_t workers, size_t queue_capacity);
+
+        ~TickDispatcher();
+
+    public:
+        // 注册订阅者, 返回订阅者序号
+        SubscriberId Register(const std::vector<InstrumentHandle> &handles, TickCallback callback);
+
+        SubscriberId Register(const std::vector<InstrumentHandle> &handles, TickHandler *handler);
+
+        // 注销订阅者, 返回时该订阅者的回调均已结束, 且不会再被调用; 不可在其自身回调中调用
+        void Unregister(SubscriberId id);
+
+        // 投递行情, 仅限 CTP 回调线程调用
+        void Dispatch(const Tick &tick);
+
+        // 订阅者统计: 已回调次数与因队列满丢弃的次数
+        uint64_t Delivered(SubscriberId id) const;
+
+        uint64_t Dropped(SubscriberId id) const;
+
+        // 订阅者的交接延迟 (Tick::local_time 到回调开始), id 为 INVALID_SUBSCRIBER 时汇总全部订阅者
+        LatencySummary HandoffLatency(SubscriberId id) const;
+
+    private:
+        void Run(Worker &worker);
+
+        bool Drain(const SubscriberList &subscribers);
+
+        void Wake(Worker &worker);
+
+        void Publish(InstrumentHandle handle, SubscriberList *routes);
+
+    private:
+        const size_t max_instruments_;
+        const size_t queue_capacity_;
+        std::vector<std::unique_ptr<Worker>> workers_;
+        // 每个合约的订阅者列表, 写时复制, 旧列表与已注销的订阅者在析构时释放
+        std::unique_ptr<std::atomic<SubscriberList *>[]> routes_;
+        std::vector<std::unique_ptr<SubscriberList>> retired_routes_;
+        std::vector<std::unique_ptr<Subscriber>> subscribers_;
+        std::vector<std::vector<InstrumentHandle>> subscriber_handles_;
+        std::atomic_bool running_{true};
+        mutable std::mutex lock_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_DISPATCHER_H
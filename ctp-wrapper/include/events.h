@@ -2,22 +2,30 @@
 #define LUEING_DATA_PROVIDER_CTP_EVENTS_H
 
 #include <string>
+#include <vector>
 #include <absl/container/node_hash_map.h>
 #include <absl/container/node_hash_set.h>
 #include <mutex>
 #include <condition_variable>
+#include "instrument.h"
 
 namespace lueing {
     #define EVENT_LOGIN "event_login"
+    // 未指定时可等待的合约句柄上限, 与 max_instruments 的默认值一致
+    #define EVENTS_MAX_HANDLES 1024
 
     class Events
     {
     private:
         absl::node_hash_map<std::string, absl::node_hash_set<std::string>> event_waiters_;
+        // 按合约句柄的通知代数与等待者数量, 行情路径不构造字符串
+        std::vector<uint64_t> generations_;
+        std::vector<uint32_t> waiting_;
+        const size_t max_handles_;
         std::mutex lock_;
         std::condition_variable condition_lock_;
     public:
-        Events(/* args */);
+        explicit Events(size_t max_handles = EVENTS_MAX_HANDLES);
         ~Events();
 
     public:
@@ -26,6 +34,10 @@ namespace lueing {
 
         void Wait(const std::string& event_name, const std::string& wait_id);
         void Notify(const std::string& event_name);
+
+        // 等待指定合约的下一次通知; 无效句柄 (INVALID_INSTRUMENT 或超出上限) 立即返回 false
+        bool Wait(InstrumentHandle handle);
+        void Notify(InstrumentHandle handle);
     };    
 } // namespace lueing
 
@@ -0,0 +1,176 @@
+#ifndef LUEING_CTP_GOVERNOR_H
+#define LUEING_CTP_GOVERNOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "latency.h"
+#include "tick.h"
+
+namespace lueing {
+    // Req* 的流控返回值: 未处理请求超过许可数、每秒发送请求数超过许可数
+#define GOVERNOR_THROTTLED_PENDING -2
+#define GOVERNOR_THROTTLED_RATE -3
+    // 被流控的请求最多重试的次数, 超过后按失败处理
+#define GOVERNOR_MAX_RETRIES 10
+    // 不限速的类别被流控时的退避时间 (纳秒)
+#define GOVERNOR_RETRY_NANOS (100 * 1000 * 1000LL)
+    // Admit 的结果: 须排队; 流控已停止
+#define GOVERNOR_QUEUE 1
+#define GOVERNOR_STOPPED (-1)
+
+    // 请求类别, 数值越小优先级越高
+    enum class RequestClass : uint32_t {
+        Order = 0,      // 报单、撤单
+        Query = 1,      // 查询
+    };
+
+#define GOVERNOR_CLASSES 2
+
+    // 发送请求, 返回 Req* 的返回值
+    typedef std::function<int()> RequestSender;
+    // 请求最终未能发出, 参数为最后一次 Req* 的返回值
+    typedef std::function<void(int)> RequestFailure;
+
+    // 单个类别的流控统计, 等待时间为提交到发出, 单位纳秒
+    struct GovernorStats {
+        size_t depth;           // 排队中的请求数
+        uint64_t sent;          // 已发出
+        uint64_t throttled;     // 被柜台流控后重试的次数
+        uint64_t failed;        // 最终失败
+        LatencySummary wait;
+    };
+
+    // 令牌桶: 每秒补充 rate 个令牌, 最多积累 burst 个; rate 为 0 时不限速; 调用方负责串行化
+    class TokenBucket {
+    public:
+        TokenBucket(double rate, double burst);
+
+    public:
+        // 距离下一个令牌可用的纳秒数, 0 为已可用
+        int64_t Wait(int64_t now);
+
+        // 取走一个令牌, 须在 Wait 返回 0 后调用
+        void Take()
+        {
+            if (rate_ > 0)
+            {
+                tokens_ -= 1;
+            }
+        }
+
+        // 被柜台流控: 清空令牌并暂停到 until
+        void Block(int64_t until);
+
+        double Rate() const { return rate_; }
+
+    private:
+        const double rate_;
+        const double burst_;
+        double tokens_;
+        int64_t refilled_ = 0;
+        int64_t blocked_until_ = 0;
+    };
+
+    // 交易请求的统一出口: 报单与查询各用一个令牌桶限速, 报单、撤单总是先于查询发出
+    // 队列为空、没有正在发送或等待重试的请求且有令牌时在调用线程直接发送, 不增加报单路径的延迟;
+    // 否则排队由流控线程按速率发出, 同一类别的请求严格按提交顺序发出 (撤单不会越过正在发送的报单)
+    // 直接发送时不把 send 装入 RequestSender, 只有排队或重试时才分配内存
+    // Req* 返回 -2/-3 (柜台流控) 时放回队首, 按速率退避后重试; 其他非 0 返回值调用 failure
+    // failure 在发送线程上调用 (停止时丢弃的请求在调用 Stop 的线程上), 不持有内部锁
+    class RequestGovernor {
+    private:
+        struct Pending {
+            RequestSender send;
+            RequestFailure failure;
+            int64_t submit_time;
+            int retries;
+        };
+
+        struct Lane {
+            TokenBucket bucket;
+            std::deque<Pending> queue;
+            // 已取出、正在发送的请求数, 不为 0 时新请求排队
+            size_t in_flight = 0;
+            std::atomic<uint64_t> sent{0};
+            std::atomic<uint64_t> throttled{0};
+            std::atomic<uint64_t> failed{0};
+            LatencyHistogram wait;
+
+            Lane(double rate, double burst) : bucket(rate, burst) {}
+        };
+
+    public:
+        // order_rate / query_rate 为每秒请求数, 0 为不限速; burst 为允许的瞬时突发数
+        RequestGovernor(double order_rate, double order_burst, double query_rate);
+
+        ~RequestGovernor();
+
+    public:
+        // 提交请求; 返回 0 表示已发出或已排队, 其他为直接发送时 Req* 的失败返回值 (不再调用 failure)
+        // send 为返回 int 的可调用对象, failure 为 RequestFailure 或可转换为它的可调用对象
+        template<typename Sender, typename Failure = std::nullptr_t>
+        int Submit(RequestClass request_class, Sender send, Failure failure = nullptr)
+        {
+            auto index = static_cast<size_t>(request_class);
+            int64_t now = MonotonicNanos();
+            int admitted = Admit(index, now);
+            if (GOVERNOR_QUEUE == admitted)
+            {
+                return Enqueue(index,
+                               Pending{RequestSender(std::move(send)), RequestFailure(std::move(failure)), now, 0});
+            }
+            if (0 != admitted)
+            {
+                return admitted;
+            }
+            int result = send();
+            if (GOVERNOR_THROTTLED_PENDING == result || GOVERNOR_THROTTLED_RATE == result)
+            {
+                Pending pending{RequestSender(std::move(send)), RequestFailure(std::move(failure)), now, 0};
+                Complete(lanes_[index], pending, result);
+                return 0;
+            }
+            Sent(index, now, result);
+            return result;
+        }
+
+        // 停止流控线程, 排队中的请求不再发出, 以 GOVERNOR_STOPPED 调用其 failure; 须在释放交易接口前调用
+        void Stop();
+
+        GovernorStats Stats(RequestClass request_class) const;
+
+    private:
+        // 可以在调用线程直接发送时占用令牌并计入在途, 返回 0; 须排队时返回 GOVERNOR_QUEUE; 已停止时返回 GOVERNOR_STOPPED
+        int Admit(size_t index, int64_t now);
+
+        // 放入队尾, 已停止时返回 GOVERNOR_STOPPED
+        int Enqueue(size_t index, Pending pending);
+
+        // 直接发送完成 (未被流控): 释放在途并计数
+        void Sent(size_t index, int64_t submit_time, int result);
+
+        void Run();
+
+        // 请求发出后的处理: 释放在途, 成功计数, 被流控时放回队首, 其他失败调用 failure; 调用方不持有锁
+        void Complete(Lane &lane, Pending &pending, int result);
+
+        // 可以立即发送的类别: 本类别有在途请求或高优先级类别有排队时不可发送; 调用方持有锁
+        bool Ready(size_t index, int64_t now, int64_t &wait);
+
+    private:
+        Lane lanes_[GOVERNOR_CLASSES];
+        mutable std::mutex lock_;
+        std::condition_variable condition_;
+        bool running_ = true;
+        std::thread worker_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_GOVERNOR_H
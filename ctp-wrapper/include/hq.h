@@ -2,86 +2,229 @@
 #define LUEING_DATA_CTP_HQ_H
 
 #include "config.h"
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "ThostFtdcMdApi.h"
 #include "events.h"
 #include "lueing_iconv.h"
+#include "bar_aggregator.h"
+#include "conflator.h"
+#include "dispatcher.h"
+#include "journal.h"
+#include "latency.h"
+#include "multicast.h"
+#include "quote_table.h"
+#include "replay.h"
+#include "tick_store.h"
 
 namespace lueing {
-    class CtpHqHandler : public CThostFtdcMdSpi {
-    public:
-        void CreateHqContext();
+    // 单次订阅/取消订阅请求的最大合约数
+#define HQ_SUBSCRIBE_BATCH 500
+    // 行情接收路径上的观察者数上限
+#define HQ_MAX_OBSERVERS 8
+
+    // 合约订阅状态, 由 OnRspSubMarketData/OnRspUnSubMarketData 更新
+    enum class SubscribeStatus : uint32_t {
+        None = 0,       // 未订阅
+        Pending = 1,    // 已发送请求, 等待响应
+        Subscribed = 2, // 订阅成功
+        Failed = 3,     // 订阅失败, 见错误码
+    };
 
-        Events &GetEvents() { return events_; }
+    class CtpHqHandler;
 
-        CThostFtdcMdApi *GetUserMdApi() { return user_md_api_; }
+    // 创建行情 API 实例, 参数与 CThostFtdcMdApi::CreateFtdcMdApi 相同; 测试时可替换为本地实现
+    typedef std::function<CThostFtdcMdApi *(const char *flow_path, bool udp, bool multicast)> MdApiFactory;
 
-        absl::node_hash_map<std::string, std::vector<CThostFtdcDepthMarketDataField>> &
-        MarketData() { return market_data_; }
+    // 行情前置会话统计
+    struct FrontSummary {
+        std::string address;
+        bool logged_in;
+        uint64_t received;              // 收到的行情条数
+        uint64_t won;                   // 率先到达并被发布的条数
+        double win_rate;
+        LatencySummary latency;         // 交易所时间到本地接收
+        LatencySummary lag;             // 重复行情落后于率先到达副本的时间
+    };
 
-        std::mutex &MarketDataLock() { return market_data_lock_; }
+    // 单个行情前置的会话, 每个前置一个 CThostFtdcMdApi 实例, 回调转交给 CtpHqHandler
+    class CtpHqFront : public CThostFtdcMdSpi {
+    public:
+        CtpHqFront(CtpHqHandler &handler, size_t index, std::string address);
+
+        ~CtpHqFront();
 
     public:
-        explicit CtpHqHandler(CtpConfigPtr config);
-        ~CtpHqHandler();
+        // 注册回调与前置地址并启动会话
+        void Connect(CThostFtdcMdApi *api);
+
+        CThostFtdcMdApi *Api() { return api_; }
+
+        size_t Index() const { return index_; }
+
+        const std::string &Address() const { return address_; }
+
+        bool LoggedIn() const { return logged_in_.load(std::memory_order_acquire); }
+
+        FrontSummary Summary() const;
 
     public:
         void OnFrontConnected() override;
 
         void OnFrontDisconnected(int nReason) override;
 
-        void OnHeartBeatWarning(int nTimeLapse) override;
-
         void OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                       bool bIsLast) override;
+                            bool bIsLast) override;
 
-        void OnRspUserLogout(CThostFtdcUserLogoutField *pUserLogout, CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                        bool bIsLast) override;
+        void OnRspSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo,
+                                int nRequestID, bool bIsLast) override;
+
+        void OnRspUnSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument,
+                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) override;
+
+        void OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *pDepthMarketData) override;
 
         void OnRspQryMulticastInstrument(CThostFtdcMulticastInstrumentField *pMulticastInstrument,
-                                                 CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                 bool bIsLast) override;
+                                         CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) override;
 
-        void OnRspError(CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) override;
+    private:
+        void ReqUserLogin();
 
-        void OnRspSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo,
-                           int nRequestID, bool bIsLast) override;
+        void ReqQryMulticastInstrument(int topic_id);
 
-        void OnRspUnSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo,
-                             int nRequestID, bool bIsLast) override;
+    private:
+        friend class CtpHqHandler;
+
+        CtpHqHandler &handler_;
+        const size_t index_;
+        const std::string address_;
+        CThostFtdcMdApi *api_ = nullptr;
+        std::atomic_bool logged_in_{false};
+        // 最近一次登录失败, 登录成功后清除
+        std::atomic_bool login_failed_{false};
+        std::atomic<uint64_t> received_{0};
+        std::atomic<uint64_t> won_{0};
+        LatencyHistogram latency_;
+        LatencyHistogram lag_;
+    };
 
-        void OnRspSubForQuoteRsp(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo,
-                            int nRequestID, bool bIsLast) override;
+    // 行情接收与发布: 可同时连接多个行情前置, 同一笔行情只发布最先到达的副本
+    class CtpHqHandler {
+    private:
+        // 按合约串行化发布, 并记录已发布的最新行情用于多前置去重
+        struct alignas(64) PublishGuard {
+            std::atomic_bool busy{false};
+            int32_t volume = 0;
+            int64_t exchange_time = 0;
+            int64_t local_time = 0;
+        };
 
-        void OnRspUnSubForQuoteRsp(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo,
-                              int nRequestID, bool bIsLast) override;
+    public:
+        void CreateHqContext();
 
-        void OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *pDepthMarketData) override;
+        Events &GetEvents() { return events_; }
 
-        void OnRtnForQuoteRsp(CThostFtdcForQuoteRspField *pForQuoteRsp) override;
+        TickStore &MarketData() { return market_data_; }
 
-    private:
-        void ReqUserLogin();
+        QuoteTable &Quotes() { return quotes_; }
+
+        BarAggregator &Bars() { return bars_; }
+
+        MarketDataStats &Stats() { return stats_; }
+
+        TickDispatcher &Dispatcher() { return dispatcher_; }
+
+        TickConflator &Conflator() { return conflator_; }
+
+        MulticastInstrumentTable &Multicast() { return multicast_; }
+
+        // 向所有已登录的前置发送订阅请求; 未登录的前置在登录后自动补订
+        int SubscribeMarketData(char *instruments[], int count);
+
+        int UnSubscribeMarketData(char *instruments[], int count);
+
+        // 各行情前置的统计
+        std::vector<FrontSummary> Fronts() const;
+
+        // 取消订阅后归还合约的行情块
+        void ReleaseHistory(InstrumentHandle handle);
+
+        // 注册行情接收路径上的观察者, 已满时返回 false
+        bool AddObserver(MarketDataObserver *observer);
+
+        // 注销观察者, 返回时该观察者已不在执行, 也不会再被调用
+        void RemoveObserver(MarketDataObserver *observer);
+
+        void SetSubscribeStatus(InstrumentHandle handle, SubscribeStatus status, int error_id);
+
+        SubscribeStatus GetSubscribeStatus(InstrumentHandle handle, int *error_id) const;
+
+    public:
+        // factory 为空时使用 CThostFtdcMdApi::CreateFtdcMdApi
+        explicit CtpHqHandler(CtpConfigPtr config, MdApiFactory factory = nullptr);
+        ~CtpHqHandler();
+
+    public:
+        // 以下由 CtpHqFront 在各前置的回调线程调用
+        void OnLogin(CtpHqFront &front, CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo);
+
+        void OnRspSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument, CThostFtdcRspInfoField *pRspInfo);
+
+        void OnRspUnSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument,
+                                  CThostFtdcRspInfoField *pRspInfo);
+
+        void OnRtnDepthMarketData(CtpHqFront &front, CThostFtdcDepthMarketDataField *pDepthMarketData);
+
+        void OnRspQryMulticastInstrument(CtpHqFront &front, CThostFtdcMulticastInstrumentField *pMulticastInstrument,
+                                         CThostFtdcRspInfoField *pRspInfo, bool bIsLast);
 
     private:
-        CThostFtdcMdApi *user_md_api_ = nullptr;
+        friend class CtpHqFront;
+
         CtpConfigPtr config_;
+        MdApiFactory api_factory_;
         Events events_;
         LueingIconv iconv_;
-        absl::node_hash_map<std::string, std::vector<CThostFtdcDepthMarketDataField>> market_data_;
-        std::mutex market_data_lock_;
+        InstrumentRegistryPtr instruments_;
+        TickStore market_data_;
+        QuoteTable quotes_;
+        BarAggregator bars_;
+        MarketDataStats stats_;
+        TickDispatcher dispatcher_;
+        TickConflator conflator_;
+        MulticastInstrumentTable multicast_;
+        std::unique_ptr<std::atomic<int64_t>[]> subscribe_status_;
+        TickJournalPtr journal_;
+        std::vector<std::unique_ptr<CtpHqFront>> fronts_;
+        std::unique_ptr<PublishGuard[]> guards_;
+        // 在发布锁内调用, 注销时逐个经过发布锁即可确认没有进行中的调用
+        std::atomic<MarketDataObserver *> observers_[HQ_MAX_OBSERVERS]{};
+        std::mutex observer_lock_;
+        // 多前置时行情日志的写入锁
+        std::atomic_bool journal_busy_{false};
+        std::mutex login_lock_;
+        std::condition_variable login_condition_;
+        bool logged_in_ = false;
     };
 
     class CtpHq {
     private:
         std::mutex lock_;
         CtpHqHandler hq_handler_;
-        absl::node_hash_map<std::string, absl::node_hash_set<std::string>> instruments_booked_;
+        InstrumentRegistryPtr instruments_;
+        // 以合约句柄为下标的订阅者集合
+        std::vector<absl::node_hash_set<std::string>> instruments_booked_;
+        // 行情回调注册信息, 注销时用于取消订阅
+        absl::node_hash_map<SubscriberId, std::pair<std::string, std::vector<std::string>>> tick_handlers_;
+        // 合并模式订阅者的注册信息
+        absl::node_hash_map<SubscriberId, std::pair<std::string, std::vector<std::string>>> conflated_readers_;
 
     public:
-        explicit CtpHq(CtpConfigPtr config);
+        explicit CtpHq(CtpConfigPtr config, MdApiFactory factory = nullptr);
 
         ~CtpHq();
 
@@ -92,13 +235,74 @@ namespace lueing {
         // 取消订阅行情
         int UnSubscribeMarketData(const std::string &instrument, const std::string &subscriber);
 
-        // 等待数据
+        // 批量订阅行情, 只为尚未订阅的合约发送请求, 每批最多 HQ_SUBSCRIBE_BATCH 个
+        int SubscribeMarketData(const std::vector<std::string> &instruments, const std::string &subscriber);
+
+        // 批量取消订阅, 只为最后一位订阅者发送请求
+        int UnSubscribeMarketData(const std::vector<std::string> &instruments, const std::string &subscriber);
+
+        // 合约订阅状态, error_id 非空时写入订阅失败的错误码
+        SubscribeStatus SubscriptionStatus(const std::string &instrument, int *error_id = nullptr);
+
+        // 等待数据 (每次行情都需重新查询, 建议改用 AddTickHandler)
         void WaitForData(const std::string &instrument, const std::string &subscriber);
 
-        // 市场数据
-        absl::node_hash_map<std::string, std::vector<CThostFtdcDepthMarketDataField>> &
-        MarketData() { return hq_handler_.MarketData(); };
-        std::mutex &MarketDataLock() { return hq_handler_.MarketDataLock(); }
+        // 订阅行情并注册回调, 新行情在分发线程上推送给回调; 失败时返回 INVALID_SUBSCRIBER
+        SubscriberId AddTickHandler(const std::vector<std::string> &instruments, const std::string &subscriber,
+                                    TickCallback callback);
+
+        SubscriberId AddTickHandler(const std::vector<std::string> &instruments, const std::string &subscriber,
+                                    TickHandler *handler);
+
+        // 注销回调并取消订阅, 返回时回调已不再执行
+        void RemoveTickHandler(SubscriberId id);
+
+        // 订阅行情并注册合并模式的读取者, 适用于跟不上逐笔行情的慢速订阅者; 失败时返回 INVALID_SUBSCRIBER
+        SubscriberId AddConflatedReader(const std::vector<std::string> &instruments, const std::string &subscriber);
+
+        // 读取自上次读取以来有更新的合约的最新行情 (每个合约一条), 追加到 out, 返回条数; 不阻塞
+        size_t PollConflated(SubscriberId id, std::vector<Tick> &out, size_t max = SIZE_MAX)
+        {
+            return hq_handler_.Conflator().Poll(id, out, max);
+        }
+
+        // 注销合并模式的读取者并取消订阅
+        void RemoveConflatedReader(SubscriberId id);
+
+        // 市场数据, 按合约句柄无锁读取
+        TickStore &MarketData() { return hq_handler_.MarketData(); };
+
+        // 最新行情快照, 无锁读取
+        QuoteTable &Quotes() { return hq_handler_.Quotes(); }
+
+        // 读取合约最新行情, 尚无行情时返回 false
+        bool Latest(const std::string &instrument, Tick &out) { return Quotes().Read(instruments_->Find(instrument), out); }
+
+        // K 线, 随行情增量聚合, 按合约句柄无锁读取
+        BarAggregator &Bars() { return hq_handler_.Bars(); }
+
+        // 行情延迟统计: 交易所时间到本地接收, 可按合约或交易所查询
+        MarketDataStats &Stats() { return hq_handler_.Stats(); }
+
+        // 行情回调的交接延迟, id 为 INVALID_SUBSCRIBER 时汇总全部回调
+        LatencySummary HandoffLatency(SubscriberId id = INVALID_SUBSCRIBER)
+        {
+            return hq_handler_.Dispatcher().HandoffLatency(id);
+        }
+
+        // 各行情前置的统计: 胜出率与延迟
+        std::vector<FrontSummary> Fronts() const { return hq_handler_.Fronts(); }
+
+        // 组播合约表, 传输方式为 multicast 时在登录后查询填充
+        MulticastInstrumentTable &MulticastInstruments() { return hq_handler_.Multicast(); }
+
+        // 合约注册表, 用于合约代码与句柄互查
+        InstrumentRegistry &Instruments() { return *instruments_; }
+
+        // 在行情接收线程上同步处理每笔已订阅合约的行情, 如风控价格缓存、止损止盈
+        bool AddObserver(MarketDataObserver *observer) { return hq_handler_.AddObserver(observer); }
+
+        void RemoveObserver(MarketDataObserver *observer) { hq_handler_.RemoveObserver(observer); }
     };
 
     typedef std::shared_ptr<CtpHq> CtpHqPtr;
@@ -0,0 +1,81 @@
+#ifndef LUEING_CTP_INSTRUMENT_H
+#define LUEING_CTP_INSTRUMENT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "ThostFtdcUserApiDataType.h"
+
+namespace lueing {
+#define INVALID_INSTRUMENT 0xFFFFFFFFu
+
+    typedef uint32_t InstrumentHandle;
+
+    // 合约注册表: 将 InstrumentID 映射为从 0 开始的连续整数句柄
+    // Intern 在订阅、下单预热等冷路径调用; Find 无锁, 供回调线程使用
+    // 合约代码补零打包为 4 个 64 位字, 查找时按字比较, 不构造 std::string
+    class InstrumentRegistry {
+    private:
+        struct Key {
+            uint64_t words[4];
+        };
+
+        struct Bucket {
+            Key key{};
+            std::atomic<InstrumentHandle> handle{INVALID_INSTRUMENT};
+        };
+
+        struct Entry {
+            TThostFtdcInstrumentIDType instrument;
+            TThostFtdcExchangeIDType exchange;
+        };
+
+    public:
+        explicit InstrumentRegistry(size_t capacity);
+
+        ~InstrumentRegistry();
+
+    public:
+        // 注册合约, 已存在时返回原句柄 (并在交易所为空时补齐); 容量已满或代码过长时返回 INVALID_INSTRUMENT
+        InstrumentHandle Intern(const std::string &instrument, const std::string &exchange = "");
+
+        // 查找合约句柄, 未注册时返回 INVALID_INSTRUMENT
+        InstrumentHandle Find(const char *instrument) const;
+
+        InstrumentHandle Find(const std::string &instrument) const { return Find(instrument.c_str()); }
+
+        const char *Instrument(InstrumentHandle handle) const
+        {
+            return handle < Size() ? entries_[handle].instrument : "";
+        }
+
+        const char *Exchange(InstrumentHandle handle) const
+        {
+            return handle < Size() ? entries_[handle].exchange : "";
+        }
+
+        size_t Size() const { return size_.load(std::memory_order_acquire); }
+
+        size_t Capacity() const { return capacity_; }
+
+    private:
+        static bool Pack(const char *instrument, Key &key);
+
+        static size_t Hash(const Key &key);
+
+    private:
+        const size_t capacity_;
+        size_t mask_;
+        std::unique_ptr<Bucket[]> buckets_;
+        std::unique_ptr<Entry[]> entries_;
+        std::atomic<size_t> size_{0};
+        std::mutex lock_;
+    };
+
+    typedef std::shared_ptr<InstrumentRegistry> InstrumentRegistryPtr;
+} // namespace lueing
+
+#endif // LUEING_CTP_INSTRUMENT_H
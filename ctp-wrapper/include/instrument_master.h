@@ -0,0 +1,118 @@
+#ifndef LUEING_CTP_INSTRUMENT_MASTER_H
+#define LUEING_CTP_INSTRUMENT_MASTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "ThostFtdcUserApiStruct.h"
+#include "instrument.h"
+
+namespace lueing {
+#define INSTRUMENT_MASTER_MAGIC 0x4D534E49u
+#define INSTRUMENT_MASTER_VERSION 1u
+
+    // 合约静态数据文件头, 文件按交易日命名: instruments-<TradingDay>.bin
+    struct InstrumentMasterHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t count;
+        char trading_day[16];
+        char reserved[32];
+    };
+
+    static_assert(sizeof(InstrumentMasterHeader) == 64, "InstrumentMasterHeader should be one cache line");
+
+    // 定长合约静态数据, 文件中按合约代码排序, 映射后直接使用
+    struct InstrumentInfo {
+        char instrument[32];
+        char exchange[16];
+        char product[32];
+        char expire_date[16];           // 到期日 YYYYMMDD
+        double price_tick;              // 最小变动价位
+        int32_t volume_multiple;        // 合约乘数
+        int32_t max_limit_order_volume; // 限价单最大下单量
+        int32_t min_limit_order_volume; // 限价单最小下单量
+        char product_class;             // 产品类型, THOST_FTDC_PC_*
+        char is_trading;                // 当前是否交易
+        char reserved[10];
+    };
+
+    static_assert(sizeof(InstrumentInfo) == 128, "InstrumentInfo should span exactly two cache lines");
+
+    // 合约主数据: 每个交易日只查询一次全部合约 (ReqQryInstrument), 写成按交易日命名的定长二进制文件,
+    // 之后重启时直接内存映射, 无需解析与再次查询
+    // 按合约代码的查找为二分查找; 按合约句柄的查找首次解析后缓存, 之后为一次原子读取, 可在报单路径上调用
+    // 不向 InstrumentRegistry 注册合约, 全市场合约不会占用行情与报单的句柄容量
+    // Load、Update 在冷路径调用 (调用方负责串行化); 查询可在任意线程, 替换后的旧数据保留到析构
+    class InstrumentMaster {
+    private:
+        struct Snapshot {
+            boost::interprocess::file_mapping file;
+            boost::interprocess::mapped_region region;
+            std::vector<InstrumentInfo> owned;      // 文件写入失败时保存在内存中
+            const InstrumentInfo *records = nullptr;
+            size_t count = 0;
+            std::string trading_day;
+        };
+
+    public:
+        InstrumentMaster(InstrumentRegistryPtr instruments, std::string directory);
+
+        ~InstrumentMaster();
+
+    public:
+        // 映射交易日的缓存文件, 文件不存在或格式不符时返回 false
+        bool Load(const std::string &trading_day);
+
+        // 以查询结果替换合约数据并写入缓存文件, 返回是否写入成功 (失败时仍在内存中生效)
+        bool Update(const std::string &trading_day, const std::vector<CThostFtdcInstrumentField> &rows);
+
+        const InstrumentInfo *Find(InstrumentHandle handle) const;
+
+        const InstrumentInfo *Find(const char *instrument) const;
+
+        // 合约所属交易所, 未知合约返回空串
+        const char *Exchange(const char *instrument) const
+        {
+            const InstrumentInfo *info = Find(instrument);
+            return nullptr != info ? info->exchange : "";
+        }
+
+        // 按最小变动价位取整: 买入向下、卖出向上, 不会比给定价格更差; 未知合约原样返回
+        double RoundPrice(InstrumentHandle handle, char direction, double price) const;
+
+        // 已加载的交易日, 尚未加载时为空串
+        std::string TradingDay() const;
+
+        size_t Size() const;
+
+        static std::string Path(const std::string &directory, const std::string &trading_day);
+
+    private:
+        static InstrumentInfo Convert(const CThostFtdcInstrumentField &row);
+
+        // 在指定数据中按合约代码二分查找, 未找到返回 nullptr
+        static const InstrumentInfo *Lookup(const Snapshot *snapshot, const char *instrument);
+
+        // 发布新数据并清空句柄缓存; 调用方持有锁
+        void Publish(std::unique_ptr<Snapshot> snapshot);
+
+    private:
+        InstrumentRegistryPtr instruments_;
+        const std::string directory_;
+        std::unique_ptr<std::atomic<const InstrumentInfo *>[]> by_handle_;
+        std::atomic<const Snapshot *> current_{nullptr};
+        std::vector<std::unique_ptr<Snapshot>> snapshots_;
+        mutable std::mutex lock_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_INSTRUMENT_MASTER_H
@@ -0,0 +1,145 @@
+#ifndef LUEING_CTP_JOURNAL_H
+#define LUEING_CTP_JOURNAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "ThostFtdcUserApiStruct.h"
+#include "bounded_queue.h"
+
+namespace lueing {
+#define JOURNAL_MAGIC 0x4C4E524Au
+#define JOURNAL_VERSION 1u
+
+    // 行情日志文件头, 文件按交易日与分片号命名: md-<TradingDay>-<part>.jnl
+    struct JournalHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t part;
+        uint64_t capacity;              // 预分配的记录条数
+        std::atomic<uint64_t> count;    // 已写入的记录条数
+        char trading_day[16];
+        char reserved[16];
+    };
+
+    static_assert(sizeof(JournalHeader) == 64, "JournalHeader should be one cache line");
+
+    // 定长行情记录, 保留 CTP 原始结构以便回放
+    struct JournalRecord {
+        int64_t receive_time;           // 本地接收时间, epoch 纳秒
+        CThostFtdcDepthMarketDataField field;
+    };
+
+    // 按交易日预分配的内存映射行情日志
+    // Append 在 CTP 回调线程调用, 只做内存拷贝, 无系统调用; 后台线程负责 msync、预读与换文件
+    // 换文件期间的行情暂存在内存队列中, 新文件就绪后按序补写
+    class TickJournal {
+    private:
+        struct Segment {
+            boost::interprocess::file_mapping file;
+            boost::interprocess::mapped_region region;
+            JournalHeader *header = nullptr;
+            JournalRecord *records = nullptr;
+            uint64_t flushed = 0;
+        };
+
+    public:
+        TickJournal(std::string directory, size_t records_per_file, int flush_interval_ms, size_t overflow_capacity);
+
+        ~TickJournal();
+
+    public:
+        // 预先打开交易日的日志文件, 登录成功后调用; 非回调线程
+        void Prepare(const std::string &trading_day);
+
+        // 追加一条行情, 仅限单个写线程调用
+        void Append(const CThostFtdcDepthMarketDataField &field, int64_t receive_time);
+
+        // 已写入文件的记录数 (当前文件)
+        uint64_t Count() const;
+
+        // 因暂存队列满而丢弃的记录数
+        uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+        // 日志文件路径
+        static std::string Path(const std::string &directory, const std::string &trading_day, uint32_t part);
+
+    private:
+        void Run();
+
+        // 打开或创建交易日的最新分片, full 为 true 时创建下一个分片
+        Segment *OpenSegment(const std::string &trading_day, bool full);
+
+        void Flush(Segment *segment, bool sync);
+
+        void Rollover(const JournalRecord &record);
+
+        // 写线程切换到新文件
+        void Adopt(Segment *segment);
+
+    private:
+        const std::string directory_;
+        const size_t records_per_file_;
+        const int flush_interval_ms_;
+
+        // 仅写线程访问
+        Segment *current_ = nullptr;
+        bool rollover_pending_ = false;
+        // 后台线程 -> 写线程: 新文件就绪
+        std::atomic<Segment *> next_{nullptr};
+        // 写线程 -> 后台线程: 需要换文件, 目标交易日写在 requested_day_
+        std::atomic_bool rollover_requested_{false};
+        char requested_day_[sizeof(JournalHeader::trading_day)] = {};
+        bool requested_full_ = false;
+        // 写线程 -> 后台线程: 已弃用的文件, 等待刷盘后释放
+        std::atomic<Segment *> retired_{nullptr};
+        BoundedQueue<JournalRecord> overflow_;
+        std::atomic<uint64_t> dropped_{0};
+
+        // 后台线程持有全部文件映射
+        std::vector<std::unique_ptr<Segment>> segments_;
+        std::atomic<Segment *> newest_{nullptr};
+        std::mutex lock_;
+        std::condition_variable condition_;
+        std::atomic_bool running_{true};
+        std::thread worker_;
+    };
+
+    typedef std::unique_ptr<TickJournal> TickJournalPtr;
+
+    // 只读打开行情日志文件
+    class JournalReader {
+    public:
+        explicit JournalReader(const std::string &path);
+
+    public:
+        bool Valid() const { return nullptr != header_; }
+
+        uint64_t Count() const { return Valid() ? header_->count.load(std::memory_order_acquire) : 0; }
+
+        const char *TradingDay() const { return Valid() ? header_->trading_day : ""; }
+
+        const JournalRecord &At(uint64_t index) const { return records_[index]; }
+
+        // 交易日的全部日志文件, 按分片顺序排列
+        static std::vector<std::string> Files(const std::string &directory, const std::string &trading_day);
+
+    private:
+        boost::interprocess::file_mapping file_;
+        boost::interprocess::mapped_region region_;
+        const JournalHeader *header_ = nullptr;
+        const JournalRecord *records_ = nullptr;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_JOURNAL_H
@@ -0,0 +1,152 @@
+#ifndef LUEING_CTP_LATENCY_H
+#define LUEING_CTP_LATENCY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "instrument.h"
+
+namespace lueing {
+    // 延迟统计摘要, 单位纳秒
+    struct LatencySummary {
+        uint64_t count;
+        int64_t min;
+        int64_t max;
+        double mean;
+        int64_t p50;
+        int64_t p90;
+        int64_t p99;
+        int64_t p999;
+    };
+
+    // HDR 风格的对数线性直方图: 每个 2 的幂区间再均分为 32 个子桶, 相对误差约 3%
+    // Record 无锁、无内存分配, 可多线程并发记录; 负值记为 0, 超过上限 (约 68 秒) 的记入最后一个桶
+    class LatencyHistogram {
+    public:
+        static constexpr int kSubBucketBits = 5;
+        static constexpr int kSubBuckets = 1 << kSubBucketBits;
+        static constexpr int kMaxBits = 36;
+        static constexpr int kBuckets = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+    public:
+        LatencyHistogram();
+
+    public:
+        void Record(int64_t nanos)
+        {
+            uint64_t value = nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+            counts_[Index(value)].fetch_add(1, std::memory_order_relaxed);
+            total_.fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(value, std::memory_order_relaxed);
+            uint64_t min = min_.load(std::memory_order_relaxed);
+            while (value < min && !min_.compare_exchange_weak(min, value, std::memory_order_relaxed))
+            {
+            }
+            uint64_t max = max_.load(std::memory_order_relaxed);
+            while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        uint64_t Count() const { return total_.load(std::memory_order_relaxed); }
+
+        // 将另一个直方图累加到本直方图, 用于按交易所或订阅者汇总
+        void Merge(const LatencyHistogram &other);
+
+        // 第 percentile (0~100) 百分位的延迟
+        int64_t Percentile(double percentile) const;
+
+        LatencySummary Summary() const;
+
+        void Reset();
+
+    public:
+        static int Index(uint64_t value)
+        {
+            if (value < static_cast<uint64_t>(kSubBuckets))
+            {
+                return static_cast<int>(value);
+            }
+            int bits = HighestBit(value);
+            if (bits >= kMaxBits)
+            {
+                return kBuckets - 1;
+            }
+            int shift = bits - kSubBucketBits;
+            return (shift + 1) * kSubBuckets + static_cast<int>((value >> shift) & (kSubBuckets - 1));
+        }
+
+        // 桶的代表值 (区间中点)
+        static int64_t Value(int index);
+
+    private:
+        static int HighestBit(uint64_t value)
+        {
+#if defined(_MSC_VER)
+            unsigned long bit;
+            _BitScanReverse64(&bit, value);
+            return static_cast<int>(bit);
+#else
+            return 63 - __builtin_clzll(value);
+#endif
+        }
+
+    private:
+        std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+        std::atomic<uint64_t> total_{0};
+        std::atomic<uint64_t> sum_{0};
+        std::atomic<uint64_t> min_{UINT64_MAX};
+        std::atomic<uint64_t> max_{0};
+    };
+
+    // 行情延迟统计: 交易所时间 (UpdateTime.UpdateMillisec) 到本地接收的系统时钟差, 按合约记录
+    // 按交易所的统计在查询时由合约直方图汇总, 接收路径上不做交易所查找
+    // Reserve 在订阅时调用 (调用方负责串行化), Record 仅限 CTP 回调线程调用, 查询可在任意线程
+    class MarketDataStats {
+    public:
+        MarketDataStats(size_t max_instruments, InstrumentRegistryPtr instruments);
+
+        ~MarketDataStats();
+
+    public:
+        bool Reserve(InstrumentHandle handle);
+
+        void Record(InstrumentHandle handle, int64_t exchange_latency)
+        {
+            LatencyHistogram *histogram = handle < max_instruments_
+                                          ? histograms_[handle].load(std::memory_order_acquire) : nullptr;
+            if (nullptr != histogram)
+            {
+                histogram->Record(exchange_latency);
+            }
+        }
+
+        // 单个合约的行情延迟
+        LatencySummary Instrument(InstrumentHandle handle) const;
+
+        // 单个交易所的行情延迟, 交易所代码为空时汇总尚未关联交易所的合约
+        LatencySummary Exchange(const std::string &exchange) const;
+
+        // 全部交易所的行情延迟
+        std::vector<std::pair<std::string, LatencySummary>> Exchanges() const;
+
+        // 全部合约的行情延迟
+        LatencySummary Total() const;
+
+        void Reset();
+
+    private:
+        const size_t max_instruments_;
+        InstrumentRegistryPtr instruments_;
+        std::unique_ptr<std::atomic<LatencyHistogram *>[]> histograms_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_LATENCY_H
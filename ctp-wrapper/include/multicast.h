@@ -0,0 +1,69 @@
+#ifndef LUEING_CTP_MULTICAST_H
+#define LUEING_CTP_MULTICAST_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "ThostFtdcUserApiStruct.h"
+#include "instrument.h"
+
+namespace lueing {
+    // 组播合约信息, 由 ReqQryMulticastInstrument 查询得到
+    struct MulticastInstrument {
+        int32_t topic_id;               // 主题号
+        int32_t instrument_no;          // 组播报文中的合约编号
+        InstrumentHandle handle;        // 本地合约句柄, 合约尚未登记 (无人订阅) 时为 INVALID_INSTRUMENT
+        TThostFtdcInstrumentIDType instrument;
+        double code_price;              // 基准价
+        int32_t volume_multiple;
+        double price_tick;
+    };
+
+    // 组播合约表: (主题号, 合约编号) 与本地合约句柄互查
+    // 组播行情由 CTP 接口解码后仍按合约代码回调, 此表用于核对行情覆盖范围与读取组播合约参数
+    // 主题 0 的查询结果是全市场合约, 因此按合约编号保存, 不向 InstrumentRegistry 登记;
+    // 句柄在查找时按合约代码解析, 合约订阅 (登记) 之后即可查到
+    // 在查询响应时写入, 读写均在冷路径, 加锁
+    class MulticastInstrumentTable {
+    public:
+        explicit MulticastInstrumentTable(InstrumentRegistryPtr instruments);
+
+        ~MulticastInstrumentTable();
+
+    public:
+        // 加入一条查询结果, 合约代码为空或过长时返回 false
+        bool Add(const CThostFtdcMulticastInstrumentField &field);
+
+        // 按主题号与合约编号查找合约句柄, 未知或合约尚未登记时返回 INVALID_INSTRUMENT
+        InstrumentHandle Find(int32_t topic_id, int32_t instrument_no) const;
+
+        // 读取已登记合约的组播信息, 不在组播合约表中时返回 false
+        bool Info(InstrumentHandle handle, MulticastInstrument &out) const;
+
+        // 主题下已登记合约的句柄, topic_id 为 0 时返回全部
+        std::vector<InstrumentHandle> Handles(int32_t topic_id = 0) const;
+
+        // 组播合约总数, 包括尚未登记的合约
+        size_t Size() const;
+
+        // 重新查询前清空
+        void Clear();
+
+    private:
+        static uint64_t Key(int32_t topic_id, int32_t instrument_no)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(topic_id)) << 32) | static_cast<uint32_t>(instrument_no);
+        }
+
+    private:
+        InstrumentRegistryPtr instruments_;
+        mutable std::mutex lock_;
+        absl::flat_hash_map<uint64_t, MulticastInstrument> rows_;
+        absl::flat_hash_map<std::string, uint64_t> keys_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_MULTICAST_H
@@ -0,0 +1,234 @@
+#ifndef LUEING_CTP_ORDER_H
+#define LUEING_CTP_ORDER_H
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "ThostFtdcUserApiStruct.h"
+#include "instrument.h"
+
+// 保留的已终止报单数, 更早的终止报单被移出跟踪表, 不能再查询进度
+#define ORDER_TRACKER_KEEP_FINISHED 4096
+// 暂存的早到成交的 OrderSysID 数上限, 超出时丢弃最早暂存的成交
+#define ORDER_TRACKER_MAX_EARLY_TRADES 1024
+
+namespace lueing {
+    // 报单状态
+    enum class OrderStatus : uint32_t {
+        Sent = 0,               // 已发送, 尚无回报
+        Accepted = 1,           // 已报入, 未成交
+        PartiallyFilled = 2,    // 部分成交
+        Filled = 3,             // 全部成交
+        Cancelled = 4,          // 已撤单 (可能部分成交)
+        Rejected = 5,           // 被柜台或交易所拒绝
+    };
+
+    // 是否为终止状态
+    inline bool IsFinal(OrderStatus status)
+    {
+        return OrderStatus::Filled == status || OrderStatus::Cancelled == status || OrderStatus::Rejected == status;
+    }
+
+    // 报单的唯一标识: OrderRef 只在会话内唯一, 需与 FrontID、SessionID 一起使用
+    struct OrderKey {
+        int32_t front_id;
+        int32_t session_id;
+        int32_t order_ref;
+
+        bool operator==(const OrderKey &other) const
+        {
+            return front_id == other.front_id && session_id == other.session_id && order_ref == other.order_ref;
+        }
+
+        template<typename H>
+        friend H AbslHashValue(H h, const OrderKey &key)
+        {
+            return H::combine(std::move(h), key.front_id, key.session_id, key.order_ref);
+        }
+    };
+
+    // 报单进度, 每次状态变化或成交时推送
+    struct OrderReport {
+        int32_t order_ref;
+        InstrumentHandle instrument;
+        OrderStatus status;
+        char direction;                 // 买卖方向, THOST_FTDC_D_*
+        char offset;                    // 开平标志, THOST_FTDC_OF_*
+        int32_t volume;                 // 报单数量
+        int32_t filled;                 // 累计成交数量
+        double average_price;           // 成交均价, 尚无成交时为 0
+        int32_t error_id;               // 拒单或最近一次撤单失败的错误码
+        std::string error;              // 拒单或最近一次撤单失败的原因 (UTF-8)
+    };
+
+    typedef std::function<void(const OrderReport &)> OrderCallback;
+
+    // 异步报单的凭据, done 在报单进入终止状态时就绪
+    struct OrderTicket {
+        int32_t order_ref;
+        std::shared_future<OrderReport> done;
+    };
+
+    // 撤单目标: 报入交易所后可按 (ExchangeID, OrderSysID) 撤单, 之前按 (FrontID, SessionID, OrderRef) 撤单
+    struct OrderAddress {
+        OrderKey key;
+        InstrumentHandle instrument;
+        TThostFtdcExchangeIDType exchange_id;     // 尚无报单回报时为空
+        TThostFtdcOrderSysIDType order_sys_id;    // 尚未报入交易所时为空
+    };
+
+    // 改单凭据: 原报单撤单完成、新报单发出后就绪, 得到新报单的凭据;
+    // 原报单已全部成交、被拒或撤单失败时得到已拒单的凭据, 不会调用新报单的回调
+    typedef std::shared_future<OrderTicket> ReplaceTicket;
+
+    // 撤单完成、等待报出的改单
+    struct OrderReplace {
+        InstrumentHandle instrument;
+        char direction;
+        char offset;
+        double price;
+        int32_t volume;                 // 原报单撤单后的剩余数量
+        OrderCallback callback;
+        std::shared_ptr<std::promise<OrderTicket>> promise;
+    };
+
+    // 报单状态机: 按 (FrontID, SessionID, OrderRef) 跟踪本会话发出的报单, 由 OnRtnOrder 推进状态,
+    // 由 OnRtnTrade 逐笔累加成交, 每笔报单单独推送进度并在终止时完成自己的 future
+    // 成交回报不带 FrontID/SessionID, 按 OnRtnOrder 登记的 (ExchangeID, OrderSysID) 归属到报单;
+    // 早于报单回报到达的成交暂存, 登记后补记
+    // 撤单回报可能先于最后几笔成交到达, 成交数量追上交易所回报的 VolumeTraded 后才完成
+    // 回调在调用 On* 的线程 (CTP 回调线程) 执行, 不持有内部锁, 可在回调中继续报单
+    // 改单先登记再撤单, 原报单撤单完成时放入待报出队列, 由调用方通过 TakeReplace 取出后立即报出
+    // 终止报单在回调返回后进入已终止队列, 只保留最近 keep_finished 笔, 跟踪表大小不随交易日内的报单数增长
+    class OrderTracker {
+    private:
+        // ExchangeID 与 OrderSysID 按定长拼接
+        typedef std::array<char, sizeof(TThostFtdcExchangeIDType) + sizeof(TThostFtdcOrderSysIDType)> SysKey;
+
+        struct Entry {
+            OrderKey key{};
+            OrderReport report{};
+            double turnover = 0;
+            // 交易所回报的成交数量
+            int32_t traded = 0;
+            char order_status = 0;
+            bool bound = false;
+            TThostFtdcExchangeIDType exchange_id{};
+            TThostFtdcOrderSysIDType order_sys_id{};
+            OrderCallback callback;
+            std::promise<OrderReport> promise;
+            std::unique_ptr<OrderReplace> replace;
+        };
+
+    public:
+        explicit OrderTracker(size_t keep_finished = ORDER_TRACKER_KEEP_FINISHED);
+
+        ~OrderTracker();
+
+    public:
+        // 登录成功后设置当前会话, 之后登记的报单属于该会话
+        void SetSession(int32_t front_id, int32_t session_id);
+
+        // 设置全部报单的观察者, 在各报单自己的回调之前调用 (如风控释放在途仓位); 须在报单前设置
+        void SetObserver(OrderCallback observer) { observer_ = std::move(observer); }
+
+        // 登记本会话的新报单, 须在发送请求前调用
+        OrderTicket Add(int32_t order_ref, InstrumentHandle instrument, char direction, char offset, int32_t volume,
+                        OrderCallback callback);
+
+        // 本会话的报单未能发出 (ReqOrderInsert 返回非 0), 或 OnRspOrderInsert/OnErrRtnOrderInsert 拒单
+        void Reject(int32_t order_ref, int32_t error_id, const std::string &error);
+
+        // 报单回报中的拒单, 不属于本会话登记的报单时忽略
+        void Reject(const OrderKey &key, int32_t error_id, const std::string &error);
+
+        // 报单回报, 非本会话登记的报单忽略
+        void OnOrder(const CThostFtdcOrderField &order);
+
+        void OnTrade(const CThostFtdcTradeField &trade);
+
+        // 读取本会话报单的进度, 未知报单返回 false
+        bool Report(int32_t order_ref, OrderReport &out) const;
+
+        bool Report(const OrderKey &key, OrderReport &out) const;
+
+        // 读取本会话未终止报单的撤单目标, 未知或已终止时返回 false
+        bool Address(int32_t order_ref, OrderAddress &out) const;
+
+        // 登记改单并返回撤单目标, 须在发送撤单请求前调用
+        // 报单未知、已终止或已有改单时返回 false, ticket 为已拒单的凭据
+        bool Replace(int32_t order_ref, double price, OrderCallback callback, ReplaceTicket &ticket,
+                     OrderAddress &address);
+
+        // 撤单失败 (ReqOrderAction 返回非 0、OnRspOrderAction、OnErrRtnOrderAction): 报单状态不变, 推送错误并作废改单
+        void ActionFailed(const OrderKey &key, int32_t error_id, const std::string &error);
+
+        // 取出一笔等待报出的改单, 没有时返回 false
+        bool TakeReplace(OrderReplace &out);
+
+        // 已就绪的拒单凭据, 不对应实际报单
+        static OrderTicket RejectedTicket(int32_t error_id, const std::string &error);
+
+        // 未完成的报单数
+        size_t Active() const;
+
+        // 跟踪表中的报单数, 包括保留的已终止报单
+        size_t Size() const;
+
+    public:
+        // OrderRef 为右对齐的数字字符串, 可能带前导空格
+        static int32_t ParseOrderRef(const char *order_ref);
+
+    private:
+        static SysKey MakeSysKey(const char *exchange_id, const char *order_sys_id);
+
+        OrderKey Key(int32_t order_ref) const { return OrderKey{front_id_, session_id_, order_ref}; }
+
+        // 累加一笔成交并推进报单; 调用方持有锁
+        void Fill(Entry &entry, const CThostFtdcTradeField &trade);
+
+        // 报单不再等待 OrderSysID (已登记或已终止); 没有等待的报单时丢弃暂存的成交; 调用方持有锁
+        void Bound(Entry &entry);
+
+        // 根据状态与成交推进报单, 返回是否有变化; 调用方持有锁
+        static bool Advance(Entry &entry);
+
+        // 报单终止: 撤单完成且有剩余数量时改单进入待报出队列, 否则作废; 调用方持有锁
+        void Finish(Entry &entry);
+
+        static void FailReplace(OrderReplace &replace, int32_t error_id, const std::string &error);
+
+        // 在锁外推送进度, 终止时完成 future 并移入已终止队列
+        void Publish(Entry &entry, const OrderReport &report);
+
+        // 回调返回后登记终止报单, 移出超出保留数的最早终止报单
+        void Retire(const OrderKey &key);
+
+    private:
+        mutable std::mutex lock_;
+        OrderCallback observer_;
+        int32_t front_id_ = 0;
+        int32_t session_id_ = 0;
+        absl::flat_hash_map<OrderKey, std::unique_ptr<Entry>> orders_;
+        absl::flat_hash_map<SysKey, Entry *> by_sys_id_;
+        absl::flat_hash_map<SysKey, std::vector<CThostFtdcTradeField>> early_trades_;
+        // 早到成交的暂存顺序, 用于丢弃最早暂存的成交
+        std::deque<SysKey> early_order_;
+        const size_t keep_finished_;
+        std::deque<OrderKey> finished_;
+        std::vector<OrderReplace> replaces_;
+        size_t active_ = 0;
+        // 尚未登记 OrderSysID 的未完成报单数
+        size_t unbound_ = 0;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_ORDER_H
@@ -0,0 +1,143 @@
+#ifndef LUEING_CTP_ORDER_TEMPLATE_H
+#define LUEING_CTP_ORDER_TEMPLATE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ThostFtdcTraderApi.h"
+#include "instrument.h"
+
+namespace lueing {
+    // 每个合约的模板数: 买卖 2 个方向 x 开仓、平仓、平今、平昨 4 种开平
+#define ORDER_TEMPLATE_DIRECTIONS 2
+#define ORDER_TEMPLATE_OFFSETS 4
+
+    // 非负整数转十进制字符串 (以 0 结尾), 返回长度; 每次处理两位, 不经过 sprintf 的格式解析
+    inline int FormatInt(int32_t value, char *out)
+    {
+        static const char digits[] =
+                "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                "8081828384858687888990919293949596979899";
+        char buffer[12];
+        char *end = buffer + sizeof(buffer);
+        char *p = end;
+        uint32_t v = value > 0 ? static_cast<uint32_t>(value) : 0;
+        while (v >= 100)
+        {
+            uint32_t i = (v % 100) * 2;
+            v /= 100;
+            *--p = digits[i + 1];
+            *--p = digits[i];
+        }
+        if (v >= 10)
+        {
+            *--p = digits[v * 2 + 1];
+            *--p = digits[v * 2];
+        }
+        else
+        {
+            *--p = static_cast<char>('0' + v);
+        }
+        int length = static_cast<int>(end - p);
+        memcpy(out, p, length);
+        out[length] = 0;
+        return length;
+    }
+
+    // 报单模板: 按 (合约, 买卖方向, 开平标志) 预先填好 CThostFtdcInputOrderField 的不变字段
+    // Warm 在订阅或开盘前调用 (内部加锁), Build 无锁, 只拷贝模板并写入价格、数量、OrderRef 与 RequestID
+    class OrderTemplates {
+    private:
+        struct Set {
+            CThostFtdcInputOrderField orders[ORDER_TEMPLATE_DIRECTIONS][ORDER_TEMPLATE_OFFSETS];
+        };
+
+    public:
+        OrderTemplates(size_t max_instruments, const CThostFtdcReqUserLoginField &principal);
+
+        ~OrderTemplates();
+
+    public:
+        // 生成合约的全部模板, 已生成时直接返回; 合约句柄超出范围时返回 false
+        // 已有模板未填交易所而 exchange 不为空时重新生成, 旧模板保留到析构, 并发的 Build 仍可读取
+        bool Warm(InstrumentHandle handle, const std::string &exchange, const std::string &contract);
+
+        bool Warmed(InstrumentHandle handle) const
+        {
+            return handle < max_instruments_ && nullptr != sets_[handle].load(std::memory_order_acquire);
+        }
+
+        // 模板中的交易所, 未生成或生成时交易所未知时为空
+        const char *Exchange(InstrumentHandle handle) const
+        {
+            Set *set = handle < max_instruments_ ? sets_[handle].load(std::memory_order_acquire) : nullptr;
+            return nullptr != set ? set->orders[0][0].ExchangeID : "";
+        }
+
+        // 由模板生成报单, 模板未生成或方向、开平标志不支持时返回 false
+        bool Build(InstrumentHandle handle, TThostFtdcDirectionType direction, TThostFtdcOffsetFlagType offset,
+                   double price, int volume, int32_t order_ref, CThostFtdcInputOrderField &out) const
+        {
+            int d = DirectionIndex(direction);
+            int o = OffsetIndex(offset);
+            Set *set = handle < max_instruments_ ? sets_[handle].load(std::memory_order_acquire) : nullptr;
+            if (nullptr == set || d < 0 || o < 0)
+            {
+                return false;
+            }
+            out = set->orders[d][o];
+            out.LimitPrice = price;
+            out.VolumeTotalOriginal = volume;
+            out.RequestID = order_ref;
+            FormatInt(order_ref, out.OrderRef);
+            return true;
+        }
+
+    public:
+        static int DirectionIndex(TThostFtdcDirectionType direction)
+        {
+            switch (direction)
+            {
+                case THOST_FTDC_D_Buy:
+                    return 0;
+                case THOST_FTDC_D_Sell:
+                    return 1;
+                default:
+                    return -1;
+            }
+        }
+
+        static int OffsetIndex(TThostFtdcOffsetFlagType offset)
+        {
+            switch (offset)
+            {
+                case THOST_FTDC_OF_Open:
+                    return 0;
+                case THOST_FTDC_OF_Close:
+                    return 1;
+                case THOST_FTDC_OF_CloseToday:
+                    return 2;
+                case THOST_FTDC_OF_CloseYesterday:
+                    return 3;
+                default:
+                    return -1;
+            }
+        }
+
+    private:
+        const size_t max_instruments_;
+        CThostFtdcInputOrderField base_{};
+        std::mutex lock_;
+        std::unique_ptr<std::atomic<Set *>[]> sets_;
+        // 被替换的模板
+        std::vector<std::unique_ptr<Set>> retired_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_ORDER_TEMPLATE_H
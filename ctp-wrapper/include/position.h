@@ -0,0 +1,102 @@
+#ifndef LUEING_CTP_POSITION_H
+#define LUEING_CTP_POSITION_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "ThostFtdcUserApiStruct.h"
+#include "instrument.h"
+#include "tick.h"
+
+namespace lueing {
+#define POSITION_LONG 0
+#define POSITION_SHORT 1
+#define POSITION_TODAY 0
+#define POSITION_YESTERDAY 1
+
+    // 单个合约的持仓与盈亏, 金额含合约乘数
+    struct PositionSummary {
+        int32_t volume[2][2];           // [POSITION_LONG/SHORT][POSITION_TODAY/YESTERDAY] 手数
+        double cost[2][2];              // 持仓成本: 今仓按开仓价, 昨仓按查询时的持仓成本 (昨结算价)
+        double realized;                // 平仓盈亏
+        double unrealized;              // 按最新价计算的持仓盈亏, 尚无行情时为 0
+        double last_price;
+    };
+
+    // 持仓簿: 登录后由 ReqQryInvestorPosition 的结果建立, 之后按成交回报增量更新, 按行情逐笔盯市
+    // 持仓只由交易回调线程写入, 最新价只由行情接收线程写入; 读取无锁, 每个合约由顺序锁保证持仓的一致
+    // 平仓顺序: 平今、平昨按指令; 上期所、能源中心的平仓为平昨; 其他交易所先平昨后平今
+    class PositionBook : public MarketDataObserver {
+    private:
+        struct Holding {
+            int32_t volume[2][2];
+            double cost[2][2];
+            double realized;
+        };
+
+        struct alignas(64) Slot {
+            // 偶数: 稳定; 奇数: 正在写入
+            std::atomic<uint64_t> sequence{0};
+            Holding holding{};
+            std::atomic<double> last_price{0};
+            std::atomic<double> multiplier{1};
+        };
+
+    public:
+        explicit PositionBook(size_t max_instruments);
+
+        ~PositionBook() override;
+
+    public:
+        // 以下仅限交易回调线程调用
+
+        // 清空全部持仓, 重新查询持仓前调用
+        void Reset();
+
+        // 累加一条持仓查询结果
+        void Seed(InstrumentHandle handle, const CThostFtdcInvestorPositionField &position);
+
+        // 按成交更新持仓与平仓盈亏
+        void OnTrade(InstrumentHandle handle, const CThostFtdcTradeField &trade);
+
+    public:
+        // 合约乘数, 默认 1; 持仓查询中的昨仓可推算乘数, 其余合约需在成交前设置
+        void SetMultiplier(InstrumentHandle handle, double multiplier);
+
+        double Multiplier(InstrumentHandle handle) const
+        {
+            return handle < max_instruments_ ? slots_[handle].multiplier.load(std::memory_order_relaxed) : 1;
+        }
+
+        // 行情接收路径上盯市
+        void OnMarketData(const CThostFtdcDepthMarketDataField &field, const Tick &tick) override;
+
+        // 无锁读取合约的持仓与盈亏, 合约句柄超出范围时返回 false
+        bool Read(InstrumentHandle handle, PositionSummary &out) const;
+
+        // 全部合约的平仓盈亏与持仓盈亏
+        void Totals(double &realized, double &unrealized) const;
+
+        // 有过持仓或成交的合约句柄上限 (不含)
+        size_t Used() const { return used_.load(std::memory_order_acquire); }
+
+    private:
+        Holding &BeginWrite(Slot &slot);
+
+        void EndWrite(Slot &slot);
+
+        void ReadHolding(const Slot &slot, Holding &out) const;
+
+        // 平掉 bucket 中的 volume 手, 返回实际平掉的手数并累计盈亏
+        static int32_t Close(Holding &holding, int side, int bucket, int32_t volume, double price, double multiplier);
+
+    private:
+        const size_t max_instruments_;
+        std::unique_ptr<Slot[]> slots_;
+        std::atomic<size_t> used_{0};
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_POSITION_H
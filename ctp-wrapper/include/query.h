@@ -0,0 +1,261 @@
+#ifndef LUEING_CTP_QUERY_H
+#define LUEING_CTP_QUERY_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ThostFtdcTraderApi.h"
+
+namespace lueing {
+    // 同时在途的查询数上限, 须为 2 的幂; 请求编号按位与映射到槽位
+#define QUERY_SLOTS 1024
+    // 在途查询过多、连接断开时的错误码; 请求未能发出时为 ReqQry* 的返回值
+#define QUERY_ERROR_SLOTS -201
+#define QUERY_ERROR_DISCONNECTED -202
+
+    // 查询失败: 请求未能发出、柜台返回错误或连接断开, 通过 future 抛出
+    class QueryError : public std::runtime_error {
+    public:
+        QueryError(int error_id, const std::string &error) : std::runtime_error(error), error_id_(error_id) {}
+
+        int ErrorId() const { return error_id_; }
+
+    private:
+        int error_id_;
+    };
+
+    // 查询请求与响应的对应关系, 由 LUEING_QUERY 为每个 ReqQry* 特化
+    template<typename Request>
+    struct QueryTraits;
+
+#define LUEING_QUERY(request, response, method)                                     \
+    template<>                                                                      \
+    struct QueryTraits<request> {                                                   \
+        typedef response Response;                                                  \
+        static int Send(CThostFtdcTraderApi *api, request *field, int request_id)   \
+        {                                                                           \
+            return api->method(field, request_id);                                  \
+        }                                                                           \
+    };
+
+    // CThostFtdcQryTradingAccountField 同时用于 ReqQrySecAgentTradingAccount, 按 ReqQryTradingAccount 发送
+    // 报价录入/撤销与期货发起查询银行余额不是查询: 结果经 OnRtn*/OnErrRtn* 回报, 响应只是请求的回显, 不在此列
+    LUEING_QUERY(CThostFtdcQryMaxOrderVolumeField, CThostFtdcQryMaxOrderVolumeField, ReqQryMaxOrderVolume)
+    LUEING_QUERY(CThostFtdcQryOrderField, CThostFtdcOrderField, ReqQryOrder)
+    LUEING_QUERY(CThostFtdcQryTradeField, CThostFtdcTradeField, ReqQryTrade)
+    LUEING_QUERY(CThostFtdcQryInvestorPositionField, CThostFtdcInvestorPositionField, ReqQryInvestorPosition)
+    LUEING_QUERY(CThostFtdcQryTradingAccountField, CThostFtdcTradingAccountField, ReqQryTradingAccount)
+    LUEING_QUERY(CThostFtdcQryInvestorField, CThostFtdcInvestorField, ReqQryInvestor)
+    LUEING_QUERY(CThostFtdcQryTradingCodeField, CThostFtdcTradingCodeField, ReqQryTradingCode)
+    LUEING_QUERY(CThostFtdcQryInstrumentMarginRateField,
+                 CThostFtdcInstrumentMarginRateField, ReqQryInstrumentMarginRate)
+    LUEING_QUERY(CThostFtdcQryInstrumentCommissionRateField,
+                 CThostFtdcInstrumentCommissionRateField, ReqQryInstrumentCommissionRate)
+    LUEING_QUERY(CThostFtdcQryExchangeField, CThostFtdcExchangeField, ReqQryExchange)
+    LUEING_QUERY(CThostFtdcQryProductField, CThostFtdcProductField, ReqQryProduct)
+    LUEING_QUERY(CThostFtdcQryInstrumentField, CThostFtdcInstrumentField, ReqQryInstrument)
+    LUEING_QUERY(CThostFtdcQryDepthMarketDataField, CThostFtdcDepthMarketDataField, ReqQryDepthMarketData)
+    LUEING_QUERY(CThostFtdcQryTraderOfferField, CThostFtdcTraderOfferField, ReqQryTraderOffer)
+    LUEING_QUERY(CThostFtdcQrySettlementInfoField, CThostFtdcSettlementInfoField, ReqQrySettlementInfo)
+    LUEING_QUERY(CThostFtdcQryTransferBankField, CThostFtdcTransferBankField, ReqQryTransferBank)
+    LUEING_QUERY(CThostFtdcQryInvestorPositionDetailField,
+                 CThostFtdcInvestorPositionDetailField, ReqQryInvestorPositionDetail)
+    LUEING_QUERY(CThostFtdcQryNoticeField, CThostFtdcNoticeField, ReqQryNotice)
+    LUEING_QUERY(CThostFtdcQrySettlementInfoConfirmField,
+                 CThostFtdcSettlementInfoConfirmField, ReqQrySettlementInfoConfirm)
+    LUEING_QUERY(CThostFtdcQryInvestorPositionCombineDetailField,
+                 CThostFtdcInvestorPositionCombineDetailField, ReqQryInvestorPositionCombineDetail)
+    LUEING_QUERY(CThostFtdcQryCFMMCTradingAccountKeyField,
+                 CThostFtdcCFMMCTradingAccountKeyField, ReqQryCFMMCTradingAccountKey)
+    LUEING_QUERY(CThostFtdcQryEWarrantOffsetField, CThostFtdcEWarrantOffsetField, ReqQryEWarrantOffset)
+    LUEING_QUERY(CThostFtdcQryInvestorProductGroupMarginField,
+                 CThostFtdcInvestorProductGroupMarginField, ReqQryInvestorProductGroupMargin)
+    LUEING_QUERY(CThostFtdcQryExchangeMarginRateField, CThostFtdcExchangeMarginRateField, ReqQryExchangeMarginRate)
+    LUEING_QUERY(CThostFtdcQryExchangeMarginRateAdjustField,
+                 CThostFtdcExchangeMarginRateAdjustField, ReqQryExchangeMarginRateAdjust)
+    LUEING_QUERY(CThostFtdcQryExchangeRateField, CThostFtdcExchangeRateField, ReqQryExchangeRate)
+    LUEING_QUERY(CThostFtdcQrySecAgentACIDMapField, CThostFtdcSecAgentACIDMapField, ReqQrySecAgentACIDMap)
+    LUEING_QUERY(CThostFtdcQryProductExchRateField, CThostFtdcProductExchRateField, ReqQryProductExchRate)
+    LUEING_QUERY(CThostFtdcQryProductGroupField, CThostFtdcProductGroupField, ReqQryProductGroup)
+    LUEING_QUERY(CThostFtdcQryMMInstrumentCommissionRateField,
+                 CThostFtdcMMInstrumentCommissionRateField, ReqQryMMInstrumentCommissionRate)
+    LUEING_QUERY(CThostFtdcQryMMOptionInstrCommRateField,
+                 CThostFtdcMMOptionInstrCommRateField, ReqQryMMOptionInstrCommRate)
+    LUEING_QUERY(CThostFtdcQryInstrumentOrderCommRateField,
+                 CThostFtdcInstrumentOrderCommRateField, ReqQryInstrumentOrderCommRate)
+    LUEING_QUERY(CThostFtdcQrySecAgentCheckModeField, CThostFtdcSecAgentCheckModeField, ReqQrySecAgentCheckMode)
+    LUEING_QUERY(CThostFtdcQrySecAgentTradeInfoField, CThostFtdcSecAgentTradeInfoField, ReqQrySecAgentTradeInfo)
+    LUEING_QUERY(CThostFtdcQryOptionInstrTradeCostField,
+                 CThostFtdcOptionInstrTradeCostField, ReqQryOptionInstrTradeCost)
+    LUEING_QUERY(CThostFtdcQryOptionInstrCommRateField, CThostFtdcOptionInstrCommRateField, ReqQryOptionInstrCommRate)
+    LUEING_QUERY(CThostFtdcQryExecOrderField, CThostFtdcExecOrderField, ReqQryExecOrder)
+    LUEING_QUERY(CThostFtdcQryForQuoteField, CThostFtdcForQuoteField, ReqQryForQuote)
+    LUEING_QUERY(CThostFtdcQryQuoteField, CThostFtdcQuoteField, ReqQryQuote)
+    LUEING_QUERY(CThostFtdcQryOptionSelfCloseField, CThostFtdcOptionSelfCloseField, ReqQryOptionSelfClose)
+    LUEING_QUERY(CThostFtdcQryInvestUnitField, CThostFtdcInvestUnitField, ReqQryInvestUnit)
+    LUEING_QUERY(CThostFtdcQryCombInstrumentGuardField, CThostFtdcCombInstrumentGuardField, ReqQryCombInstrumentGuard)
+    LUEING_QUERY(CThostFtdcQryCombActionField, CThostFtdcCombActionField, ReqQryCombAction)
+    LUEING_QUERY(CThostFtdcQryTransferSerialField, CThostFtdcTransferSerialField, ReqQryTransferSerial)
+    LUEING_QUERY(CThostFtdcQryAccountregisterField, CThostFtdcAccountregisterField, ReqQryAccountregister)
+    LUEING_QUERY(CThostFtdcQryContractBankField, CThostFtdcContractBankField, ReqQryContractBank)
+    LUEING_QUERY(CThostFtdcQryParkedOrderField, CThostFtdcParkedOrderField, ReqQryParkedOrder)
+    LUEING_QUERY(CThostFtdcQryParkedOrderActionField, CThostFtdcParkedOrderActionField, ReqQryParkedOrderAction)
+    LUEING_QUERY(CThostFtdcQryTradingNoticeField, CThostFtdcTradingNoticeField, ReqQryTradingNotice)
+    LUEING_QUERY(CThostFtdcQryBrokerTradingParamsField, CThostFtdcBrokerTradingParamsField, ReqQryBrokerTradingParams)
+    LUEING_QUERY(CThostFtdcQryBrokerTradingAlgosField, CThostFtdcBrokerTradingAlgosField, ReqQryBrokerTradingAlgos)
+    LUEING_QUERY(CThostFtdcQueryCFMMCTradingAccountTokenField,
+                 CThostFtdcQueryCFMMCTradingAccountTokenField, ReqQueryCFMMCTradingAccountToken)
+    LUEING_QUERY(CThostFtdcQryClassifiedInstrumentField, CThostFtdcInstrumentField, ReqQryClassifiedInstrument)
+    LUEING_QUERY(CThostFtdcQryCombPromotionParamField, CThostFtdcCombPromotionParamField, ReqQryCombPromotionParam)
+    LUEING_QUERY(CThostFtdcQryRiskSettleInvstPositionField,
+                 CThostFtdcRiskSettleInvstPositionField, ReqQryRiskSettleInvstPosition)
+    LUEING_QUERY(CThostFtdcQryRiskSettleProductStatusField,
+                 CThostFtdcRiskSettleProductStatusField, ReqQryRiskSettleProductStatus)
+    LUEING_QUERY(CThostFtdcQrySPBMFutureParameterField, CThostFtdcSPBMFutureParameterField, ReqQrySPBMFutureParameter)
+    LUEING_QUERY(CThostFtdcQrySPBMOptionParameterField, CThostFtdcSPBMOptionParameterField, ReqQrySPBMOptionParameter)
+    LUEING_QUERY(CThostFtdcQrySPBMIntraParameterField, CThostFtdcSPBMIntraParameterField, ReqQrySPBMIntraParameter)
+    LUEING_QUERY(CThostFtdcQrySPBMInterParameterField, CThostFtdcSPBMInterParameterField, ReqQrySPBMInterParameter)
+    LUEING_QUERY(CThostFtdcQrySPBMPortfDefinitionField, CThostFtdcSPBMPortfDefinitionField, ReqQrySPBMPortfDefinition)
+    LUEING_QUERY(CThostFtdcQrySPBMInvestorPortfDefField,
+                 CThostFtdcSPBMInvestorPortfDefField, ReqQrySPBMInvestorPortfDef)
+    LUEING_QUERY(CThostFtdcQryInvestorPortfMarginRatioField,
+                 CThostFtdcInvestorPortfMarginRatioField, ReqQryInvestorPortfMarginRatio)
+    LUEING_QUERY(CThostFtdcQryInvestorProdSPBMDetailField,
+                 CThostFtdcInvestorProdSPBMDetailField, ReqQryInvestorProdSPBMDetail)
+    LUEING_QUERY(CThostFtdcQryInvestorCommoditySPMMMarginField,
+                 CThostFtdcInvestorCommoditySPMMMarginField, ReqQryInvestorCommoditySPMMMargin)
+    LUEING_QUERY(CThostFtdcQryInvestorCommodityGroupSPMMMarginField,
+                 CThostFtdcInvestorCommodityGroupSPMMMarginField, ReqQryInvestorCommodityGroupSPMMMargin)
+    LUEING_QUERY(CThostFtdcQrySPMMInstParamField, CThostFtdcSPMMInstParamField, ReqQrySPMMInstParam)
+    LUEING_QUERY(CThostFtdcQrySPMMProductParamField, CThostFtdcSPMMProductParamField, ReqQrySPMMProductParam)
+    LUEING_QUERY(CThostFtdcQrySPBMAddOnInterParameterField,
+                 CThostFtdcSPBMAddOnInterParameterField, ReqQrySPBMAddOnInterParameter)
+    LUEING_QUERY(CThostFtdcQryRCAMSCombProductInfoField,
+                 CThostFtdcRCAMSCombProductInfoField, ReqQryRCAMSCombProductInfo)
+    LUEING_QUERY(CThostFtdcQryRCAMSInstrParameterField, CThostFtdcRCAMSInstrParameterField, ReqQryRCAMSInstrParameter)
+    LUEING_QUERY(CThostFtdcQryRCAMSIntraParameterField, CThostFtdcRCAMSIntraParameterField, ReqQryRCAMSIntraParameter)
+    LUEING_QUERY(CThostFtdcQryRCAMSInterParameterField, CThostFtdcRCAMSInterParameterField, ReqQryRCAMSInterParameter)
+    LUEING_QUERY(CThostFtdcQryRCAMSShortOptAdjustParamField,
+                 CThostFtdcRCAMSShortOptAdjustParamField, ReqQryRCAMSShortOptAdjustParam)
+    LUEING_QUERY(CThostFtdcQryRCAMSInvestorCombPositionField,
+                 CThostFtdcRCAMSInvestorCombPositionField, ReqQryRCAMSInvestorCombPosition)
+    LUEING_QUERY(CThostFtdcQryInvestorProdRCAMSMarginField,
+                 CThostFtdcInvestorProdRCAMSMarginField, ReqQryInvestorProdRCAMSMargin)
+    LUEING_QUERY(CThostFtdcQryRULEInstrParameterField, CThostFtdcRULEInstrParameterField, ReqQryRULEInstrParameter)
+    LUEING_QUERY(CThostFtdcQryRULEIntraParameterField, CThostFtdcRULEIntraParameterField, ReqQryRULEIntraParameter)
+    LUEING_QUERY(CThostFtdcQryRULEInterParameterField, CThostFtdcRULEInterParameterField, ReqQryRULEInterParameter)
+    LUEING_QUERY(CThostFtdcQryInvestorProdRULEMarginField,
+                 CThostFtdcInvestorProdRULEMarginField, ReqQryInvestorProdRULEMargin)
+
+    // 一次查询的响应收集, 按类型擦除后存入槽位
+    class QuerySink {
+    public:
+        virtual ~QuerySink() = default;
+
+        virtual void Append(const void *row) = 0;
+
+        virtual void Finish(int error_id, const std::string &error) = 0;
+    };
+
+    template<typename Response>
+    class QueryCollector final : public QuerySink {
+    public:
+        std::future<std::vector<Response>> Future() { return promise_.get_future(); }
+
+        void Append(const void *row) override { rows_.push_back(*static_cast<const Response *>(row)); }
+
+        void Finish(int error_id, const std::string &error) override
+        {
+            if (0 == error_id)
+            {
+                promise_.set_value(std::move(rows_));
+                return;
+            }
+            promise_.set_exception(std::make_exception_ptr(QueryError(error_id, error)));
+        }
+
+    private:
+        std::vector<Response> rows_;
+        std::promise<std::vector<Response>> promise_;
+    };
+
+    // 以回调接收全部响应, 在 CTP 回调线程 (或登记失败时在调用线程) 调用
+    template<typename Response>
+    class QueryCallback final : public QuerySink {
+    public:
+        typedef std::function<void(int error_id, const std::string &error, std::vector<Response> &rows)> Callback;
+
+        explicit QueryCallback(Callback callback) : callback_(std::move(callback)) {}
+
+        void Append(const void *row) override { rows_.push_back(*static_cast<const Response *>(row)); }
+
+        void Finish(int error_id, const std::string &error) override { callback_(error_id, error, rows_); }
+
+    private:
+        std::vector<Response> rows_;
+        Callback callback_;
+    };
+
+    // 在途查询表: 按 nRequestID 定位槽位, 登记与响应匹配均无锁
+    // Register 可在任意线程调用; Complete、AbortAll 仅限 CTP 回调线程; Abort 用于未能发出的查询
+    // 响应逐条追加, bIsLast 时完成 future; 编号不匹配 (非本表登记的请求) 的响应忽略
+    class QueryTable {
+    private:
+        // request_id 为 0 表示空闲, -1 表示正在登记或结束
+        struct alignas(64) Slot {
+            std::atomic<int32_t> request_id{0};
+            QuerySink *sink = nullptr;
+        };
+
+    public:
+        QueryTable();
+
+        ~QueryTable();
+
+    public:
+        // 登记查询, 接管 sink; 槽位被占用 (在途查询过多) 时以 QUERY_ERROR_SLOTS 完成 sink 并返回 false
+        bool Register(int32_t request_id, QuerySink *sink);
+
+        // 追加一条响应, last 时以 error_id/error 完成查询
+        template<typename Response>
+        void Complete(const Response *row, int error_id, const std::string &error, int32_t request_id, bool last)
+        {
+            Slot &slot = slots_[Index(request_id)];
+            if (request_id <= 0 || slot.request_id.load(std::memory_order_acquire) != request_id)
+            {
+                return;
+            }
+            if (nullptr != row && 0 == error_id)
+            {
+                slot.sink->Append(row);
+            }
+            if (last)
+            {
+                Abort(request_id, error_id, error);
+            }
+        }
+
+        // 以错误结束查询 (error_id 为 0 时正常完成), 查询不存在时忽略
+        void Abort(int32_t request_id, int error_id, const std::string &error);
+
+        // 连接断开, 在途查询不会再有响应, 全部以 QUERY_ERROR_DISCONNECTED 结束
+        void AbortAll();
+
+        // 在途查询数
+        size_t Pending() const;
+
+    private:
+        static size_t Index(int32_t request_id) { return static_cast<uint32_t>(request_id) & (QUERY_SLOTS - 1); }
+
+    private:
+        std::unique_ptr<Slot[]> slots_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_QUERY_H
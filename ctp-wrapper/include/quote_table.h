@@ -0,0 +1,97 @@
+#ifndef LUEING_CTP_QUOTE_TABLE_H
+#define LUEING_CTP_QUOTE_TABLE_H
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "instrument.h"
+#include "tick.h"
+
+namespace lueing {
+    // 最新行情快照表, 每个合约一个连续存放的槽位, 以合约句柄为下标
+    // 每个槽位由顺序锁保护: 单个写线程 (CTP 回调线程) 发布, 任意多个读线程无锁读取一致的快照
+    class QuoteTable {
+    private:
+        struct Slot {
+            // 偶数: 稳定; 奇数: 正在写入; 0: 尚无行情
+            std::atomic<uint64_t> sequence{0};
+            Tick tick;
+        };
+
+    public:
+        explicit QuoteTable(size_t max_instruments);
+
+        ~QuoteTable();
+
+    public:
+        size_t Capacity() const { return capacity_; }
+
+        // 仅限单个写线程调用
+        void Publish(InstrumentHandle handle, const Tick &tick)
+        {
+            if (handle >= capacity_)
+            {
+                return;
+            }
+            Slot &slot = slots_[handle];
+            uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+            slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(static_cast<void *>(&slot.tick), &tick, sizeof(Tick));
+            slot.sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        // 读取合约最新行情, 尚无行情时返回 false
+        bool Read(InstrumentHandle handle, Tick &out) const
+        {
+            uint64_t version;
+            return Read(handle, out, version);
+        }
+
+        // 读取合约最新行情及其版本 (已发布的行情次数), 尚无行情时返回 false
+        bool Read(InstrumentHandle handle, Tick &out, uint64_t &version) const
+        {
+            if (handle >= capacity_)
+            {
+                return false;
+            }
+            const Slot &slot = slots_[handle];
+            for (;;)
+            {
+                uint64_t begin = slot.sequence.load(std::memory_order_acquire);
+                if (0 == begin)
+                {
+                    return false;
+                }
+                if (begin & 1)
+                {
+                    continue;
+                }
+                std::memcpy(static_cast<void *>(&out), &slot.tick, sizeof(Tick));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) == begin)
+                {
+                    version = begin / 2;
+                    return true;
+                }
+            }
+        }
+
+        // 批量读取, out 与 handles 一一对应, 返回读到行情的合约数量; 无行情的槽位 instrument 置为 INVALID_INSTRUMENT
+        size_t Read(const std::vector<InstrumentHandle> &handles, std::vector<Tick> &out) const;
+
+        // 合约已发布的行情次数
+        uint64_t Version(InstrumentHandle handle) const
+        {
+            return handle < capacity_ ? slots_[handle].sequence.load(std::memory_order_acquire) / 2 : 0;
+        }
+
+    private:
+        const size_t capacity_;
+        std::unique_ptr<Slot[]> slots_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_QUOTE_TABLE_H
@@ -0,0 +1,116 @@
+#ifndef LUEING_CTP_REPLAY_H
+#define LUEING_CTP_REPLAY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <absl/container/flat_hash_set.h>
+
+#include "ThostFtdcMdApi.h"
+#include "journal.h"
+
+namespace lueing {
+    // 行情回放接口: 读取行情日志, 按 CTP 行情 API 的方式回调 CThostFtdcMdSpi
+    // 用于无前置环境下压测 OnRtnDepthMarketData 之后的整条链路, 上层代码无需改动
+    // 所有回调都在回放线程上执行; 首次订阅成功后开始回放, 只推送已订阅的合约
+    // speed: 1 按原始节奏回放, N 为 N 倍速, 0 或负数为不等待全速回放
+    class ReplayMdApi final : public CThostFtdcMdApi {
+    public:
+        ReplayMdApi(std::string directory, std::string trading_day, double speed);
+
+        // 与 CTP 一致, 通过 Release 释放
+        ~ReplayMdApi();
+
+    public:
+        void Release() override;
+
+        void Init() override;
+
+        // 等待回放结束或接口释放
+        int Join() override;
+
+        const char *GetTradingDay() override { return trading_day_.c_str(); }
+
+        void RegisterFront(char *pszFrontAddress) override {}
+
+        void RegisterNameServer(char *pszNsAddress) override {}
+
+        void RegisterFensUserInfo(CThostFtdcFensUserInfoField *pFensUserInfo) override {}
+
+        void RegisterSpi(CThostFtdcMdSpi *pSpi) override { spi_ = pSpi; }
+
+        int SubscribeMarketData(char *ppInstrumentID[], int nCount) override;
+
+        int UnSubscribeMarketData(char *ppInstrumentID[], int nCount) override;
+
+        int SubscribeForQuoteRsp(char *ppInstrumentID[], int nCount) override;
+
+        int UnSubscribeForQuoteRsp(char *ppInstrumentID[], int nCount) override;
+
+        int ReqUserLogin(CThostFtdcReqUserLoginField *pReqUserLoginField, int nRequestID) override;
+
+        int ReqUserLogout(CThostFtdcUserLogoutField *pUserLogout, int nRequestID) override;
+
+        int ReqQryMulticastInstrument(CThostFtdcQryMulticastInstrumentField *pQryMulticastInstrument,
+                                      int nRequestID) override;
+
+    public:
+        // 已推送的行情条数
+        uint64_t Replayed() const { return replayed_.load(std::memory_order_acquire); }
+
+        // 日志已全部回放
+        bool Finished() const { return finished_.load(std::memory_order_acquire); }
+
+        // 目录中最新的交易日, 没有日志时返回空串
+        static std::string LatestTradingDay(const std::string &directory);
+
+    private:
+        void Run();
+
+        // 在回放线程上执行请求的响应
+        void Post(std::function<void()> task);
+
+        void RunTasks();
+
+        // 读取下一条记录, 日志读完时返回 nullptr
+        const JournalRecord *Next();
+
+        // 按回放速度等待到记录的接收时刻, 返回 false 表示已停止
+        bool Pace(int64_t receive_time);
+
+        void RspSpecificInstrument(char *ppInstrumentID[], int nCount, bool subscribe);
+
+    private:
+        const std::string directory_;
+        const double speed_;
+        std::string trading_day_;
+        CThostFtdcMdSpi *spi_ = nullptr;
+
+        // 仅回放线程访问
+        absl::flat_hash_set<std::string> subscribed_;
+        std::vector<std::string> files_;
+        size_t file_index_ = 0;
+        std::unique_ptr<JournalReader> reader_;
+        uint64_t record_index_ = 0;
+        bool started_ = false;
+        int64_t base_receive_time_ = 0;
+        int64_t base_local_time_ = 0;
+
+        std::mutex lock_;
+        std::condition_variable condition_;
+        std::deque<std::function<void()>> tasks_;
+        std::atomic_bool has_tasks_{false};
+        std::atomic_bool running_{false};
+        std::atomic_bool finished_{false};
+        std::atomic<uint64_t> replayed_{0};
+        std::thread worker_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_REPLAY_H
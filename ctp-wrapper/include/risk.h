@@ -0,0 +1,96 @@
+#ifndef LUEING_CTP_RISK_H
+#define LUEING_CTP_RISK_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "instrument.h"
+#include "order.h"
+#include "tick.h"
+
+namespace lueing {
+    // 风控检查结果, 非 0 时作为拒单错误码
+#define RISK_PASSED 0
+#define RISK_ORDER_VOLUME (-101)
+#define RISK_ORDER_COUNT (-102)
+#define RISK_POSITION (-103)
+#define RISK_PRICE_LIMIT (-104)
+#define RISK_FAT_FINGER (-105)
+#define RISK_INSTRUMENT (-106)
+
+    struct RiskLimits {
+        int32_t max_order_volume;       // 单笔最大手数, 0 为不限
+        int32_t max_daily_orders;       // 每日最多报单次数, 0 为不限
+        int32_t max_position;           // 单个合约单个方向的最大持仓 (含在途开仓), 0 为不限
+        double max_deviation;           // 报单价格偏离最新价的最大百分比, 0 为不检查
+    };
+
+    // 报单前风控: 单笔手数、每日报单次数、单合约持仓、涨跌停价格带与偏离最新价 (防乌龙指)
+    // 平仓只检查单笔手数与涨跌停价格带, 不计报单次数
+    // Check 在报单线程调用, 只读写原子变量, 不加锁; 价格缓存由行情接收路径 (OnMarketData) 更新,
+    // 在途开仓由报单终止时的回报 (OnOrderReport) 释放
+    // 持仓按本引擎放行的开仓累计, 平仓成交后扣减; 启动前已有的持仓需通过 SetPosition 预置
+    class RiskEngine : public MarketDataObserver {
+    private:
+        struct alignas(64) Slot {
+            std::atomic<double> last_price{0};
+            std::atomic<double> upper_limit{0};
+            std::atomic<double> lower_limit{0};
+            // 多头、空头的持仓与在途开仓
+            std::atomic<int32_t> position[2]{};
+        };
+
+    public:
+        RiskEngine(size_t max_instruments, const RiskLimits &limits);
+
+        ~RiskEngine() override;
+
+    public:
+        // 检查并占用额度 (报单次数、在途开仓), 返回 RISK_PASSED 或拒绝原因
+        int Check(InstrumentHandle handle, char direction, char offset, double price, int32_t volume);
+
+        // 已通过检查的报单未能发出 (ReqOrderInsert 或流控失败) 时退还报单次数; 在途开仓由拒单回报释放
+        // 平仓不占用报单次数, 不退还
+        void Refund(char offset);
+
+        // 报单回报, 报单终止时释放未成交的开仓、扣减平仓成交
+        void OnOrderReport(const OrderReport &report);
+
+        // 行情接收路径上更新最新价与涨跌停价
+        void OnMarketData(const CThostFtdcDepthMarketDataField &field, const Tick &tick) override;
+
+        // 预置涨跌停价, 如从合约查询或开盘前的行情快照
+        void SetPriceLimits(InstrumentHandle handle, double upper, double lower);
+
+        // 预置持仓, direction 为持仓方向 THOST_FTDC_D_Buy (多头) 或 THOST_FTDC_D_Sell (空头)
+        void SetPosition(InstrumentHandle handle, char direction, int32_t volume);
+
+        int32_t Position(InstrumentHandle handle, char direction) const;
+
+        int32_t DailyOrders() const { return daily_orders_.load(std::memory_order_relaxed); }
+
+        // 新交易日清零报单次数, 登录后交易日变化时调用
+        void ResetDaily() { daily_orders_.store(0, std::memory_order_relaxed); }
+
+        // 拒绝原因
+        static const char *Describe(int result);
+
+    private:
+        // 开仓占用报单方向的持仓, 平仓扣减相反方向的持仓
+        static int Side(char direction, char offset, bool *open);
+
+        static void Sub(std::atomic<int32_t> &value, int32_t amount);
+
+        // 不超过 limit 时占用 amount, 返回是否占用成功
+        static bool Reserve(std::atomic<int32_t> &value, int32_t amount, int32_t limit);
+
+    private:
+        const size_t max_instruments_;
+        const RiskLimits limits_;
+        std::unique_ptr<Slot[]> slots_;
+        std::atomic<int32_t> daily_orders_{0};
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_RISK_H
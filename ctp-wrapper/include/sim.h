@@ -0,0 +1,438 @@
+#ifndef LUEING_CTP_SIM_H
+#define LUEING_CTP_SIM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
+#include "ThostFtdcTraderApi.h"
+#include "instrument.h"
+#include "order.h"
+#include "tick.h"
+
+namespace lueing {
+    // 模拟撮合的柜台错误码, 与 CTP 一致
+#define SIM_ERROR_INVALID_FIELD 15
+#define SIM_ERROR_INSTRUMENT_NOT_FOUND 16
+#define SIM_ERROR_ORDER_NOT_FOUND 25
+#define SIM_ERROR_ORDER_FINISHED 26
+
+    // 模拟交易接口: 以 CTP 交易 API 的方式回调 CThostFtdcTraderSpi, 报单在进程内按一档行情撮合, 不连接柜台
+    // 用于 fake_x 模拟交易, 上层代码无需改动; 作为行情观察者注册到 CtpHq (见 CtpTx::Protect) 后才有成交
+    // 所有回调都在撮合线程上执行; 报单、撤单在 latency 纳秒后到达撮合线程, 模拟往返柜台的延迟
+    // 撮合规则: 买单价格不低于卖一价时按卖一价成交, 数量不超过卖一量, 卖单对称; 未成交部分挂单,
+    // 之后每笔行情按时间优先依次撮合, 挂单按自身价格成交; 每笔行情的一档数量被本模拟的成交消耗后不再复用
+    // 撮合线程处理不及时, 同一合约积压的行情只保留最新一笔
+    // 支持登录、结算单确认、持仓查询 (总为空)、报单 (含 FAK/FOK) 与撤单, 其他请求返回 -1
+    class SimTraderApi final : public CThostFtdcTraderApi, public MarketDataObserver {
+    private:
+        // 一档行情, 数量为尚未被模拟成交消耗的部分
+        struct Quote {
+            double bid_price = 0;
+            double ask_price = 0;
+            int32_t bid_volume = 0;
+            int32_t ask_volume = 0;
+            bool dirty = false;
+        };
+
+    public:
+        SimTraderApi(InstrumentRegistryPtr instruments, int64_t latency);
+
+        // 与 CTP 一致, 通过 Release 释放
+        ~SimTraderApi();
+
+    public:
+        void Release() override;
+
+        void Init() override;
+
+        int Join() override;
+
+        const char *GetTradingDay() override { return trading_day_.c_str(); }
+
+        void RegisterFront(char *pszFrontAddress) override {}
+
+        void RegisterNameServer(char *pszNsAddress) override {}
+
+        void RegisterFensUserInfo(CThostFtdcFensUserInfoField *pFensUserInfo) override {}
+
+        void RegisterSpi(CThostFtdcTraderSpi *pSpi) override { spi_ = pSpi; }
+
+        void SubscribePrivateTopic(THOST_TE_RESUME_TYPE nResumeType) override {}
+
+        void SubscribePublicTopic(THOST_TE_RESUME_TYPE nResumeType) override {}
+
+        int RegisterUserSystemInfo(CThostFtdcUserSystemInfoField *pUserSystemInfo) override { return 0; }
+
+        int SubmitUserSystemInfo(CThostFtdcUserSystemInfoField *pUserSystemInfo) override { return 0; }
+
+        int ReqAuthenticate(CThostFtdcReqAuthenticateField *pReqAuthenticateField, int nRequestID) override;
+
+        int ReqUserLogin(CThostFtdcReqUserLoginField *pReqUserLoginField, int nRequestID) override;
+
+        int ReqUserLogout(CThostFtdcUserLogoutField *pUserLogout, int nRequestID) override;
+
+        int ReqSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm,
+                                     int nRequestID) override;
+
+        int ReqQryInvestorPosition(CThostFtdcQryInvestorPositionField *pQryInvestorPosition, int nRequestID) override;
+
+        int ReqOrderInsert(CThostFtdcInputOrderField *pInputOrder, int nRequestID) override;
+
+        int ReqOrderAction(CThostFtdcInputOrderActionField *pInputOrderAction, int nRequestID) override;
+
+    public:
+        // 行情接收线程上调用, 只记录一档行情并唤醒撮合线程
+        void OnMarketData(const CThostFtdcDepthMarketDataField &field, const Tick &tick) override;
+
+        // 已推送的成交笔数
+        uint64_t Trades() const { return trades_.load(std::memory_order_acquire); }
+
+    public:
+        // 以下请求模拟环境不支持
+        int ReqUserPasswordUpdate(CThostFtdcUserPasswordUpdateField *pUserPasswordUpdate,
+                                  int nRequestID) override { return -1; }
+
+        int ReqTradingAccountPasswordUpdate(CThostFtdcTradingAccountPasswordUpdateField *pTradingAccountPasswordUpdate,
+                                            int nRequestID) override { return -1; }
+
+        int ReqUserAuthMethod(CThostFtdcReqUserAuthMethodField *pReqUserAuthMethod,
+                              int nRequestID) override { return -1; }
+
+        int ReqGenUserCaptcha(CThostFtdcReqGenUserCaptchaField *pReqGenUserCaptcha,
+                              int nRequestID) override { return -1; }
+
+        int ReqGenUserText(CThostFtdcReqGenUserTextField *pReqGenUserText, int nRequestID) override { return -1; }
+
+        int ReqUserLoginWithCaptcha(CThostFtdcReqUserLoginWithCaptchaField *pReqUserLoginWithCaptcha,
+                                    int nRequestID) override { return -1; }
+
+        int ReqUserLoginWithText(CThostFtdcReqUserLoginWithTextField *pReqUserLoginWithText,
+                                 int nRequestID) override { return -1; }
+
+        int ReqUserLoginWithOTP(CThostFtdcReqUserLoginWithOTPField *pReqUserLoginWithOTP,
+                                int nRequestID) override { return -1; }
+
+        int ReqParkedOrderInsert(CThostFtdcParkedOrderField *pParkedOrder, int nRequestID) override { return -1; }
+
+        int ReqParkedOrderAction(CThostFtdcParkedOrderActionField *pParkedOrderAction,
+                                 int nRequestID) override { return -1; }
+
+        int ReqQryMaxOrderVolume(CThostFtdcQryMaxOrderVolumeField *pQryMaxOrderVolume,
+                                 int nRequestID) override { return -1; }
+
+        int ReqRemoveParkedOrder(CThostFtdcRemoveParkedOrderField *pRemoveParkedOrder,
+                                 int nRequestID) override { return -1; }
+
+        int ReqRemoveParkedOrderAction(CThostFtdcRemoveParkedOrderActionField *pRemoveParkedOrderAction,
+                                       int nRequestID) override { return -1; }
+
+        int ReqExecOrderInsert(CThostFtdcInputExecOrderField *pInputExecOrder, int nRequestID) override { return -1; }
+
+        int ReqExecOrderAction(CThostFtdcInputExecOrderActionField *pInputExecOrderAction,
+                               int nRequestID) override { return -1; }
+
+        int ReqForQuoteInsert(CThostFtdcInputForQuoteField *pInputForQuote, int nRequestID) override { return -1; }
+
+        int ReqQuoteInsert(CThostFtdcInputQuoteField *pInputQuote, int nRequestID) override { return -1; }
+
+        int ReqQuoteAction(CThostFtdcInputQuoteActionField *pInputQuoteAction, int nRequestID) override { return -1; }
+
+        int ReqBatchOrderAction(CThostFtdcInputBatchOrderActionField *pInputBatchOrderAction,
+                                int nRequestID) override { return -1; }
+
+        int ReqOptionSelfCloseInsert(CThostFtdcInputOptionSelfCloseField *pInputOptionSelfClose,
+                                     int nRequestID) override { return -1; }
+
+        int ReqOptionSelfCloseAction(CThostFtdcInputOptionSelfCloseActionField *pInputOptionSelfCloseAction,
+                                     int nRequestID) override { return -1; }
+
+        int ReqCombActionInsert(CThostFtdcInputCombActionField *pInputCombAction,
+                                int nRequestID) override { return -1; }
+
+        int ReqQryOrder(CThostFtdcQryOrderField *pQryOrder, int nRequestID) override { return -1; }
+
+        int ReqQryTrade(CThostFtdcQryTradeField *pQryTrade, int nRequestID) override { return -1; }
+
+        int ReqQryTradingAccount(CThostFtdcQryTradingAccountField *pQryTradingAccount,
+                                 int nRequestID) override { return -1; }
+
+        int ReqQryInvestor(CThostFtdcQryInvestorField *pQryInvestor, int nRequestID) override { return -1; }
+
+        int ReqQryTradingCode(CThostFtdcQryTradingCodeField *pQryTradingCode, int nRequestID) override { return -1; }
+
+        int ReqQryInstrumentMarginRate(CThostFtdcQryInstrumentMarginRateField *pQryInstrumentMarginRate,
+                                       int nRequestID) override { return -1; }
+
+        int ReqQryInstrumentCommissionRate(CThostFtdcQryInstrumentCommissionRateField *pQryInstrumentCommissionRate,
+                                           int nRequestID) override { return -1; }
+
+        int ReqQryExchange(CThostFtdcQryExchangeField *pQryExchange, int nRequestID) override { return -1; }
+
+        int ReqQryProduct(CThostFtdcQryProductField *pQryProduct, int nRequestID) override { return -1; }
+
+        int ReqQryInstrument(CThostFtdcQryInstrumentField *pQryInstrument, int nRequestID) override { return -1; }
+
+        int ReqQryDepthMarketData(CThostFtdcQryDepthMarketDataField *pQryDepthMarketData,
+                                  int nRequestID) override { return -1; }
+
+        int ReqQryTraderOffer(CThostFtdcQryTraderOfferField *pQryTraderOffer, int nRequestID) override { return -1; }
+
+        int ReqQrySettlementInfo(CThostFtdcQrySettlementInfoField *pQrySettlementInfo,
+                                 int nRequestID) override { return -1; }
+
+        int ReqQryTransferBank(CThostFtdcQryTransferBankField *pQryTransferBank, int nRequestID) override { return -1; }
+
+        int ReqQryInvestorPositionDetail(CThostFtdcQryInvestorPositionDetailField *pQryInvestorPositionDetail,
+                                         int nRequestID) override { return -1; }
+
+        int ReqQryNotice(CThostFtdcQryNoticeField *pQryNotice, int nRequestID) override { return -1; }
+
+        int ReqQrySettlementInfoConfirm(CThostFtdcQrySettlementInfoConfirmField *pQrySettlementInfoConfirm,
+                                        int nRequestID) override { return -1; }
+
+        int ReqQryInvestorPositionCombineDetail(CThostFtdcQryInvestorPositionCombineDetailField *pQryInvestorPositionCombineDetail,
+                                                int nRequestID) override { return -1; }
+
+        int ReqQryCFMMCTradingAccountKey(CThostFtdcQryCFMMCTradingAccountKeyField *pQryCFMMCTradingAccountKey,
+                                         int nRequestID) override { return -1; }
+
+        int ReqQryEWarrantOffset(CThostFtdcQryEWarrantOffsetField *pQryEWarrantOffset,
+                                 int nRequestID) override { return -1; }
+
+        int ReqQryInvestorProductGroupMargin(CThostFtdcQryInvestorProductGroupMarginField *pQryInvestorProductGroupMargin,
+                                             int nRequestID) override { return -1; }
+
+        int ReqQryExchangeMarginRate(CThostFtdcQryExchangeMarginRateField *pQryExchangeMarginRate,
+                                     int nRequestID) override { return -1; }
+
+        int ReqQryExchangeMarginRateAdjust(CThostFtdcQryExchangeMarginRateAdjustField *pQryExchangeMarginRateAdjust,
+                                           int nRequestID) override { return -1; }
+
+        int ReqQryExchangeRate(CThostFtdcQryExchangeRateField *pQryExchangeRate, int nRequestID) override { return -1; }
+
+        int ReqQrySecAgentACIDMap(CThostFtdcQrySecAgentACIDMapField *pQrySecAgentACIDMap,
+                                  int nRequestID) override { return -1; }
+
+        int ReqQryProductExchRate(CThostFtdcQryProductExchRateField *pQryProductExchRate,
+                                  int nRequestID) override { return -1; }
+
+        int ReqQryProductGroup(CThostFtdcQryProductGroupField *pQryProductGroup, int nRequestID) override { return -1; }
+
+        int ReqQryMMInstrumentCommissionRate(CThostFtdcQryMMInstrumentCommissionRateField *pQryMMInstrumentCommissionRate,
+                                             int nRequestID) override { return -1; }
+
+        int ReqQryMMOptionInstrCommRate(CThostFtdcQryMMOptionInstrCommRateField *pQryMMOptionInstrCommRate,
+                                        int nRequestID) override { return -1; }
+
+        int ReqQryInstrumentOrderCommRate(CThostFtdcQryInstrumentOrderCommRateField *pQryInstrumentOrderCommRate,
+                                          int nRequestID) override { return -1; }
+
+        int ReqQrySecAgentTradingAccount(CThostFtdcQryTradingAccountField *pQryTradingAccount,
+                                         int nRequestID) override { return -1; }
+
+        int ReqQrySecAgentCheckMode(CThostFtdcQrySecAgentCheckModeField *pQrySecAgentCheckMode,
+                                    int nRequestID) override { return -1; }
+
+        int ReqQrySecAgentTradeInfo(CThostFtdcQrySecAgentTradeInfoField *pQrySecAgentTradeInfo,
+                                    int nRequestID) override { return -1; }
+
+        int ReqQryOptionInstrTradeCost(CThostFtdcQryOptionInstrTradeCostField *pQryOptionInstrTradeCost,
+                                       int nRequestID) override { return -1; }
+
+        int ReqQryOptionInstrCommRate(CThostFtdcQryOptionInstrCommRateField *pQryOptionInstrCommRate,
+                                      int nRequestID) override { return -1; }
+
+        int ReqQryExecOrder(CThostFtdcQryExecOrderField *pQryExecOrder, int nRequestID) override { return -1; }
+
+        int ReqQryForQuote(CThostFtdcQryForQuoteField *pQryForQuote, int nRequestID) override { return -1; }
+
+        int ReqQryQuote(CThostFtdcQryQuoteField *pQryQuote, int nRequestID) override { return -1; }
+
+        int ReqQryOptionSelfClose(CThostFtdcQryOptionSelfCloseField *pQryOptionSelfClose,
+                                  int nRequestID) override { return -1; }
+
+        int ReqQryInvestUnit(CThostFtdcQryInvestUnitField *pQryInvestUnit, int nRequestID) override { return -1; }
+
+        int ReqQryCombInstrumentGuard(CThostFtdcQryCombInstrumentGuardField *pQryCombInstrumentGuard,
+                                      int nRequestID) override { return -1; }
+
+        int ReqQryCombAction(CThostFtdcQryCombActionField *pQryCombAction, int nRequestID) override { return -1; }
+
+        int ReqQryTransferSerial(CThostFtdcQryTransferSerialField *pQryTransferSerial,
+                                 int nRequestID) override { return -1; }
+
+        int ReqQryAccountregister(CThostFtdcQryAccountregisterField *pQryAccountregister,
+                                  int nRequestID) override { return -1; }
+
+        int ReqQryContractBank(CThostFtdcQryContractBankField *pQryContractBank, int nRequestID) override { return -1; }
+
+        int ReqQryParkedOrder(CThostFtdcQryParkedOrderField *pQryParkedOrder, int nRequestID) override { return -1; }
+
+        int ReqQryParkedOrderAction(CThostFtdcQryParkedOrderActionField *pQryParkedOrderAction,
+                                    int nRequestID) override { return -1; }
+
+        int ReqQryTradingNotice(CThostFtdcQryTradingNoticeField *pQryTradingNotice,
+                                int nRequestID) override { return -1; }
+
+        int ReqQryBrokerTradingParams(CThostFtdcQryBrokerTradingParamsField *pQryBrokerTradingParams,
+                                      int nRequestID) override { return -1; }
+
+        int ReqQryBrokerTradingAlgos(CThostFtdcQryBrokerTradingAlgosField *pQryBrokerTradingAlgos,
+                                     int nRequestID) override { return -1; }
+
+        int ReqQueryCFMMCTradingAccountToken(CThostFtdcQueryCFMMCTradingAccountTokenField *pQueryCFMMCTradingAccountToken,
+                                             int nRequestID) override { return -1; }
+
+        int ReqFromBankToFutureByFuture(CThostFtdcReqTransferField *pReqTransfer,
+                                        int nRequestID) override { return -1; }
+
+        int ReqFromFutureToBankByFuture(CThostFtdcReqTransferField *pReqTransfer,
+                                        int nRequestID) override { return -1; }
+
+        int ReqQueryBankAccountMoneyByFuture(CThostFtdcReqQueryAccountField *pReqQueryAccount,
+                                             int nRequestID) override { return -1; }
+
+        int ReqQryClassifiedInstrument(CThostFtdcQryClassifiedInstrumentField *pQryClassifiedInstrument,
+                                       int nRequestID) override { return -1; }
+
+        int ReqQryCombPromotionParam(CThostFtdcQryCombPromotionParamField *pQryCombPromotionParam,
+                                     int nRequestID) override { return -1; }
+
+        int ReqQryRiskSettleInvstPosition(CThostFtdcQryRiskSettleInvstPositionField *pQryRiskSettleInvstPosition,
+                                          int nRequestID) override { return -1; }
+
+        int ReqQryRiskSettleProductStatus(CThostFtdcQryRiskSettleProductStatusField *pQryRiskSettleProductStatus,
+                                          int nRequestID) override { return -1; }
+
+        int ReqQrySPBMFutureParameter(CThostFtdcQrySPBMFutureParameterField *pQrySPBMFutureParameter,
+                                      int nRequestID) override { return -1; }
+
+        int ReqQrySPBMOptionParameter(CThostFtdcQrySPBMOptionParameterField *pQrySPBMOptionParameter,
+                                      int nRequestID) override { return -1; }
+
+        int ReqQrySPBMIntraParameter(CThostFtdcQrySPBMIntraParameterField *pQrySPBMIntraParameter,
+                                     int nRequestID) override { return -1; }
+
+        int ReqQrySPBMInterParameter(CThostFtdcQrySPBMInterParameterField *pQrySPBMInterParameter,
+                                     int nRequestID) override { return -1; }
+
+        int ReqQrySPBMPortfDefinition(CThostFtdcQrySPBMPortfDefinitionField *pQrySPBMPortfDefinition,
+                                      int nRequestID) override { return -1; }
+
+        int ReqQrySPBMInvestorPortfDef(CThostFtdcQrySPBMInvestorPortfDefField *pQrySPBMInvestorPortfDef,
+                                       int nRequestID) override { return -1; }
+
+        int ReqQryInvestorPortfMarginRatio(CThostFtdcQryInvestorPortfMarginRatioField *pQryInvestorPortfMarginRatio,
+                                           int nRequestID) override { return -1; }
+
+        int ReqQryInvestorProdSPBMDetail(CThostFtdcQryInvestorProdSPBMDetailField *pQryInvestorProdSPBMDetail,
+                                         int nRequestID) override { return -1; }
+
+        int ReqQryInvestorCommoditySPMMMargin(CThostFtdcQryInvestorCommoditySPMMMarginField *pQryInvestorCommoditySPMMMargin,
+                                              int nRequestID) override { return -1; }
+
+        int ReqQryInvestorCommodityGroupSPMMMargin(CThostFtdcQryInvestorCommodityGroupSPMMMarginField *pQryInvestorCommodityGroupSPMMMargin,
+                                                   int nRequestID) override { return -1; }
+
+        int ReqQrySPMMInstParam(CThostFtdcQrySPMMInstParamField *pQrySPMMInstParam,
+                                int nRequestID) override { return -1; }
+
+        int ReqQrySPMMProductParam(CThostFtdcQrySPMMProductParamField *pQrySPMMProductParam,
+                                   int nRequestID) override { return -1; }
+
+        int ReqQrySPBMAddOnInterParameter(CThostFtdcQrySPBMAddOnInterParameterField *pQrySPBMAddOnInterParameter,
+                                          int nRequestID) override { return -1; }
+
+        int ReqQryRCAMSCombProductInfo(CThostFtdcQryRCAMSCombProductInfoField *pQryRCAMSCombProductInfo,
+                                       int nRequestID) override { return -1; }
+
+        int ReqQryRCAMSInstrParameter(CThostFtdcQryRCAMSInstrParameterField *pQryRCAMSInstrParameter,
+                                      int nRequestID) override { return -1; }
+
+        int ReqQryRCAMSIntraParameter(CThostFtdcQryRCAMSIntraParameterField *pQryRCAMSIntraParameter,
+                                      int nRequestID) override { return -1; }
+
+        int ReqQryRCAMSInterParameter(CThostFtdcQryRCAMSInterParameterField *pQryRCAMSInterParameter,
+                                      int nRequestID) override { return -1; }
+
+        int ReqQryRCAMSShortOptAdjustParam(CThostFtdcQryRCAMSShortOptAdjustParamField *pQryRCAMSShortOptAdjustParam,
+                                           int nRequestID) override { return -1; }
+
+        int ReqQryRCAMSInvestorCombPosition(CThostFtdcQryRCAMSInvestorCombPositionField *pQryRCAMSInvestorCombPosition,
+                                            int nRequestID) override { return -1; }
+
+        int ReqQryInvestorProdRCAMSMargin(CThostFtdcQryInvestorProdRCAMSMarginField *pQryInvestorProdRCAMSMargin,
+                                          int nRequestID) override { return -1; }
+
+        int ReqQryRULEInstrParameter(CThostFtdcQryRULEInstrParameterField *pQryRULEInstrParameter,
+                                     int nRequestID) override { return -1; }
+
+        int ReqQryRULEIntraParameter(CThostFtdcQryRULEIntraParameterField *pQryRULEIntraParameter,
+                                     int nRequestID) override { return -1; }
+
+        int ReqQryRULEInterParameter(CThostFtdcQryRULEInterParameterField *pQryRULEInterParameter,
+                                     int nRequestID) override { return -1; }
+
+        int ReqQryInvestorProdRULEMargin(CThostFtdcQryInvestorProdRULEMarginField *pQryInvestorProdRULEMargin,
+                                         int nRequestID) override { return -1; }
+
+    private:
+        void Run();
+
+        // 在撮合线程上延迟 delay 纳秒执行
+        void Post(int64_t delay, std::function<void()> task);
+
+        void Insert(const CThostFtdcInputOrderField &input, int request_id);
+
+        void Action(const CThostFtdcInputOrderActionField &action, int request_id);
+
+        // 报单与一档行情撮合, resting 为已挂单 (按报单价成交), 返回报单是否已终止
+        bool Match(size_t index, Quote &quote, bool resting);
+
+        // 用最新行情撮合合约上的全部挂单
+        void MatchResting(InstrumentHandle handle);
+
+        void Cancel(CThostFtdcOrderField &order);
+
+        void RejectInsert(const CThostFtdcInputOrderField &input, int request_id, int error_id, const char *error);
+
+        void RejectAction(const CThostFtdcInputOrderActionField &action, int request_id, int error_id,
+                          const char *error);
+
+    private:
+        InstrumentRegistryPtr instruments_;
+        const int64_t latency_;
+        std::string trading_day_;
+        CThostFtdcTraderSpi *spi_ = nullptr;
+
+        // 仅撮合线程访问
+        int32_t session_id_ = 0;
+        std::vector<CThostFtdcOrderField> orders_;
+        // 本模拟的 OrderSysID 为 orders_ 下标加 1
+        absl::flat_hash_map<OrderKey, size_t> by_key_;
+        // 每个合约按时间顺序排列的挂单
+        std::vector<std::vector<size_t>> resting_;
+        std::vector<Quote> books_;
+
+        std::mutex lock_;
+        std::condition_variable condition_;
+        // 按到达时刻排序, 相同时刻按投递顺序
+        std::multimap<int64_t, std::function<void()>> tasks_;
+        // 尚未撮合的最新行情, 按合约句柄索引
+        std::vector<Quote> quotes_;
+        std::vector<InstrumentHandle> dirty_;
+        std::atomic_bool running_{false};
+        std::atomic<uint64_t> trades_{0};
+        std::thread worker_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_SIM_H
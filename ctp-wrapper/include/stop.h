@@ -0,0 +1,117 @@
+#ifndef LUEING_CTP_STOP_H
+#define LUEING_CTP_STOP_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "absl/container/flat_hash_map.h"
+#include "instrument.h"
+#include "order.h"
+#include "tick.h"
+
+namespace lueing {
+    // 平仓单连续失败 (未能发出或被拒单) 时的退避时间 (纳秒), 每次失败加倍
+#define STOP_RETRY_NANOS (1000 * 1000 * 1000LL)
+    // 平仓单连续失败的次数达到上限后停止该方向的止损止盈, 直到持仓重新建立
+#define STOP_MAX_FAILURES 5
+
+    // 发出平仓单: direction 为平仓报单的买卖方向; done 须收到该笔平仓单的回报 (如作为 OrderAsync 的回调),
+    // 未能发出 (如被风控拒绝) 时也须以拒单回报调用, 可在 StopSender 返回前调用
+    typedef std::function<void(InstrumentHandle handle, char direction, double price, int32_t volume,
+                               OrderCallback done)> StopSender;
+
+    // 持仓出现时调用, 用于订阅该合约的行情
+    typedef std::function<void(InstrumentHandle handle)> StopWatcher;
+
+    // 止损止盈: 按成交回报累计持仓与开仓均价, 在行情接收路径上逐笔比较盈亏百分比, 触发时直接发出平仓单
+    // stop_loss 与 stop_profit 为相对开仓均价的百分比, 亏损达到 |stop_loss| 或盈利达到 stop_profit 时平仓, 0 为不启用
+    // 持仓由报单回报线程写入, 行情线程只读原子变量, 两侧不共享锁; 每个方向同一时刻只有一笔平仓单在途
+    // 在途状态与失败次数只按本引擎发出的平仓单的回报 (done) 更新, 手动平仓、改单撤单不影响
+    // 平仓单不超过单笔最大手数, 超出的持仓在该笔平仓单终止后的下一笔行情继续平仓
+    // 平仓单未能发出或被拒单时按 STOP_RETRY_NANOS 起加倍退避, 连续 STOP_MAX_FAILURES 次后停用, 开仓或预置持仓时恢复
+    class StopEngine : public MarketDataObserver {
+    private:
+        struct alignas(64) Side {
+            std::atomic<int32_t> volume{0};
+            std::atomic<double> entry_price{0};
+            // 已发出平仓单, 本引擎的平仓单终止后清除
+            std::atomic_bool firing{false};
+            // 平仓单连续失败的次数与下次允许发出的时间 (单调时钟纳秒)
+            std::atomic<int32_t> failures{0};
+            std::atomic<int64_t> retry_after{0};
+        };
+
+        struct Slot {
+            // 多头、空头
+            Side sides[2];
+        };
+
+        struct Fill {
+            int32_t filled;
+            double turnover;
+        };
+
+    public:
+        // max_order_volume 为单笔平仓单的最大手数, 0 为不限
+        StopEngine(size_t max_instruments, double stop_loss, double stop_profit, int32_t max_order_volume = 0);
+
+        ~StopEngine() override;
+
+    public:
+        // 须在报单与行情到达前设置
+        void SetSender(StopSender sender) { sender_ = std::move(sender); }
+
+        // 设置时对已有持仓的合约调用一次
+        void SetWatcher(StopWatcher watcher);
+
+        // 报单回报 (含手动报单), 开仓成交增加持仓并更新均价, 平仓成交减少持仓
+        void OnOrderReport(const OrderReport &report);
+
+        // 行情接收路径上检查止损止盈
+        void OnMarketData(const CThostFtdcDepthMarketDataField &field, const Tick &tick) override;
+
+        // 预置持仓, direction 为持仓方向 THOST_FTDC_D_Buy (多头) 或 THOST_FTDC_D_Sell (空头)
+        void SetPosition(InstrumentHandle handle, char direction, int32_t volume, double entry_price);
+
+        int32_t Position(InstrumentHandle handle, char direction) const;
+
+        double EntryPrice(InstrumentHandle handle, char direction) const;
+
+        // 平仓单连续失败次数达到上限, 该方向的止损止盈已停用
+        bool Disarmed(InstrumentHandle handle, char direction) const;
+
+        // 已触发的平仓次数
+        uint64_t Triggered() const { return triggered_.load(std::memory_order_relaxed); }
+
+    private:
+        void Check(InstrumentHandle handle, int side, const Tick &tick);
+
+        // 本引擎发出的平仓单的回报, 终止时清除在途状态, 没有成交的拒单计为一次失败
+        void OnCloseReport(InstrumentHandle handle, int side, const OrderReport &report);
+
+        // 平仓单失败一次, 按连续失败次数推迟下次发出
+        static void Fail(Side &side, int64_t now);
+
+        // 持仓重新建立或平仓有成交, 清除失败记录
+        static void Rearm(Side &side);
+
+    private:
+        const size_t max_instruments_;
+        const double stop_loss_;
+        const double stop_profit_;
+        const int32_t max_order_volume_;
+        std::unique_ptr<Slot[]> slots_;
+        StopSender sender_;
+        StopWatcher watcher_;
+        std::atomic<uint64_t> triggered_{0};
+
+        // 各报单已计入的成交, 仅报单回报路径使用
+        std::mutex lock_;
+        absl::flat_hash_map<int32_t, Fill> fills_;
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_STOP_H
@@ -0,0 +1,57 @@
+#ifndef LUEING_CTP_TICK_H
+#define LUEING_CTP_TICK_H
+
+#include <cstdint>
+
+#include "ThostFtdcUserApiStruct.h"
+
+namespace lueing {
+#define TICK_LEVELS 5
+
+    // 归一化后的紧凑行情记录, 由 CThostFtdcDepthMarketDataField 在接收时转换一次
+    // 无效价格 (DBL_MAX) 统一归零, 时间均为纳秒
+    struct alignas(64) Tick {
+        uint32_t instrument;            // 合约句柄, 见 InstrumentRegistry
+        int32_t volume;                 // 当日累计成交量
+        int64_t exchange_time;          // 交易所时间, epoch 纳秒
+        int64_t local_time;             // 本地接收时间, 单调时钟纳秒
+        double last_price;
+        double open_price;
+        double high_price;
+        double low_price;
+        double turnover;                // 当日累计成交额
+        double open_interest;
+        double bid_price[TICK_LEVELS];
+        double ask_price[TICK_LEVELS];
+        int32_t bid_volume[TICK_LEVELS];
+        int32_t ask_volume[TICK_LEVELS];
+    };
+
+    static_assert(sizeof(Tick) == 192, "Tick should span exactly three cache lines");
+
+    // 行情接收路径上的观察者, 在 CTP 回调线程、合约的发布锁内同步调用, 同一合约的行情按顺序到达
+    // 用于风控缓存、止损止盈等需要零跳转的处理, 实现须快速返回且不可阻塞
+    class MarketDataObserver {
+    public:
+        virtual ~MarketDataObserver() = default;
+
+        virtual void OnMarketData(const CThostFtdcDepthMarketDataField &field, const Tick &tick) = 0;
+    };
+
+    // 本地单调时钟 (Linux 下为 CLOCK_MONOTONIC_RAW), 纳秒, 用于本机内的延迟计算
+    int64_t MonotonicNanos();
+
+    // 本地系统时钟, epoch 纳秒
+    int64_t WallClockNanos();
+
+    // 将交易所日期 (YYYYMMDD)、时间 (HH:MM:SS) 与毫秒转换为 epoch 纳秒 (北京时间)
+    int64_t ExchangeNanos(const char *date, const char *time, int millisec);
+
+    // 计算行情的交易所时间, 修正大商所/郑商所夜盘 ActionDay 填写为交易日的问题
+    int64_t ExchangeNanos(const CThostFtdcDepthMarketDataField &field);
+
+    // 转换 CTP 行情为紧凑记录
+    void ToTick(const CThostFtdcDepthMarketDataField &field, uint32_t instrument, int64_t local_time, Tick &tick);
+} // namespace lueing
+
+#endif // LUEING_CTP_TICK_H
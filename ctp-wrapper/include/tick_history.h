@@ -0,0 +1,209 @@
+#ifndef LUEING_CTP_TICK_HISTORY_H
+#define LUEING_CTP_TICK_HISTORY_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "tick.h"
+
+namespace lueing {
+    // 每个块容纳的行情条数, 必须为 2 的幂
+#define TICK_BLOCK_BITS 8
+#define TICK_BLOCK_SIZE (1u << TICK_BLOCK_BITS)
+
+    // 定长行情块, 由 TickBlockPool 分配, 在合约之间回收复用, 内存直到进程退出才释放
+    struct TickBlock {
+        struct alignas(64) Slot {
+            // 2 * index + 1: 正在写入; 2 * index + 2: 写入完成
+            std::atomic<uint64_t> sequence{0};
+            Tick value;
+        };
+
+        // 所属合约与块号, 读线程据此识别已被回收给其他合约的块; 0 表示空闲
+        std::atomic<uint64_t> tag{0};
+        // 块内最后一条行情的本地时间, 仅写线程访问
+        int64_t last_time = 0;
+        Slot slots[TICK_BLOCK_SIZE];
+    };
+
+    // 行情块池: 块按批预分配 (冷路径), 空闲块放在无锁队列中, 写线程取块、还块都不分配内存
+    class TickBlockPool {
+    public:
+        // max_blocks 为块总数上限 (内存预算)
+        explicit TickBlockPool(size_t max_blocks);
+
+        ~TickBlockPool();
+
+        TickBlockPool(const TickBlockPool &) = delete;
+
+        TickBlockPool &operator=(const TickBlockPool &) = delete;
+
+    public:
+        // 预分配到共计至少 total 个块 (含正在使用的), 不超过上限; 在订阅时调用
+        void Grow(size_t total);
+
+        // 取一个空闲块, 池已空时返回 nullptr
+        TickBlock *Allocate()
+        {
+            TickBlock *block = nullptr;
+            return free_.TryPop(block) ? block : nullptr;
+        }
+
+        void Free(TickBlock *block)
+        {
+            block->tag.store(0, std::memory_order_relaxed);
+            free_.TryPush(block);
+        }
+
+        size_t MaxBlocks() const { return max_blocks_; }
+
+        // 已分配的块数, 含正在使用与空闲的
+        size_t Allocated() const { return allocated_.load(std::memory_order_acquire); }
+
+        size_t Available() const { return free_.Size(); }
+
+    private:
+        const size_t max_blocks_;
+        BoundedQueue<TickBlock *> free_;
+        std::mutex lock_;
+        std::vector<std::unique_ptr<TickBlock[]>> slabs_;
+        std::atomic<size_t> allocated_{0};
+    };
+
+    // 单个合约的行情历史, 由若干行情块串成, 追加时只在块写满后换块, 不搬移旧数据
+    // 保留策略在换块时执行: 最近 max_ticks 条 (按块向上取整), 以及可选的最近 retention_ns 时间;
+    // 池中无空闲块 (超出内存预算) 时复用本合约最旧的块
+    // 写线程单一 (Push/Clear 由调用方串行化), 读线程无锁, 读到已回收或正在覆盖的数据时返回 false
+    class TickHistory {
+    public:
+        TickHistory(TickBlockPool &pool, uint32_t id, size_t max_ticks, int64_t retention_ns);
+
+        ~TickHistory();
+
+        TickHistory(const TickHistory &) = delete;
+
+        TickHistory &operator=(const TickHistory &) = delete;
+
+    public:
+        // 最多保留的行情条数
+        size_t Capacity() const { return max_blocks_ * TICK_BLOCK_SIZE; }
+
+        // 已写入的总条数, 下一条写入的序号
+        uint64_t Head() const { return head_.load(std::memory_order_acquire); }
+
+        // 仍可读取的最早序号
+        uint64_t Tail() const { return tail_.load(std::memory_order_acquire); }
+
+        bool Empty() const { return 0 == Head(); }
+
+        // 占用的块数
+        size_t Blocks() const { return held_.load(std::memory_order_acquire); }
+
+        // 追加一条行情, 无可用块时丢弃并返回 false
+        bool Push(const Tick &tick)
+        {
+            uint64_t index = head_.load(std::memory_order_relaxed);
+            if (0 == (index & (TICK_BLOCK_SIZE - 1)) && !Advance(index >> TICK_BLOCK_BITS, tick.local_time))
+            {
+                return false;
+            }
+            TickBlock::Slot &slot = current_->slots[index & (TICK_BLOCK_SIZE - 1)];
+            slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(static_cast<void *>(&slot.value), &tick, sizeof(Tick));
+            slot.sequence.store(2 * index + 2, std::memory_order_release);
+            current_->last_time = tick.local_time;
+            head_.store(index + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 读取指定序号的数据, 数据已被回收、覆盖或尚未写入时返回 false
+        bool Read(uint64_t index, Tick &out) const
+        {
+            uint64_t number = index >> TICK_BLOCK_BITS;
+            const TickBlock *block = directory_[number & directory_mask_].load(std::memory_order_acquire);
+            uint64_t tag = Tag(number);
+            if (nullptr == block || block->tag.load(std::memory_order_acquire) != tag)
+            {
+                return false;
+            }
+            const TickBlock::Slot &slot = block->slots[index & (TICK_BLOCK_SIZE - 1)];
+            uint64_t expected = 2 * index + 2;
+            if (slot.sequence.load(std::memory_order_acquire) != expected)
+            {
+                return false;
+            }
+            std::memcpy(static_cast<void *>(&out), &slot.value, sizeof(Tick));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return slot.sequence.load(std::memory_order_relaxed) == expected
+                   && block->tag.load(std::memory_order_relaxed) == tag;
+        }
+
+        // 读取最新一条数据
+        bool Latest(Tick &out) const
+        {
+            for (;;)
+            {
+                uint64_t head = Head();
+                if (0 == head || head <= Tail())
+                {
+                    return false;
+                }
+                if (Read(head - 1, out))
+                {
+                    return true;
+                }
+            }
+        }
+
+        // 追加 [from, Head()) 区间内仍可读取的数据, 返回下一次读取的起始序号
+        uint64_t ReadFrom(uint64_t from, std::vector<Tick> &out) const
+        {
+            uint64_t head = Head();
+            uint64_t tail = Tail();
+            Tick value;
+            for (uint64_t i = from > tail ? from : tail; i < head; i++)
+            {
+                if (Read(i, value))
+                {
+                    out.push_back(value);
+                }
+            }
+            return head;
+        }
+
+        // 归还全部块, 序号跳到下一个块的起点; 取消订阅时调用
+        void Clear();
+
+    private:
+        uint64_t Tag(uint64_t number) const { return (static_cast<uint64_t>(id_) + 1) << 40 | number; }
+
+        // 换块: 按保留策略回收旧块, 再取新块登记为第 number 块
+        bool Advance(uint64_t number, int64_t now);
+
+        // 回收最旧的块, 返回该块
+        TickBlock *Retire();
+
+    private:
+        TickBlockPool &pool_;
+        const uint32_t id_;
+        const size_t max_blocks_;
+        const int64_t retention_ns_;
+        size_t directory_mask_;
+        // 第 n 块存放在 directory_[n & directory_mask_]
+        std::unique_ptr<std::atomic<TickBlock *>[]> directory_;
+        // 仅写线程访问
+        TickBlock *current_ = nullptr;
+        uint64_t first_ = 0;
+        std::atomic<size_t> held_{0};
+        alignas(64) std::atomic<uint64_t> head_{0};
+        std::atomic<uint64_t> tail_{0};
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_TICK_HISTORY_H
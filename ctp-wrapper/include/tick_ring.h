@@ -0,0 +1,127 @@
+#ifndef LUEING_CTP_TICK_RING_H
+#define LUEING_CTP_TICK_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace lueing {
+    // 单写多读的定长环形缓冲区
+    // 写线程 (CTP 回调线程) 无锁、无内存分配; 读线程通过每个槽位的序号校验读取一致的数据,
+    // 读到正在被覆盖的槽位时返回 false, 永远不会阻塞写线程
+    template<typename T>
+    class TickRing {
+        static_assert(std::is_trivially_copyable<T>::value, "TickRing requires trivially copyable elements");
+
+    private:
+        struct alignas(64) Slot {
+            // 2 * index + 1: 正在写入; 2 * index + 2: 写入完成
+            std::atomic<uint64_t> sequence{0};
+            T value;
+        };
+
+    public:
+        explicit TickRing(size_t capacity) : capacity_(RoundUp(capacity)), mask_(capacity_ - 1),
+                                             slots_(new Slot[capacity_]) {}
+
+        TickRing(const TickRing &) = delete;
+
+        TickRing &operator=(const TickRing &) = delete;
+
+    public:
+        size_t Capacity() const { return capacity_; }
+
+        // 已写入的总条数, 下一条写入的序号
+        uint64_t Head() const { return head_.load(std::memory_order_acquire); }
+
+        // 仍可读取的最早序号
+        uint64_t Tail() const
+        {
+            uint64_t head = Head();
+            return head > capacity_ ? head - capacity_ : 0;
+        }
+
+        bool Empty() const { return 0 == Head(); }
+
+        // 仅限单个写线程调用
+        void Push(const T &value)
+        {
+            uint64_t index = head_.load(std::memory_order_relaxed);
+            Slot &slot = slots_[index & mask_];
+            slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(static_cast<void *>(&slot.value), &value, sizeof(T));
+            slot.sequence.store(2 * index + 2, std::memory_order_release);
+            head_.store(index + 1, std::memory_order_release);
+        }
+
+        // 读取指定序号的数据, 数据已被覆盖或尚未写入时返回 false
+        bool Read(uint64_t index, T &out) const
+        {
+            const Slot &slot = slots_[index & mask_];
+            uint64_t expected = 2 * index + 2;
+            if (slot.sequence.load(std::memory_order_acquire) != expected)
+            {
+                return false;
+            }
+            std::memcpy(static_cast<void *>(&out), &slot.value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return slot.sequence.load(std::memory_order_relaxed) == expected;
+        }
+
+        // 读取最新一条数据
+        bool Latest(T &out) const
+        {
+            for (;;)
+            {
+                uint64_t head = Head();
+                if (0 == head)
+                {
+                    return false;
+                }
+                if (Read(head - 1, out))
+                {
+                    return true;
+                }
+            }
+        }
+
+        // 追加 [from, Head()) 区间内仍可读取的数据, 返回下一次读取的起始序号
+        uint64_t ReadFrom(uint64_t from, std::vector<T> &out) const
+        {
+            uint64_t head = Head();
+            uint64_t tail = head > capacity_ ? head - capacity_ : 0;
+            T value;
+            for (uint64_t i = from > tail ? from : tail; i < head; i++)
+            {
+                if (Read(i, value))
+                {
+                    out.push_back(value);
+                }
+            }
+            return head;
+        }
+
+    private:
+        static size_t RoundUp(size_t capacity)
+        {
+            size_t size = 1;
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            return size;
+        }
+
+    private:
+        const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<Slot[]> slots_;
+        alignas(64) std::atomic<uint64_t> head_{0};
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_TICK_RING_H
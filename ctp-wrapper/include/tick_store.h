@@ -0,0 +1,55 @@
+#ifndef LUEING_CTP_TICK_STORE_H
+#define LUEING_CTP_TICK_STORE_H
+
+#include <atomic>
+#include <memory>
+
+#include "instrument.h"
+#include "tick.h"
+#include "tick_history.h"
+
+namespace lueing {
+    // 按合约划分的行情存储, 每个合约一段由行情块串成的历史, 以合约句柄为下标
+    // 行情块来自进程内共享的块池: 取消订阅时归还, 供其他合约复用; 总内存不超过预算
+    // Reserve/Release 在订阅、取消订阅时调用 (调用方负责串行化, Release 还需与该合约的写入串行化),
+    // At 可在任意线程无锁调用
+    class TickStore {
+    public:
+        // history_ticks: 每个合约至少保留的最近行情条数; retention_ns: 大于 0 时只保留最近这段时间的行情;
+        // memory_budget: 行情块总字节数上限, 0 为按 max_instruments * history_ticks 计
+        TickStore(size_t max_instruments, size_t history_ticks, int64_t retention_ns = 0, size_t memory_budget = 0);
+
+        ~TickStore();
+
+    public:
+        // 为合约启用行情历史并预分配行情块, 已启用时直接返回; 句柄越界时返回 nullptr
+        TickHistory *Reserve(InstrumentHandle handle);
+
+        // 停用合约的行情历史并归还行情块, 之后 At 返回 nullptr
+        void Release(InstrumentHandle handle);
+
+        // 按合约句柄取行情历史, 未订阅时返回 nullptr
+        TickHistory *At(InstrumentHandle handle) const
+        {
+            return handle < max_instruments_ ? active_[handle].load(std::memory_order_acquire) : nullptr;
+        }
+
+        size_t Size() const { return size_.load(std::memory_order_acquire); }
+
+        bool Empty() const { return 0 == Size(); }
+
+        const TickBlockPool &Pool() const { return pool_; }
+
+    private:
+        const size_t max_instruments_;
+        const size_t history_ticks_;
+        const int64_t retention_ns_;
+        TickBlockPool pool_;
+        // 历史对象在首次订阅时创建, 直到析构才释放, 读线程持有的指针始终有效
+        std::unique_ptr<std::unique_ptr<TickHistory>[]> histories_;
+        std::unique_ptr<std::atomic<TickHistory *>[]> active_;
+        std::atomic<size_t> size_{0};
+    };
+} // namespace lueing
+
+#endif // LUEING_CTP_TICK_STORE_H
@@ -4,7 +4,18 @@
 #include "config.h"
 #include "lueing_iconv.h"
 #include "events.h"
+#include "order.h"
+#include "order_template.h"
+#include "risk.h"
+#include "stop.h"
+#include "position.h"
+#include "hq.h"
+#include "sim.h"
+#include "governor.h"
+#include "query.h"
+#include "instrument_master.h"
 #include "ThostFtdcTraderApi.h"
+#include <absl/container/flat_hash_map.h>
 
 namespace lueing {
 
@@ -19,9 +30,74 @@ namespace lueing {
         CtpConfigPtr config_;
         LueingIconv gbk_to_utf8_converter_;
         Events events_;
-        absl::node_hash_map<std::string, std::vector<CThostFtdcTradeField>> trade_data_;
-        absl::node_hash_set<std::string> trade_finish_;
+        // 报单状态机, 按 (FrontID, SessionID, OrderRef) 跟踪本会话的报单
+        OrderTracker orders_;
+        // 预先填好的报单, 报单时只写入价格、数量与编号
+        OrderTemplates templates_;
+        // 报单前风控, 价格缓存需注册为行情观察者 (CtpHq::AddObserver)
+        RiskEngine risk_;
+        // 止损止盈, 同样需注册为行情观察者
+        StopEngine stops_;
+        // 持仓簿, 登录后查询持仓建立, 之后按成交更新
+        PositionBook positions_;
+        // 持仓查询完成前的成交已包含在查询结果中, 不重复计入
+        std::atomic_bool positions_ready_{false};
+        // 报单、撤单与查询的流控出口
+        RequestGovernor governor_;
+        // 在途的通用查询, 按 nRequestID 匹配响应
+        QueryTable queries_;
+        // 合约静态数据, 每个交易日查询一次并缓存到文件
+        InstrumentMaster master_;
+        // 登录应答中的交易日, 仅 CTP 回调线程访问
+        std::string trading_day_;
         CThostFtdcTraderApi *user_tx_api_ = nullptr;
+        // 模拟交易 (fake_x > 0) 时与 user_tx_api_ 指向同一对象, 需注册为行情观察者才有成交
+        SimTraderApi *sim_tx_api_ = nullptr;
+
+    private:
+        int SendCancel(const OrderAddress &address);
+
+        // 登记查询并经流控发出, 未能发出时以 ReqQry* 的返回值结束查询
+        template<typename Request>
+        void SendQuery(const Request &request, QuerySink *sink) {
+            int32_t request_id = config_->tx_request_id.fetch_add(1);
+            if (!queries_.Register(request_id, sink)) {
+                return;
+            }
+            auto fail = [this, request_id](int result) {
+                queries_.Abort(request_id, result, "ReqQry failed");
+            };
+            Request field = request;
+            int result = governor_.Submit(RequestClass::Query, [this, field, request_id]() mutable {
+                return QueryTraits<Request>::Send(user_tx_api_, &field, request_id);
+            }, fail);
+            if (0 != result) {
+                fail(result);
+            }
+        }
+
+        // 加载当前交易日的合约数据: 先读缓存文件, 没有时查询全部合约; 加载完成或失败后调用 ready
+        void LoadInstruments(std::function<void()> ready);
+
+        // 将合约数据同步到持仓簿 (合约乘数)、合约登记表与报单模板 (交易所)
+        void ApplyInstrument(InstrumentHandle handle);
+
+        // 将查询响应交给在途查询表
+        template<typename Response>
+        void Respond(Response *row, CThostFtdcRspInfoField *info, int request_id, bool last) {
+            int error_id = nullptr != info ? info->ErrorID : 0;
+            queries_.Complete(row, error_id, 0 != error_id ? gbk_to_utf8_converter_.GBK2UTF8(info->ErrorMsg) : "",
+                              request_id, last);
+        }
+
+        // 查询全部持仓, 重建持仓簿
+        void QueryPositions();
+
+        // 以持仓查询结果重建持仓簿, 并同步到风控与止损止盈
+        void SeedPositions(const std::vector<CThostFtdcInvestorPositionField> &rows);
+
+        // 报出撤单已完成的改单, 在报单、成交回报之后调用
+        void SendReplaces();
 
     public:
         explicit CtpTxHandler(CtpConfigPtr config);
@@ -31,8 +107,66 @@ namespace lueing {
     public:
         void CreateTxContext();
 
+        // 报单并等待其终止 (全部成交、撤单或拒单), 返回成交均价, 没有成交时返回 -1
         double Order(const std::string &exchange, const std::string &contract, TxDirection direction, double price, int amt);
 
+        // 异步报单, 发送后立即返回; callback 在每次状态变化或成交时调用 (CTP 回调线程), ticket.done 在全部成交、撤单或拒单时就绪
+        OrderTicket OrderAsync(const std::string &exchange, const std::string &contract, TxDirection direction,
+                               double price, int amt, OrderCallback callback = nullptr);
+
+        // 按合约句柄报单, 不查找合约也不拼装报单; 合约须先经 WarmOrder 生成模板, 否则直接拒单
+        OrderTicket OrderAsync(InstrumentHandle handle, TxDirection direction, TThostFtdcOffsetFlagType offset,
+                               double price, int amt, OrderCallback callback = nullptr);
+
+        // 为合约生成报单模板, 返回合约句柄; 应在订阅或开盘前调用, 避免首笔报单在发送路径上生成
+        // exchange 为空时按合约主数据确定交易所
+        InstrumentHandle WarmOrder(const std::string &exchange, const std::string &contract);
+
+        // 撤单, 返回 0 表示撤单请求已发送或因流控排队, -1 表示报单未知或已终止, 其他为 ReqOrderAction 的返回值
+        // 撤单结果由报单回调推送: 成功时报单变为 Cancelled, 失败时推送 error_id/error
+        int Cancel(int32_t order_ref);
+
+        // 改单: 撤销原报单, 撤单完成后立即按新价格报出剩余数量
+        ReplaceTicket Replace(int32_t order_ref, double price, OrderCallback callback = nullptr);
+
+        OrderTracker &Orders() { return orders_; }
+
+        RiskEngine &Risk() { return risk_; }
+
+        StopEngine &Stops() { return stops_; }
+
+        PositionBook &Positions() { return positions_; }
+
+        bool PositionsReady() const { return positions_ready_.load(std::memory_order_acquire); }
+
+        InstrumentRegistryPtr Instruments() { return config_->instruments; }
+
+        // 通用查询: 发出 Request 对应的 ReqQry*, 经流控排队, 可连续发起多个
+        // future 在最后一条响应到达时得到全部记录 (没有记录时为空); 未能发出、柜台返回错误或断线时抛出 QueryError
+        template<typename Request>
+        std::future<std::vector<typename QueryTraits<Request>::Response>> Query(const Request &request) {
+            auto *collector = new QueryCollector<typename QueryTraits<Request>::Response>();
+            auto future = collector->Future();
+            SendQuery(request, collector);
+            return future;
+        }
+
+        // 通用查询, 以回调代替 future, 回调在 CTP 回调线程执行
+        template<typename Request>
+        void Query(const Request &request,
+                   typename QueryCallback<typename QueryTraits<Request>::Response>::Callback callback) {
+            SendQuery(request, new QueryCallback<typename QueryTraits<Request>::Response>(std::move(callback)));
+        }
+
+        // 合约静态数据: 交易所、最小变动价位、合约乘数等, 登录后加载
+        const InstrumentMaster &Master() const { return master_; }
+
+        // 流控统计: 排队深度、等待时间与被柜台流控的次数
+        GovernorStats FlowControl(RequestClass request_class) const { return governor_.Stats(request_class); }
+
+        // 模拟撮合, 非模拟交易时为 nullptr
+        SimTraderApi *Simulator() { return sim_tx_api_; }
+
     public:
         /// 当客户端与交易后台建立起通信连接时（还未登录前），该方法被调用。
         void OnFrontConnected() override;
@@ -668,6 +802,8 @@ namespace lueing {
     class CtpTx {
     private:
         CtpTxHandler tx_handler_;
+        // Protect 接入的行情, 析构时从中注销观察者
+        CtpHq *hq_ = nullptr;
 
     public:
         explicit CtpTx(CtpConfigPtr config);
@@ -676,6 +812,66 @@ namespace lueing {
 
     public:
         double Order(const std::string &exchange, const std::string &contract, TxDirection direction, double price, int amt);
+
+        // 异步报单, 不阻塞调用线程, 可同时有多笔报单在途
+        OrderTicket OrderAsync(const std::string &exchange, const std::string &contract, TxDirection direction,
+                               double price, int amt, OrderCallback callback = nullptr);
+
+        OrderTicket OrderAsync(InstrumentHandle handle, TxDirection direction, TThostFtdcOffsetFlagType offset,
+                               double price, int amt, OrderCallback callback = nullptr);
+
+        // 按合约主数据确定交易所, 登录后合约数据加载完成才能使用
+        double Order(const std::string &contract, TxDirection direction, double price, int amt)
+        {
+            return tx_handler_.Order("", contract, direction, price, amt);
+        }
+
+        OrderTicket OrderAsync(const std::string &contract, TxDirection direction, double price, int amt,
+                               OrderCallback callback = nullptr)
+        {
+            return tx_handler_.OrderAsync("", contract, direction, price, amt, std::move(callback));
+        }
+
+        InstrumentHandle WarmOrder(const std::string &exchange, const std::string &contract)
+        {
+            return tx_handler_.WarmOrder(exchange, contract);
+        }
+
+        int Cancel(int32_t order_ref) { return tx_handler_.Cancel(order_ref); }
+
+        // 报单前风控, 注册到行情 (CtpHq::AddObserver) 后才有涨跌停与偏离检查
+        RiskEngine &Risk() { return tx_handler_.Risk(); }
+
+        StopEngine &Stops() { return tx_handler_.Stops(); }
+
+        // 持仓与盈亏, 无锁读取; 登录后的持仓查询完成前 PositionsReady 为 false
+        PositionBook &Positions() { return tx_handler_.Positions(); }
+
+        bool PositionsReady() const { return tx_handler_.PositionsReady(); }
+
+        // 通用查询, 如 Query(CThostFtdcQryInstrumentField{}) 得到全部合约
+        template<typename Request>
+        std::future<std::vector<typename QueryTraits<Request>::Response>> Query(const Request &request) {
+            return tx_handler_.Query(request);
+        }
+
+        // 合约静态数据, 登录后加载; 可按合约句柄无锁查询
+        const InstrumentMaster &Master() const { return tx_handler_.Master(); }
+
+        // 报单 (含撤单) 与查询的流控统计
+        GovernorStats FlowControl(RequestClass request_class) const { return tx_handler_.FlowControl(request_class); }
+
+        // 接入行情: 风控、止损止盈与持仓盯市注册为行情观察者, 有持仓的合约自动订阅行情; hq 须比本对象存活更久
+        // 模拟交易时模拟撮合也注册为行情观察者, 报单合约须已订阅行情才能成交
+        void Protect(CtpHq &hq);
+
+        ReplaceTicket Replace(int32_t order_ref, double price, OrderCallback callback = nullptr)
+        {
+            return tx_handler_.Replace(order_ref, price, std::move(callback));
+        }
+
+        // 读取报单进度, 未知报单返回 false
+        bool OrderStatusOf(int32_t order_ref, OrderReport &out) { return tx_handler_.Orders().Report(order_ref, out); }
     };
 
     typedef std::shared_ptr<CtpTx> CtpTxPtr;
@@ -0,0 +1,107 @@
+#include "instrument.h"
+
+#include <cstring>
+
+lueing::InstrumentRegistry::InstrumentRegistry(size_t capacity) : capacity_(capacity)
+{
+    // 负载因子不超过 0.5, 保证线性探测足够短
+    size_t buckets = 1;
+    while (buckets < capacity_ * 2)
+    {
+        buckets <<= 1;
+    }
+    mask_ = buckets - 1;
+    buckets_.reset(new Bucket[buckets]);
+    entries_.reset(new Entry[capacity_]());
+}
+
+lueing::InstrumentRegistry::~InstrumentRegistry()
+= default;
+
+lueing::InstrumentHandle lueing::InstrumentRegistry::Intern(const std::string &instrument, const std::string &exchange)
+{
+    Key key;
+    if (!Pack(instrument.c_str(), key) || exchange.size() >= sizeof(TThostFtdcExchangeIDType))
+    {
+        return INVALID_INSTRUMENT;
+    }
+    std::unique_lock<std::mutex> lock(lock_);
+    for (size_t i = Hash(key);; i++)
+    {
+        Bucket &bucket = buckets_[i & mask_];
+        InstrumentHandle handle = bucket.handle.load(std::memory_order_acquire);
+        if (INVALID_INSTRUMENT == handle)
+        {
+            size_t size = size_.load(std::memory_order_relaxed);
+            if (size >= capacity_)
+            {
+                return INVALID_INSTRUMENT;
+            }
+            handle = static_cast<InstrumentHandle>(size);
+            std::strcpy(entries_[handle].instrument, instrument.c_str());
+            std::strcpy(entries_[handle].exchange, exchange.c_str());
+            bucket.key = key;
+            // 先写键和合约信息, 再发布句柄
+            size_.store(size + 1, std::memory_order_release);
+            bucket.handle.store(handle, std::memory_order_release);
+            return handle;
+        }
+        if (0 == std::memcmp(bucket.key.words, key.words, sizeof(key.words)))
+        {
+            if (0 == entries_[handle].exchange[0] && !exchange.empty())
+            {
+                std::strcpy(entries_[handle].exchange, exchange.c_str());
+            }
+            return handle;
+        }
+    }
+}
+
+lueing::InstrumentHandle lueing::InstrumentRegistry::Find(const char *instrument) const
+{
+    Key key;
+    if (!Pack(instrument, key))
+    {
+        return INVALID_INSTRUMENT;
+    }
+    for (size_t i = Hash(key);; i++)
+    {
+        const Bucket &bucket = buckets_[i & mask_];
+        InstrumentHandle handle = bucket.handle.load(std::memory_order_acquire);
+        if (INVALID_INSTRUMENT == handle)
+        {
+            return INVALID_INSTRUMENT;
+        }
+        if (bucket.key.words[0] == key.words[0] && bucket.key.words[1] == key.words[1]
+            && bucket.key.words[2] == key.words[2] && bucket.key.words[3] == key.words[3])
+        {
+            return handle;
+        }
+    }
+}
+
+bool lueing::InstrumentRegistry::Pack(const char *instrument, Key &key)
+{
+    // 合约代码最长 31 字节, 以保证补零后的 32 字节键唯一
+    std::memset(key.words, 0, sizeof(key.words));
+    char *bytes = reinterpret_cast<char *>(key.words);
+    size_t length = 0;
+    for (; instrument[length]; length++)
+    {
+        if (length >= sizeof(key.words) - 1)
+        {
+            return false;
+        }
+        bytes[length] = instrument[length];
+    }
+    return length > 0;
+}
+
+size_t lueing::InstrumentRegistry::Hash(const Key &key)
+{
+    uint64_t hash = key.words[0] * 0x9E3779B97F4A7C15ULL;
+    hash ^= key.words[1] * 0xC2B2AE3D27D4EB4FULL;
+    hash ^= key.words[2] * 0x165667B19E3779F9ULL;
+    hash ^= key.words[3] * 0x27D4EB2F165667C5ULL;
+    return static_cast<size_t>(hash ^ (hash >> 29));
+}
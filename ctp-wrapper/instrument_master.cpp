@@ -0,0 +1,247 @@
+#include "instrument_master.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+namespace {
+    // 价格换算为最小变动价位个数时容许的浮点误差
+    constexpr double kTickEpsilon = 1e-6;
+
+    bool Less(const lueing::InstrumentInfo &left, const lueing::InstrumentInfo &right)
+    {
+        return std::strncmp(left.instrument, right.instrument, sizeof(left.instrument)) < 0;
+    }
+
+    template<size_t N>
+    bool Copy(char (&to)[N], const char *from)
+    {
+        size_t length = strnlen(from, N);
+        if (length >= N)
+        {
+            return false;
+        }
+        std::memcpy(to, from, length);
+        return true;
+    }
+}
+
+lueing::InstrumentMaster::InstrumentMaster(InstrumentRegistryPtr instruments, std::string directory)
+    : instruments_(std::move(instruments)), directory_(std::move(directory)),
+      by_handle_(new std::atomic<const InstrumentInfo *>[instruments_->Capacity()])
+{
+    for (size_t i = 0; i < instruments_->Capacity(); i++)
+    {
+        by_handle_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+lueing::InstrumentMaster::~InstrumentMaster()
+= default;
+
+std::string lueing::InstrumentMaster::Path(const std::string &directory, const std::string &trading_day)
+{
+    return (std::filesystem::path(directory) / ("instruments-" + trading_day + ".bin")).string();
+}
+
+bool lueing::InstrumentMaster::Load(const std::string &trading_day)
+{
+    namespace bip = boost::interprocess;
+    std::string path = Path(directory_, trading_day);
+    std::error_code error;
+    if (!std::filesystem::exists(path, error))
+    {
+        return false;
+    }
+    try
+    {
+        std::unique_ptr<Snapshot> snapshot(new Snapshot());
+        snapshot->file = bip::file_mapping(path.c_str(), bip::read_only);
+        snapshot->region = bip::mapped_region(snapshot->file, bip::read_only);
+        auto *header = static_cast<const InstrumentMasterHeader *>(snapshot->region.get_address());
+        if (snapshot->region.get_size() < sizeof(InstrumentMasterHeader)
+            || INSTRUMENT_MASTER_MAGIC != header->magic || INSTRUMENT_MASTER_VERSION != header->version
+            || sizeof(InstrumentInfo) != header->record_size
+            || 0 != strncmp(trading_day.c_str(), header->trading_day, sizeof(header->trading_day))
+            || snapshot->region.get_size() < sizeof(InstrumentMasterHeader) + header->count * sizeof(InstrumentInfo))
+        {
+            spdlog::warn("[合约主数据] 文件格式不符, 忽略: {}", path);
+            return false;
+        }
+        snapshot->records = reinterpret_cast<const InstrumentInfo *>(header + 1);
+        snapshot->count = header->count;
+        snapshot->trading_day = trading_day;
+        std::unique_lock<std::mutex> lock(lock_);
+        Publish(std::move(snapshot));
+    }
+    catch (const bip::interprocess_exception &e)
+    {
+        spdlog::warn("[合约主数据] 映射文件失败: {}, {}", path, e.what());
+        return false;
+    }
+    spdlog::info("[合约主数据] 已加载缓存, 交易日: {}, 合约数: {}", trading_day, Size());
+    return true;
+}
+
+bool lueing::InstrumentMaster::Update(const std::string &trading_day,
+                                      const std::vector<CThostFtdcInstrumentField> &rows)
+{
+    std::vector<InstrumentInfo> records;
+    records.reserve(rows.size());
+    for (const CThostFtdcInstrumentField &row : rows)
+    {
+        // 合约代码超过 31 个字符的无法放入定长记录, 与 InstrumentRegistry 的限制一致
+        if (0 != row.InstrumentID[0] && strnlen(row.InstrumentID, sizeof(InstrumentInfo::instrument))
+                                        < sizeof(InstrumentInfo::instrument))
+        {
+            records.push_back(Convert(row));
+        }
+    }
+    std::sort(records.begin(), records.end(), Less);
+    records.erase(std::unique(records.begin(), records.end(), [](const InstrumentInfo &left,
+                                                                 const InstrumentInfo &right) {
+        return !Less(left, right) && !Less(right, left);
+    }), records.end());
+
+    // 先写临时文件再改名, 重启时不会映射到写了一半的文件
+    std::string path = Path(directory_, trading_day);
+    std::string temporary = path + ".tmp";
+    bool saved = false;
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory_, error);
+        InstrumentMasterHeader header{};
+        header.magic = INSTRUMENT_MASTER_MAGIC;
+        header.version = INSTRUMENT_MASTER_VERSION;
+        header.record_size = sizeof(InstrumentInfo);
+        header.count = static_cast<uint32_t>(records.size());
+        std::strncpy(header.trading_day, trading_day.c_str(), sizeof(header.trading_day) - 1);
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(records.data()),
+                   static_cast<std::streamsize>(records.size() * sizeof(InstrumentInfo)));
+        file.close();
+        if (file)
+        {
+            std::filesystem::rename(temporary, path, error);
+            saved = !error;
+        }
+    }
+    if (saved && Load(trading_day))
+    {
+        return true;
+    }
+    spdlog::warn("[合约主数据] 写入缓存失败, 仅在内存中使用: {}", path);
+    std::unique_ptr<Snapshot> snapshot(new Snapshot());
+    snapshot->owned = std::move(records);
+    snapshot->records = snapshot->owned.data();
+    snapshot->count = snapshot->owned.size();
+    snapshot->trading_day = trading_day;
+    std::unique_lock<std::mutex> lock(lock_);
+    Publish(std::move(snapshot));
+    return false;
+}
+
+void lueing::InstrumentMaster::Publish(std::unique_ptr<Snapshot> snapshot)
+{
+    current_.store(snapshot.get(), std::memory_order_release);
+    snapshots_.push_back(std::move(snapshot));
+    // 句柄缓存指向旧数据, 旧数据保留到析构, 并发读取到的旧记录仍然有效
+    for (size_t i = 0; i < instruments_->Capacity(); i++)
+    {
+        by_handle_[i].store(nullptr, std::memory_order_release);
+    }
+}
+
+lueing::InstrumentInfo lueing::InstrumentMaster::Convert(const CThostFtdcInstrumentField &row)
+{
+    InstrumentInfo info{};
+    Copy(info.instrument, row.InstrumentID);
+    Copy(info.exchange, row.ExchangeID);
+    Copy(info.product, row.ProductID);
+    Copy(info.expire_date, row.ExpireDate);
+    info.price_tick = row.PriceTick;
+    info.volume_multiple = row.VolumeMultiple;
+    info.max_limit_order_volume = row.MaxLimitOrderVolume;
+    info.min_limit_order_volume = row.MinLimitOrderVolume;
+    info.product_class = row.ProductClass;
+    info.is_trading = static_cast<char>(row.IsTrading);
+    return info;
+}
+
+const lueing::InstrumentInfo *lueing::InstrumentMaster::Find(const char *instrument) const
+{
+    return Lookup(current_.load(std::memory_order_acquire), instrument);
+}
+
+const lueing::InstrumentInfo *lueing::InstrumentMaster::Lookup(const Snapshot *snapshot, const char *instrument)
+{
+    if (nullptr == snapshot || nullptr == instrument)
+    {
+        return nullptr;
+    }
+    InstrumentInfo key{};
+    if (!Copy(key.instrument, instrument))
+    {
+        return nullptr;
+    }
+    const InstrumentInfo *end = snapshot->records + snapshot->count;
+    const InstrumentInfo *found = std::lower_bound(snapshot->records, end, key, Less);
+    return end != found && !Less(key, *found) ? found : nullptr;
+}
+
+const lueing::InstrumentInfo *lueing::InstrumentMaster::Find(InstrumentHandle handle) const
+{
+    if (handle >= instruments_->Capacity())
+    {
+        return nullptr;
+    }
+    const InstrumentInfo *info = by_handle_[handle].load(std::memory_order_acquire);
+    if (nullptr != info)
+    {
+        return info;
+    }
+    const Snapshot *snapshot = current_.load(std::memory_order_acquire);
+    info = Lookup(snapshot, instruments_->Instrument(handle));
+    if (nullptr == info)
+    {
+        return nullptr;
+    }
+    // 查找期间 Publish 可能已换入新数据并清空缓存: 写入后数据已变化时撤回, 不让旧记录长期留在缓存中
+    // 写入为读改写, 读到 Publish 清空的值时与其同步, 之后一定能看到新的 current_
+    const InstrumentInfo *expected = nullptr;
+    if (by_handle_[handle].compare_exchange_strong(expected, info, std::memory_order_acq_rel)
+        && current_.load(std::memory_order_acquire) != snapshot)
+    {
+        expected = info;
+        by_handle_[handle].compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+    }
+    return info;
+}
+
+double lueing::InstrumentMaster::RoundPrice(InstrumentHandle handle, char direction, double price) const
+{
+    const InstrumentInfo *info = Find(handle);
+    if (nullptr == info || info->price_tick <= 0)
+    {
+        return price;
+    }
+    double ticks = price / info->price_tick;
+    ticks = THOST_FTDC_D_Buy == direction ? std::floor(ticks + kTickEpsilon) : std::ceil(ticks - kTickEpsilon);
+    return ticks * info->price_tick;
+}
+
+std::string lueing::InstrumentMaster::TradingDay() const
+{
+    const Snapshot *snapshot = current_.load(std::memory_order_acquire);
+    return nullptr != snapshot ? snapshot->trading_day : "";
+}
+
+size_t lueing::InstrumentMaster::Size() const
+{
+    const Snapshot *snapshot = current_.load(std::memory_order_acquire);
+    return nullptr != snapshot ? snapshot->count : 0;
+}
@@ -0,0 +1,115 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include "gtest/gtest.h"
+#include "instrument_master.h"
+
+namespace {
+    CThostFtdcInstrumentField Row(const char *instrument, const char *exchange, double price_tick, int multiple)
+    {
+        CThostFtdcInstrumentField row{};
+        strcpy(row.InstrumentID, instrument);
+        strcpy(row.ExchangeID, exchange);
+        strcpy(row.ExpireDate, "20250515");
+        row.ProductClass = THOST_FTDC_PC_Futures;
+        row.PriceTick = price_tick;
+        row.VolumeMultiple = multiple;
+        row.IsTrading = 1;
+        return row;
+    }
+
+    std::string Directory(const char *name)
+    {
+        auto directory = (std::filesystem::temp_directory_path() / name).string();
+        std::filesystem::remove_all(directory);
+        return directory;
+    }
+}
+
+TEST(InstrumentMasterTest, update_writes_cache_and_restart_maps_it)
+{
+    std::string directory = Directory("ctp_instrument_master_test");
+    auto instruments = std::make_shared<lueing::InstrumentRegistry>(16);
+    lueing::InstrumentHandle rb = instruments->Intern("rb2505");
+    {
+        lueing::InstrumentMaster master(instruments, directory);
+        EXPECT_FALSE(master.Load("20250224"));
+        EXPECT_EQ(nullptr, master.Find(rb));
+        EXPECT_TRUE(master.Update("20250224", {Row("sc2505", "INE", 0.1, 1000), Row("rb2505", "SHFE", 1, 10),
+                                               Row("IF2503", "CFFEX", 0.2, 300)}));
+        EXPECT_EQ("20250224", master.TradingDay());
+        EXPECT_EQ(3u, master.Size());
+        ASSERT_NE(nullptr, master.Find(rb));
+        EXPECT_EQ(10, master.Find(rb)->volume_multiple);
+    }
+    EXPECT_TRUE(std::filesystem::exists(lueing::InstrumentMaster::Path(directory, "20250224")));
+
+    // 重启后直接映射缓存文件, 不向注册表登记其他合约
+    lueing::InstrumentMaster master(instruments, directory);
+    EXPECT_FALSE(master.Load("20250225"));
+    ASSERT_TRUE(master.Load("20250224"));
+    EXPECT_EQ(3u, master.Size());
+    EXPECT_STREQ("CFFEX", master.Exchange("IF2503"));
+    EXPECT_STREQ("INE", master.Exchange("sc2505"));
+    EXPECT_STREQ("", master.Exchange("ag2506"));
+    const lueing::InstrumentInfo *info = master.Find(rb);
+    ASSERT_NE(nullptr, info);
+    EXPECT_STREQ("SHFE", info->exchange);
+    EXPECT_STREQ("20250515", info->expire_date);
+    EXPECT_EQ(THOST_FTDC_PC_Futures, info->product_class);
+    // 句柄解析后缓存, 再次查找返回同一条记录
+    EXPECT_EQ(info, master.Find(rb));
+    EXPECT_EQ(1u, instruments->Size());
+}
+
+TEST(InstrumentMasterTest, round_price_never_worse_than_requested)
+{
+    std::string directory = Directory("ctp_instrument_master_round_test");
+    auto instruments = std::make_shared<lueing::InstrumentRegistry>(16);
+    lueing::InstrumentHandle index = instruments->Intern("IF2503");
+    lueing::InstrumentHandle unknown = instruments->Intern("ag2506");
+    lueing::InstrumentMaster master(instruments, directory);
+    master.Update("20250224", {Row("IF2503", "CFFEX", 0.2, 300)});
+    EXPECT_DOUBLE_EQ(3900.2, master.RoundPrice(index, THOST_FTDC_D_Buy, 3900.3));
+    EXPECT_DOUBLE_EQ(3900.4, master.RoundPrice(index, THOST_FTDC_D_Sell, 3900.3));
+    // 已在价位上的价格不因浮点误差移动
+    EXPECT_DOUBLE_EQ(3900.4, master.RoundPrice(index, THOST_FTDC_D_Buy, 3900.4));
+    EXPECT_DOUBLE_EQ(3900.4, master.RoundPrice(index, THOST_FTDC_D_Sell, 3900.4));
+    EXPECT_DOUBLE_EQ(5000.5, master.RoundPrice(unknown, THOST_FTDC_D_Buy, 5000.5));
+}
+
+TEST(InstrumentMasterTest, rejects_corrupt_cache)
+{
+    std::string directory = Directory("ctp_instrument_master_corrupt_test");
+    std::filesystem::create_directories(directory);
+    std::ofstream(lueing::InstrumentMaster::Path(directory, "20250224"), std::ios::binary) << "not a cache";
+    auto instruments = std::make_shared<lueing::InstrumentRegistry>(16);
+    lueing::InstrumentMaster master(instruments, directory);
+    EXPECT_FALSE(master.Load("20250224"));
+    EXPECT_EQ(0u, master.Size());
+}
+
+TEST(InstrumentMasterTest, handle_cache_follows_updates)
+{
+    std::string directory = Directory("ctp_instrument_master_update_test");
+    auto instruments = std::make_shared<lueing::InstrumentRegistry>(16);
+    lueing::InstrumentHandle rb = instruments->Intern("rb2505");
+    lueing::InstrumentMaster master(instruments, directory);
+    // 并发的句柄查找不能把替换前的记录写回缓存
+    std::atomic_bool done{false};
+    std::thread reader([&master, &done, rb]() {
+        while (!done.load())
+        {
+            master.Find(rb);
+        }
+    });
+    for (int multiple = 1; multiple <= 50; multiple++)
+    {
+        master.Update("20250224", {Row("rb2505", "SHFE", 1, multiple)});
+    }
+    done.store(true);
+    reader.join();
+    ASSERT_NE(nullptr, master.Find(rb));
+    EXPECT_EQ(50, master.Find(rb)->volume_multiple);
+}
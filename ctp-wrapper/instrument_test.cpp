@@ -0,0 +1,49 @@
+#include <thread>
+#include "gtest/gtest.h"
+#include "instrument.h"
+
+TEST(InstrumentTest, InternAndFind)
+{
+    lueing::InstrumentRegistry registry(2);
+    EXPECT_EQ(registry.Find("ag2504"), INVALID_INSTRUMENT);
+
+    auto ag = registry.Intern("ag2504");
+    EXPECT_EQ(ag, 0u);
+    EXPECT_EQ(registry.Intern("ag2504", "SHFE"), ag);
+    EXPECT_STREQ(registry.Exchange(ag), "SHFE");
+    EXPECT_EQ(registry.Intern("IO2504-C-3800", "CFFEX"), 1u);
+    EXPECT_EQ(registry.Intern("au2506"), INVALID_INSTRUMENT);
+    EXPECT_EQ(registry.Intern(""), INVALID_INSTRUMENT);
+    EXPECT_EQ(registry.Intern(std::string(40, 'a')), INVALID_INSTRUMENT);
+
+    TThostFtdcInstrumentIDType raw = "IO2504-C-3800";
+    EXPECT_EQ(registry.Find(raw), 1u);
+    EXPECT_STREQ(registry.Instrument(1), "IO2504-C-3800");
+    EXPECT_EQ(registry.Find("ag250"), INVALID_INSTRUMENT);
+    EXPECT_EQ(registry.Size(), 2u);
+}
+
+TEST(InstrumentTest, ConcurrentFind)
+{
+    lueing::InstrumentRegistry registry(512);
+    std::atomic_bool done{false};
+
+    std::thread reader([&] {
+        while (!done.load())
+        {
+            auto handle = registry.Find("c0");
+            if (INVALID_INSTRUMENT != handle)
+            {
+                EXPECT_STREQ(registry.Instrument(handle), "c0");
+            }
+        }
+    });
+
+    for (int i = 0; i < 500; i++)
+    {
+        EXPECT_EQ(registry.Intern("c" + std::to_string(i)), static_cast<lueing::InstrumentHandle>(i));
+    }
+    done.store(true);
+    reader.join();
+    EXPECT_EQ(registry.Find("c499"), 499u);
+}
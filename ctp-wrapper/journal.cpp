@@ -0,0 +1,317 @@
+#include "journal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+namespace {
+    // 后台线程提前预读的窗口, 减少写线程的缺页
+    constexpr uint64_t kPrefaultBytes = 4 * 1024 * 1024;
+    constexpr uint64_t kPageSize = 4096;
+}
+
+lueing::TickJournal::TickJournal(std::string directory, size_t records_per_file, int flush_interval_ms,
+                                 size_t overflow_capacity)
+    : directory_(std::move(directory)), records_per_file_(records_per_file), flush_interval_ms_(flush_interval_ms),
+      overflow_(overflow_capacity)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    worker_ = std::thread([this] { Run(); });
+}
+
+lueing::TickJournal::~TickJournal()
+{
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        running_.store(false);
+    }
+    condition_.notify_one();
+    worker_.join();
+    // 补写尚在暂存队列中的行情, 暂存的行情可能超过一个分片
+    while (!overflow_.Empty())
+    {
+        Segment *next = next_.exchange(nullptr);
+        if (nullptr == next)
+        {
+            bool full = nullptr != current_
+                        && current_->header->count.load(std::memory_order_relaxed) >= current_->header->capacity;
+            next = OpenSegment(full ? current_->header->trading_day : requested_day_, full);
+        }
+        if (nullptr == next)
+        {
+            break;
+        }
+        Adopt(next);
+    }
+    for (auto &segment : segments_)
+    {
+        Flush(segment.get(), true);
+    }
+}
+
+void lueing::TickJournal::Prepare(const std::string &trading_day)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    if (nullptr != newest_.load() || trading_day.empty())
+    {
+        return;
+    }
+    Segment *segment = OpenSegment(trading_day, false);
+    if (nullptr != segment)
+    {
+        newest_.store(segment);
+        next_.store(segment, std::memory_order_release);
+    }
+}
+
+void lueing::TickJournal::Append(const CThostFtdcDepthMarketDataField &field, int64_t receive_time)
+{
+    Segment *next = next_.load(std::memory_order_acquire);
+    if (nullptr != next)
+    {
+        next_.store(nullptr, std::memory_order_release);
+        Adopt(next);
+    }
+
+    Segment *segment = current_;
+    if (nullptr == segment || !overflow_.Empty()
+        || segment->header->count.load(std::memory_order_relaxed) >= segment->header->capacity
+        || (field.TradingDay[0] && std::strcmp(field.TradingDay, segment->header->trading_day) > 0))
+    {
+        JournalRecord record;
+        record.receive_time = receive_time;
+        std::memcpy(static_cast<void *>(&record.field), &field, sizeof(field));
+        Rollover(record);
+        return;
+    }
+
+    uint64_t index = segment->header->count.load(std::memory_order_relaxed);
+    JournalRecord &slot = segment->records[index];
+    slot.receive_time = receive_time;
+    std::memcpy(static_cast<void *>(&slot.field), &field, sizeof(field));
+    segment->header->count.store(index + 1, std::memory_order_release);
+}
+
+void lueing::TickJournal::Adopt(Segment *segment)
+{
+    current_ = segment;
+    rollover_pending_ = false;
+    // 先按序补写换文件期间暂存的行情
+    JournalRecord record;
+    uint64_t count = current_->header->count.load(std::memory_order_relaxed);
+    while (count < current_->header->capacity && overflow_.TryPop(record))
+    {
+        std::memcpy(static_cast<void *>(&current_->records[count]), &record, sizeof(JournalRecord));
+        current_->header->count.store(++count, std::memory_order_release);
+    }
+}
+
+uint64_t lueing::TickJournal::Count() const
+{
+    Segment *segment = newest_.load();
+    return nullptr == segment ? 0 : segment->header->count.load(std::memory_order_acquire);
+}
+
+std::string lueing::TickJournal::Path(const std::string &directory, const std::string &trading_day, uint32_t part)
+{
+    return (std::filesystem::path(directory) / fmt::format("md-{}-{}.jnl", trading_day, part)).string();
+}
+
+void lueing::TickJournal::Rollover(const JournalRecord &record)
+{
+    // 后台线程打开新文件后即清除请求标志, 写线程取走新文件前不得再次请求, 否则会多开一个分片
+    if (!rollover_pending_)
+    {
+        rollover_pending_ = true;
+        bool full = nullptr != current_ && current_->header->count.load(std::memory_order_relaxed) >= current_->header->capacity;
+        const char *day = full ? current_->header->trading_day : record.field.TradingDay;
+        std::strcpy(requested_day_, day[0] ? day : "00000000");
+        requested_full_ = full;
+        rollover_requested_.store(true, std::memory_order_release);
+        // 换文件一天只发生一两次, 这里的唤醒不在常规路径上
+        condition_.notify_one();
+    }
+    if (!overflow_.TryPush(record))
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void lueing::TickJournal::Run()
+{
+    while (running_.load())
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        condition_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_), [this] {
+            return !running_.load() || rollover_requested_.load(std::memory_order_acquire);
+        });
+
+        if (rollover_requested_.load(std::memory_order_acquire) && nullptr == next_.load(std::memory_order_acquire))
+        {
+            Segment *segment = OpenSegment(requested_day_, requested_full_);
+            if (nullptr != segment)
+            {
+                newest_.store(segment);
+                next_.store(segment, std::memory_order_release);
+            }
+            rollover_requested_.store(false, std::memory_order_release);
+        }
+
+        // 写线程取走新文件后, 旧文件不再被访问, 刷盘后释放
+        if (nullptr == next_.load(std::memory_order_acquire) && segments_.size() > 1)
+        {
+            Segment *newest = newest_.load();
+            for (auto &segment : segments_)
+            {
+                if (segment.get() != newest)
+                {
+                    Flush(segment.get(), true);
+                }
+            }
+            segments_.erase(std::remove_if(segments_.begin(), segments_.end(),
+                                           [newest](const std::unique_ptr<Segment> &segment) {
+                                               return segment.get() != newest;
+                                           }), segments_.end());
+        }
+
+        Segment *newest = newest_.load();
+        if (nullptr != newest)
+        {
+            Flush(newest, false);
+            // 预读写入位置之后的页面
+            uint64_t begin = sizeof(JournalHeader) + newest->header->count.load() * sizeof(JournalRecord);
+            uint64_t end = std::min<uint64_t>(begin + kPrefaultBytes, newest->region.get_size());
+            auto *bytes = static_cast<const volatile char *>(newest->region.get_address());
+            for (uint64_t offset = begin - begin % kPageSize + kPageSize; offset < end; offset += kPageSize)
+            {
+                (void) bytes[offset];
+            }
+        }
+    }
+}
+
+lueing::TickJournal::Segment *lueing::TickJournal::OpenSegment(const std::string &trading_day, bool full)
+{
+    namespace bip = boost::interprocess;
+    try
+    {
+        uint32_t part = 0;
+        while (std::filesystem::exists(Path(directory_, trading_day, part + 1)))
+        {
+            part++;
+        }
+        std::string path = Path(directory_, trading_day, part);
+        bool resume = std::filesystem::exists(path);
+        if (resume && full)
+        {
+            path = Path(directory_, trading_day, ++part);
+            resume = false;
+        }
+
+        uint64_t size = sizeof(JournalHeader) + records_per_file_ * sizeof(JournalRecord);
+        if (!resume)
+        {
+            std::ofstream(path, std::ios::binary | std::ios::trunc).close();
+            std::filesystem::resize_file(path, size);
+        }
+
+        std::unique_ptr<Segment> segment(new Segment());
+        segment->file = bip::file_mapping(path.c_str(), bip::read_write);
+        segment->region = bip::mapped_region(segment->file, bip::read_write);
+        segment->header = static_cast<JournalHeader *>(segment->region.get_address());
+        segment->records = reinterpret_cast<JournalRecord *>(segment->header + 1);
+
+        if (resume)
+        {
+            JournalHeader *header = segment->header;
+            if (JOURNAL_MAGIC != header->magic || JOURNAL_VERSION != header->version
+                || sizeof(JournalRecord) != header->record_size
+                || segment->region.get_size() < sizeof(JournalHeader) + header->capacity * sizeof(JournalRecord))
+            {
+                spdlog::warn("[行情日志] 文件格式不符, 改用新分片: {}", path);
+                return OpenSegment(trading_day, true);
+            }
+            if (header->count.load() >= header->capacity)
+            {
+                return OpenSegment(trading_day, true);
+            }
+            segment->flushed = header->count.load();
+        }
+        else
+        {
+            JournalHeader *header = segment->header;
+            header->magic = JOURNAL_MAGIC;
+            header->version = JOURNAL_VERSION;
+            header->record_size = sizeof(JournalRecord);
+            header->part = part;
+            header->capacity = records_per_file_;
+            header->count.store(0);
+            std::strncpy(header->trading_day, trading_day.c_str(), sizeof(header->trading_day) - 1);
+        }
+        spdlog::info("[行情日志] 打开文件: {}, 已有记录: {}", path, segment->header->count.load());
+        segments_.push_back(std::move(segment));
+        return segments_.back().get();
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("[行情日志] 打开文件失败, 交易日: {}, 错误: {}", trading_day, e.what());
+        return nullptr;
+    }
+}
+
+void lueing::TickJournal::Flush(Segment *segment, bool sync)
+{
+    uint64_t count = segment->header->count.load(std::memory_order_acquire);
+    if (count == segment->flushed && !sync)
+    {
+        return;
+    }
+    std::size_t begin = sizeof(JournalHeader) + segment->flushed * sizeof(JournalRecord);
+    std::size_t end = sizeof(JournalHeader) + count * sizeof(JournalRecord);
+    // 文件头中的记录数随每次刷盘一起落盘
+    segment->region.flush(0, sizeof(JournalHeader), !sync);
+    if (end > begin)
+    {
+        segment->region.flush(begin, end - begin, !sync);
+    }
+    segment->flushed = count;
+}
+
+lueing::JournalReader::JournalReader(const std::string &path)
+{
+    namespace bip = boost::interprocess;
+    try
+    {
+        file_ = bip::file_mapping(path.c_str(), bip::read_only);
+        region_ = bip::mapped_region(file_, bip::read_only);
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("[行情日志] 打开文件失败: {}, 错误: {}", path, e.what());
+        return;
+    }
+    auto *header = static_cast<const JournalHeader *>(region_.get_address());
+    if (region_.get_size() < sizeof(JournalHeader) || JOURNAL_MAGIC != header->magic
+        || JOURNAL_VERSION != header->version || sizeof(JournalRecord) != header->record_size
+        || region_.get_size() < sizeof(JournalHeader) + header->capacity * sizeof(JournalRecord))
+    {
+        spdlog::error("[行情日志] 文件格式不符: {}", path);
+        return;
+    }
+    header_ = header;
+    records_ = reinterpret_cast<const JournalRecord *>(header_ + 1);
+}
+
+std::vector<std::string> lueing::JournalReader::Files(const std::string &directory, const std::string &trading_day)
+{
+    std::vector<std::string> files;
+    for (uint32_t part = 0; std::filesystem::exists(TickJournal::Path(directory, trading_day, part)); part++)
+    {
+        files.push_back(TickJournal::Path(directory, trading_day, part));
+    }
+    return files;
+}
@@ -0,0 +1,145 @@
+#include <filesystem>
+#include <thread>
+#include "gtest/gtest.h"
+#include "journal.h"
+
+namespace {
+    CThostFtdcDepthMarketDataField Field(const char *trading_day, int volume)
+    {
+        CThostFtdcDepthMarketDataField field{};
+        strcpy(field.TradingDay, trading_day);
+        strcpy(field.InstrumentID, "ag2504");
+        field.Volume = volume;
+        return field;
+    }
+
+    void WaitUntil(const std::function<bool()> &predicate)
+    {
+        for (int i = 0; i < 500 && !predicate(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+}
+
+TEST(JournalTest, AppendRolloverAndRead)
+{
+    auto directory = (std::filesystem::temp_directory_path() / "ctp_journal_test").string();
+    std::filesystem::remove_all(directory);
+    {
+        lueing::TickJournal journal(directory, 8, 10, 64);
+        journal.Prepare("20250224");
+        // 写满第一个分片后切换到分片 1, 交易日变化后切换到新交易日
+        for (int i = 0; i < 12; i++)
+        {
+            journal.Append(Field("20250224", i), i);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        journal.Append(Field("20250225", 100), 100);
+        WaitUntil([&] { return std::filesystem::exists(lueing::TickJournal::Path(directory, "20250225", 0)); });
+        journal.Append(Field("20250225", 101), 101);
+        EXPECT_EQ(journal.Dropped(), 0u);
+    }
+
+    auto files = lueing::JournalReader::Files(directory, "20250224");
+    ASSERT_EQ(files.size(), 2u);
+    lueing::JournalReader first(files[0]);
+    lueing::JournalReader second(files[1]);
+    ASSERT_TRUE(first.Valid() && second.Valid());
+    EXPECT_EQ(first.Count(), 8u);
+    EXPECT_EQ(second.Count(), 4u);
+    EXPECT_STREQ(first.TradingDay(), "20250224");
+    for (uint64_t i = 0; i < 8; i++)
+    {
+        EXPECT_EQ(first.At(i).field.Volume, static_cast<int>(i));
+        EXPECT_EQ(first.At(i).receive_time, static_cast<int64_t>(i));
+    }
+    EXPECT_EQ(second.At(3).field.Volume, 11);
+
+    lueing::JournalReader next(lueing::TickJournal::Path(directory, "20250225", 0));
+    ASSERT_TRUE(next.Valid());
+    EXPECT_EQ(next.Count(), 2u);
+    EXPECT_EQ(next.At(1).field.Volume, 101);
+
+    // 重新打开同一交易日时接着已有记录写
+    {
+        lueing::TickJournal journal(directory, 8, 10, 64);
+        journal.Prepare("20250225");
+        journal.Append(Field("20250225", 102), 102);
+    }
+    lueing::JournalReader resumed(lueing::TickJournal::Path(directory, "20250225", 0));
+    EXPECT_EQ(resumed.Count(), 3u);
+    std::filesystem::remove_all(directory);
+}
+
+
+TEST(JournalTest, ShutdownWritesStagedRecords)
+{
+    auto directory = (std::filesystem::temp_directory_path() / "ctp_journal_shutdown_test").string();
+    std::filesystem::remove_all(directory);
+    {
+        lueing::TickJournal journal(directory, 8, 10, 64);
+        journal.Prepare("20250224");
+        WaitUntil([&] { return std::filesystem::exists(lueing::TickJournal::Path(directory, "20250224", 0)); });
+        // 写满分片后的行情进入暂存队列, 之后不再有行情触发写线程换文件; 暂存的行情超过一个分片
+        for (int i = 0; i < 20; i++)
+        {
+            journal.Append(Field("20250224", i), i);
+        }
+    }
+
+    auto files = lueing::JournalReader::Files(directory, "20250224");
+    ASSERT_EQ(files.size(), 3u);
+    int expected = 0;
+    for (const auto &file : files)
+    {
+        lueing::JournalReader reader(file);
+        ASSERT_TRUE(reader.Valid());
+        for (uint64_t i = 0; i < reader.Count(); i++)
+        {
+            EXPECT_EQ(reader.At(i).field.Volume, expected++);
+        }
+    }
+    EXPECT_EQ(expected, 20);
+    std::filesystem::remove_all(directory);
+}
+
+
+TEST(JournalTest, FastWriterRequestsOneRolloverPerFile)
+{
+    auto directory = (std::filesystem::temp_directory_path() / "ctp_journal_fast_test").string();
+    std::filesystem::remove_all(directory);
+    const int total = 2000;
+    {
+        lueing::TickJournal journal(directory, 16, 1, total);
+        journal.Prepare("20250224");
+        WaitUntil([&] { return std::filesystem::exists(lueing::TickJournal::Path(directory, "20250224", 0)); });
+        // 写线程在后台线程打开新文件的同时持续写入, 覆盖换文件的各个时间窗口
+        for (int i = 0; i < total; i++)
+        {
+            journal.Append(Field("20250224", i), i);
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+        EXPECT_EQ(journal.Dropped(), 0u);
+    }
+
+    // 除最后一个分片外都已写满, 记录按序连续
+    auto files = lueing::JournalReader::Files(directory, "20250224");
+    ASSERT_FALSE(files.empty());
+    int expected = 0;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        lueing::JournalReader reader(files[i]);
+        ASSERT_TRUE(reader.Valid());
+        if (i + 1 < files.size())
+        {
+            EXPECT_EQ(reader.Count(), 16u) << files[i];
+        }
+        for (uint64_t j = 0; j < reader.Count(); j++)
+        {
+            ASSERT_EQ(reader.At(j).field.Volume, expected++);
+        }
+    }
+    EXPECT_EQ(expected, total);
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,191 @@
+#include "latency.h"
+
+#include <algorithm>
+
+lueing::LatencyHistogram::LatencyHistogram() : counts_(new std::atomic<uint64_t>[kBuckets]())
+{
+}
+
+void lueing::LatencyHistogram::Merge(const LatencyHistogram &other)
+{
+    for (int i = 0; i < kBuckets; i++)
+    {
+        uint64_t count = other.counts_[i].load(std::memory_order_relaxed);
+        if (0 != count)
+        {
+            counts_[i].fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+    total_.fetch_add(other.total_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    min_.store(std::min(min_.load(std::memory_order_relaxed), other.min_.load(std::memory_order_relaxed)),
+               std::memory_order_relaxed);
+    max_.store(std::max(max_.load(std::memory_order_relaxed), other.max_.load(std::memory_order_relaxed)),
+               std::memory_order_relaxed);
+}
+
+int64_t lueing::LatencyHistogram::Percentile(double percentile) const
+{
+    // 并发记录时各桶之和可能略大于 total_, 以桶为准
+    uint64_t total = 0;
+    for (int i = 0; i < kBuckets; i++)
+    {
+        total += counts_[i].load(std::memory_order_relaxed);
+    }
+    if (0 == total)
+    {
+        return 0;
+    }
+    auto rank = static_cast<uint64_t>(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(total));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++)
+    {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+            // 代表值不超出实际记录的范围
+            auto max = static_cast<int64_t>(max_.load(std::memory_order_relaxed));
+            auto min = static_cast<int64_t>(min_.load(std::memory_order_relaxed));
+            return std::max(min, std::min(max, Value(i)));
+        }
+    }
+    return static_cast<int64_t>(max_.load(std::memory_order_relaxed));
+}
+
+lueing::LatencySummary lueing::LatencyHistogram::Summary() const
+{
+    LatencySummary summary{};
+    summary.count = Count();
+    if (0 == summary.count)
+    {
+        return summary;
+    }
+    summary.min = static_cast<int64_t>(min_.load(std::memory_order_relaxed));
+    summary.max = static_cast<int64_t>(max_.load(std::memory_order_relaxed));
+    summary.mean = static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(summary.count);
+    summary.p50 = Percentile(50);
+    summary.p90 = Percentile(90);
+    summary.p99 = Percentile(99);
+    summary.p999 = Percentile(99.9);
+    return summary;
+}
+
+void lueing::LatencyHistogram::Reset()
+{
+    for (int i = 0; i < kBuckets; i++)
+    {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+    total_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+int64_t lueing::LatencyHistogram::Value(int index)
+{
+    if (index < kSubBuckets)
+    {
+        return index;
+    }
+    int shift = index / kSubBuckets - 1;
+    int64_t low = static_cast<int64_t>(kSubBuckets + index % kSubBuckets) << shift;
+    return low + ((static_cast<int64_t>(1) << shift) >> 1);
+}
+
+lueing::MarketDataStats::MarketDataStats(size_t max_instruments, InstrumentRegistryPtr instruments)
+    : max_instruments_(max_instruments), instruments_(std::move(instruments)),
+      histograms_(new std::atomic<LatencyHistogram *>[max_instruments]())
+{
+}
+
+lueing::MarketDataStats::~MarketDataStats()
+{
+    for (size_t i = 0; i < max_instruments_; i++)
+    {
+        delete histograms_[i].load(std::memory_order_relaxed);
+    }
+}
+
+bool lueing::MarketDataStats::Reserve(InstrumentHandle handle)
+{
+    if (handle >= max_instruments_)
+    {
+        return false;
+    }
+    if (nullptr == histograms_[handle].load(std::memory_order_acquire))
+    {
+        histograms_[handle].store(new LatencyHistogram(), std::memory_order_release);
+    }
+    return true;
+}
+
+lueing::LatencySummary lueing::MarketDataStats::Instrument(InstrumentHandle handle) const
+{
+    LatencyHistogram *histogram = handle < max_instruments_ ? histograms_[handle].load(std::memory_order_acquire) : nullptr;
+    return nullptr == histogram ? LatencySummary{} : histogram->Summary();
+}
+
+lueing::LatencySummary lueing::MarketDataStats::Exchange(const std::string &exchange) const
+{
+    LatencyHistogram merged;
+    for (size_t i = 0; i < max_instruments_; i++)
+    {
+        LatencyHistogram *histogram = histograms_[i].load(std::memory_order_acquire);
+        if (nullptr != histogram && exchange == instruments_->Exchange(static_cast<InstrumentHandle>(i)))
+        {
+            merged.Merge(*histogram);
+        }
+    }
+    return merged.Summary();
+}
+
+std::vector<std::pair<std::string, lueing::LatencySummary>> lueing::MarketDataStats::Exchanges() const
+{
+    std::vector<std::string> exchanges;
+    for (size_t i = 0; i < max_instruments_; i++)
+    {
+        if (nullptr == histograms_[i].load(std::memory_order_acquire))
+        {
+            continue;
+        }
+        std::string exchange = instruments_->Exchange(static_cast<InstrumentHandle>(i));
+        if (std::find(exchanges.begin(), exchanges.end(), exchange) == exchanges.end())
+        {
+            exchanges.push_back(exchange);
+        }
+    }
+    std::vector<std::pair<std::string, LatencySummary>> result;
+    for (const auto &exchange : exchanges)
+    {
+        result.emplace_back(exchange, Exchange(exchange));
+    }
+    return result;
+}
+
+lueing::LatencySummary lueing::MarketDataStats::Total() const
+{
+    LatencyHistogram merged;
+    for (size_t i = 0; i < max_instruments_; i++)
+    {
+        LatencyHistogram *histogram = histograms_[i].load(std::memory_order_acquire);
+        if (nullptr != histogram)
+        {
+            merged.Merge(*histogram);
+        }
+    }
+    return merged.Summary();
+}
+
+void lueing::MarketDataStats::Reset()
+{
+    for (size_t i = 0; i < max_instruments_; i++)
+    {
+        LatencyHistogram *histogram = histograms_[i].load(std::memory_order_acquire);
+        if (nullptr != histogram)
+        {
+            histogram->Reset();
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#include <cmath>
+#include <memory>
+#include "gtest/gtest.h"
+#include "latency.h"
+
+TEST(LatencyTest, HistogramBucketsAreContinuous)
+{
+    // 相邻数值的桶序号单调不减, 且代表值落在相对误差范围内
+    int previous = 0;
+    for (uint64_t value = 0; value < (1u << 20); value += 7)
+    {
+        int index = lueing::LatencyHistogram::Index(value);
+        EXPECT_GE(index, previous);
+        previous = index;
+        double error = std::abs(static_cast<double>(lueing::LatencyHistogram::Value(index)) - static_cast<double>(value));
+        EXPECT_LE(error, static_cast<double>(value) / lueing::LatencyHistogram::kSubBuckets + 1);
+    }
+    EXPECT_EQ(lueing::LatencyHistogram::Index(UINT64_MAX), lueing::LatencyHistogram::kBuckets - 1);
+}
+
+TEST(LatencyTest, HistogramPercentiles)
+{
+    lueing::LatencyHistogram histogram;
+    for (int64_t i = 1; i <= 1000; i++)
+    {
+        histogram.Record(i * 1000);
+    }
+    histogram.Record(-5);
+    auto summary = histogram.Summary();
+    EXPECT_EQ(summary.count, 1001u);
+    EXPECT_EQ(summary.min, 0);
+    EXPECT_EQ(summary.max, 1000000);
+    EXPECT_NEAR(summary.p50, 500000, 500000 * 0.04);
+    EXPECT_NEAR(summary.p99, 990000, 990000 * 0.04);
+    EXPECT_LE(summary.p999, summary.max);
+
+    histogram.Reset();
+    EXPECT_EQ(histogram.Summary().count, 0u);
+}
+
+TEST(LatencyTest, StatsByInstrumentAndExchange)
+{
+    auto instruments = std::make_shared<lueing::InstrumentRegistry>(8);
+    auto ag = instruments->Intern("ag2504", "SHFE");
+    auto au = instruments->Intern("au2506", "SHFE");
+    auto m = instruments->Intern("m2505", "DCE");
+    auto unknown = instruments->Intern("IF2503");
+    lueing::MarketDataStats stats(8, instruments);
+    for (auto handle : {ag, au, m, unknown})
+    {
+        ASSERT_TRUE(stats.Reserve(handle));
+    }
+    EXPECT_FALSE(stats.Reserve(8));
+
+    stats.Record(ag, 1000);
+    stats.Record(au, 3000);
+    stats.Record(m, 5000000);
+    stats.Record(unknown, 10);
+    stats.Record(7, 10);
+
+    EXPECT_EQ(stats.Instrument(ag).count, 1u);
+    EXPECT_EQ(stats.Instrument(7).count, 0u);
+    auto shfe = stats.Exchange("SHFE");
+    EXPECT_EQ(shfe.count, 2u);
+    EXPECT_EQ(shfe.min, 1000);
+    EXPECT_EQ(shfe.max, 3000);
+    EXPECT_EQ(stats.Exchange("DCE").count, 1u);
+    EXPECT_EQ(stats.Exchange("").count, 1u);
+    EXPECT_EQ(stats.Exchanges().size(), 3u);
+    EXPECT_EQ(stats.Total().count, 4u);
+}
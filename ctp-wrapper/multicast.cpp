@@ -0,0 +1,97 @@
+#include "multicast.h"
+
+#include <cstring>
+#include <utility>
+
+lueing::MulticastInstrumentTable::MulticastInstrumentTable(InstrumentRegistryPtr instruments)
+    : instruments_(std::move(instruments))
+{
+}
+
+lueing::MulticastInstrumentTable::~MulticastInstrumentTable()
+= default;
+
+bool lueing::MulticastInstrumentTable::Add(const CThostFtdcMulticastInstrumentField &field)
+{
+    size_t length = strnlen(field.InstrumentID, sizeof(field.InstrumentID));
+    if (0 == length || length >= sizeof(field.InstrumentID))
+    {
+        return false;
+    }
+    MulticastInstrument info{};
+    info.topic_id = field.TopicID;
+    info.instrument_no = field.InstrumentNo;
+    info.handle = INVALID_INSTRUMENT;
+    std::memcpy(info.instrument, field.InstrumentID, length);
+    info.code_price = field.CodePrice;
+    info.volume_multiple = field.VolumeMultiple;
+    info.price_tick = field.PriceTick;
+
+    std::unique_lock<std::mutex> lock(lock_);
+    // 合约编号变化 (重新查询) 时移除旧编号
+    auto it = keys_.find(info.instrument);
+    if (it != keys_.end())
+    {
+        rows_.erase(it->second);
+    }
+    uint64_t key = Key(info.topic_id, info.instrument_no);
+    rows_[key] = info;
+    keys_[info.instrument] = key;
+    return true;
+}
+
+lueing::InstrumentHandle lueing::MulticastInstrumentTable::Find(int32_t topic_id, int32_t instrument_no) const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    auto it = rows_.find(Key(topic_id, instrument_no));
+    return it == rows_.end() ? INVALID_INSTRUMENT : instruments_->Find(it->second.instrument);
+}
+
+bool lueing::MulticastInstrumentTable::Info(InstrumentHandle handle, MulticastInstrument &out) const
+{
+    if (handle >= instruments_->Size())
+    {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(lock_);
+    auto key = keys_.find(instruments_->Instrument(handle));
+    if (key == keys_.end())
+    {
+        return false;
+    }
+    out = rows_.find(key->second)->second;
+    out.handle = handle;
+    return true;
+}
+
+std::vector<lueing::InstrumentHandle> lueing::MulticastInstrumentTable::Handles(int32_t topic_id) const
+{
+    std::vector<InstrumentHandle> handles;
+    std::unique_lock<std::mutex> lock(lock_);
+    for (const auto &item : rows_)
+    {
+        if (0 != topic_id && item.second.topic_id != topic_id)
+        {
+            continue;
+        }
+        InstrumentHandle handle = instruments_->Find(item.second.instrument);
+        if (INVALID_INSTRUMENT != handle)
+        {
+            handles.push_back(handle);
+        }
+    }
+    return handles;
+}
+
+size_t lueing::MulticastInstrumentTable::Size() const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    return rows_.size();
+}
+
+void lueing::MulticastInstrumentTable::Clear()
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    rows_.clear();
+    keys_.clear();
+}
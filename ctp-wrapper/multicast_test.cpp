@@ -0,0 +1,65 @@
+#include <cstring>
+#include "gtest/gtest.h"
+#include "multicast.h"
+
+namespace {
+    CThostFtdcMulticastInstrumentField MakeField(int topic_id, int instrument_no, const char *instrument)
+    {
+        CThostFtdcMulticastInstrumentField field{};
+        field.TopicID = topic_id;
+        field.InstrumentNo = instrument_no;
+        field.VolumeMultiple = 15;
+        field.PriceTick = 1;
+        strcpy(field.InstrumentID, instrument);
+        return field;
+    }
+}
+
+TEST(MulticastTest, MapInstrumentNumbersToHandles)
+{
+    auto registry = std::make_shared<lueing::InstrumentRegistry>(4);
+    lueing::MulticastInstrumentTable table(registry);
+    EXPECT_TRUE(table.Add(MakeField(1001, 7, "ag2504")));
+    EXPECT_TRUE(table.Add(MakeField(1002, 7, "au2506")));
+    // 尚未订阅的合约不登记, 句柄在订阅之后才能查到
+    EXPECT_EQ(table.Find(1001, 7), INVALID_INSTRUMENT);
+    EXPECT_EQ(registry->Size(), 0u);
+    auto ag = registry->Intern("ag2504");
+    auto au = registry->Intern("au2506");
+    EXPECT_EQ(table.Find(1001, 7), ag);
+    EXPECT_EQ(table.Find(1002, 7), au);
+    EXPECT_EQ(table.Find(1001, 8), INVALID_INSTRUMENT);
+    EXPECT_EQ(table.Handles(1001).size(), 1u);
+    EXPECT_EQ(table.Handles().size(), 2u);
+
+    lueing::MulticastInstrument info{};
+    ASSERT_TRUE(table.Info(au, info));
+    EXPECT_EQ(info.volume_multiple, 15);
+    EXPECT_EQ(info.handle, au);
+
+    // 重新查询后合约编号变化, 旧编号失效
+    EXPECT_TRUE(table.Add(MakeField(1001, 9, "ag2504")));
+    EXPECT_EQ(table.Find(1001, 7), INVALID_INSTRUMENT);
+    EXPECT_EQ(table.Find(1001, 9), ag);
+    EXPECT_EQ(table.Size(), 2u);
+
+    table.Clear();
+    EXPECT_FALSE(table.Info(ag, info));
+}
+
+TEST(MulticastTest, WholeMarketDoesNotFillRegistry)
+{
+    auto registry = std::make_shared<lueing::InstrumentRegistry>(1);
+    lueing::MulticastInstrumentTable table(registry);
+    // 主题 0 返回的合约数远超注册表容量
+    EXPECT_TRUE(table.Add(MakeField(0, 1, "ag2504")));
+    EXPECT_TRUE(table.Add(MakeField(0, 2, "au2506")));
+    EXPECT_TRUE(table.Add(MakeField(0, 3, "cu2505")));
+    EXPECT_EQ(table.Size(), 3u);
+    EXPECT_EQ(registry->Size(), 0u);
+    // 之后订阅的合约仍能登记并查到组播信息
+    auto au = registry->Intern("au2506");
+    ASSERT_NE(au, INVALID_INSTRUMENT);
+    EXPECT_EQ(table.Find(0, 2), au);
+    EXPECT_EQ(table.Handles(), std::vector<lueing::InstrumentHandle>{au});
+}
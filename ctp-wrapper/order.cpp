@@ -0,0 +1,439 @@
+#include "order.h"
+
+#include <cstring>
+#include <utility>
+
+lueing::OrderTracker::OrderTracker(size_t keep_finished) : keep_finished_(keep_finished)
+{
+}
+
+lueing::OrderTracker::~OrderTracker()
+= default;
+
+int32_t lueing::OrderTracker::ParseOrderRef(const char *order_ref)
+{
+    int32_t value = 0;
+    for (; ' ' == *order_ref; order_ref++)
+    {
+    }
+    for (; *order_ref >= '0' && *order_ref <= '9'; order_ref++)
+    {
+        value = value * 10 + (*order_ref - '0');
+    }
+    return value;
+}
+
+lueing::OrderTracker::SysKey lueing::OrderTracker::MakeSysKey(const char *exchange_id, const char *order_sys_id)
+{
+    SysKey key{};
+    strncpy(key.data(), exchange_id, sizeof(TThostFtdcExchangeIDType) - 1);
+    strncpy(key.data() + sizeof(TThostFtdcExchangeIDType), order_sys_id, sizeof(TThostFtdcOrderSysIDType) - 1);
+    return key;
+}
+
+void lueing::OrderTracker::SetSession(int32_t front_id, int32_t session_id)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    front_id_ = front_id;
+    session_id_ = session_id;
+}
+
+lueing::OrderTicket lueing::OrderTracker::Add(int32_t order_ref, InstrumentHandle instrument, char direction,
+                                              char offset, int32_t volume, OrderCallback callback)
+{
+    std::unique_ptr<Entry> entry(new Entry());
+    entry->report.order_ref = order_ref;
+    entry->report.instrument = instrument;
+    entry->report.status = OrderStatus::Sent;
+    entry->report.volume = volume;
+    entry->report.direction = direction;
+    entry->report.offset = offset;
+    entry->callback = std::move(callback);
+    OrderTicket ticket{order_ref, entry->promise.get_future().share()};
+
+    std::unique_lock<std::mutex> lock(lock_);
+    entry->key = Key(order_ref);
+    orders_[entry->key] = std::move(entry);
+    active_++;
+    unbound_++;
+    return ticket;
+}
+
+void lueing::OrderTracker::Reject(int32_t order_ref, int32_t error_id, const std::string &error)
+{
+    OrderKey key;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        key = Key(order_ref);
+    }
+    Reject(key, error_id, error);
+}
+
+void lueing::OrderTracker::Reject(const OrderKey &key, int32_t error_id, const std::string &error)
+{
+    Entry *entry;
+    OrderReport report;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        auto it = orders_.find(key);
+        if (it == orders_.end() || IsFinal(it->second->report.status))
+        {
+            return;
+        }
+        entry = it->second.get();
+        entry->report.status = OrderStatus::Rejected;
+        entry->report.error_id = error_id;
+        entry->report.error = error;
+        active_--;
+        Bound(*entry);
+        Finish(*entry);
+        report = entry->report;
+    }
+    Publish(*entry, report);
+}
+
+void lueing::OrderTracker::OnOrder(const CThostFtdcOrderField &order)
+{
+    Entry *entry;
+    OrderReport report;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        auto it = orders_.find(OrderKey{order.FrontID, order.SessionID, ParseOrderRef(order.OrderRef)});
+        if (it == orders_.end())
+        {
+            return;
+        }
+        entry = it->second.get();
+        bool filled = false;
+        if (!entry->bound && 0 != order.OrderSysID[0])
+        {
+            // 报入交易所后才有 OrderSysID, 之后的成交按它归属
+            strcpy(entry->exchange_id, order.ExchangeID);
+            strcpy(entry->order_sys_id, order.OrderSysID);
+            SysKey key = MakeSysKey(order.ExchangeID, order.OrderSysID);
+            by_sys_id_[key] = entry;
+            auto early = early_trades_.find(key);
+            if (early != early_trades_.end())
+            {
+                for (const auto &trade : early->second)
+                {
+                    Fill(*entry, trade);
+                }
+                early_trades_.erase(early);
+                filled = true;
+            }
+            Bound(*entry);
+        }
+        entry->order_status = order.OrderStatus;
+        if (order.VolumeTraded > entry->traded)
+        {
+            entry->traded = order.VolumeTraded;
+        }
+        if (!Advance(*entry) && !filled)
+        {
+            return;
+        }
+        report = entry->report;
+        if (IsFinal(report.status))
+        {
+            active_--;
+            Bound(*entry);
+            Finish(*entry);
+        }
+    }
+    Publish(*entry, report);
+}
+
+void lueing::OrderTracker::OnTrade(const CThostFtdcTradeField &trade)
+{
+    Entry *entry;
+    OrderReport report;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        SysKey key = MakeSysKey(trade.ExchangeID, trade.OrderSysID);
+        auto it = by_sys_id_.find(key);
+        if (it == by_sys_id_.end())
+        {
+            // 本会话有报单尚未收到带 OrderSysID 的回报时暂存; 其他会话的成交在没有等待的报单后丢弃
+            if (unbound_ > 0 && 0 != trade.OrderSysID[0])
+            {
+                // 一直收不到报单回报的报单会让暂存持续增长, 只保留最近的若干笔
+                auto &trades = early_trades_[key];
+                if (trades.empty())
+                {
+                    early_order_.push_back(key);
+                    if (early_order_.size() > ORDER_TRACKER_MAX_EARLY_TRADES)
+                    {
+                        early_trades_.erase(early_order_.front());
+                        early_order_.pop_front();
+                    }
+                }
+                trades.push_back(trade);
+            }
+            return;
+        }
+        entry = it->second;
+        if (IsFinal(entry->report.status))
+        {
+            return;
+        }
+        Fill(*entry, trade);
+        report = entry->report;
+        if (IsFinal(report.status))
+        {
+            active_--;
+            Finish(*entry);
+        }
+    }
+    Publish(*entry, report);
+}
+
+bool lueing::OrderTracker::Report(int32_t order_ref, OrderReport &out) const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    auto it = orders_.find(Key(order_ref));
+    if (it == orders_.end())
+    {
+        return false;
+    }
+    out = it->second->report;
+    return true;
+}
+
+bool lueing::OrderTracker::Report(const OrderKey &key, OrderReport &out) const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    auto it = orders_.find(key);
+    if (it == orders_.end())
+    {
+        return false;
+    }
+    out = it->second->report;
+    return true;
+}
+
+bool lueing::OrderTracker::Address(int32_t order_ref, OrderAddress &out) const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    auto it = orders_.find(Key(order_ref));
+    if (it == orders_.end() || IsFinal(it->second->report.status))
+    {
+        return false;
+    }
+    const Entry &entry = *it->second;
+    out.key = entry.key;
+    out.instrument = entry.report.instrument;
+    strcpy(out.exchange_id, entry.exchange_id);
+    strcpy(out.order_sys_id, entry.order_sys_id);
+    return true;
+}
+
+bool lueing::OrderTracker::Replace(int32_t order_ref, double price, OrderCallback callback, ReplaceTicket &ticket,
+                                   OrderAddress &address)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    auto it = orders_.find(Key(order_ref));
+    if (it == orders_.end() || IsFinal(it->second->report.status) || it->second->replace)
+    {
+        lock.unlock();
+        std::promise<OrderTicket> rejected;
+        rejected.set_value(RejectedTicket(-1, "order is not replaceable"));
+        ticket = rejected.get_future().share();
+        return false;
+    }
+    Entry &entry = *it->second;
+    entry.replace.reset(new OrderReplace());
+    entry.replace->instrument = entry.report.instrument;
+    entry.replace->direction = entry.report.direction;
+    entry.replace->offset = entry.report.offset;
+    entry.replace->price = price;
+    entry.replace->callback = std::move(callback);
+    entry.replace->promise = std::make_shared<std::promise<OrderTicket>>();
+    ticket = entry.replace->promise->get_future().share();
+    address.key = entry.key;
+    address.instrument = entry.report.instrument;
+    strcpy(address.exchange_id, entry.exchange_id);
+    strcpy(address.order_sys_id, entry.order_sys_id);
+    return true;
+}
+
+void lueing::OrderTracker::ActionFailed(const OrderKey &key, int32_t error_id, const std::string &error)
+{
+    Entry *entry;
+    OrderReport report;
+    std::unique_ptr<OrderReplace> replace;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        auto it = orders_.find(key);
+        if (it == orders_.end() || IsFinal(it->second->report.status))
+        {
+            return;
+        }
+        entry = it->second.get();
+        entry->report.error_id = error_id;
+        entry->report.error = error;
+        report = entry->report;
+        replace = std::move(entry->replace);
+    }
+    if (replace)
+    {
+        FailReplace(*replace, error_id, error);
+    }
+    Publish(*entry, report);
+}
+
+bool lueing::OrderTracker::TakeReplace(OrderReplace &out)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    if (replaces_.empty())
+    {
+        return false;
+    }
+    out = std::move(replaces_.back());
+    replaces_.pop_back();
+    return true;
+}
+
+lueing::OrderTicket lueing::OrderTracker::RejectedTicket(int32_t error_id, const std::string &error)
+{
+    OrderReport report{};
+    report.status = OrderStatus::Rejected;
+    report.error_id = error_id;
+    report.error = error;
+    std::promise<OrderReport> promise;
+    promise.set_value(report);
+    return OrderTicket{0, promise.get_future().share()};
+}
+
+size_t lueing::OrderTracker::Active() const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    return active_;
+}
+
+size_t lueing::OrderTracker::Size() const
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    return orders_.size();
+}
+
+void lueing::OrderTracker::Fill(Entry &entry, const CThostFtdcTradeField &trade)
+{
+    entry.report.filled += trade.Volume;
+    entry.turnover += trade.Price * trade.Volume;
+    entry.report.average_price = entry.turnover / entry.report.filled;
+    Advance(entry);
+}
+
+void lueing::OrderTracker::Bound(Entry &entry)
+{
+    if (entry.bound)
+    {
+        return;
+    }
+    entry.bound = true;
+    if (0 == --unbound_)
+    {
+        early_trades_.clear();
+        early_order_.clear();
+    }
+}
+
+bool lueing::OrderTracker::Advance(Entry &entry)
+{
+    OrderReport &report = entry.report;
+    if (IsFinal(report.status))
+    {
+        return false;
+    }
+    OrderStatus status;
+    if (report.filled >= report.volume)
+    {
+        status = OrderStatus::Filled;
+    }
+    else if (THOST_FTDC_OST_Canceled == entry.order_status && report.filled >= entry.traded)
+    {
+        // 撤单前的成交已全部到达
+        status = OrderStatus::Cancelled;
+    }
+    else if (report.filled > 0)
+    {
+        status = OrderStatus::PartiallyFilled;
+    }
+    else if (0 != entry.order_status)
+    {
+        status = OrderStatus::Accepted;
+    }
+    else
+    {
+        status = OrderStatus::Sent;
+    }
+    bool changed = status != report.status;
+    report.status = status;
+    return changed;
+}
+
+void lueing::OrderTracker::Finish(Entry &entry)
+{
+    if (!entry.replace)
+    {
+        return;
+    }
+    std::unique_ptr<OrderReplace> replace = std::move(entry.replace);
+    int32_t remaining = entry.report.volume - entry.report.filled;
+    if (OrderStatus::Cancelled == entry.report.status && remaining > 0)
+    {
+        replace->volume = remaining;
+        replaces_.push_back(std::move(*replace));
+        return;
+    }
+    // 只设置改单的 future, 不调用回调, 可在锁内完成
+    FailReplace(*replace, -1, OrderStatus::Filled == entry.report.status ? "order filled" : "order rejected");
+}
+
+void lueing::OrderTracker::FailReplace(OrderReplace &replace, int32_t error_id, const std::string &error)
+{
+    replace.promise->set_value(RejectedTicket(error_id, error));
+}
+
+void lueing::OrderTracker::Publish(Entry &entry, const OrderReport &report)
+{
+    if (observer_)
+    {
+        observer_(report);
+    }
+    if (entry.callback)
+    {
+        entry.callback(report);
+    }
+    if (IsFinal(report.status))
+    {
+        entry.promise.set_value(report);
+        Retire(entry.key);
+    }
+}
+
+void lueing::OrderTracker::Retire(const OrderKey &key)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    finished_.push_back(key);
+    while (finished_.size() > keep_finished_)
+    {
+        auto it = orders_.find(finished_.front());
+        finished_.pop_front();
+        if (it == orders_.end())
+        {
+            continue;
+        }
+        const Entry &entry = *it->second;
+        if (0 != entry.order_sys_id[0])
+        {
+            auto sys = by_sys_id_.find(MakeSysKey(entry.exchange_id, entry.order_sys_id));
+            if (sys != by_sys_id_.end() && sys->second == &entry)
+            {
+                by_sys_id_.erase(sys);
+            }
+        }
+        orders_.erase(it);
+    }
+}
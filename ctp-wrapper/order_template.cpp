@@ -0,0 +1,68 @@
+#include "order_template.h"
+
+lueing::OrderTemplates::OrderTemplates(size_t max_instruments, const CThostFtdcReqUserLoginField &principal)
+        : max_instruments_(max_instruments), sets_(new std::atomic<Set *>[max_instruments])
+{
+    for (size_t i = 0; i < max_instruments_; i++)
+    {
+        sets_[i].store(nullptr, std::memory_order_relaxed);
+    }
+    strcpy(base_.BrokerID, principal.BrokerID);
+    strcpy(base_.InvestorID, principal.reserve1);
+    strcpy(base_.UserID, principal.UserID);
+    base_.OrderPriceType = THOST_FTDC_OPT_LimitPrice;
+    base_.CombHedgeFlag[0] = THOST_FTDC_HF_Speculation;
+    base_.TimeCondition = THOST_FTDC_TC_GFD;               // 当日有效
+    base_.VolumeCondition = THOST_FTDC_VC_AV;              // 任何数量
+    base_.MinVolume = 1;
+    base_.ContingentCondition = THOST_FTDC_CC_Immediately; // 立即
+    base_.ForceCloseReason = THOST_FTDC_FCC_NotForceClose; // 非强平
+    base_.IsAutoSuspend = 0;
+}
+
+lueing::OrderTemplates::~OrderTemplates()
+{
+    for (size_t i = 0; i < max_instruments_; i++)
+    {
+        delete sets_[i].load(std::memory_order_relaxed);
+    }
+}
+
+bool lueing::OrderTemplates::Warm(InstrumentHandle handle, const std::string &exchange, const std::string &contract)
+{
+    if (handle >= max_instruments_)
+    {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(lock_);
+    Set *warmed = sets_[handle].load(std::memory_order_relaxed);
+    if (nullptr != warmed && (0 != warmed->orders[0][0].ExchangeID[0] || exchange.empty()))
+    {
+        return true;
+    }
+    static const TThostFtdcDirectionType directions[ORDER_TEMPLATE_DIRECTIONS] = {THOST_FTDC_D_Buy,
+                                                                                  THOST_FTDC_D_Sell};
+    static const TThostFtdcOffsetFlagType offsets[ORDER_TEMPLATE_OFFSETS] = {THOST_FTDC_OF_Open,
+                                                                             THOST_FTDC_OF_Close,
+                                                                             THOST_FTDC_OF_CloseToday,
+                                                                             THOST_FTDC_OF_CloseYesterday};
+    Set *set = new Set();
+    for (int d = 0; d < ORDER_TEMPLATE_DIRECTIONS; d++)
+    {
+        for (int o = 0; o < ORDER_TEMPLATE_OFFSETS; o++)
+        {
+            CThostFtdcInputOrderField &order = set->orders[d][o];
+            order = base_;
+            strncpy(order.InstrumentID, contract.c_str(), sizeof(order.InstrumentID) - 1);
+            strncpy(order.ExchangeID, exchange.c_str(), sizeof(order.ExchangeID) - 1);
+            order.Direction = directions[d];
+            order.CombOffsetFlag[0] = offsets[o];
+        }
+    }
+    sets_[handle].store(set, std::memory_order_release);
+    if (nullptr != warmed)
+    {
+        retired_.emplace_back(warmed);
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cstdio>
+#include "governor.h"
+#include "order.h"
+#include "order_template.h"
+#include "risk.h"
+
+// 报单发送路径的耗时: 由模板生成报单、风控检查、登记到 OrderTracker 并经流控发出,
+// 即 CtpTxHandler::OrderAsync 中除 ReqOrderInsert 本身之外的全部工作
+// 手工运行, 不注册为单元测试; 平均耗时超过 ORDER_BENCH_LIMIT_NS 时返回非 0, 只对 Release 构建有意义
+#define ORDER_BENCH_ORDERS 200000
+#define ORDER_BENCH_LIMIT_NS 1000
+
+int main()
+{
+    CThostFtdcReqUserLoginField principal{};
+    strcpy(principal.BrokerID, "9999");
+    strcpy(principal.UserID, "bench");
+    strcpy(principal.reserve1, "bench");
+    lueing::OrderTemplates templates(16, principal);
+    templates.Warm(3, "SHFE", "rb2501");
+    lueing::OrderTracker tracker;
+    tracker.SetSession(1, 1);
+    // 报单次数与持仓不设上限, 否则基准中途被风控拒单; 价格检查照常执行
+    lueing::RiskEngine risk(16, lueing::RiskLimits{100, 0, 0, 5});
+    risk.SetPriceLimits(3, 3800, 3200);
+    // 报单不限速, 与未被流控时一样在调用线程直接发出
+    lueing::RequestGovernor governor(0, 0, 0);
+
+    CThostFtdcInputOrderField order;
+    int64_t checksum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int32_t i = 1; i <= ORDER_BENCH_ORDERS; i++)
+    {
+        templates.Build(3, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 3500 + (i & 7), 1, i, order);
+        if (RISK_PASSED != risk.Check(3, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, order.LimitPrice, 1))
+        {
+            printf("order %d rejected by risk\n", i);
+            return 1;
+        }
+        lueing::OrderTicket ticket = tracker.Add(i, 3, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, nullptr);
+        // 代替 ReqOrderInsert, 只读取报单, 不计柜台接口的耗时
+        governor.Submit(lueing::RequestClass::Order, [&order, &checksum]() {
+            checksum += order.OrderRef[0];
+            return 0;
+        });
+        checksum += ticket.order_ref;
+    }
+    auto end = std::chrono::steady_clock::now();
+    governor.Stop();
+
+    double nanos = std::chrono::duration<double, std::nano>(end - begin).count() / ORDER_BENCH_ORDERS;
+    printf("order send path: %.1f ns/order (%d orders, checksum %lld)\n", nanos, ORDER_BENCH_ORDERS,
+           static_cast<long long>(checksum));
+    return nanos < ORDER_BENCH_LIMIT_NS ? 0 : 1;
+}
@@ -0,0 +1,74 @@
+#include <climits>
+#include <cstdio>
+#include "gtest/gtest.h"
+#include "order_template.h"
+
+TEST(OrderTemplateTest, FormatInt)
+{
+    char buffer[16];
+    const int32_t values[] = {0, 7, 10, 99, 100, 12345, 1000000, INT_MAX};
+    for (int32_t value : values)
+    {
+        char expected[16];
+        int length = sprintf(expected, "%d", value);
+        EXPECT_EQ(lueing::FormatInt(value, buffer), length);
+        EXPECT_STREQ(buffer, expected);
+    }
+}
+
+TEST(OrderTemplateTest, BuildFromTemplate)
+{
+    CThostFtdcReqUserLoginField principal{};
+    strcpy(principal.BrokerID, "9999");
+    strcpy(principal.UserID, "u1");
+    strcpy(principal.reserve1, "inv1");
+    lueing::OrderTemplates templates(4, principal);
+
+    CThostFtdcInputOrderField order{};
+    EXPECT_FALSE(templates.Build(1, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, 1, 1, order));
+    ASSERT_TRUE(templates.Warm(1, "SHFE", "rb2501"));
+    EXPECT_FALSE(templates.Warm(4, "SHFE", "rb2505"));
+    EXPECT_TRUE(templates.Warmed(1));
+    EXPECT_FALSE(templates.Warmed(2));
+    // 不支持的开平标志
+    EXPECT_FALSE(templates.Build(1, THOST_FTDC_D_Buy, THOST_FTDC_OF_ForceClose, 1, 1, 1, order));
+
+    ASSERT_TRUE(templates.Build(1, THOST_FTDC_D_Sell, THOST_FTDC_OF_CloseToday, 3512.5, 3, 1024, order));
+    EXPECT_STREQ(order.BrokerID, "9999");
+    EXPECT_STREQ(order.InvestorID, "inv1");
+    EXPECT_STREQ(order.UserID, "u1");
+    EXPECT_STREQ(order.InstrumentID, "rb2501");
+    EXPECT_STREQ(order.ExchangeID, "SHFE");
+    EXPECT_STREQ(order.OrderRef, "1024");
+    EXPECT_EQ(order.RequestID, 1024);
+    EXPECT_EQ(order.Direction, THOST_FTDC_D_Sell);
+    EXPECT_EQ(order.CombOffsetFlag[0], THOST_FTDC_OF_CloseToday);
+    EXPECT_EQ(order.CombHedgeFlag[0], THOST_FTDC_HF_Speculation);
+    EXPECT_EQ(order.OrderPriceType, THOST_FTDC_OPT_LimitPrice);
+    EXPECT_EQ(order.TimeCondition, THOST_FTDC_TC_GFD);
+    EXPECT_DOUBLE_EQ(order.LimitPrice, 3512.5);
+    EXPECT_EQ(order.VolumeTotalOriginal, 3);
+
+    // 较短的 OrderRef 不残留上一笔的字符
+    ASSERT_TRUE(templates.Build(1, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 3500, 1, 7, order));
+    EXPECT_STREQ(order.OrderRef, "7");
+    EXPECT_EQ(order.Direction, THOST_FTDC_D_Buy);
+    EXPECT_EQ(order.CombOffsetFlag[0], THOST_FTDC_OF_Open);
+}
+
+TEST(OrderTemplateTest, RewarmOnceExchangeIsKnown)
+{
+    CThostFtdcReqUserLoginField principal{};
+    lueing::OrderTemplates templates(4, principal);
+    // 交易所未知时生成的模板在得知交易所后重新生成, 已知的交易所不被覆盖
+    ASSERT_TRUE(templates.Warm(2, "", "au2506"));
+    EXPECT_STREQ(templates.Exchange(2), "");
+    ASSERT_TRUE(templates.Warm(2, "", "au2506"));
+    ASSERT_TRUE(templates.Warm(2, "SHFE", "au2506"));
+    EXPECT_STREQ(templates.Exchange(2), "SHFE");
+    ASSERT_TRUE(templates.Warm(2, "INE", "au2506"));
+    CThostFtdcInputOrderField order{};
+    ASSERT_TRUE(templates.Build(2, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 600, 1, 1, order));
+    EXPECT_STREQ(order.ExchangeID, "SHFE");
+    EXPECT_STREQ(order.InstrumentID, "au2506");
+}
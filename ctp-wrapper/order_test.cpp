@@ -0,0 +1,263 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "order.h"
+
+namespace {
+    const int FRONT_ID = 1;
+    const int SESSION_ID = 1001;
+
+    CThostFtdcOrderField MakeOrder(int session_id, const char *order_ref, const char *order_sys_id, char status,
+                                   int traded)
+    {
+        CThostFtdcOrderField order{};
+        order.FrontID = FRONT_ID;
+        order.SessionID = session_id;
+        strcpy(order.OrderRef, order_ref);
+        strcpy(order.ExchangeID, "SHFE");
+        strcpy(order.OrderSysID, order_sys_id);
+        order.OrderStatus = status;
+        order.OrderSubmitStatus = THOST_FTDC_OSS_Accepted;
+        order.VolumeTraded = traded;
+        return order;
+    }
+
+    CThostFtdcOrderField MakeOrder(const char *order_ref, const char *order_sys_id, char status, int traded)
+    {
+        return MakeOrder(SESSION_ID, order_ref, order_sys_id, status, traded);
+    }
+
+    CThostFtdcTradeField MakeTrade(const char *order_ref, const char *order_sys_id, int volume, double price)
+    {
+        CThostFtdcTradeField trade{};
+        strcpy(trade.OrderRef, order_ref);
+        strcpy(trade.ExchangeID, "SHFE");
+        strcpy(trade.OrderSysID, order_sys_id);
+        trade.Volume = volume;
+        trade.Price = price;
+        return trade;
+    }
+}
+
+TEST(OrderTest, PartialFillsThenFilled)
+{
+    lueing::OrderTracker tracker;
+    tracker.SetSession(FRONT_ID, SESSION_ID);
+    std::vector<lueing::OrderStatus> updates;
+    auto ticket = tracker.Add(12, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 3,
+                              [&updates](const lueing::OrderReport &report) {
+                                  updates.push_back(report.status);
+                              });
+    EXPECT_EQ(tracker.Active(), 1u);
+
+    // CTP 先回报未进交易所的报单 (无 OrderSysID)
+    tracker.OnOrder(MakeOrder("          12", "", THOST_FTDC_OST_Unknown, 0));
+    tracker.OnOrder(MakeOrder("          12", "      8001", THOST_FTDC_OST_NoTradeQueueing, 0));
+    tracker.OnTrade(MakeTrade("          12", "      8001", 1, 100));
+    // 交易所先回报全部成交, 剩余成交尚未到达时不完成
+    tracker.OnOrder(MakeOrder("          12", "      8001", THOST_FTDC_OST_AllTraded, 3));
+    EXPECT_NE(ticket.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    tracker.OnTrade(MakeTrade("          12", "      8001", 2, 103));
+
+    ASSERT_EQ(ticket.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    auto report = ticket.done.get();
+    EXPECT_EQ(report.status, lueing::OrderStatus::Filled);
+    EXPECT_EQ(report.filled, 3);
+    EXPECT_DOUBLE_EQ(report.average_price, 102);
+    EXPECT_EQ(updates, std::vector<lueing::OrderStatus>({lueing::OrderStatus::Accepted,
+                                                         lueing::OrderStatus::PartiallyFilled,
+                                                         lueing::OrderStatus::Filled}));
+    EXPECT_EQ(tracker.Active(), 0u);
+}
+
+TEST(OrderTest, CancelAndReject)
+{
+    lueing::OrderTracker tracker;
+    tracker.SetSession(FRONT_ID, SESSION_ID);
+    auto cancelled = tracker.Add(1, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 5, nullptr);
+    auto rejected = tracker.Add(2, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, nullptr);
+    auto other = tracker.Add(3, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, nullptr);
+
+    // 撤单前成交 2 手, 成交回报晚于撤单回报
+    tracker.OnOrder(MakeOrder("1", "101", THOST_FTDC_OST_Canceled, 2));
+    EXPECT_NE(cancelled.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    tracker.OnTrade(MakeTrade("1", "101", 2, 50));
+    ASSERT_EQ(cancelled.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(cancelled.done.get().status, lueing::OrderStatus::Cancelled);
+    EXPECT_EQ(cancelled.done.get().filled, 2);
+
+    tracker.Reject(2, 31, "资金不足");
+    EXPECT_EQ(rejected.done.get().status, lueing::OrderStatus::Rejected);
+    EXPECT_EQ(rejected.done.get().error_id, 31);
+    lueing::OrderReport report{};
+    ASSERT_TRUE(tracker.Report(2, report));
+    EXPECT_EQ(report.filled, 0);
+
+    EXPECT_EQ(tracker.Active(), 1u);
+    EXPECT_NE(other.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+}
+
+TEST(OrderTest, SessionsShareOrderRef)
+{
+    lueing::OrderTracker tracker;
+    tracker.SetSession(FRONT_ID, SESSION_ID);
+    auto first = tracker.Add(7, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, nullptr);
+    // 重新登录后会话变化, OrderRef 从头编号
+    tracker.SetSession(FRONT_ID, SESSION_ID + 1);
+    auto second = tracker.Add(7, 1, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 2, nullptr);
+
+    tracker.OnOrder(MakeOrder(SESSION_ID + 1, "7", "202", THOST_FTDC_OST_NoTradeQueueing, 0));
+    tracker.OnOrder(MakeOrder(SESSION_ID, "7", "201", THOST_FTDC_OST_NoTradeQueueing, 0));
+    tracker.OnTrade(MakeTrade("7", "202", 2, 10));
+    ASSERT_EQ(second.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(second.done.get().status, lueing::OrderStatus::Filled);
+    EXPECT_EQ(second.done.get().instrument, 1u);
+    EXPECT_NE(first.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+
+    lueing::OrderReport report{};
+    ASSERT_TRUE(tracker.Report(lueing::OrderKey{FRONT_ID, SESSION_ID, 7}, report));
+    EXPECT_EQ(report.status, lueing::OrderStatus::Accepted);
+    EXPECT_EQ(report.filled, 0);
+    tracker.OnTrade(MakeTrade("7", "201", 1, 11));
+    EXPECT_EQ(first.done.get().status, lueing::OrderStatus::Filled);
+    EXPECT_DOUBLE_EQ(first.done.get().average_price, 11);
+
+    // 其他会话的报单不被跟踪
+    tracker.OnOrder(MakeOrder(SESSION_ID + 2, "7", "203", THOST_FTDC_OST_AllTraded, 1));
+    tracker.OnTrade(MakeTrade("7", "203", 1, 12));
+    EXPECT_EQ(tracker.Active(), 0u);
+}
+
+TEST(OrderTest, TradeBeforeOrderSysID)
+{
+    lueing::OrderTracker tracker;
+    tracker.SetSession(FRONT_ID, SESSION_ID);
+    auto ticket = tracker.Add(5, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 2, nullptr);
+
+    // 成交回报先于带 OrderSysID 的报单回报到达
+    tracker.OnTrade(MakeTrade("5", "301", 2, 20));
+    EXPECT_NE(ticket.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    tracker.OnOrder(MakeOrder("5", "301", THOST_FTDC_OST_AllTraded, 2));
+    ASSERT_EQ(ticket.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(ticket.done.get().status, lueing::OrderStatus::Filled);
+    EXPECT_EQ(ticket.done.get().filled, 2);
+}
+
+TEST(OrderTest, ReplaceAfterCancel)
+{
+    lueing::OrderTracker tracker;
+    tracker.SetSession(FRONT_ID, SESSION_ID);
+    tracker.Add(8, 2, THOST_FTDC_D_Sell, THOST_FTDC_OF_CloseToday, 5, nullptr);
+    tracker.OnOrder(MakeOrder("8", "401", THOST_FTDC_OST_PartTradedQueueing, 1));
+    tracker.OnTrade(MakeTrade("8", "401", 1, 30));
+
+    lueing::ReplaceTicket ticket;
+    lueing::OrderAddress address{};
+    ASSERT_TRUE(tracker.Replace(8, 29.5, nullptr, ticket, address));
+    EXPECT_EQ(address.key.session_id, SESSION_ID);
+    EXPECT_STREQ(address.order_sys_id, "401");
+    // 同一报单不能重复改单
+    lueing::ReplaceTicket duplicate;
+    EXPECT_FALSE(tracker.Replace(8, 29, nullptr, duplicate, address));
+    EXPECT_EQ(duplicate.get().done.get().status, lueing::OrderStatus::Rejected);
+
+    lueing::OrderReplace replace;
+    EXPECT_FALSE(tracker.TakeReplace(replace));
+    // 撤单回报到达, 剩余 4 手等待按新价格报出
+    tracker.OnOrder(MakeOrder("8", "401", THOST_FTDC_OST_Canceled, 1));
+    ASSERT_TRUE(tracker.TakeReplace(replace));
+    EXPECT_EQ(replace.instrument, 2u);
+    EXPECT_EQ(replace.direction, THOST_FTDC_D_Sell);
+    EXPECT_EQ(replace.offset, THOST_FTDC_OF_CloseToday);
+    EXPECT_DOUBLE_EQ(replace.price, 29.5);
+    EXPECT_EQ(replace.volume, 4);
+    EXPECT_FALSE(tracker.TakeReplace(replace));
+    EXPECT_NE(ticket.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    replace.promise->set_value(tracker.Add(9, replace.instrument, replace.direction, replace.offset, replace.volume,
+                                           nullptr));
+    EXPECT_EQ(ticket.get().order_ref, 9);
+}
+
+TEST(OrderTest, ReplaceAbandoned)
+{
+    lueing::OrderTracker tracker;
+    tracker.SetSession(FRONT_ID, SESSION_ID);
+    std::vector<lueing::OrderReport> reports;
+    tracker.Add(10, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, [&reports](const lueing::OrderReport &report) {
+        reports.push_back(report);
+    });
+    tracker.Add(11, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, nullptr);
+
+    lueing::ReplaceTicket failed;
+    lueing::OrderAddress address{};
+    ASSERT_TRUE(tracker.Replace(10, 40, nullptr, failed, address));
+    // 撤单尚未报入交易所就被柜台拒绝: 报单状态不变, 改单作废
+    tracker.ActionFailed(address.key, 26, "报单已全部成交或已撤销");
+    ASSERT_EQ(failed.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(failed.get().done.get().status, lueing::OrderStatus::Rejected);
+    EXPECT_EQ(failed.get().done.get().error_id, 26);
+    ASSERT_EQ(reports.size(), 1u);
+    EXPECT_EQ(reports[0].status, lueing::OrderStatus::Sent);
+    EXPECT_EQ(reports[0].error_id, 26);
+
+    // 撤单前已全部成交, 不再报出
+    lueing::ReplaceTicket filled;
+    ASSERT_TRUE(tracker.Replace(11, 40, nullptr, filled, address));
+    tracker.OnOrder(MakeOrder("11", "501", THOST_FTDC_OST_AllTraded, 1));
+    tracker.OnTrade(MakeTrade("11", "501", 1, 41));
+    lueing::OrderReplace replace;
+    EXPECT_FALSE(tracker.TakeReplace(replace));
+    ASSERT_EQ(filled.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(filled.get().done.get().status, lueing::OrderStatus::Rejected);
+}
+
+TEST(OrderTest, FinishedOrdersAreEvicted)
+{
+    lueing::OrderTracker tracker(2);
+    tracker.SetSession(FRONT_ID, SESSION_ID);
+    for (int i = 1; i <= 5; i++)
+    {
+        tracker.Add(i, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, nullptr);
+    }
+    tracker.Reject(1, 31, "资金不足");
+    tracker.OnOrder(MakeOrder("2", "602", THOST_FTDC_OST_AllTraded, 1));
+    tracker.OnTrade(MakeTrade("2", "602", 1, 10));
+    tracker.OnOrder(MakeOrder("3", "603", THOST_FTDC_OST_Canceled, 0));
+    EXPECT_EQ(tracker.Active(), 2u);
+    // 只保留最近终止的 2 笔, 未完成的报单不受影响
+    EXPECT_EQ(tracker.Size(), 4u);
+    lueing::OrderReport report{};
+    EXPECT_FALSE(tracker.Report(1, report));
+    ASSERT_TRUE(tracker.Report(2, report));
+    EXPECT_EQ(report.status, lueing::OrderStatus::Filled);
+    ASSERT_TRUE(tracker.Report(4, report));
+
+    tracker.Reject(4, 31, "资金不足");
+    EXPECT_FALSE(tracker.Report(2, report));
+    // 移出的报单不再接收成交
+    tracker.OnTrade(MakeTrade("2", "602", 1, 10));
+    EXPECT_EQ(tracker.Size(), 3u);
+    EXPECT_EQ(tracker.Active(), 1u);
+}
+
+TEST(OrderTest, EarlyTradesAreBounded)
+{
+    lueing::OrderTracker tracker;
+    tracker.SetSession(FRONT_ID, SESSION_ID);
+    auto dropped = tracker.Add(1, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, nullptr);
+    auto kept = tracker.Add(2, 0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, nullptr);
+    // 报单回报迟迟不到时, 暂存的成交不会无限增长
+    for (int i = 0; i <= ORDER_TRACKER_MAX_EARLY_TRADES; i++)
+    {
+        std::string sys_id = std::to_string(10000 + i);
+        tracker.OnTrade(MakeTrade("9", sys_id.c_str(), 1, 10));
+    }
+    // 最早暂存的成交被丢弃, 最近的仍可补记
+    tracker.OnOrder(MakeOrder("1", "10000", THOST_FTDC_OST_NoTradeQueueing, 0));
+    EXPECT_NE(dropped.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    std::string last = std::to_string(10000 + ORDER_TRACKER_MAX_EARLY_TRADES);
+    tracker.OnOrder(MakeOrder("2", last.c_str(), THOST_FTDC_OST_AllTraded, 1));
+    ASSERT_EQ(kept.done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(kept.done.get().filled, 1);
+}
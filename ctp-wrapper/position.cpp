@@ -0,0 +1,207 @@
+#include "position.h"
+
+#include <cfloat>
+#include <cmath>
+
+lueing::PositionBook::PositionBook(size_t max_instruments)
+        : max_instruments_(max_instruments), slots_(new Slot[max_instruments])
+{
+}
+
+lueing::PositionBook::~PositionBook()
+= default;
+
+lueing::PositionBook::Holding &lueing::PositionBook::BeginWrite(Slot &slot)
+{
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot.holding;
+}
+
+void lueing::PositionBook::EndWrite(Slot &slot)
+{
+    slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void lueing::PositionBook::ReadHolding(const Slot &slot, Holding &out) const
+{
+    for (;;)
+    {
+        uint64_t begin = slot.sequence.load(std::memory_order_acquire);
+        if (begin & 1)
+        {
+            continue;
+        }
+        std::memcpy(static_cast<void *>(&out), &slot.holding, sizeof(Holding));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == begin)
+        {
+            return;
+        }
+    }
+}
+
+void lueing::PositionBook::Reset()
+{
+    size_t used = used_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < used; i++)
+    {
+        Holding &holding = BeginWrite(slots_[i]);
+        holding = Holding{};
+        EndWrite(slots_[i]);
+    }
+}
+
+void lueing::PositionBook::Seed(InstrumentHandle handle, const CThostFtdcInvestorPositionField &position)
+{
+    int side = THOST_FTDC_PD_Long == position.PosiDirection ? POSITION_LONG
+               : (THOST_FTDC_PD_Short == position.PosiDirection ? POSITION_SHORT : -1);
+    if (handle >= max_instruments_ || side < 0)
+    {
+        return;
+    }
+    Slot &slot = slots_[handle];
+    int32_t today = position.TodayPosition;
+    int32_t yesterday = position.Position - position.TodayPosition;
+    // 纯昨仓的持仓成本按昨结算价计算, 可据此推算合约乘数
+    if (0 == today && yesterday > 0 && position.PreSettlementPrice > 0 && position.PositionCost > 0)
+    {
+        slot.multiplier.store(std::round(position.PositionCost / (position.PreSettlementPrice * yesterday)),
+                              std::memory_order_relaxed);
+    }
+
+    Holding &holding = BeginWrite(slot);
+    holding.realized += position.CloseProfit;
+    if (position.Position > 0)
+    {
+        // 同一条记录含今昨仓时 (非上期所), 成本按手数拆分
+        holding.volume[side][POSITION_TODAY] += today;
+        holding.volume[side][POSITION_YESTERDAY] += yesterday;
+        holding.cost[side][POSITION_TODAY] += position.PositionCost * today / position.Position;
+        holding.cost[side][POSITION_YESTERDAY] += position.PositionCost * yesterday / position.Position;
+    }
+    EndWrite(slot);
+    if (handle >= used_.load(std::memory_order_relaxed))
+    {
+        used_.store(handle + 1, std::memory_order_release);
+    }
+}
+
+void lueing::PositionBook::OnTrade(InstrumentHandle handle, const CThostFtdcTradeField &trade)
+{
+    int direction = THOST_FTDC_D_Buy == trade.Direction ? POSITION_LONG
+                    : (THOST_FTDC_D_Sell == trade.Direction ? POSITION_SHORT : -1);
+    if (handle >= max_instruments_ || direction < 0 || trade.Volume <= 0)
+    {
+        return;
+    }
+    Slot &slot = slots_[handle];
+    double multiplier = slot.multiplier.load(std::memory_order_relaxed);
+    Holding &holding = BeginWrite(slot);
+    if (THOST_FTDC_OF_Open == trade.OffsetFlag)
+    {
+        holding.volume[direction][POSITION_TODAY] += trade.Volume;
+        holding.cost[direction][POSITION_TODAY] += trade.Price * trade.Volume * multiplier;
+    }
+    else
+    {
+        // 卖平减少多头, 买平减少空头
+        int side = 1 - direction;
+        int32_t remaining = trade.Volume;
+        if (THOST_FTDC_OF_CloseToday == trade.OffsetFlag)
+        {
+            Close(holding, side, POSITION_TODAY, remaining, trade.Price, multiplier);
+        }
+        else if (THOST_FTDC_OF_CloseYesterday == trade.OffsetFlag || 0 == strcmp(trade.ExchangeID, "SHFE")
+                 || 0 == strcmp(trade.ExchangeID, "INE"))
+        {
+            Close(holding, side, POSITION_YESTERDAY, remaining, trade.Price, multiplier);
+        }
+        else
+        {
+            remaining -= Close(holding, side, POSITION_YESTERDAY, remaining, trade.Price, multiplier);
+            Close(holding, side, POSITION_TODAY, remaining, trade.Price, multiplier);
+        }
+    }
+    EndWrite(slot);
+    if (handle >= used_.load(std::memory_order_relaxed))
+    {
+        used_.store(handle + 1, std::memory_order_release);
+    }
+}
+
+int32_t lueing::PositionBook::Close(Holding &holding, int side, int bucket, int32_t volume, double price,
+                                    double multiplier)
+{
+    int32_t held = holding.volume[side][bucket];
+    int32_t closed = volume < held ? volume : held;
+    if (closed <= 0)
+    {
+        return 0;
+    }
+    double cost = holding.cost[side][bucket] * closed / held;
+    double value = price * closed * multiplier;
+    holding.realized += POSITION_LONG == side ? value - cost : cost - value;
+    holding.volume[side][bucket] -= closed;
+    holding.cost[side][bucket] -= cost;
+    return closed;
+}
+
+void lueing::PositionBook::SetMultiplier(InstrumentHandle handle, double multiplier)
+{
+    if (handle < max_instruments_ && multiplier > 0)
+    {
+        slots_[handle].multiplier.store(multiplier, std::memory_order_relaxed);
+    }
+}
+
+void lueing::PositionBook::OnMarketData(const CThostFtdcDepthMarketDataField &field, const Tick &tick)
+{
+    if (tick.instrument < max_instruments_ && tick.last_price > 0)
+    {
+        slots_[tick.instrument].last_price.store(tick.last_price, std::memory_order_relaxed);
+    }
+}
+
+bool lueing::PositionBook::Read(InstrumentHandle handle, PositionSummary &out) const
+{
+    if (handle >= max_instruments_)
+    {
+        return false;
+    }
+    const Slot &slot = slots_[handle];
+    Holding holding;
+    ReadHolding(slot, holding);
+    std::memcpy(out.volume, holding.volume, sizeof(out.volume));
+    std::memcpy(out.cost, holding.cost, sizeof(out.cost));
+    out.realized = holding.realized;
+    out.last_price = slot.last_price.load(std::memory_order_relaxed);
+    out.unrealized = 0;
+    if (out.last_price > 0)
+    {
+        double multiplier = slot.multiplier.load(std::memory_order_relaxed);
+        for (int bucket = 0; bucket < 2; bucket++)
+        {
+            out.unrealized += out.last_price * holding.volume[POSITION_LONG][bucket] * multiplier
+                              - holding.cost[POSITION_LONG][bucket];
+            out.unrealized += holding.cost[POSITION_SHORT][bucket]
+                              - out.last_price * holding.volume[POSITION_SHORT][bucket] * multiplier;
+        }
+    }
+    return true;
+}
+
+void lueing::PositionBook::Totals(double &realized, double &unrealized) const
+{
+    realized = 0;
+    unrealized = 0;
+    size_t used = used_.load(std::memory_order_acquire);
+    PositionSummary summary{};
+    for (size_t i = 0; i < used; i++)
+    {
+        Read(static_cast<InstrumentHandle>(i), summary);
+        realized += summary.realized;
+        unrealized += summary.unrealized;
+    }
+}
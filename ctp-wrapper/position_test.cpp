@@ -0,0 +1,114 @@
+#include <cstring>
+#include <thread>
+#include "gtest/gtest.h"
+#include "position.h"
+
+namespace {
+    CThostFtdcTradeField MakeTrade(const char *exchange, char direction, char offset, int volume, double price)
+    {
+        CThostFtdcTradeField trade{};
+        strcpy(trade.ExchangeID, exchange);
+        trade.Direction = direction;
+        trade.OffsetFlag = offset;
+        trade.Volume = volume;
+        trade.Price = price;
+        return trade;
+    }
+
+    void Mark(lueing::PositionBook &book, lueing::InstrumentHandle handle, double price)
+    {
+        CThostFtdcDepthMarketDataField field{};
+        lueing::Tick tick{};
+        tick.instrument = handle;
+        tick.last_price = price;
+        book.OnMarketData(field, tick);
+    }
+}
+
+TEST(PositionTest, SeedTradeAndMark)
+{
+    lueing::PositionBook book(4);
+    // 上期所昨仓 2 手空头, 昨结算 4000, 乘数 10
+    CThostFtdcInvestorPositionField history{};
+    history.PosiDirection = THOST_FTDC_PD_Short;
+    history.PositionDate = THOST_FTDC_PSD_History;
+    history.Position = 2;
+    history.YdPosition = 2;
+    history.PreSettlementPrice = 4000;
+    history.PositionCost = 80000;
+    history.CloseProfit = 150;
+    book.Seed(1, history);
+    EXPECT_DOUBLE_EQ(book.Multiplier(1), 10);
+    EXPECT_EQ(book.Used(), 2u);
+
+    // 开多 3 手, 平今 1 手 (盈利 5 点), 平昨空头 1 手 (买平, 亏损 20 点)
+    book.OnTrade(1, MakeTrade("SHFE", THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 3, 4010));
+    book.OnTrade(1, MakeTrade("SHFE", THOST_FTDC_D_Sell, THOST_FTDC_OF_CloseToday, 1, 4015));
+    book.OnTrade(1, MakeTrade("SHFE", THOST_FTDC_D_Buy, THOST_FTDC_OF_Close, 1, 4020));
+
+    lueing::PositionSummary summary{};
+    ASSERT_TRUE(book.Read(1, summary));
+    EXPECT_EQ(summary.volume[POSITION_LONG][POSITION_TODAY], 2);
+    EXPECT_EQ(summary.volume[POSITION_SHORT][POSITION_YESTERDAY], 1);
+    EXPECT_DOUBLE_EQ(summary.cost[POSITION_LONG][POSITION_TODAY], 80200);
+    EXPECT_DOUBLE_EQ(summary.realized, 150 + 50 - 200);
+    EXPECT_DOUBLE_EQ(summary.unrealized, 0);
+
+    Mark(book, 1, 4030);
+    ASSERT_TRUE(book.Read(1, summary));
+    // 多头 2 手盈利 20 点, 空头 1 手亏损 30 点
+    EXPECT_DOUBLE_EQ(summary.unrealized, 400 - 300);
+    double realized, unrealized;
+    book.Totals(realized, unrealized);
+    EXPECT_DOUBLE_EQ(realized, 0);
+    EXPECT_DOUBLE_EQ(unrealized, 100);
+
+    book.Reset();
+    ASSERT_TRUE(book.Read(1, summary));
+    EXPECT_EQ(summary.volume[POSITION_LONG][POSITION_TODAY], 0);
+    EXPECT_DOUBLE_EQ(summary.realized, 0);
+}
+
+TEST(PositionTest, CloseYesterdayFirst)
+{
+    lueing::PositionBook book(4);
+    book.SetMultiplier(0, 5);
+    // 非上期所: 一条记录含今昨仓
+    CThostFtdcInvestorPositionField position{};
+    position.PosiDirection = THOST_FTDC_PD_Long;
+    position.PositionDate = THOST_FTDC_PSD_Today;
+    position.Position = 3;
+    position.TodayPosition = 1;
+    position.PositionCost = 3 * 100 * 5;
+    book.Seed(0, position);
+
+    book.OnTrade(0, MakeTrade("DCE", THOST_FTDC_D_Sell, THOST_FTDC_OF_Close, 3, 110));
+    lueing::PositionSummary summary{};
+    ASSERT_TRUE(book.Read(0, summary));
+    EXPECT_EQ(summary.volume[POSITION_LONG][POSITION_YESTERDAY], 0);
+    EXPECT_EQ(summary.volume[POSITION_LONG][POSITION_TODAY], 0);
+    EXPECT_DOUBLE_EQ(summary.realized, 150);
+}
+
+TEST(PositionTest, ConsistentReads)
+{
+    lueing::PositionBook book(1);
+    std::atomic_bool done{false};
+    std::thread writer([&] {
+        for (int i = 0; i < 100000; i++)
+        {
+            book.OnTrade(0, MakeTrade("DCE", THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1, 100));
+            book.OnTrade(0, MakeTrade("DCE", THOST_FTDC_D_Sell, THOST_FTDC_OF_Close, 1, 100));
+        }
+        done = true;
+    });
+    lueing::PositionSummary summary{};
+    while (!done)
+    {
+        book.Read(0, summary);
+        // 持仓与成本总是成对变化
+        EXPECT_DOUBLE_EQ(summary.cost[POSITION_LONG][POSITION_TODAY],
+                         100.0 * summary.volume[POSITION_LONG][POSITION_TODAY]);
+    }
+    writer.join();
+}
@@ -0,0 +1,72 @@
+#include "query.h"
+
+namespace {
+    // 槽位正在登记或结束, 其他线程不可占用
+    constexpr int32_t kBusy = -1;
+}
+
+lueing::QueryTable::QueryTable()
+    : slots_(new Slot[QUERY_SLOTS])
+{
+}
+
+lueing::QueryTable::~QueryTable()
+{
+    for (size_t i = 0; i < QUERY_SLOTS; i++)
+    {
+        delete slots_[i].sink;
+    }
+}
+
+bool lueing::QueryTable::Register(int32_t request_id, QuerySink *sink)
+{
+    Slot &slot = slots_[Index(request_id)];
+    int32_t expected = 0;
+    if (request_id <= 0 || !slot.request_id.compare_exchange_strong(expected, kBusy, std::memory_order_acq_rel))
+    {
+        sink->Finish(QUERY_ERROR_SLOTS, "too many queries in flight");
+        delete sink;
+        return false;
+    }
+    slot.sink = sink;
+    slot.request_id.store(request_id, std::memory_order_release);
+    return true;
+}
+
+void lueing::QueryTable::Abort(int32_t request_id, int error_id, const std::string &error)
+{
+    Slot &slot = slots_[Index(request_id)];
+    int32_t expected = request_id;
+    if (request_id <= 0 || !slot.request_id.compare_exchange_strong(expected, kBusy, std::memory_order_acq_rel))
+    {
+        return;
+    }
+    QuerySink *sink = slot.sink;
+    slot.sink = nullptr;
+    slot.request_id.store(0, std::memory_order_release);
+    // 先释放槽位再完成, 等待方可在 future 就绪后立即发起下一次查询
+    sink->Finish(error_id, error);
+    delete sink;
+}
+
+void lueing::QueryTable::AbortAll()
+{
+    for (size_t i = 0; i < QUERY_SLOTS; i++)
+    {
+        int32_t request_id = slots_[i].request_id.load(std::memory_order_acquire);
+        if (request_id > 0)
+        {
+            Abort(request_id, QUERY_ERROR_DISCONNECTED, "front disconnected");
+        }
+    }
+}
+
+size_t lueing::QueryTable::Pending() const
+{
+    size_t pending = 0;
+    for (size_t i = 0; i < QUERY_SLOTS; i++)
+    {
+        pending += slots_[i].request_id.load(std::memory_order_relaxed) > 0 ? 1 : 0;
+    }
+    return pending;
+}
@@ -0,0 +1,99 @@
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <type_traits>
+#include "gtest/gtest.h"
+#include "query.h"
+
+static_assert(std::is_same<lueing::QueryTraits<CThostFtdcQryInstrumentField>::Response,
+                           CThostFtdcInstrumentField>::value, "ReqQryInstrument answers CThostFtdcInstrumentField");
+static_assert(std::is_same<lueing::QueryTraits<CThostFtdcQryInvestorPositionField>::Response,
+                           CThostFtdcInvestorPositionField>::value, "ReqQryInvestorPosition answers positions");
+
+namespace {
+    std::future<std::vector<CThostFtdcInstrumentField>> Register(lueing::QueryTable &table, int32_t request_id)
+    {
+        auto *collector = new lueing::QueryCollector<CThostFtdcInstrumentField>();
+        auto future = collector->Future();
+        table.Register(request_id, collector);
+        return future;
+    }
+
+    bool Ready(const std::future<std::vector<CThostFtdcInstrumentField>> &future)
+    {
+        return std::future_status::ready == future.wait_for(std::chrono::seconds(0));
+    }
+}
+
+TEST(QueryTableTest, collects_rows_until_last_response)
+{
+    lueing::QueryTable table;
+    auto future = Register(table, 7);
+    auto empty = Register(table, 8);
+    EXPECT_EQ(2u, table.Pending());
+
+    CThostFtdcInstrumentField instrument{};
+    strcpy(instrument.InstrumentID, "rb2505");
+    table.Complete(&instrument, 0, "", 7, false);
+    // 其他请求的响应不影响本查询
+    table.Complete(&instrument, 0, "", 9, true);
+    strcpy(instrument.InstrumentID, "ag2506");
+    table.Complete(&instrument, 0, "", 7, false);
+    EXPECT_FALSE(Ready(future));
+    table.Complete<CThostFtdcInstrumentField>(nullptr, 0, "", 7, true);
+    ASSERT_TRUE(Ready(future));
+    std::vector<CThostFtdcInstrumentField> rows = future.get();
+    ASSERT_EQ(2u, rows.size());
+    EXPECT_STREQ("rb2505", rows[0].InstrumentID);
+    EXPECT_STREQ("ag2506", rows[1].InstrumentID);
+
+    // 没有记录时 CTP 只回调一次空指针
+    table.Complete<CThostFtdcInstrumentField>(nullptr, 0, "", 8, true);
+    EXPECT_TRUE(empty.get().empty());
+    EXPECT_EQ(0u, table.Pending());
+}
+
+TEST(QueryTableTest, error_response_throws_query_error)
+{
+    lueing::QueryTable table;
+    auto future = Register(table, 3);
+    table.Complete<CThostFtdcInstrumentField>(nullptr, 90, "query too frequent", 3, true);
+    try
+    {
+        future.get();
+        FAIL() << "expected QueryError";
+    }
+    catch (const lueing::QueryError &error)
+    {
+        EXPECT_EQ(90, error.ErrorId());
+        EXPECT_STREQ("query too frequent", error.what());
+    }
+}
+
+TEST(QueryTableTest, slot_collision_and_disconnect_abort_queries)
+{
+    lueing::QueryTable table;
+    auto first = Register(table, 5);
+    // 编号相差 QUERY_SLOTS 的请求落在同一槽位
+    auto collided = Register(table, 5 + QUERY_SLOTS);
+    ASSERT_TRUE(Ready(collided));
+    EXPECT_THROW(collided.get(), lueing::QueryError);
+
+    table.AbortAll();
+    ASSERT_TRUE(Ready(first));
+    try
+    {
+        first.get();
+        FAIL() << "expected QueryError";
+    }
+    catch (const lueing::QueryError &error)
+    {
+        EXPECT_EQ(QUERY_ERROR_DISCONNECTED, error.ErrorId());
+    }
+    EXPECT_EQ(0u, table.Pending());
+
+    // 槽位释放后可再次使用
+    auto reused = Register(table, 5 + QUERY_SLOTS);
+    table.Complete<CThostFtdcInstrumentField>(nullptr, 0, "", 5 + QUERY_SLOTS, true);
+    EXPECT_TRUE(reused.get().empty());
+}
@@ -0,0 +1,26 @@
+#include "quote_table.h"
+
+lueing::QuoteTable::QuoteTable(size_t max_instruments) : capacity_(max_instruments), slots_(new Slot[max_instruments])
+{
+}
+
+lueing::QuoteTable::~QuoteTable()
+= default;
+
+size_t lueing::QuoteTable::Read(const std::vector<InstrumentHandle> &handles, std::vector<Tick> &out) const
+{
+    size_t found = 0;
+    out.resize(handles.size());
+    for (size_t i = 0; i < handles.size(); i++)
+    {
+        if (Read(handles[i], out[i]))
+        {
+            found++;
+        }
+        else
+        {
+            out[i].instrument = INVALID_INSTRUMENT;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,61 @@
+#include <thread>
+#include "gtest/gtest.h"
+#include "quote_table.h"
+
+TEST(QuoteTableTest, PublishAndRead)
+{
+    lueing::QuoteTable quotes(4);
+    lueing::Tick tick{};
+    EXPECT_FALSE(quotes.Read(1, tick));
+    EXPECT_FALSE(quotes.Read(INVALID_INSTRUMENT, tick));
+
+    tick.instrument = 1;
+    tick.last_price = 7800;
+    quotes.Publish(1, tick);
+    tick.last_price = 7801;
+    quotes.Publish(1, tick);
+    EXPECT_EQ(quotes.Version(1), 2u);
+
+    lueing::Tick out{};
+    EXPECT_TRUE(quotes.Read(1, out));
+    EXPECT_EQ(out.last_price, 7801);
+
+    std::vector<lueing::Tick> batch;
+    EXPECT_EQ(quotes.Read({1, 2}, batch), 1u);
+    EXPECT_EQ(batch[0].last_price, 7801);
+    EXPECT_EQ(batch[1].instrument, INVALID_INSTRUMENT);
+}
+
+TEST(QuoteTableTest, ConcurrentReaders)
+{
+    lueing::QuoteTable quotes(1);
+    std::atomic_bool done{false};
+    std::vector<std::thread> readers;
+
+    for (int r = 0; r < 4; r++)
+    {
+        readers.emplace_back([&] {
+            lueing::Tick tick{};
+            while (!done.load())
+            {
+                if (quotes.Read(0, tick))
+                {
+                    EXPECT_EQ(static_cast<int>(tick.bid_price[4]), tick.ask_volume[4]);
+                }
+            }
+        });
+    }
+
+    lueing::Tick tick{};
+    for (int i = 0; i < 100000; i++)
+    {
+        tick.bid_price[4] = i;
+        tick.ask_volume[4] = i;
+        quotes.Publish(0, tick);
+    }
+    done.store(true);
+    for (auto &reader : readers)
+    {
+        reader.join();
+    }
+}
@@ -0,0 +1,273 @@
+#include "replay.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "tick.h"
+
+namespace {
+    // 距离目标时刻小于该值时自旋等待, 否则休眠; 休眠分段进行以便及时响应请求与停止
+    constexpr int64_t kSpinNanos = 200 * 1000;
+    constexpr int64_t kMaxSleepNanos = 10 * 1000 * 1000;
+}
+
+lueing::ReplayMdApi::ReplayMdApi(std::string directory, std::string trading_day, double speed)
+    : directory_(std::move(directory)), speed_(speed), trading_day_(std::move(trading_day))
+{
+    if (trading_day_.empty())
+    {
+        trading_day_ = LatestTradingDay(directory_);
+    }
+    files_ = JournalReader::Files(directory_, trading_day_);
+    spdlog::info("[行情回放] 目录: {}, 交易日: {}, 文件数: {}, 速度: {}", directory_, trading_day_, files_.size(),
+                 speed_);
+}
+
+lueing::ReplayMdApi::~ReplayMdApi()
+{
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        running_.store(false);
+    }
+    condition_.notify_all();
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+}
+
+void lueing::ReplayMdApi::Release()
+{
+    delete this;
+}
+
+void lueing::ReplayMdApi::Init()
+{
+    if (running_.exchange(true))
+    {
+        return;
+    }
+    worker_ = std::thread([this] { Run(); });
+}
+
+int lueing::ReplayMdApi::Join()
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    condition_.wait(lock, [this] { return !running_.load() || finished_.load(); });
+    return 0;
+}
+
+int lueing::ReplayMdApi::SubscribeMarketData(char *ppInstrumentID[], int nCount)
+{
+    RspSpecificInstrument(ppInstrumentID, nCount, true);
+    return 0;
+}
+
+int lueing::ReplayMdApi::UnSubscribeMarketData(char *ppInstrumentID[], int nCount)
+{
+    RspSpecificInstrument(ppInstrumentID, nCount, false);
+    return 0;
+}
+
+int lueing::ReplayMdApi::SubscribeForQuoteRsp(char *ppInstrumentID[], int nCount)
+{
+    return 0;
+}
+
+int lueing::ReplayMdApi::UnSubscribeForQuoteRsp(char *ppInstrumentID[], int nCount)
+{
+    return 0;
+}
+
+int lueing::ReplayMdApi::ReqUserLogin(CThostFtdcReqUserLoginField *pReqUserLoginField, int nRequestID)
+{
+    CThostFtdcRspUserLoginField login{};
+    std::strncpy(login.TradingDay, trading_day_.c_str(), sizeof(login.TradingDay) - 1);
+    if (nullptr != pReqUserLoginField)
+    {
+        std::strcpy(login.BrokerID, pReqUserLoginField->BrokerID);
+        std::strcpy(login.UserID, pReqUserLoginField->UserID);
+    }
+    Post([this, login, nRequestID]() mutable {
+        CThostFtdcRspInfoField info{};
+        spi_->OnRspUserLogin(&login, &info, nRequestID, true);
+    });
+    return 0;
+}
+
+int lueing::ReplayMdApi::ReqUserLogout(CThostFtdcUserLogoutField *pUserLogout, int nRequestID)
+{
+    CThostFtdcUserLogoutField logout{};
+    if (nullptr != pUserLogout)
+    {
+        logout = *pUserLogout;
+    }
+    Post([this, logout, nRequestID]() mutable {
+        CThostFtdcRspInfoField info{};
+        spi_->OnRspUserLogout(&logout, &info, nRequestID, true);
+    });
+    return 0;
+}
+
+int lueing::ReplayMdApi::ReqQryMulticastInstrument(CThostFtdcQryMulticastInstrumentField *pQryMulticastInstrument,
+                                                   int nRequestID)
+{
+    Post([this, nRequestID]() {
+        spi_->OnRspQryMulticastInstrument(nullptr, nullptr, nRequestID, true);
+    });
+    return 0;
+}
+
+std::string lueing::ReplayMdApi::LatestTradingDay(const std::string &directory)
+{
+    // 文件名形如 md-20250224-0.jnl
+    std::string latest;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.size() == 17 && 0 == name.compare(0, 3, "md-") && 0 == name.compare(11, 6, "-0.jnl"))
+        {
+            latest = std::max(latest, name.substr(3, 8));
+        }
+    }
+    return latest;
+}
+
+void lueing::ReplayMdApi::Post(std::function<void()> task)
+{
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        tasks_.push_back(std::move(task));
+        has_tasks_.store(true, std::memory_order_release);
+    }
+    condition_.notify_all();
+}
+
+void lueing::ReplayMdApi::RunTasks()
+{
+    if (!has_tasks_.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    std::deque<std::function<void()>> tasks;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        tasks.swap(tasks_);
+        has_tasks_.store(false, std::memory_order_release);
+    }
+    for (auto &task : tasks)
+    {
+        task();
+    }
+}
+
+void lueing::ReplayMdApi::RspSpecificInstrument(char *ppInstrumentID[], int nCount, bool subscribe)
+{
+    std::vector<std::string> instruments;
+    for (int i = 0; i < nCount; i++)
+    {
+        instruments.emplace_back(ppInstrumentID[i]);
+    }
+    Post([this, instruments, subscribe]() {
+        for (size_t i = 0; i < instruments.size(); i++)
+        {
+            CThostFtdcSpecificInstrumentField instrument{};
+            CThostFtdcRspInfoField info{};
+            std::strncpy(instrument.InstrumentID, instruments[i].c_str(), sizeof(instrument.InstrumentID) - 1);
+            if (subscribe)
+            {
+                subscribed_.insert(instruments[i]);
+                spi_->OnRspSubMarketData(&instrument, &info, 0, i + 1 == instruments.size());
+            }
+            else
+            {
+                subscribed_.erase(instruments[i]);
+                spi_->OnRspUnSubMarketData(&instrument, &info, 0, i + 1 == instruments.size());
+            }
+        }
+        started_ = started_ || subscribe;
+    });
+}
+
+void lueing::ReplayMdApi::Run()
+{
+    spi_->OnFrontConnected();
+    while (running_.load(std::memory_order_acquire))
+    {
+        RunTasks();
+        if (!started_ || finished_.load(std::memory_order_relaxed))
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            condition_.wait(lock, [this] { return !running_.load() || has_tasks_.load(); });
+            continue;
+        }
+
+        const JournalRecord *record = Next();
+        if (nullptr == record)
+        {
+            spdlog::info("[行情回放] 回放结束, 交易日: {}, 推送行情: {}", trading_day_, Replayed());
+            {
+                std::unique_lock<std::mutex> lock(lock_);
+                finished_.store(true, std::memory_order_release);
+            }
+            // 唤醒 Join
+            condition_.notify_all();
+            continue;
+        }
+        // 未订阅的记录同样参与计时, 保持原始节奏
+        if (!Pace(record->receive_time) || !subscribed_.contains(record->field.InstrumentID))
+        {
+            continue;
+        }
+        // 与 CTP 一致, 每次回调传入独立的结构体
+        CThostFtdcDepthMarketDataField field = record->field;
+        spi_->OnRtnDepthMarketData(&field);
+        replayed_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+const lueing::JournalRecord *lueing::ReplayMdApi::Next()
+{
+    while (nullptr == reader_ || record_index_ >= reader_->Count())
+    {
+        if (file_index_ >= files_.size())
+        {
+            return nullptr;
+        }
+        reader_ = std::make_unique<JournalReader>(files_[file_index_++]);
+        record_index_ = 0;
+    }
+    return &reader_->At(record_index_++);
+}
+
+bool lueing::ReplayMdApi::Pace(int64_t receive_time)
+{
+    if (speed_ <= 0)
+    {
+        return true;
+    }
+    if (0 == base_local_time_)
+    {
+        base_receive_time_ = receive_time;
+        base_local_time_ = MonotonicNanos();
+        return true;
+    }
+    int64_t target = base_local_time_ + static_cast<int64_t>(static_cast<double>(receive_time - base_receive_time_) / speed_);
+    for (int64_t now = MonotonicNanos(); now < target; now = MonotonicNanos())
+    {
+        if (!running_.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        if (target - now > kSpinNanos)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(std::min(target - now - kSpinNanos, kMaxSleepNanos)));
+            RunTasks();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,143 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "replay.h"
+
+namespace {
+    class RecordingSpi : public CThostFtdcMdSpi {
+    public:
+        explicit RecordingSpi(CThostFtdcMdApi *api) : api_(api) {}
+
+        void OnFrontConnected() override
+        {
+            CThostFtdcReqUserLoginField login{};
+            api_->ReqUserLogin(&login, 1);
+        }
+
+        void OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo,
+                            int nRequestID, bool bIsLast) override
+        {
+            trading_day = pRspUserLogin->TradingDay;
+            logged_in.store(true);
+        }
+
+        void OnRspSubMarketData(CThostFtdcSpecificInstrumentField *pSpecificInstrument,
+                                CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) override
+        {
+            subscribed++;
+        }
+
+        void OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *pDepthMarketData) override
+        {
+            instruments.emplace_back(pDepthMarketData->InstrumentID);
+            volumes.push_back(pDepthMarketData->Volume);
+        }
+
+        std::string trading_day;
+        std::atomic_bool logged_in{false};
+        std::atomic_int subscribed{0};
+        std::vector<std::string> instruments;
+        std::vector<int> volumes;
+
+    private:
+        CThostFtdcMdApi *api_;
+    };
+
+    // 写入 count 条行情, 合约交替为 ag2504/au2506, 接收时间间隔 interval_ns
+    std::string WriteJournal(const char *name, int count, int64_t interval_ns)
+    {
+        auto directory = (std::filesystem::temp_directory_path() / name).string();
+        std::filesystem::remove_all(directory);
+        lueing::TickJournal journal(directory, 16, 10, 64);
+        journal.Prepare("20250224");
+        for (int i = 0; i < count; i++)
+        {
+            CThostFtdcDepthMarketDataField field{};
+            strcpy(field.TradingDay, "20250224");
+            strcpy(field.InstrumentID, i % 2 ? "au2506" : "ag2504");
+            field.Volume = i;
+            journal.Append(field, 1000000000LL + i * interval_ns);
+        }
+        return directory;
+    }
+
+    void Replay(lueing::ReplayMdApi *api, RecordingSpi &spi, char *instrument)
+    {
+        api->RegisterSpi(&spi);
+        api->Init();
+        for (int i = 0; i < 500 && !spi.logged_in.load(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        char *instruments[] = {instrument};
+        api->SubscribeMarketData(instruments, 1);
+        for (int i = 0; i < 5000 && !api->Finished(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+TEST(ReplayTest, FullSpeedReplaysSubscribedInOrder)
+{
+    auto directory = WriteJournal("ctp_replay_test", 40, 1000000);
+    auto *api = new lueing::ReplayMdApi(directory, "", 0);
+    RecordingSpi spi(api);
+    char instrument[] = "ag2504";
+    Replay(api, spi, instrument);
+
+    EXPECT_EQ(spi.trading_day, "20250224");
+    EXPECT_EQ(spi.subscribed.load(), 1);
+    EXPECT_TRUE(api->Finished());
+    // 40 条跨越 3 个分片, 只推送已订阅的 ag2504, 顺序不变
+    ASSERT_EQ(api->Replayed(), 20u);
+    ASSERT_EQ(spi.volumes.size(), 20u);
+    for (size_t i = 0; i < spi.volumes.size(); i++)
+    {
+        EXPECT_EQ(spi.instruments[i], "ag2504");
+        EXPECT_EQ(spi.volumes[i], static_cast<int>(i * 2));
+    }
+    api->Release();
+}
+
+TEST(ReplayTest, AcceleratedReplayKeepsPacing)
+{
+    // 原始跨度 20 x 10ms = 190ms, 2 倍速约 95ms
+    auto directory = WriteJournal("ctp_replay_pacing_test", 20, 10000000);
+    auto *api = new lueing::ReplayMdApi(directory, "20250224", 2);
+    RecordingSpi spi(api);
+    char instrument[] = "au2506";
+    auto begin = std::chrono::steady_clock::now();
+    Replay(api, spi, instrument);
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+
+    EXPECT_EQ(api->Replayed(), 10u);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(90));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(180));
+    api->Release();
+}
+
+TEST(ReplayTest, JoinReturnsWhenJournalIsExhausted)
+{
+    auto directory = WriteJournal("ctp_replay_join_test", 10, 1000000);
+    auto *api = new lueing::ReplayMdApi(directory, "20250224", 0);
+    RecordingSpi spi(api);
+    api->RegisterSpi(&spi);
+    api->Init();
+    for (int i = 0; i < 500 && !spi.logged_in.load(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    char instrument[] = "ag2504";
+    char *instruments[] = {instrument};
+    api->SubscribeMarketData(instruments, 1);
+
+    EXPECT_EQ(api->Join(), 0);
+    EXPECT_TRUE(api->Finished());
+    EXPECT_EQ(api->Replayed(), 5u);
+    api->Release();
+}
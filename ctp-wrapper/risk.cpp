@@ -0,0 +1,210 @@
+#include "risk.h"
+
+#include <cfloat>
+#include <cmath>
+
+lueing::RiskEngine::RiskEngine(size_t max_instruments, const RiskLimits &limits)
+        : max_instruments_(max_instruments), limits_(limits), slots_(new Slot[max_instruments])
+{
+}
+
+lueing::RiskEngine::~RiskEngine()
+= default;
+
+int lueing::RiskEngine::Check(InstrumentHandle handle, char direction, char offset, double price, int32_t volume)
+{
+    if (volume <= 0 || (limits_.max_order_volume > 0 && volume > limits_.max_order_volume))
+    {
+        return RISK_ORDER_VOLUME;
+    }
+    if (handle >= max_instruments_)
+    {
+        return RISK_INSTRUMENT;
+    }
+    Slot &slot = slots_[handle];
+    double upper = slot.upper_limit.load(std::memory_order_relaxed);
+    double lower = slot.lower_limit.load(std::memory_order_relaxed);
+    if ((upper > 0 && price > upper) || (lower > 0 && price < lower))
+    {
+        return RISK_PRICE_LIMIT;
+    }
+    bool open = true;
+    int side = Side(direction, offset, &open);
+    // 平仓只减少风险, 不受偏离最新价与报单次数限制, 止损止盈在行情急变或次数用尽时仍能平仓
+    if (!open)
+    {
+        return RISK_PASSED;
+    }
+    double last = slot.last_price.load(std::memory_order_relaxed);
+    if (limits_.max_deviation > 0 && last > 0 && std::fabs(price - last) * 100 > last * limits_.max_deviation)
+    {
+        return RISK_FAT_FINGER;
+    }
+
+    if (limits_.max_daily_orders > 0 && !Reserve(daily_orders_, 1, limits_.max_daily_orders))
+    {
+        return RISK_ORDER_COUNT;
+    }
+    if (side < 0)
+    {
+        return RISK_PASSED;
+    }
+    if (limits_.max_position <= 0)
+    {
+        slot.position[side].fetch_add(volume, std::memory_order_relaxed);
+    }
+    else if (!Reserve(slot.position[side], volume, limits_.max_position))
+    {
+        Refund(offset);
+        return RISK_POSITION;
+    }
+    return RISK_PASSED;
+}
+
+void lueing::RiskEngine::Refund(char offset)
+{
+    if (limits_.max_daily_orders > 0 && THOST_FTDC_OF_Open == offset)
+    {
+        Sub(daily_orders_, 1);
+    }
+}
+
+bool lueing::RiskEngine::Reserve(std::atomic<int32_t> &value, int32_t amount, int32_t limit)
+{
+    // 超限时不写入, 并发的检查不会因为其他线程暂时多占的额度被误拒
+    int32_t current = value.load(std::memory_order_relaxed);
+    do
+    {
+        if (current + amount > limit)
+        {
+            return false;
+        }
+    } while (!value.compare_exchange_weak(current, current + amount, std::memory_order_relaxed));
+    return true;
+}
+
+void lueing::RiskEngine::OnOrderReport(const OrderReport &report)
+{
+    if (!IsFinal(report.status) || report.instrument >= max_instruments_)
+    {
+        return;
+    }
+    bool open;
+    int side = Side(report.direction, report.offset, &open);
+    if (side < 0)
+    {
+        return;
+    }
+    Slot &slot = slots_[report.instrument];
+    if (open)
+    {
+        Sub(slot.position[side], report.volume - report.filled);
+    }
+    else
+    {
+        Sub(slot.position[side], report.filled);
+    }
+}
+
+void lueing::RiskEngine::OnMarketData(const CThostFtdcDepthMarketDataField &field, const Tick &tick)
+{
+    if (tick.instrument >= max_instruments_)
+    {
+        return;
+    }
+    Slot &slot = slots_[tick.instrument];
+    if (tick.last_price > 0)
+    {
+        slot.last_price.store(tick.last_price, std::memory_order_relaxed);
+    }
+    // 涨跌停价盘中不变, 相同时不写, 避免每笔行情都使缓存行失效
+    if (field.UpperLimitPrice > 0 && field.UpperLimitPrice < DBL_MAX
+        && slot.upper_limit.load(std::memory_order_relaxed) != field.UpperLimitPrice)
+    {
+        slot.upper_limit.store(field.UpperLimitPrice, std::memory_order_relaxed);
+    }
+    if (field.LowerLimitPrice > 0 && field.LowerLimitPrice < DBL_MAX
+        && slot.lower_limit.load(std::memory_order_relaxed) != field.LowerLimitPrice)
+    {
+        slot.lower_limit.store(field.LowerLimitPrice, std::memory_order_relaxed);
+    }
+}
+
+void lueing::RiskEngine::SetPriceLimits(InstrumentHandle handle, double upper, double lower)
+{
+    if (handle >= max_instruments_)
+    {
+        return;
+    }
+    slots_[handle].upper_limit.store(upper, std::memory_order_relaxed);
+    slots_[handle].lower_limit.store(lower, std::memory_order_relaxed);
+}
+
+void lueing::RiskEngine::SetPosition(InstrumentHandle handle, char direction, int32_t volume)
+{
+    int side = THOST_FTDC_D_Buy == direction ? 0 : (THOST_FTDC_D_Sell == direction ? 1 : -1);
+    if (handle >= max_instruments_ || side < 0)
+    {
+        return;
+    }
+    slots_[handle].position[side].store(volume, std::memory_order_relaxed);
+}
+
+int32_t lueing::RiskEngine::Position(InstrumentHandle handle, char direction) const
+{
+    int side = THOST_FTDC_D_Buy == direction ? 0 : (THOST_FTDC_D_Sell == direction ? 1 : -1);
+    if (handle >= max_instruments_ || side < 0)
+    {
+        return 0;
+    }
+    return slots_[handle].position[side].load(std::memory_order_relaxed);
+}
+
+const char *lueing::RiskEngine::Describe(int result)
+{
+    switch (result)
+    {
+        case RISK_PASSED:
+            return "passed";
+        case RISK_ORDER_VOLUME:
+            return "order volume exceeds limit";
+        case RISK_ORDER_COUNT:
+            return "daily order count exceeds limit";
+        case RISK_POSITION:
+            return "position exceeds limit";
+        case RISK_PRICE_LIMIT:
+            return "price outside limit band";
+        case RISK_FAT_FINGER:
+            return "price deviates too far from last price";
+        case RISK_INSTRUMENT:
+            return "unknown instrument";
+        default:
+            return "unknown risk result";
+    }
+}
+
+int lueing::RiskEngine::Side(char direction, char offset, bool *open)
+{
+    int side = THOST_FTDC_D_Buy == direction ? 0 : (THOST_FTDC_D_Sell == direction ? 1 : -1);
+    if (side < 0)
+    {
+        return -1;
+    }
+    *open = THOST_FTDC_OF_Open == offset;
+    // 平仓减少相反方向的持仓: 卖平对应多头, 买平对应空头
+    return *open ? side : 1 - side;
+}
+
+void lueing::RiskEngine::Sub(std::atomic<int32_t> &value, int32_t amount)
+{
+    if (amount <= 0)
+    {
+        return;
+    }
+    // 不低于 0: 未预置的持仓被平掉时不会凭空放出额度
+    int32_t current = value.load(std::memory_order_relaxed);
+    while (!value.compare_exchange_weak(current, current > amount ? current - amount : 0,
+                                        std::memory_order_relaxed))
+    {
+    }
+}
@@ -0,0 +1,137 @@
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "risk.h"
+
+namespace {
+    void Feed(lueing::RiskEngine &risk, lueing::InstrumentHandle handle, double last, double upper, double lower)
+    {
+        CThostFtdcDepthMarketDataField field{};
+        field.UpperLimitPrice = upper;
+        field.LowerLimitPrice = lower;
+        lueing::Tick tick{};
+        tick.instrument = handle;
+        tick.last_price = last;
+        risk.OnMarketData(field, tick);
+    }
+
+    lueing::OrderReport Final(lueing::InstrumentHandle handle, char direction, char offset, lueing::OrderStatus status,
+                              int32_t volume, int32_t filled)
+    {
+        lueing::OrderReport report{};
+        report.instrument = handle;
+        report.direction = direction;
+        report.offset = offset;
+        report.status = status;
+        report.volume = volume;
+        report.filled = filled;
+        return report;
+    }
+}
+
+TEST(RiskTest, VolumeCountAndPrice)
+{
+    lueing::RiskEngine risk(4, lueing::RiskLimits{5, 3, 0, 2});
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 6), RISK_ORDER_VOLUME);
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 0), RISK_ORDER_VOLUME);
+    EXPECT_EQ(risk.Check(9, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 1), RISK_INSTRUMENT);
+
+    // 没有行情时不做价格检查
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 1000, 1), RISK_PASSED);
+    Feed(risk, 0, 100, 110, 90);
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 111, 1), RISK_PRICE_LIMIT);
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Sell, THOST_FTDC_OF_Open, 89, 1), RISK_PRICE_LIMIT);
+    // 偏离最新价超过 2%
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 102.5, 1), RISK_FAT_FINGER);
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 102, 1), RISK_PASSED);
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Sell, THOST_FTDC_OF_Open, 98, 1), RISK_PASSED);
+
+    // 被拒的报单不计入次数
+    EXPECT_EQ(risk.DailyOrders(), 3);
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 1), RISK_ORDER_COUNT);
+    // 平仓不计次数、不检查偏离, 次数用尽后仍可平仓; 涨跌停价格带照常检查
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Sell, THOST_FTDC_OF_Close, 95, 1), RISK_PASSED);
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_CloseToday, 105, 1), RISK_PASSED);
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Sell, THOST_FTDC_OF_Close, 89, 1), RISK_PRICE_LIMIT);
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Sell, THOST_FTDC_OF_Close, 95, 6), RISK_ORDER_VOLUME);
+    EXPECT_EQ(risk.DailyOrders(), 3);
+    risk.ResetDaily();
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 1), RISK_PASSED);
+}
+
+TEST(RiskTest, PositionLimit)
+{
+    lueing::RiskEngine risk(4, lueing::RiskLimits{0, 0, 5, 0});
+    risk.SetPosition(1, THOST_FTDC_D_Buy, 2);
+    EXPECT_EQ(risk.Check(1, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 4), RISK_POSITION);
+    EXPECT_EQ(risk.Check(1, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 3), RISK_PASSED);
+    EXPECT_EQ(risk.Position(1, THOST_FTDC_D_Buy), 5);
+    // 空头与多头分别计算
+    EXPECT_EQ(risk.Check(1, THOST_FTDC_D_Sell, THOST_FTDC_OF_Open, 100, 5), RISK_PASSED);
+
+    // 开仓撤单后释放未成交部分
+    risk.OnOrderReport(Final(1, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, lueing::OrderStatus::Cancelled, 3, 1));
+    EXPECT_EQ(risk.Position(1, THOST_FTDC_D_Buy), 3);
+    // 卖平成交扣减多头
+    risk.OnOrderReport(Final(1, THOST_FTDC_D_Sell, THOST_FTDC_OF_CloseToday, lueing::OrderStatus::Filled, 2, 2));
+    EXPECT_EQ(risk.Position(1, THOST_FTDC_D_Buy), 1);
+    EXPECT_EQ(risk.Position(1, THOST_FTDC_D_Sell), 5);
+    // 平掉未登记的持仓不会低于 0
+    risk.OnOrderReport(Final(1, THOST_FTDC_D_Sell, THOST_FTDC_OF_Close, lueing::OrderStatus::Filled, 3, 3));
+    EXPECT_EQ(risk.Position(1, THOST_FTDC_D_Buy), 0);
+    EXPECT_EQ(risk.Check(1, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 5), RISK_PASSED);
+}
+
+TEST(RiskTest, RefundUnsentOrder)
+{
+    lueing::RiskEngine risk(4, lueing::RiskLimits{0, 2, 5, 0});
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 5), RISK_PASSED);
+    // 报单未能发出: 退还次数, 拒单回报释放在途开仓
+    risk.Refund(THOST_FTDC_OF_Open);
+    risk.OnOrderReport(Final(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, lueing::OrderStatus::Rejected, 5, 0));
+    EXPECT_EQ(risk.DailyOrders(), 0);
+    EXPECT_EQ(risk.Position(0, THOST_FTDC_D_Buy), 0);
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 5), RISK_PASSED);
+    // 持仓超限的报单不占用次数
+    EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 1), RISK_POSITION);
+    EXPECT_EQ(risk.DailyOrders(), 1);
+}
+
+TEST(RiskTest, ConcurrentPositionLimit)
+{
+    const int orders = 20000;
+    lueing::RiskEngine risk(4, lueing::RiskLimits{0, 0, orders + 1, 0});
+    risk.SetPosition(0, THOST_FTDC_D_Buy, 1);
+    std::atomic_bool done{false};
+    // 超限的大单被拒时不能让并发的小单看到临时多占的额度
+    std::thread large([&risk, &done]() {
+        while (!done.load())
+        {
+            EXPECT_EQ(risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, orders + 1), RISK_POSITION);
+        }
+    });
+    std::vector<std::thread> small;
+    std::atomic<int> passed{0};
+    for (int i = 0; i < 4; i++)
+    {
+        small.emplace_back([&risk, &passed]() {
+            for (int j = 0; j < orders / 4; j++)
+            {
+                if (RISK_PASSED == risk.Check(0, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, 100, 1))
+                {
+                    passed++;
+                }
+            }
+        });
+    }
+    for (auto &thread : small)
+    {
+        thread.join();
+    }
+    done.store(true);
+    large.join();
+    EXPECT_EQ(passed.load(), orders);
+    EXPECT_EQ(risk.Position(0, THOST_FTDC_D_Buy), orders + 1);
+}
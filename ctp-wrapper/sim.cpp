@@ -0,0 +1,462 @@
+#include "sim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <spdlog/spdlog.h>
+
+namespace {
+    // 模拟柜台只有一个前置
+    constexpr int32_t kFrontId = 1;
+
+    // 本地日期 (YYYYMMDD) 与时间 (HH:MM:SS), 任一参数为空时不填
+    void Stamp(char *date, char *time)
+    {
+        std::time_t now = std::time(nullptr);
+        std::tm local{};
+#if defined(_MSC_VER)
+        localtime_s(&local, &now);
+#else
+        localtime_r(&now, &local);
+#endif
+        if (nullptr != date)
+        {
+            std::strftime(date, sizeof(TThostFtdcDateType), "%Y%m%d", &local);
+        }
+        if (nullptr != time)
+        {
+            std::strftime(time, sizeof(TThostFtdcTimeType), "%H:%M:%S", &local);
+        }
+    }
+
+    bool IsActive(const CThostFtdcOrderField &order)
+    {
+        return THOST_FTDC_OST_NoTradeQueueing == order.OrderStatus
+               || THOST_FTDC_OST_PartTradedQueueing == order.OrderStatus;
+    }
+}
+
+lueing::SimTraderApi::SimTraderApi(InstrumentRegistryPtr instruments, int64_t latency)
+    : instruments_(std::move(instruments)), latency_(latency)
+{
+    TThostFtdcDateType date{};
+    Stamp(date, nullptr);
+    trading_day_ = date;
+    resting_.resize(instruments_->Capacity());
+    books_.resize(instruments_->Capacity());
+    quotes_.resize(instruments_->Capacity());
+    dirty_.reserve(instruments_->Capacity());
+    spdlog::info("[模拟交易] 交易日: {}, 延迟: {} 纳秒", trading_day_, latency_);
+}
+
+lueing::SimTraderApi::~SimTraderApi()
+{
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        running_.store(false);
+    }
+    condition_.notify_all();
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+}
+
+void lueing::SimTraderApi::Release()
+{
+    delete this;
+}
+
+void lueing::SimTraderApi::Init()
+{
+    if (running_.exchange(true))
+    {
+        return;
+    }
+    worker_ = std::thread([this] { Run(); });
+    Post(0, [this]() { spi_->OnFrontConnected(); });
+}
+
+int lueing::SimTraderApi::Join()
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    condition_.wait(lock, [this] { return !running_.load(); });
+    return 0;
+}
+
+int lueing::SimTraderApi::ReqAuthenticate(CThostFtdcReqAuthenticateField *pReqAuthenticateField, int nRequestID)
+{
+    CThostFtdcRspAuthenticateField authenticate{};
+    if (nullptr != pReqAuthenticateField)
+    {
+        std::strcpy(authenticate.BrokerID, pReqAuthenticateField->BrokerID);
+        std::strcpy(authenticate.UserID, pReqAuthenticateField->UserID);
+        std::strcpy(authenticate.AppID, pReqAuthenticateField->AppID);
+    }
+    Post(latency_, [this, authenticate, nRequestID]() mutable {
+        CThostFtdcRspInfoField info{};
+        spi_->OnRspAuthenticate(&authenticate, &info, nRequestID, true);
+    });
+    return 0;
+}
+
+int lueing::SimTraderApi::ReqUserLogin(CThostFtdcReqUserLoginField *pReqUserLoginField, int nRequestID)
+{
+    CThostFtdcRspUserLoginField login{};
+    std::strncpy(login.TradingDay, trading_day_.c_str(), sizeof(login.TradingDay) - 1);
+    std::strcpy(login.SystemName, "SimTrader");
+    std::strcpy(login.MaxOrderRef, "0");
+    if (nullptr != pReqUserLoginField)
+    {
+        std::strcpy(login.BrokerID, pReqUserLoginField->BrokerID);
+        std::strcpy(login.UserID, pReqUserLoginField->UserID);
+    }
+    Post(latency_, [this, login, nRequestID]() mutable {
+        login.FrontID = kFrontId;
+        login.SessionID = ++session_id_;
+        Stamp(nullptr, login.LoginTime);
+        CThostFtdcRspInfoField info{};
+        spi_->OnRspUserLogin(&login, &info, nRequestID, true);
+    });
+    return 0;
+}
+
+int lueing::SimTraderApi::ReqUserLogout(CThostFtdcUserLogoutField *pUserLogout, int nRequestID)
+{
+    CThostFtdcUserLogoutField logout{};
+    if (nullptr != pUserLogout)
+    {
+        logout = *pUserLogout;
+    }
+    Post(latency_, [this, logout, nRequestID]() mutable {
+        CThostFtdcRspInfoField info{};
+        spi_->OnRspUserLogout(&logout, &info, nRequestID, true);
+    });
+    return 0;
+}
+
+int lueing::SimTraderApi::ReqSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm,
+                                                   int nRequestID)
+{
+    CThostFtdcSettlementInfoConfirmField confirm{};
+    if (nullptr != pSettlementInfoConfirm)
+    {
+        confirm = *pSettlementInfoConfirm;
+    }
+    Post(latency_, [this, confirm, nRequestID]() mutable {
+        Stamp(confirm.ConfirmDate, confirm.ConfirmTime);
+        CThostFtdcRspInfoField info{};
+        spi_->OnRspSettlementInfoConfirm(&confirm, &info, nRequestID, true);
+    });
+    return 0;
+}
+
+int lueing::SimTraderApi::ReqQryInvestorPosition(CThostFtdcQryInvestorPositionField *pQryInvestorPosition,
+                                                 int nRequestID)
+{
+    // 模拟账户每次启动都从空仓开始
+    Post(latency_, [this, nRequestID]() {
+        CThostFtdcRspInfoField info{};
+        spi_->OnRspQryInvestorPosition(nullptr, &info, nRequestID, true);
+    });
+    return 0;
+}
+
+int lueing::SimTraderApi::ReqOrderInsert(CThostFtdcInputOrderField *pInputOrder, int nRequestID)
+{
+    if (nullptr == pInputOrder)
+    {
+        return -1;
+    }
+    CThostFtdcInputOrderField input = *pInputOrder;
+    Post(latency_, [this, input, nRequestID]() { Insert(input, nRequestID); });
+    return 0;
+}
+
+int lueing::SimTraderApi::ReqOrderAction(CThostFtdcInputOrderActionField *pInputOrderAction, int nRequestID)
+{
+    if (nullptr == pInputOrderAction)
+    {
+        return -1;
+    }
+    CThostFtdcInputOrderActionField action = *pInputOrderAction;
+    Post(latency_, [this, action, nRequestID]() { Action(action, nRequestID); });
+    return 0;
+}
+
+void lueing::SimTraderApi::OnMarketData(const CThostFtdcDepthMarketDataField &field, const Tick &tick)
+{
+    if (tick.instrument >= quotes_.size())
+    {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        Quote &quote = quotes_[tick.instrument];
+        quote.bid_price = tick.bid_price[0];
+        quote.ask_price = tick.ask_price[0];
+        quote.bid_volume = tick.bid_volume[0];
+        quote.ask_volume = tick.ask_volume[0];
+        if (quote.dirty)
+        {
+            return;
+        }
+        quote.dirty = true;
+        dirty_.push_back(tick.instrument);
+    }
+    condition_.notify_one();
+}
+
+void lueing::SimTraderApi::Post(int64_t delay, std::function<void()> task)
+{
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        tasks_.emplace(MonotonicNanos() + delay, std::move(task));
+    }
+    condition_.notify_one();
+}
+
+void lueing::SimTraderApi::Run()
+{
+    std::vector<std::function<void()>> tasks;
+    std::vector<InstrumentHandle> dirty;
+    dirty.reserve(quotes_.size());
+    while (running_.load(std::memory_order_acquire))
+    {
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            int64_t now = MonotonicNanos();
+            while (running_.load() && dirty_.empty() && (tasks_.empty() || tasks_.begin()->first > now))
+            {
+                if (tasks_.empty())
+                {
+                    condition_.wait(lock);
+                }
+                else
+                {
+                    condition_.wait_for(lock, std::chrono::nanoseconds(tasks_.begin()->first - now));
+                }
+                now = MonotonicNanos();
+            }
+            for (auto it = tasks_.begin(); it != tasks_.end() && it->first <= now; it = tasks_.erase(it))
+            {
+                tasks.push_back(std::move(it->second));
+            }
+            // 撮合用的一档行情只在撮合线程上读写, 此处取出最新值后即可释放锁
+            for (InstrumentHandle handle : dirty_)
+            {
+                books_[handle] = quotes_[handle];
+                quotes_[handle].dirty = false;
+            }
+            dirty.swap(dirty_);
+        }
+        for (auto &task : tasks)
+        {
+            task();
+        }
+        tasks.clear();
+        for (InstrumentHandle handle : dirty)
+        {
+            MatchResting(handle);
+        }
+        dirty.clear();
+    }
+}
+
+void lueing::SimTraderApi::Insert(const CThostFtdcInputOrderField &input, int request_id)
+{
+    InstrumentHandle handle = instruments_->Find(input.InstrumentID);
+    if (INVALID_INSTRUMENT == handle || handle >= resting_.size())
+    {
+        RejectInsert(input, request_id, SIM_ERROR_INSTRUMENT_NOT_FOUND, "CTP:instrument not found");
+        return;
+    }
+    bool any_price = THOST_FTDC_OPT_AnyPrice == input.OrderPriceType;
+    if (input.VolumeTotalOriginal <= 0 || (!any_price && THOST_FTDC_OPT_LimitPrice != input.OrderPriceType)
+        || (!any_price && input.LimitPrice <= 0))
+    {
+        RejectInsert(input, request_id, SIM_ERROR_INVALID_FIELD, "CTP:invalid order field");
+        return;
+    }
+
+    CThostFtdcOrderField order{};
+    std::strcpy(order.BrokerID, input.BrokerID);
+    std::strcpy(order.InvestorID, input.InvestorID);
+    std::strcpy(order.InstrumentID, input.InstrumentID);
+    std::strcpy(order.ExchangeID, 0 != input.ExchangeID[0] ? input.ExchangeID : instruments_->Exchange(handle));
+    std::strcpy(order.OrderRef, input.OrderRef);
+    std::strcpy(order.UserID, input.UserID);
+    order.OrderPriceType = input.OrderPriceType;
+    order.Direction = input.Direction;
+    std::strcpy(order.CombOffsetFlag, input.CombOffsetFlag);
+    std::strcpy(order.CombHedgeFlag, input.CombHedgeFlag);
+    order.LimitPrice = input.LimitPrice;
+    order.VolumeTotalOriginal = input.VolumeTotalOriginal;
+    order.TimeCondition = input.TimeCondition;
+    order.VolumeCondition = input.VolumeCondition;
+    order.MinVolume = input.MinVolume;
+    order.ContingentCondition = input.ContingentCondition;
+    order.ForceCloseReason = input.ForceCloseReason;
+    order.RequestID = input.RequestID;
+    order.FrontID = kFrontId;
+    order.SessionID = session_id_;
+    order.OrderSubmitStatus = THOST_FTDC_OSS_Accepted;
+    order.OrderStatus = THOST_FTDC_OST_NoTradeQueueing;
+    order.VolumeTotal = input.VolumeTotalOriginal;
+    order.SequenceNo = static_cast<int>(orders_.size() + 1);
+    std::snprintf(order.OrderSysID, sizeof(order.OrderSysID), "%12zu", orders_.size() + 1);
+    std::strncpy(order.TradingDay, trading_day_.c_str(), sizeof(order.TradingDay) - 1);
+    Stamp(order.InsertDate, order.InsertTime);
+
+    size_t index = orders_.size();
+    orders_.push_back(order);
+    by_key_[OrderKey{kFrontId, session_id_, OrderTracker::ParseOrderRef(input.OrderRef)}] = index;
+    spi_->OnRtnOrder(&order);
+
+    if (Match(index, books_[handle], false))
+    {
+        return;
+    }
+    // 市价单与 FAK/FOK 不挂单, 剩余部分立即撤销
+    if (any_price || THOST_FTDC_TC_IOC == input.TimeCondition)
+    {
+        Cancel(orders_[index]);
+        return;
+    }
+    resting_[handle].push_back(index);
+}
+
+void lueing::SimTraderApi::Action(const CThostFtdcInputOrderActionField &action, int request_id)
+{
+    size_t index = orders_.size();
+    // 与柜台一致, 有 OrderSysID 时按 OrderSysID 查找, 否则按 (FrontID, SessionID, OrderRef)
+    if (0 != action.OrderSysID[0])
+    {
+        size_t sys_id = std::strtoull(action.OrderSysID, nullptr, 10);
+        index = sys_id > 0 ? sys_id - 1 : orders_.size();
+    }
+    else
+    {
+        auto it = by_key_.find(OrderKey{action.FrontID, action.SessionID, OrderTracker::ParseOrderRef(action.OrderRef)});
+        if (by_key_.end() != it)
+        {
+            index = it->second;
+        }
+    }
+    if (index >= orders_.size())
+    {
+        RejectAction(action, request_id, SIM_ERROR_ORDER_NOT_FOUND, "CTP:order not found");
+        return;
+    }
+    if (THOST_FTDC_AF_Delete != action.ActionFlag)
+    {
+        RejectAction(action, request_id, SIM_ERROR_INVALID_FIELD, "CTP:only delete is supported");
+        return;
+    }
+    if (!IsActive(orders_[index]))
+    {
+        RejectAction(action, request_id, SIM_ERROR_ORDER_FINISHED, "CTP:order already finished");
+        return;
+    }
+    // 挂单列表在下一笔行情撮合时跳过并移除已撤销的报单
+    Cancel(orders_[index]);
+}
+
+bool lueing::SimTraderApi::Match(size_t index, Quote &quote, bool resting)
+{
+    CThostFtdcOrderField &order = orders_[index];
+    bool buy = THOST_FTDC_D_Buy == order.Direction;
+    double price = buy ? quote.ask_price : quote.bid_price;
+    int32_t &available = buy ? quote.ask_volume : quote.bid_volume;
+    if (available <= 0 || price <= 0)
+    {
+        return false;
+    }
+    if (THOST_FTDC_OPT_AnyPrice != order.OrderPriceType && (buy ? order.LimitPrice < price : order.LimitPrice > price))
+    {
+        return false;
+    }
+    int32_t volume = std::min(order.VolumeTotal, available);
+    if (THOST_FTDC_VC_CV == order.VolumeCondition && volume < order.VolumeTotal)
+    {
+        return false;
+    }
+    available -= volume;
+    order.VolumeTraded += volume;
+    order.VolumeTotal -= volume;
+    order.OrderStatus = 0 == order.VolumeTotal ? THOST_FTDC_OST_AllTraded : THOST_FTDC_OST_PartTradedQueueing;
+    Stamp(nullptr, order.UpdateTime);
+
+    CThostFtdcTradeField trade{};
+    std::strcpy(trade.BrokerID, order.BrokerID);
+    std::strcpy(trade.InvestorID, order.InvestorID);
+    std::strcpy(trade.InstrumentID, order.InstrumentID);
+    std::strcpy(trade.ExchangeID, order.ExchangeID);
+    std::strcpy(trade.OrderRef, order.OrderRef);
+    std::strcpy(trade.UserID, order.UserID);
+    std::strcpy(trade.OrderSysID, order.OrderSysID);
+    std::strcpy(trade.TradingDay, order.TradingDay);
+    trade.Direction = order.Direction;
+    trade.OffsetFlag = order.CombOffsetFlag[0];
+    trade.HedgeFlag = order.CombHedgeFlag[0];
+    trade.TradeType = THOST_FTDC_TRDT_Common;
+    // 挂单按自身价格成交, 新报单按对手价成交
+    trade.Price = resting ? order.LimitPrice : price;
+    trade.Volume = volume;
+    uint64_t trade_id = trades_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    std::snprintf(trade.TradeID, sizeof(trade.TradeID), "%12llu", static_cast<unsigned long long>(trade_id));
+    trade.SequenceNo = static_cast<int>(trade_id);
+    Stamp(trade.TradeDate, trade.TradeTime);
+
+    // 与柜台一致, 先推送报单回报再推送成交回报
+    CThostFtdcOrderField update = order;
+    spi_->OnRtnOrder(&update);
+    spi_->OnRtnTrade(&trade);
+    return 0 == order.VolumeTotal;
+}
+
+void lueing::SimTraderApi::MatchResting(InstrumentHandle handle)
+{
+    std::vector<size_t> &resting = resting_[handle];
+    size_t kept = 0;
+    for (size_t index : resting)
+    {
+        if (IsActive(orders_[index]) && !Match(index, books_[handle], true))
+        {
+            resting[kept++] = index;
+        }
+    }
+    resting.resize(kept);
+}
+
+void lueing::SimTraderApi::Cancel(CThostFtdcOrderField &order)
+{
+    order.OrderStatus = THOST_FTDC_OST_Canceled;
+    Stamp(nullptr, order.CancelTime);
+    std::strcpy(order.UpdateTime, order.CancelTime);
+    CThostFtdcOrderField update = order;
+    spi_->OnRtnOrder(&update);
+}
+
+void lueing::SimTraderApi::RejectInsert(const CThostFtdcInputOrderField &input, int request_id, int error_id,
+                                        const char *error)
+{
+    CThostFtdcInputOrderField rejected = input;
+    CThostFtdcRspInfoField info{};
+    info.ErrorID = error_id;
+    std::strncpy(info.ErrorMsg, error, sizeof(info.ErrorMsg) - 1);
+    spi_->OnRspOrderInsert(&rejected, &info, request_id, true);
+}
+
+void lueing::SimTraderApi::RejectAction(const CThostFtdcInputOrderActionField &action, int request_id, int error_id,
+                                        const char *error)
+{
+    CThostFtdcInputOrderActionField rejected = action;
+    CThostFtdcRspInfoField info{};
+    info.ErrorID = error_id;
+    std::strncpy(info.ErrorMsg, error, sizeof(info.ErrorMsg) - 1);
+    spi_->OnRspOrderAction(&rejected, &info, request_id, true);
+}
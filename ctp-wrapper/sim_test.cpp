@@ -0,0 +1,224 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "sim.h"
+
+namespace {
+    class RecordingSpi : public CThostFtdcTraderSpi {
+    public:
+        explicit RecordingSpi(CThostFtdcTraderApi *api) : api_(api) {}
+
+        void OnFrontConnected() override
+        {
+            CThostFtdcReqUserLoginField login{};
+            strcpy(login.BrokerID, "9999");
+            strcpy(login.UserID, "000001");
+            api_->ReqUserLogin(&login, 1);
+        }
+
+        void OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserLogin, CThostFtdcRspInfoField *pRspInfo,
+                            int nRequestID, bool bIsLast) override
+        {
+            front_id = pRspUserLogin->FrontID;
+            session_id = pRspUserLogin->SessionID;
+            logged_in.store(true);
+        }
+
+        void OnRtnOrder(CThostFtdcOrderField *pOrder) override
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            orders.push_back(*pOrder);
+        }
+
+        void OnRtnTrade(CThostFtdcTradeField *pTrade) override
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            trades.push_back(*pTrade);
+        }
+
+        void OnRspOrderInsert(CThostFtdcInputOrderField *pInputOrder, CThostFtdcRspInfoField *pRspInfo,
+                              int nRequestID, bool bIsLast) override
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            errors.push_back(pRspInfo->ErrorID);
+        }
+
+        void OnRspOrderAction(CThostFtdcInputOrderActionField *pInputOrderAction, CThostFtdcRspInfoField *pRspInfo,
+                              int nRequestID, bool bIsLast) override
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            errors.push_back(pRspInfo->ErrorID);
+        }
+
+        // 等待条件成立, 超时返回 false
+        bool WaitFor(const std::function<bool()> &condition)
+        {
+            for (int i = 0; i < 2000; i++)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(lock_);
+                    if (condition())
+                    {
+                        return true;
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return false;
+        }
+
+        int32_t front_id = 0;
+        int32_t session_id = 0;
+        std::atomic_bool logged_in{false};
+        std::vector<CThostFtdcOrderField> orders;
+        std::vector<CThostFtdcTradeField> trades;
+        std::vector<int> errors;
+
+    private:
+        CThostFtdcTraderApi *api_;
+        std::mutex lock_;
+    };
+
+    class SimTraderApiTest : public ::testing::Test {
+    protected:
+        void SetUp() override
+        {
+            instruments_ = std::make_shared<lueing::InstrumentRegistry>(16);
+            handle_ = instruments_->Intern("rb2505", "SHFE");
+            api_ = new lueing::SimTraderApi(instruments_, 0);
+            spi_ = std::make_unique<RecordingSpi>(api_);
+            api_->RegisterSpi(spi_.get());
+            api_->Init();
+            ASSERT_TRUE(spi_->WaitFor([this] { return spi_->logged_in.load(); }));
+        }
+
+        void TearDown() override
+        {
+            api_->Release();
+        }
+
+        void Quote(double bid, int32_t bid_volume, double ask, int32_t ask_volume)
+        {
+            CThostFtdcDepthMarketDataField field{};
+            lueing::Tick tick{};
+            tick.instrument = handle_;
+            tick.bid_price[0] = bid;
+            tick.bid_volume[0] = bid_volume;
+            tick.ask_price[0] = ask;
+            tick.ask_volume[0] = ask_volume;
+            api_->OnMarketData(field, tick);
+        }
+
+        void Order(int order_ref, char direction, double price, int32_t volume,
+                   char time_condition = THOST_FTDC_TC_GFD)
+        {
+            CThostFtdcInputOrderField input{};
+            strcpy(input.InstrumentID, "rb2505");
+            snprintf(input.OrderRef, sizeof(input.OrderRef), "%12d", order_ref);
+            input.OrderPriceType = THOST_FTDC_OPT_LimitPrice;
+            input.Direction = direction;
+            input.CombOffsetFlag[0] = THOST_FTDC_OF_Open;
+            input.CombHedgeFlag[0] = THOST_FTDC_HF_Speculation;
+            input.LimitPrice = price;
+            input.VolumeTotalOriginal = volume;
+            input.TimeCondition = time_condition;
+            input.VolumeCondition = THOST_FTDC_VC_AV;
+            ASSERT_EQ(0, api_->ReqOrderInsert(&input, order_ref));
+        }
+
+        void Cancel(int order_ref)
+        {
+            CThostFtdcInputOrderActionField action{};
+            action.FrontID = spi_->front_id;
+            action.SessionID = spi_->session_id;
+            snprintf(action.OrderRef, sizeof(action.OrderRef), "%12d", order_ref);
+            action.ActionFlag = THOST_FTDC_AF_Delete;
+            ASSERT_EQ(0, api_->ReqOrderAction(&action, order_ref));
+        }
+
+        lueing::InstrumentRegistryPtr instruments_;
+        lueing::InstrumentHandle handle_ = INVALID_INSTRUMENT;
+        lueing::SimTraderApi *api_ = nullptr;
+        std::unique_ptr<RecordingSpi> spi_;
+    };
+}
+
+TEST_F(SimTraderApiTest, marketable_order_fills_at_opposite_price)
+{
+    Quote(3500, 5, 3501, 3);
+    Order(1, THOST_FTDC_D_Buy, 3505, 2);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 1 == spi_->trades.size(); }));
+    EXPECT_EQ(3501, spi_->trades[0].Price);
+    EXPECT_EQ(2, spi_->trades[0].Volume);
+    EXPECT_EQ(THOST_FTDC_OF_Open, spi_->trades[0].OffsetFlag);
+    EXPECT_STREQ("SHFE", spi_->trades[0].ExchangeID);
+    // 先报入, 再全部成交, 成交回报的 OrderSysID 与报单回报一致
+    ASSERT_EQ(2u, spi_->orders.size());
+    EXPECT_EQ(THOST_FTDC_OST_NoTradeQueueing, spi_->orders[0].OrderStatus);
+    EXPECT_EQ(THOST_FTDC_OST_AllTraded, spi_->orders[1].OrderStatus);
+    EXPECT_STREQ(spi_->orders[1].OrderSysID, spi_->trades[0].OrderSysID);
+    EXPECT_EQ(spi_->session_id, spi_->orders[1].SessionID);
+
+    // 卖一剩余 1 手, 第二笔买单只成交 1 手, 其余挂单
+    Order(2, THOST_FTDC_D_Buy, 3505, 2);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 2 == spi_->trades.size(); }));
+    EXPECT_EQ(1, spi_->trades[1].Volume);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 4 == spi_->orders.size(); }));
+    EXPECT_EQ(THOST_FTDC_OST_PartTradedQueueing, spi_->orders[3].OrderStatus);
+    EXPECT_EQ(1, spi_->orders[3].VolumeTotal);
+}
+
+TEST_F(SimTraderApiTest, resting_order_fills_at_own_price_when_market_crosses)
+{
+    Quote(3499, 5, 3501, 5);
+    Order(1, THOST_FTDC_D_Sell, 3502, 3);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 1 == spi_->orders.size(); }));
+    EXPECT_EQ(0u, spi_->trades.size());
+
+    Quote(3502, 1, 3503, 5);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 1 == spi_->trades.size(); }));
+    EXPECT_EQ(3502, spi_->trades[0].Price);
+    EXPECT_EQ(1, spi_->trades[0].Volume);
+
+    Quote(3505, 10, 3506, 5);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 2 == spi_->trades.size(); }));
+    EXPECT_EQ(3502, spi_->trades[1].Price);
+    EXPECT_EQ(2, spi_->trades[1].Volume);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 3 == spi_->orders.size(); }));
+    EXPECT_EQ(THOST_FTDC_OST_AllTraded, spi_->orders[2].OrderStatus);
+    EXPECT_EQ(3, spi_->orders[2].VolumeTraded);
+}
+
+TEST_F(SimTraderApiTest, cancel_and_immediate_or_cancel)
+{
+    Quote(3500, 5, 3501, 1);
+    Order(1, THOST_FTDC_D_Buy, 3490, 1);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 1 == spi_->orders.size(); }));
+    Cancel(1);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 2 == spi_->orders.size(); }));
+    EXPECT_EQ(THOST_FTDC_OST_Canceled, spi_->orders[1].OrderStatus);
+
+    // 已撤销的报单不能再撤, 未知报单找不到
+    Cancel(1);
+    Cancel(9);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 2 == spi_->errors.size(); }));
+    EXPECT_EQ(SIM_ERROR_ORDER_FINISHED, spi_->errors[0]);
+    EXPECT_EQ(SIM_ERROR_ORDER_NOT_FOUND, spi_->errors[1]);
+
+    // FAK 成交 1 手, 剩余立即撤销
+    Order(2, THOST_FTDC_D_Buy, 3501, 3, THOST_FTDC_TC_IOC);
+    ASSERT_TRUE(spi_->WaitFor([this] { return 5 == spi_->orders.size(); }));
+    EXPECT_EQ(THOST_FTDC_OST_Canceled, spi_->orders[4].OrderStatus);
+    EXPECT_EQ(1, spi_->orders[4].VolumeTraded);
+    EXPECT_EQ(1u, api_->Trades());
+
+    // 撤销的报单不再参与撮合
+    Quote(3480, 5, 3485, 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(1u, api_->Trades());
+}
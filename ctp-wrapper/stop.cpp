@@ -0,0 +1,229 @@
+#include "stop.h"
+
+#include <spdlog/spdlog.h>
+#include <cmath>
+
+namespace {
+    int SideOf(char direction)
+    {
+        return THOST_FTDC_D_Buy == direction ? 0 : (THOST_FTDC_D_Sell == direction ? 1 : -1);
+    }
+}
+
+lueing::StopEngine::StopEngine(size_t max_instruments, double stop_loss, double stop_profit, int32_t max_order_volume)
+        : max_instruments_(max_instruments), stop_loss_(std::fabs(stop_loss)), stop_profit_(std::fabs(stop_profit)),
+          max_order_volume_(max_order_volume), slots_(new Slot[max_instruments])
+{
+}
+
+lueing::StopEngine::~StopEngine()
+= default;
+
+void lueing::StopEngine::SetWatcher(StopWatcher watcher)
+{
+    watcher_ = std::move(watcher);
+    if (!watcher_)
+    {
+        return;
+    }
+    for (InstrumentHandle handle = 0; handle < max_instruments_; handle++)
+    {
+        const Slot &slot = slots_[handle];
+        if (slot.sides[0].volume.load(std::memory_order_acquire) > 0
+            || slot.sides[1].volume.load(std::memory_order_acquire) > 0)
+        {
+            watcher_(handle);
+        }
+    }
+}
+
+void lueing::StopEngine::OnOrderReport(const OrderReport &report)
+{
+    int direction = SideOf(report.direction);
+    if (report.instrument >= max_instruments_ || direction < 0)
+    {
+        return;
+    }
+    bool open = THOST_FTDC_OF_Open == report.offset;
+    int32_t delta;
+    double price = 0;
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        Fill &fill = fills_[report.order_ref];
+        delta = report.filled - fill.filled;
+        if (delta > 0)
+        {
+            double turnover = report.average_price * report.filled;
+            price = (turnover - fill.turnover) / delta;
+            fill.filled = report.filled;
+            fill.turnover = turnover;
+        }
+        if (IsFinal(report.status))
+        {
+            fills_.erase(report.order_ref);
+        }
+    }
+
+    // 开仓增加报单方向的持仓, 平仓减少相反方向的持仓
+    Side &side = slots_[report.instrument].sides[open ? direction : 1 - direction];
+    if (open && delta > 0)
+    {
+        Rearm(side);
+        int32_t volume = side.volume.load(std::memory_order_relaxed);
+        double entry = side.entry_price.load(std::memory_order_relaxed);
+        // 先写均价再写数量, 行情线程看到新数量时均价已更新
+        side.entry_price.store((entry * volume + price * delta) / (volume + delta), std::memory_order_relaxed);
+        side.volume.store(volume + delta, std::memory_order_release);
+        if (0 == volume && watcher_)
+        {
+            watcher_(report.instrument);
+        }
+    }
+    else if (!open && delta > 0)
+    {
+        int32_t volume = side.volume.load(std::memory_order_relaxed);
+        side.volume.store(volume > delta ? volume - delta : 0, std::memory_order_release);
+    }
+}
+
+void lueing::StopEngine::OnMarketData(const CThostFtdcDepthMarketDataField &field, const Tick &tick)
+{
+    if (tick.instrument >= max_instruments_ || tick.last_price <= 0)
+    {
+        return;
+    }
+    Check(tick.instrument, 0, tick);
+    Check(tick.instrument, 1, tick);
+}
+
+void lueing::StopEngine::Check(InstrumentHandle handle, int side, const Tick &tick)
+{
+    Side &position = slots_[handle].sides[side];
+    int32_t volume = position.volume.load(std::memory_order_acquire);
+    if (volume <= 0 || position.firing.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    if (position.failures.load(std::memory_order_relaxed) >= STOP_MAX_FAILURES
+        || tick.local_time < position.retry_after.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    double entry = position.entry_price.load(std::memory_order_relaxed);
+    if (entry <= 0)
+    {
+        return;
+    }
+    // 多头按最新价上涨为盈利, 空头相反
+    double percent = (tick.last_price - entry) * 100 / entry;
+    if (1 == side)
+    {
+        percent = -percent;
+    }
+    bool stop = stop_loss_ > 0 && percent <= -stop_loss_;
+    bool profit = stop_profit_ > 0 && percent >= stop_profit_;
+    if (!(stop || profit) || !sender_ || position.firing.exchange(true, std::memory_order_acq_rel))
+    {
+        return;
+    }
+    // 以对手价平仓: 多头卖在买一价, 空头买在卖一价, 没有盘口时用最新价
+    char direction = 0 == side ? THOST_FTDC_D_Sell : THOST_FTDC_D_Buy;
+    double price = 0 == side ? tick.bid_price[0] : tick.ask_price[0];
+    if (price <= 0)
+    {
+        price = tick.last_price;
+    }
+    if (max_order_volume_ > 0 && volume > max_order_volume_)
+    {
+        volume = max_order_volume_;
+    }
+    triggered_.fetch_add(1, std::memory_order_relaxed);
+    sender_(handle, direction, price, volume, [this, handle, side](const OrderReport &report) {
+        OnCloseReport(handle, side, report);
+    });
+}
+
+void lueing::StopEngine::OnCloseReport(InstrumentHandle handle, int side, const OrderReport &report)
+{
+    if (!IsFinal(report.status))
+    {
+        return;
+    }
+    Side &position = slots_[handle].sides[side];
+    // 平仓单终止, 仍有持仓时重新检查; 没有成交的拒单 (如风控拒单、交易所拒绝平今) 计为一次失败
+    if (report.filled > 0)
+    {
+        Rearm(position);
+    }
+    else if (OrderStatus::Rejected == report.status)
+    {
+        Fail(position, MonotonicNanos());
+        if (STOP_MAX_FAILURES == position.failures.load(std::memory_order_relaxed))
+        {
+            spdlog::error("[止损止盈] 合约句柄: {}, 方向: {}, 平仓单连续 {} 次失败, 停用止损止盈直到持仓重新建立, "
+                          "最后一次错误: {} {}", handle, 0 == side ? "多头" : "空头", STOP_MAX_FAILURES,
+                          report.error_id, report.error);
+        }
+    }
+    position.firing.store(false, std::memory_order_release);
+}
+
+void lueing::StopEngine::Fail(Side &side, int64_t now)
+{
+    int32_t failures = side.failures.fetch_add(1, std::memory_order_relaxed) + 1;
+    int shift = failures < STOP_MAX_FAILURES ? failures - 1 : STOP_MAX_FAILURES - 1;
+    side.retry_after.store(now + (STOP_RETRY_NANOS << shift), std::memory_order_relaxed);
+}
+
+void lueing::StopEngine::Rearm(Side &side)
+{
+    side.retry_after.store(0, std::memory_order_relaxed);
+    side.failures.store(0, std::memory_order_relaxed);
+}
+
+void lueing::StopEngine::SetPosition(InstrumentHandle handle, char direction, int32_t volume, double entry_price)
+{
+    int side = SideOf(direction);
+    if (handle >= max_instruments_ || side < 0)
+    {
+        return;
+    }
+    Side &position = slots_[handle].sides[side];
+    Rearm(position);
+    position.entry_price.store(entry_price, std::memory_order_relaxed);
+    position.volume.store(volume, std::memory_order_release);
+    if (volume > 0 && watcher_)
+    {
+        watcher_(handle);
+    }
+}
+
+int32_t lueing::StopEngine::Position(InstrumentHandle handle, char direction) const
+{
+    int side = SideOf(direction);
+    if (handle >= max_instruments_ || side < 0)
+    {
+        return 0;
+    }
+    return slots_[handle].sides[side].volume.load(std::memory_order_acquire);
+}
+
+double lueing::StopEngine::EntryPrice(InstrumentHandle handle, char direction) const
+{
+    int side = SideOf(direction);
+    if (handle >= max_instruments_ || side < 0)
+    {
+        return 0;
+    }
+    return slots_[handle].sides[side].entry_price.load(std::memory_order_relaxed);
+}
+
+bool lueing::StopEngine::Disarmed(InstrumentHandle handle, char direction) const
+{
+    int side = SideOf(direction);
+    if (handle >= max_instruments_ || side < 0)
+    {
+        return false;
+    }
+    return slots_[handle].sides[side].failures.load(std::memory_order_relaxed) >= STOP_MAX_FAILURES;
+}
@@ -0,0 +1,205 @@
+#include <vector>
+#include <utility>
+#include "gtest/gtest.h"
+#include "stop.h"
+
+namespace {
+    struct Close {
+        lueing::InstrumentHandle handle;
+        char direction;
+        double price;
+        int32_t volume;
+        lueing::OrderCallback done;
+    };
+
+    lueing::OrderReport Report(int32_t order_ref, char direction, char offset, lueing::OrderStatus status,
+                               int32_t volume, int32_t filled, double average_price)
+    {
+        lueing::OrderReport report{};
+        report.order_ref = order_ref;
+        report.instrument = 1;
+        report.direction = direction;
+        report.offset = offset;
+        report.status = status;
+        report.volume = volume;
+        report.filled = filled;
+        report.average_price = average_price;
+        return report;
+    }
+
+    void Feed(lueing::StopEngine &stops, double last, double bid, double ask, int64_t local_time = 0)
+    {
+        CThostFtdcDepthMarketDataField field{};
+        lueing::Tick tick{};
+        tick.instrument = 1;
+        tick.local_time = local_time;
+        tick.last_price = last;
+        tick.bid_price[0] = bid;
+        tick.ask_price[0] = ask;
+        stops.OnMarketData(field, tick);
+    }
+
+    // 报单跟踪先通知观察者, 再调用该笔报单的回调
+    void Finish(lueing::StopEngine &stops, const Close &close, const lueing::OrderReport &report)
+    {
+        stops.OnOrderReport(report);
+        close.done(report);
+    }
+}
+
+TEST(StopTest, StopLossOnLong)
+{
+    lueing::StopEngine stops(4, -2, 5);
+    std::vector<Close> closes;
+    std::vector<lueing::InstrumentHandle> watched;
+    stops.SetSender([&closes](lueing::InstrumentHandle handle, char direction, double price, int32_t volume,
+                              lueing::OrderCallback done) {
+        closes.push_back(Close{handle, direction, price, volume, std::move(done)});
+    });
+    stops.SetWatcher([&watched](lueing::InstrumentHandle handle) { watched.push_back(handle); });
+
+    // 分两笔成交开多 2 手, 均价 100
+    stops.OnOrderReport(Report(1, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, lueing::OrderStatus::PartiallyFilled, 2, 1,
+                               99));
+    stops.OnOrderReport(Report(1, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, lueing::OrderStatus::Filled, 2, 2, 100));
+    EXPECT_EQ(stops.Position(1, THOST_FTDC_D_Buy), 2);
+    EXPECT_DOUBLE_EQ(stops.EntryPrice(1, THOST_FTDC_D_Buy), 100);
+    EXPECT_EQ(watched, std::vector<lueing::InstrumentHandle>({1}));
+
+    Feed(stops, 98.5, 98.4, 98.6);
+    EXPECT_TRUE(closes.empty());
+    // 亏损 2%, 以买一价卖出平仓
+    Feed(stops, 98, 97.9, 98.1);
+    ASSERT_EQ(closes.size(), 1u);
+    EXPECT_EQ(closes[0].direction, THOST_FTDC_D_Sell);
+    EXPECT_DOUBLE_EQ(closes[0].price, 97.9);
+    EXPECT_EQ(closes[0].volume, 2);
+    // 平仓单在途时不重复触发
+    Feed(stops, 97, 96.9, 97.1);
+    EXPECT_EQ(closes.size(), 1u);
+
+    // 手动平仓终止不影响在途的平仓单
+    stops.OnOrderReport(Report(3, THOST_FTDC_D_Sell, THOST_FTDC_OF_Close, lueing::OrderStatus::Rejected, 1, 0, 0));
+    Feed(stops, 97, 96.9, 97.1);
+    EXPECT_EQ(closes.size(), 1u);
+    EXPECT_FALSE(stops.Disarmed(1, THOST_FTDC_D_Buy));
+
+    // 平仓只成交 1 手后撤单, 剩余持仓重新受保护
+    Finish(stops, closes[0], Report(2, THOST_FTDC_D_Sell, THOST_FTDC_OF_CloseToday, lueing::OrderStatus::Cancelled, 2,
+                                    1, 97.9));
+    EXPECT_EQ(stops.Position(1, THOST_FTDC_D_Buy), 1);
+    Feed(stops, 97, 96.9, 97.1);
+    ASSERT_EQ(closes.size(), 2u);
+    EXPECT_EQ(closes[1].volume, 1);
+    EXPECT_EQ(stops.Triggered(), 2u);
+}
+
+TEST(StopTest, TakeProfitOnShortAndRetry)
+{
+    lueing::StopEngine stops(4, 3, 5);
+    std::vector<Close> closes;
+    bool accept = false;
+    stops.SetSender([&](lueing::InstrumentHandle handle, char direction, double price, int32_t volume,
+                        lueing::OrderCallback done) {
+        closes.push_back(Close{handle, direction, price, volume, done});
+        if (!accept)
+        {
+            // 未能发出, 在返回前以拒单回报调用
+            lueing::OrderReport rejected{};
+            rejected.status = lueing::OrderStatus::Rejected;
+            done(rejected);
+        }
+    });
+    stops.SetPosition(1, THOST_FTDC_D_Sell, 3, 200);
+
+    Feed(stops, 195, 194.9, 195.1);
+    EXPECT_TRUE(closes.empty());
+    // 空头盈利 5%, 以卖一价买入平仓; 未能发出时退避后重试
+    Feed(stops, 190, 189.9, 190.1);
+    ASSERT_EQ(closes.size(), 1u);
+    EXPECT_EQ(closes[0].direction, THOST_FTDC_D_Buy);
+    EXPECT_DOUBLE_EQ(closes[0].price, 190.1);
+    accept = true;
+    int64_t now = lueing::MonotonicNanos();
+    Feed(stops, 189, 0, 0, now);
+    EXPECT_EQ(closes.size(), 1u);
+    Feed(stops, 189, 0, 0, now + STOP_RETRY_NANOS);
+    ASSERT_EQ(closes.size(), 2u);
+    EXPECT_DOUBLE_EQ(closes[1].price, 189);
+    EXPECT_EQ(closes[1].volume, 3);
+    // 多头没有持仓, 不受影响
+    EXPECT_EQ(stops.Position(1, THOST_FTDC_D_Buy), 0);
+}
+
+TEST(StopTest, CloseInChunks)
+{
+    lueing::StopEngine stops(4, 2, 0, 3);
+    std::vector<Close> closes;
+    stops.SetSender([&closes](lueing::InstrumentHandle handle, char direction, double price, int32_t volume,
+                              lueing::OrderCallback done) {
+        closes.push_back(Close{handle, direction, price, volume, std::move(done)});
+    });
+    stops.SetPosition(1, THOST_FTDC_D_Buy, 7, 100);
+
+    // 每笔平仓单不超过单笔最大手数, 上一笔终止后继续平仓
+    Feed(stops, 97, 96.9, 97.1);
+    ASSERT_EQ(closes.size(), 1u);
+    EXPECT_EQ(closes[0].volume, 3);
+    Finish(stops, closes[0], Report(2, THOST_FTDC_D_Sell, THOST_FTDC_OF_Close, lueing::OrderStatus::Filled, 3, 3,
+                                    96.9));
+    Feed(stops, 97, 96.9, 97.1);
+    ASSERT_EQ(closes.size(), 2u);
+    EXPECT_EQ(closes[1].volume, 3);
+    Finish(stops, closes[1], Report(3, THOST_FTDC_D_Sell, THOST_FTDC_OF_Close, lueing::OrderStatus::Filled, 3, 3,
+                                    96.9));
+    Feed(stops, 97, 96.9, 97.1);
+    ASSERT_EQ(closes.size(), 3u);
+    EXPECT_EQ(closes[2].volume, 1);
+}
+
+TEST(StopTest, DisarmAfterRepeatedRejects)
+{
+    lueing::StopEngine stops(4, 2, 0);
+    std::vector<Close> closes;
+    stops.SetSender([&closes](lueing::InstrumentHandle handle, char direction, double price, int32_t volume,
+                              lueing::OrderCallback done) {
+        closes.push_back(Close{handle, direction, price, volume, std::move(done)});
+    });
+    stops.SetPosition(1, THOST_FTDC_D_Buy, 2, 100);
+
+    // 交易所拒单 (如对昨仓平今) 后按加倍的间隔重试, 不在每笔行情上重复报单
+    int64_t now = 0;
+    for (int i = 0; i < STOP_MAX_FAILURES; i++)
+    {
+        Feed(stops, 97, 96.9, 97.1, now);
+        ASSERT_EQ(closes.size(), static_cast<size_t>(i + 1));
+        Finish(stops, closes[i], Report(10 + i, THOST_FTDC_D_Sell, THOST_FTDC_OF_CloseToday,
+                                        lueing::OrderStatus::Rejected, 2, 0, 0));
+        now = lueing::MonotonicNanos();
+        Feed(stops, 97, 96.9, 97.1, now);
+        EXPECT_EQ(closes.size(), static_cast<size_t>(i + 1));
+        now += STOP_RETRY_NANOS << i;
+    }
+    EXPECT_TRUE(stops.Disarmed(1, THOST_FTDC_D_Buy));
+    Feed(stops, 97, 96.9, 97.1, now);
+    EXPECT_EQ(closes.size(), static_cast<size_t>(STOP_MAX_FAILURES));
+
+    // 重新开仓后恢复
+    stops.OnOrderReport(Report(20, THOST_FTDC_D_Buy, THOST_FTDC_OF_Open, lueing::OrderStatus::Filled, 1, 1, 100));
+    EXPECT_FALSE(stops.Disarmed(1, THOST_FTDC_D_Buy));
+    Feed(stops, 97, 96.9, 97.1, now);
+    EXPECT_EQ(closes.size(), static_cast<size_t>(STOP_MAX_FAILURES + 1));
+}
+
+TEST(StopTest, WatcherSeesSeededPositions)
+{
+    lueing::StopEngine stops(4, 2, 0);
+    // 登录后查询到的持仓可能早于设置观察者
+    stops.SetPosition(2, THOST_FTDC_D_Sell, 1, 50);
+    stops.SetPosition(3, THOST_FTDC_D_Buy, 0, 0);
+    std::vector<lueing::InstrumentHandle> watched;
+    stops.SetWatcher([&watched](lueing::InstrumentHandle handle) { watched.push_back(handle); });
+    EXPECT_EQ(watched, std::vector<lueing::InstrumentHandle>({2}));
+    stops.SetPosition(1, THOST_FTDC_D_Buy, 2, 100);
+    EXPECT_EQ(watched, std::vector<lueing::InstrumentHandle>({2, 1}));
+}
@@ -0,0 +1,137 @@
+#include "tick.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+namespace {
+    constexpr int64_t kNanosPerSecond = 1000000000LL;
+    constexpr int64_t kSecondsPerDay = 86400;
+    // 北京时间 UTC+8
+    constexpr int64_t kExchangeUtcOffset = 8 * 3600;
+
+    int Digits(const char *text, int count)
+    {
+        int value = 0;
+        for (int i = 0; i < count; i++)
+        {
+            value = value * 10 + (text[i] - '0');
+        }
+        return value;
+    }
+
+    // 公历日期距 1970-01-01 的天数
+    int64_t DaysFromCivil(int64_t y, unsigned m, unsigned d)
+    {
+        y -= m <= 2;
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    int64_t DaysFromDate(const char *date)
+    {
+        return DaysFromCivil(Digits(date, 4), Digits(date + 4, 2), Digits(date + 6, 2));
+    }
+
+    double Price(double value)
+    {
+        // CTP 用 DBL_MAX 表示无效价格
+        return std::fabs(value) < 1e300 ? value : 0;
+    }
+}
+
+int64_t lueing::MonotonicNanos()
+{
+#if defined(__linux__)
+    // 不受 NTP 调频影响, 经 vDSO 读取, 无系统调用
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return static_cast<int64_t>(now.tv_sec) * kNanosPerSecond + now.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+int64_t lueing::WallClockNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t lueing::ExchangeNanos(const char *date, const char *time, int millisec)
+{
+    int64_t seconds = DaysFromDate(date) * kSecondsPerDay
+                      + Digits(time, 2) * 3600 + Digits(time + 3, 2) * 60 + Digits(time + 6, 2)
+                      - kExchangeUtcOffset;
+    return seconds * kNanosPerSecond + static_cast<int64_t>(millisec) * 1000000;
+}
+
+int64_t lueing::ExchangeNanos(const CThostFtdcDepthMarketDataField &field)
+{
+    if (0 == field.TradingDay[0] && 0 == field.ActionDay[0])
+    {
+        return 0;
+    }
+    const char *date = field.ActionDay[0] ? field.ActionDay : field.TradingDay;
+    int64_t nanos = ExchangeNanos(date, field.UpdateTime, field.UpdateMillisec);
+    if (field.ActionDay[0] && 0 != std::strcmp(field.ActionDay, field.TradingDay))
+    {
+        return nanos;
+    }
+
+    // 大商所、郑商所夜盘的 ActionDay 填的是交易日, 需要回推到自然日
+    // 夜盘 21:00 开始属于前一个工作日, 周一交易日的夜盘在上周五, 过零点后为周六
+    int hour = Digits(field.UpdateTime, 2);
+    int64_t weekday = (DaysFromDate(date) + 4) % 7;
+    int64_t days_back = 0;
+    if (hour >= 18)
+    {
+        days_back = 1 == weekday ? 3 : 1;
+    }
+    else if (hour < 6)
+    {
+        days_back = 1 == weekday ? 2 : 0;
+    }
+    return nanos - days_back * kSecondsPerDay * kNanosPerSecond;
+}
+
+void lueing::ToTick(const CThostFtdcDepthMarketDataField &field, uint32_t instrument, int64_t local_time, Tick &tick)
+{
+    tick.instrument = instrument;
+    tick.volume = field.Volume;
+    tick.exchange_time = ExchangeNanos(field);
+    tick.local_time = local_time;
+    tick.last_price = Price(field.LastPrice);
+    tick.open_price = Price(field.OpenPrice);
+    tick.high_price = Price(field.HighestPrice);
+    tick.low_price = Price(field.LowestPrice);
+    tick.turnover = Price(field.Turnover);
+    tick.open_interest = Price(field.OpenInterest);
+
+    tick.bid_price[0] = Price(field.BidPrice1);
+    tick.bid_price[1] = Price(field.BidPrice2);
+    tick.bid_price[2] = Price(field.BidPrice3);
+    tick.bid_price[3] = Price(field.BidPrice4);
+    tick.bid_price[4] = Price(field.BidPrice5);
+    tick.ask_price[0] = Price(field.AskPrice1);
+    tick.ask_price[1] = Price(field.AskPrice2);
+    tick.ask_price[2] = Price(field.AskPrice3);
+    tick.ask_price[3] = Price(field.AskPrice4);
+    tick.ask_price[4] = Price(field.AskPrice5);
+
+    tick.bid_volume[0] = field.BidVolume1;
+    tick.bid_volume[1] = field.BidVolume2;
+    tick.bid_volume[2] = field.BidVolume3;
+    tick.bid_volume[3] = field.BidVolume4;
+    tick.bid_volume[4] = field.BidVolume5;
+    tick.ask_volume[0] = field.AskVolume1;
+    tick.ask_volume[1] = field.AskVolume2;
+    tick.ask_volume[2] = field.AskVolume3;
+    tick.ask_volume[3] = field.AskVolume4;
+    tick.ask_volume[4] = field.AskVolume5;
+}
@@ -0,0 +1,109 @@
+#include "tick_history.h"
+
+#include <algorithm>
+
+lueing::TickBlockPool::TickBlockPool(size_t max_blocks) : max_blocks_(max_blocks), free_(max_blocks)
+{
+}
+
+lueing::TickBlockPool::~TickBlockPool()
+= default;
+
+void lueing::TickBlockPool::Grow(size_t total)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    size_t allocated = allocated_.load(std::memory_order_relaxed);
+    if (allocated >= total || allocated >= max_blocks_)
+    {
+        return;
+    }
+    // 构造时写入每个槽位的序号, 页面在此处 (冷路径) 全部触碰, 回调线程换块时不会缺页
+    size_t count = std::min(total, max_blocks_) - allocated;
+    std::unique_ptr<TickBlock[]> slab(new TickBlock[count]);
+    for (size_t i = 0; i < count; i++)
+    {
+        free_.TryPush(&slab[i]);
+    }
+    slabs_.push_back(std::move(slab));
+    allocated_.store(allocated + count, std::memory_order_release);
+}
+
+lueing::TickHistory::TickHistory(TickBlockPool &pool, uint32_t id, size_t max_ticks, int64_t retention_ns)
+    : pool_(pool), id_(id), max_blocks_((max_ticks + TICK_BLOCK_SIZE - 1) / TICK_BLOCK_SIZE + 1),
+      retention_ns_(retention_ns)
+{
+    size_t size = 1;
+    while (size < max_blocks_)
+    {
+        size <<= 1;
+    }
+    directory_mask_ = size - 1;
+    directory_.reset(new std::atomic<TickBlock *>[size]());
+}
+
+lueing::TickHistory::~TickHistory()
+{
+    Clear();
+}
+
+void lueing::TickHistory::Clear()
+{
+    while (held_.load(std::memory_order_relaxed) > 0)
+    {
+        pool_.Free(Retire());
+    }
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t next = (head + TICK_BLOCK_SIZE - 1) & ~static_cast<uint64_t>(TICK_BLOCK_SIZE - 1);
+    first_ = next >> TICK_BLOCK_BITS;
+    current_ = nullptr;
+    head_.store(next, std::memory_order_release);
+    tail_.store(next, std::memory_order_release);
+}
+
+bool lueing::TickHistory::Advance(uint64_t number, int64_t now)
+{
+    // 超出条数上限, 或整块都早于保留时间的旧块归还到池中
+    size_t held = held_.load(std::memory_order_relaxed);
+    while (held > 0
+           && (held >= max_blocks_
+               || (retention_ns_ > 0
+                   && directory_[first_ & directory_mask_].load(std::memory_order_relaxed)->last_time
+                      < now - retention_ns_)))
+    {
+        pool_.Free(Retire());
+        held--;
+    }
+
+    TickBlock *block = pool_.Allocate();
+    if (nullptr == block && held > 0)
+    {
+        // 超出内存预算, 复用本合约最旧的块
+        block = Retire();
+        held--;
+    }
+    current_ = block;
+    if (nullptr == block)
+    {
+        return false;
+    }
+    if (0 == held)
+    {
+        first_ = number;
+    }
+    block->tag.store(Tag(number), std::memory_order_relaxed);
+    block->last_time = now;
+    directory_[number & directory_mask_].store(block, std::memory_order_release);
+    held_.store(held + 1, std::memory_order_release);
+    return true;
+}
+
+lueing::TickBlock *lueing::TickHistory::Retire()
+{
+    std::atomic<TickBlock *> &entry = directory_[first_ & directory_mask_];
+    TickBlock *block = entry.load(std::memory_order_relaxed);
+    entry.store(nullptr, std::memory_order_release);
+    first_++;
+    tail_.store(first_ << TICK_BLOCK_BITS, std::memory_order_release);
+    held_.fetch_sub(1, std::memory_order_release);
+    return block;
+}
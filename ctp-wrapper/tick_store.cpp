@@ -0,0 +1,55 @@
+#include "tick_store.h"
+
+namespace {
+    size_t BlocksPerInstrument(size_t history_ticks)
+    {
+        return (history_ticks + TICK_BLOCK_SIZE - 1) / TICK_BLOCK_SIZE + 1;
+    }
+}
+
+lueing::TickStore::TickStore(size_t max_instruments, size_t history_ticks, int64_t retention_ns, size_t memory_budget)
+    : max_instruments_(max_instruments), history_ticks_(history_ticks), retention_ns_(retention_ns),
+      pool_(0 == memory_budget ? max_instruments * BlocksPerInstrument(history_ticks)
+                               : memory_budget / sizeof(TickBlock)),
+      histories_(new std::unique_ptr<TickHistory>[max_instruments]),
+      active_(new std::atomic<TickHistory *>[max_instruments]())
+{
+}
+
+lueing::TickStore::~TickStore()
+= default;
+
+lueing::TickHistory *lueing::TickStore::Reserve(InstrumentHandle handle)
+{
+    if (handle >= max_instruments_)
+    {
+        return nullptr;
+    }
+    TickHistory *history = active_[handle].load(std::memory_order_acquire);
+    if (nullptr != history)
+    {
+        return history;
+    }
+    if (!histories_[handle])
+    {
+        histories_[handle].reset(new TickHistory(pool_, handle, history_ticks_, retention_ns_));
+    }
+    // 按已订阅合约数预分配, 每个合约都能写满自己的历史, 回调线程换块时不分配内存;
+    // 取消订阅归还的块留在池中, 重新订阅不会重复分配
+    pool_.Grow((size_.load(std::memory_order_relaxed) + 1) * BlocksPerInstrument(history_ticks_));
+    history = histories_[handle].get();
+    active_[handle].store(history, std::memory_order_release);
+    size_.fetch_add(1, std::memory_order_release);
+    return history;
+}
+
+void lueing::TickStore::Release(InstrumentHandle handle)
+{
+    if (handle >= max_instruments_ || nullptr == active_[handle].load(std::memory_order_acquire))
+    {
+        return;
+    }
+    active_[handle].store(nullptr, std::memory_order_release);
+    histories_[handle]->Clear();
+    size_.fetch_sub(1, std::memory_order_release);
+}
@@ -0,0 +1,220 @@
+#include <thread>
+#include <cfloat>
+#include <cstring>
+#include "gtest/gtest.h"
+#include "tick_ring.h"
+#include "tick_store.h"
+
+TEST(TickStoreTest, RingWrapAround)
+{
+    lueing::TickRing<int> ring(3);
+    EXPECT_EQ(ring.Capacity(), 4u);
+    for (int i = 0; i < 10; i++)
+    {
+        ring.Push(i);
+    }
+    int value = 0;
+    EXPECT_TRUE(ring.Latest(value));
+    EXPECT_EQ(value, 9);
+    EXPECT_FALSE(ring.Read(5, value));
+    EXPECT_TRUE(ring.Read(6, value));
+    EXPECT_EQ(value, 6);
+
+    std::vector<int> out;
+    EXPECT_EQ(ring.ReadFrom(0, out), 10u);
+    EXPECT_EQ(out, std::vector<int>({6, 7, 8, 9}));
+}
+
+TEST(TickStoreTest, Reserve)
+{
+    lueing::TickStore store(2, 16);
+    EXPECT_TRUE(store.Empty());
+    auto *ring = store.Reserve(1);
+    EXPECT_NE(ring, nullptr);
+    EXPECT_EQ(store.Reserve(1), ring);
+    EXPECT_EQ(store.At(1), ring);
+    EXPECT_EQ(store.At(0), nullptr);
+    EXPECT_EQ(store.Reserve(2), nullptr);
+    EXPECT_EQ(store.At(INVALID_INSTRUMENT), nullptr);
+    EXPECT_EQ(store.Size(), 1u);
+}
+
+TEST(TickStoreTest, ConcurrentReaders)
+{
+    lueing::TickStore store(1, 64);
+    auto *ring = store.Reserve(0);
+    std::atomic_bool done{false};
+
+    std::thread reader([&] {
+        lueing::Tick tick{};
+        while (!done.load())
+        {
+            if (ring->Latest(tick))
+            {
+                // 写入时 last_price 与 volume 一致, 读到的快照不应撕裂
+                EXPECT_EQ(static_cast<int>(tick.last_price), tick.volume);
+            }
+        }
+    });
+
+    lueing::Tick tick{};
+    for (int i = 0; i < 100000; i++)
+    {
+        tick.last_price = i;
+        tick.volume = i;
+        ring->Push(tick);
+    }
+    done.store(true);
+    reader.join();
+    EXPECT_EQ(ring->Head(), 100000u);
+}
+
+TEST(TickStoreTest, RetainLastTicksInBlocks)
+{
+    lueing::TickStore store(1, 300);
+    auto *history = store.Reserve(0);
+    lueing::Tick tick{};
+    for (int i = 0; i < 2000; i++)
+    {
+        tick.volume = i;
+        EXPECT_TRUE(history->Push(tick));
+    }
+    // 至少保留 300 条, 按 256 条一块: 最多 3 块, 不再增长
+    EXPECT_EQ(history->Head(), 2000u);
+    EXPECT_LE(history->Blocks(), 3u);
+    EXPECT_LE(history->Head() - history->Tail(), history->Capacity());
+    EXPECT_GE(history->Head() - history->Tail(), 300u);
+    EXPECT_EQ(store.Pool().Allocated(), 3u);
+
+    std::vector<lueing::Tick> out;
+    EXPECT_EQ(history->ReadFrom(0, out), 2000u);
+    ASSERT_EQ(out.size(), history->Head() - history->Tail());
+    EXPECT_EQ(out.front().volume, static_cast<int>(history->Tail()));
+    EXPECT_EQ(out.back().volume, 1999);
+    EXPECT_FALSE(history->Read(history->Tail() - 1, tick));
+}
+
+TEST(TickStoreTest, RetainByTime)
+{
+    // 每条行情间隔 10 纳秒, 每块跨度 2560 纳秒, 只保留 1000 纳秒
+    lueing::TickStore store(1, 4096, 1000);
+    auto *history = store.Reserve(0);
+    lueing::Tick tick{};
+    for (int i = 0; i < 5000; i++)
+    {
+        tick.local_time = i * 10;
+        history->Push(tick);
+    }
+    EXPECT_LE(history->Blocks(), 2u);
+    lueing::Tick latest{};
+    ASSERT_TRUE(history->Latest(latest));
+    EXPECT_EQ(latest.local_time, 49990);
+}
+
+TEST(TickStoreTest, RecycleBlocksOnRelease)
+{
+    // 内存预算只够 3 块, 超出后复用本合约最旧的块
+    lueing::TickStore store(2, 1024, 0, 3 * sizeof(lueing::TickBlock));
+    auto *first = store.Reserve(0);
+    lueing::Tick tick{};
+    for (int i = 0; i < 2000; i++)
+    {
+        tick.volume = i;
+        EXPECT_TRUE(first->Push(tick));
+    }
+    EXPECT_EQ(store.Pool().Allocated(), 3u);
+    EXPECT_EQ(first->Blocks(), 3u);
+
+    // 取消订阅后行情块归还, 其他合约复用, 不再分配
+    store.Release(0);
+    EXPECT_EQ(store.At(0), nullptr);
+    EXPECT_EQ(store.Size(), 0u);
+    EXPECT_EQ(first->Blocks(), 0u);
+    EXPECT_FALSE(first->Latest(tick));
+    auto *second = store.Reserve(1);
+    for (int i = 0; i < 600; i++)
+    {
+        tick.volume = -i;
+        EXPECT_TRUE(second->Push(tick));
+    }
+    EXPECT_EQ(store.Pool().Allocated(), 3u);
+    std::vector<lueing::Tick> out;
+    first->ReadFrom(0, out);
+    EXPECT_TRUE(out.empty());
+
+    // 重新订阅后序号从下一个块开始, 旧序号不可读
+    EXPECT_EQ(store.Reserve(0), first);
+    uint64_t head = first->Head();
+    EXPECT_EQ(head % TICK_BLOCK_SIZE, 0u);
+    EXPECT_FALSE(first->Push(tick));
+    store.Release(1);
+    EXPECT_TRUE(first->Push(tick));
+    EXPECT_EQ(first->Tail(), head);
+    EXPECT_FALSE(first->Read(head - 1, tick));
+}
+
+TEST(TickStoreTest, EveryReservedInstrumentGetsBlocks)
+{
+    // 每个合约 300 条需 2 块, 加上换块时的 1 块余量; 先全部订阅再写入
+    lueing::TickStore store(4, 300);
+    for (lueing::InstrumentHandle handle = 0; handle < 4; handle++)
+    {
+        ASSERT_NE(store.Reserve(handle), nullptr);
+    }
+    lueing::Tick tick{};
+    for (lueing::InstrumentHandle handle = 0; handle < 4; handle++)
+    {
+        for (int i = 0; i < 600; i++)
+        {
+            tick.volume = i;
+            ASSERT_TRUE(store.At(handle)->Push(tick)) << "instrument " << handle << " tick " << i;
+        }
+    }
+    EXPECT_EQ(store.Pool().Allocated(), 12u);
+    for (lueing::InstrumentHandle handle = 0; handle < 4; handle++)
+    {
+        ASSERT_TRUE(store.At(handle)->Latest(tick));
+        EXPECT_EQ(tick.volume, 599);
+        EXPECT_GE(store.At(handle)->Head() - store.At(handle)->Tail(), 300u);
+    }
+
+    // 取消订阅再订阅复用归还的块
+    store.Release(3);
+    store.Reserve(3);
+    EXPECT_EQ(store.Pool().Allocated(), 12u);
+}
+
+TEST(TickStoreTest, ToTick)
+{
+    CThostFtdcDepthMarketDataField field{};
+    strcpy(field.TradingDay, "20250224");
+    strcpy(field.ActionDay, "20250224");
+    strcpy(field.UpdateTime, "09:00:01");
+    field.UpdateMillisec = 500;
+    field.LastPrice = 7800;
+    field.BidPrice1 = 7799;
+    field.BidPrice2 = DBL_MAX;
+    field.Volume = 12;
+
+    lueing::Tick tick{};
+    lueing::ToTick(field, 3, 42, tick);
+    EXPECT_EQ(tick.instrument, 3u);
+    EXPECT_EQ(tick.local_time, 42);
+    EXPECT_EQ(tick.volume, 12);
+    EXPECT_EQ(tick.bid_price[0], 7799);
+    EXPECT_EQ(tick.bid_price[1], 0);
+    // 2025-02-24 09:00:01.500 +08:00
+    EXPECT_EQ(tick.exchange_time, 1740358801500000000LL);
+
+    // 大商所周一交易日的夜盘, ActionDay 填为交易日, 实际为上周五
+    strcpy(field.UpdateTime, "21:00:00");
+    field.UpdateMillisec = 0;
+    EXPECT_EQ(lueing::ExchangeNanos(field), lueing::ExchangeNanos("20250221", "21:00:00", 0));
+    strcpy(field.UpdateTime, "01:00:00");
+    EXPECT_EQ(lueing::ExchangeNanos(field), lueing::ExchangeNanos("20250222", "01:00:00", 0));
+
+    // 上期所夜盘 ActionDay 正确
+    strcpy(field.ActionDay, "20250221");
+    strcpy(field.UpdateTime, "21:00:00");
+    EXPECT_EQ(lueing::ExchangeNanos(field), lueing::ExchangeNanos("20250221", "21:00:00", 0));
+}
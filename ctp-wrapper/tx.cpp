@@ -12,24 +12,108 @@ lueing::CtpTx::Order(const std::string &exchange, const std::string &contract, T
     return tx_handler_.Order(exchange, contract, direction, price, amt);
 }
 
-lueing::CtpTx::~CtpTx() = default;
+lueing::OrderTicket
+lueing::CtpTx::OrderAsync(const std::string &exchange, const std::string &contract, TxDirection direction,
+                          double price, int amt, OrderCallback callback) {
+    return tx_handler_.OrderAsync(exchange, contract, direction, price, amt, std::move(callback));
+}
+
+void lueing::CtpTx::Protect(CtpHq &hq) {
+    hq_ = &hq;
+    hq.AddObserver(&tx_handler_.Risk());
+    hq.AddObserver(&tx_handler_.Stops());
+    hq.AddObserver(&tx_handler_.Positions());
+    if (nullptr != tx_handler_.Simulator()) {
+        hq.AddObserver(tx_handler_.Simulator());
+    }
+    InstrumentRegistryPtr instruments = tx_handler_.Instruments();
+    // 设置时订阅已有持仓的合约, 登录后查询到的持仓可能早于此处
+    tx_handler_.Stops().SetWatcher([&hq, instruments](InstrumentHandle handle) {
+        hq.SubscribeMarketData(instruments->Instrument(handle), "stop-engine");
+    });
+}
 
-lueing::CtpTxHandler::CtpTxHandler(CtpConfigPtr config) : config_(std::move(config)) {
+lueing::OrderTicket
+lueing::CtpTx::OrderAsync(InstrumentHandle handle, TxDirection direction, TThostFtdcOffsetFlagType offset, double price,
+                          int amt, OrderCallback callback) {
+    return tx_handler_.OrderAsync(handle, direction, offset, price, amt, std::move(callback));
+}
+
+lueing::CtpTx::~CtpTx() {
+    // 先从行情注销观察者, 返回后行情线程不再访问风控、止损止盈、持仓簿与模拟撮合, 之后才能析构它们
+    if (nullptr != hq_) {
+        hq_->RemoveObserver(&tx_handler_.Risk());
+        hq_->RemoveObserver(&tx_handler_.Stops());
+        hq_->RemoveObserver(&tx_handler_.Positions());
+        if (nullptr != tx_handler_.Simulator()) {
+            hq_->RemoveObserver(tx_handler_.Simulator());
+        }
+    }
+}
+
+lueing::CtpTxHandler::CtpTxHandler(CtpConfigPtr config)
+        : config_(std::move(config)), templates_(config_->max_instruments, config_->m_userPrincipal),
+          risk_(config_->max_instruments,
+                RiskLimits{config_->amt, config_->x_times, config_->max_position, config_->max_deviation}),
+          stops_(config_->max_instruments, config_->stop_loss, config_->stop_profit, config_->amt),
+          positions_(config_->max_instruments),
+          governor_(config_->order_rate, config_->order_burst, config_->query_rate),
+          master_(config_->instruments, config_->instrument_cache_directory) {
+    orders_.SetObserver([this](const OrderReport &report) {
+        risk_.OnOrderReport(report);
+        stops_.OnOrderReport(report);
+    });
+    // 在行情接收线程上直接发出平仓单
+    stops_.SetSender([this](InstrumentHandle handle, char direction, double price, int32_t volume, OrderCallback done) {
+        TThostFtdcOffsetFlagType offset = THOST_FTDC_OF_Close;
+        const char *exchange = config_->instruments->Exchange(handle);
+        if (0 == strcmp(exchange, "SHFE") || 0 == strcmp(exchange, "INE")) {
+            // 上期所、能源中心区分平今平昨 (平仓即平昨): 先平今仓, 没有今仓时平昨仓, 本笔不超过该部分的持仓
+            int side = THOST_FTDC_D_Sell == direction ? POSITION_LONG : POSITION_SHORT;
+            PositionSummary summary{};
+            positions_.Read(handle, summary);
+            int32_t today = summary.volume[side][POSITION_TODAY];
+            int32_t yesterday = summary.volume[side][POSITION_YESTERDAY];
+            if (today > 0 || 0 == yesterday) {
+                offset = THOST_FTDC_OF_CloseToday;
+                volume = today > 0 && today < volume ? today : volume;
+            } else {
+                volume = yesterday < volume ? yesterday : volume;
+            }
+        }
+        // 平仓单的回报经回调交给止损止盈, 未能发出时回调在 OrderAsync 返回前以拒单调用
+        OrderTicket ticket = OrderAsync(handle, direction, offset, price, volume, std::move(done));
+        if (std::future_status::ready == ticket.done.wait_for(std::chrono::seconds(0))
+            && OrderStatus::Rejected == ticket.done.get().status) {
+            return;
+        }
+        spdlog::info(fmt::format("[TX] 止损止盈触发，合约:{} 数量:{} 价格:{}", config_->instruments->Instrument(handle),
+                                 volume, price));
+    });
 }
 
 lueing::CtpTxHandler::~CtpTxHandler() {
     if (nullptr == user_tx_api_) {
         return;
     }
+    // 流控线程可能正在发送请求, 须先停止
+    governor_.Stop();
     user_tx_api_->Release();
     user_tx_api_ = nullptr;
+    sim_tx_api_ = nullptr;
 }
 
 void lueing::CtpTxHandler::CreateTxContext() {
     if (nullptr != user_tx_api_) {
         return;
     }
-    user_tx_api_ = CThostFtdcTraderApi::CreateFtdcTraderApi("./flow-tx/");
+    if (config_->fake_x > 0) {
+        // 模拟交易: 报单在进程内按行情撮合, 不连接柜台
+        sim_tx_api_ = new SimTraderApi(config_->instruments, static_cast<int64_t>(config_->fake_latency_us) * 1000);
+        user_tx_api_ = sim_tx_api_;
+    } else {
+        user_tx_api_ = CThostFtdcTraderApi::CreateFtdcTraderApi("./flow-tx/");
+    }
     user_tx_api_->RegisterSpi(this);
     user_tx_api_->SubscribePrivateTopic(THOST_TERT_QUICK);
     user_tx_api_->SubscribePublicTopic(THOST_TERT_QUICK);
@@ -80,6 +164,13 @@ void lueing::CtpTxHandler::OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserL
             pRspUserLogin->BrokerID,
             pRspUserLogin->UserID,
             pRspUserLogin->SystemName));
+    // OrderRef 只在会话内唯一, 报单回报按 (FrontID, SessionID, OrderRef) 归属
+    orders_.SetSession(pRspUserLogin->FrontID, pRspUserLogin->SessionID);
+    // 跨交易日重连 (如夜盘结束后次日再登录) 时清零每日报单次数; 同一交易日断线重连保留已用次数
+    if (!trading_day_.empty() && trading_day_ != pRspUserLogin->TradingDay) {
+        risk_.ResetDaily();
+    }
+    trading_day_ = pRspUserLogin->TradingDay;
     // 确认结算单
     CThostFtdcSettlementInfoConfirmField Confirm{};
 
@@ -97,58 +188,155 @@ void lueing::CtpTxHandler::OnRspUserLogin(CThostFtdcRspUserLoginField *pRspUserL
 double
 lueing::CtpTxHandler::Order(const std::string &exchange, const std::string &contract, lueing::TxDirection direction,
                             double price, int amt) {
-    CThostFtdcInputOrderField ord = {};
-    int orderRef = config_->tx_request_id.fetch_add(1);
-    double avg = -1;
-
-    strcpy(ord.BrokerID, config_->m_userPrincipal.BrokerID);
-    strcpy(ord.InvestorID, config_->m_userPrincipal.reserve1);
-    strcpy(ord.InstrumentID, contract.c_str());
-    strcpy(ord.UserID, config_->m_userPrincipal.UserID);
-    strcpy(ord.ExchangeID, exchange.c_str());
-    sprintf(ord.OrderRef, "%d", orderRef);
-    ord.RequestID = config_->tx_request_id.fetch_add(1);
-
-    ord.OrderPriceType = THOST_FTDC_OPT_LimitPrice;
-    ord.Direction = direction;
-    ord.CombOffsetFlag[0] = TX_CALL == direction ? THOST_FTDC_OF_Open : THOST_FTDC_OF_Close;
-    ord.CombHedgeFlag[0] = THOST_FTDC_HF_Speculation;
-    ord.LimitPrice = price;
-    ord.VolumeTotalOriginal = amt;
-    ord.TimeCondition = THOST_FTDC_TC_GFD;               // 当日有效
-    ord.VolumeCondition = THOST_FTDC_VC_AV;              // 任何数量
-    ord.MinVolume = 1;
-    ord.ContingentCondition = THOST_FTDC_CC_Immediately; //立即
-    ord.ForceCloseReason = THOST_FTDC_FCC_NotForceClose; //非强平
-    ord.IsAutoSuspend = 0;
-    int a = user_tx_api_->ReqOrderInsert(&ord, config_->tx_request_id.fetch_add(1));
-    spdlog::info(fmt::format(
-            (a == 0) ? "[TX] 报单成功，序号=[{}], 合约:{} 数量:{} 方向: {}" : "[TX] 报单失败，序号=[{}] 合约:{} 数量:{}",
-            a, contract, amt, TX_PUT == direction ? "空" : "多"));
+    // 只等待本笔报单, 同一合约上的其他报单不会唤醒或干扰
+    OrderTicket ticket = OrderAsync(exchange, contract, direction, price, amt);
+    spdlog::info(fmt::format("[TX] 报单，序号=[{}], 合约:{} 数量:{} 方向: {}",
+                             ticket.order_ref, contract, amt, TX_PUT == direction ? "空" : "多"));
+    const OrderReport &report = ticket.done.get();
+    double avg = report.filled > 0 ? report.average_price : -1;
+
+    // round to 2 decimal places
+    if (avg > 0) {
+        avg = std::round(avg * 100) / 100.0;
+    }
+    spdlog::info(fmt::format("[TX] 合约:{} 数量:{} 成交均价: {}", contract, amt, avg));
+    return avg;
+}
 
-    std::string order = fmt::format("{}", orderRef);
-    events_.Wait(contract, fmt::format("{}", order));
+lueing::InstrumentHandle
+lueing::CtpTxHandler::WarmOrder(const std::string &exchange, const std::string &contract) {
+    // 调用方未给出交易所时按合约主数据确定, 主数据未加载 (如 fake_x 模拟交易) 时按行情、成交登记的交易所
+    std::string exchange_id = exchange.empty() ? master_.Exchange(contract.c_str()) : exchange;
+    lueing::InstrumentHandle handle = config_->instruments->Find(contract);
+    if (INVALID_INSTRUMENT == handle || (!exchange_id.empty() && 0 == config_->instruments->Exchange(handle)[0])) {
+        // 未登记时登记, 已登记但交易所为空时补齐
+        handle = config_->instruments->Intern(contract, exchange_id);
+    }
+    if (exchange_id.empty()) {
+        exchange_id = config_->instruments->Exchange(handle);
+    }
+    // 交易所未知时生成的模板不带交易所, 得知交易所后重新生成
+    if ((!templates_.Warmed(handle) || (0 == templates_.Exchange(handle)[0] && !exchange_id.empty()))
+        && !templates_.Warm(handle, exchange_id, contract)) {
+        spdlog::error(fmt::format("[TX] 合约:{} 超出 max_instruments, 无法生成报单模板", contract));
+    }
+    if (exchange_id.empty()) {
+        spdlog::warn(fmt::format("[TX] 合约:{} 交易所未知, 报单不带交易所", contract));
+    }
+    ApplyInstrument(handle);
+    return handle;
+}
 
-    auto it = trade_data_.find(order);
+lueing::OrderTicket
+lueing::CtpTxHandler::OrderAsync(const std::string &exchange, const std::string &contract, TxDirection direction,
+                                 double price, int amt, OrderCallback callback) {
+    InstrumentHandle handle = WarmOrder(exchange, contract);
+    TThostFtdcOffsetFlagType offset = TX_CALL == direction ? THOST_FTDC_OF_Open : THOST_FTDC_OF_Close;
+    return OrderAsync(handle, direction, offset, price, amt, std::move(callback));
+}
 
-    if (it != trade_data_.end()) {
-        int total_volume = 0;
-        double total_price = 0;
-        for (const auto &trade: it->second) {
-            total_volume += trade.Volume;
-            total_price += trade.Price * trade.Volume;
+lueing::OrderTicket
+lueing::CtpTxHandler::OrderAsync(InstrumentHandle handle, TxDirection direction, TThostFtdcOffsetFlagType offset,
+                                 double price, int amt, OrderCallback callback) {
+    CThostFtdcInputOrderField ord;
+    // OrderRef 与请求编号共用一个序号
+    int orderRef = config_->tx_request_id.fetch_add(1);
+    // 按最小变动价位取整, 不会比给定价格更差
+    price = master_.RoundPrice(handle, direction, price);
+    if (!templates_.Build(handle, direction, offset, price, amt, orderRef, ord)) {
+        OrderTicket rejected = OrderTracker::RejectedTicket(-1, "order template not warmed");
+        if (callback) {
+            callback(rejected.done.get());
         }
-        if (total_volume > 0) {
-            avg = total_price / total_volume;
+        return rejected;
+    }
+    int risk = risk_.Check(handle, direction, offset, price, amt);
+    if (RISK_PASSED != risk) {
+        spdlog::warn(fmt::format("[TX] 风控拒单，合约:{} 价格:{} 数量:{} 原因:{}", ord.InstrumentID, price, amt,
+                                 RiskEngine::Describe(risk)));
+        OrderTicket rejected = OrderTracker::RejectedTicket(risk, RiskEngine::Describe(risk));
+        if (callback) {
+            callback(rejected.done.get());
         }
+        return rejected;
     }
+    // 先登记再发送, 回报可能在 ReqOrderInsert 返回之前到达
+    OrderTicket ticket = orders_.Add(orderRef, handle, direction, offset, amt, std::move(callback));
+    // 超出流控的报单排队, 由流控线程发出; 发送失败时拒单并退还报单次数
+    auto reject = [this, orderRef, offset](int result) {
+        spdlog::error(fmt::format("[TX] 报单失败，序号=[{}] 报单:{}", result, orderRef));
+        risk_.Refund(offset);
+        orders_.Reject(orderRef, result, "ReqOrderInsert failed");
+    };
+    // 报单按值捕获在栈上的 lambda 中, 只有排队或重试时才装入 std::function
+    int result = governor_.Submit(RequestClass::Order, [this, ord, orderRef]() mutable {
+        return user_tx_api_->ReqOrderInsert(&ord, orderRef);
+    }, reject);
+    if (0 != result) {
+        reject(result);
+    }
+    return ticket;
+}
 
-    // round to 2 decimal places
-    if (avg > 0) {
-        avg = std::round(avg * 100) / 100.0;
+int lueing::CtpTxHandler::Cancel(int32_t order_ref) {
+    OrderAddress address{};
+    if (!orders_.Address(order_ref, address)) {
+        return -1;
+    }
+    return SendCancel(address);
+}
+
+lueing::ReplaceTicket lueing::CtpTxHandler::Replace(int32_t order_ref, double price, OrderCallback callback) {
+    ReplaceTicket ticket;
+    OrderAddress address{};
+    // 先登记改单再撤单, 撤单回报可能在 ReqOrderAction 返回之前到达
+    if (orders_.Replace(order_ref, price, std::move(callback), ticket, address)) {
+        SendCancel(address);
+    }
+    return ticket;
+}
+
+int lueing::CtpTxHandler::SendCancel(const OrderAddress &address) {
+    CThostFtdcInputOrderActionField action = {};
+    strcpy(action.BrokerID, config_->m_userPrincipal.BrokerID);
+    strcpy(action.InvestorID, config_->m_userPrincipal.reserve1);
+    strcpy(action.UserID, config_->m_userPrincipal.UserID);
+    strcpy(action.InstrumentID, config_->instruments->Instrument(address.instrument));
+    action.ActionFlag = THOST_FTDC_AF_Delete;
+    // 总是带上 FrontID/SessionID/OrderRef, 错误回报据此找到报单; 已有 OrderSysID 时柜台按 OrderSysID 撤单
+    action.FrontID = address.key.front_id;
+    action.SessionID = address.key.session_id;
+    FormatInt(address.key.order_ref, action.OrderRef);
+    if (0 != address.order_sys_id[0]) {
+        strcpy(action.ExchangeID, address.exchange_id);
+        strcpy(action.OrderSysID, address.order_sys_id);
+    } else {
+        strcpy(action.ExchangeID, config_->instruments->Exchange(address.instrument));
+    }
+    int requestId = config_->tx_request_id.fetch_add(1);
+    action.OrderActionRef = requestId;
+    action.RequestID = requestId;
+    OrderKey key = address.key;
+    auto fail = [this, key](int result) {
+        spdlog::error(fmt::format("[TX] 撤单失败，序号=[{}] 报单:{}", result, key.order_ref));
+        orders_.ActionFailed(key, result, "ReqOrderAction failed");
+    };
+    int result = governor_.Submit(RequestClass::Order, [this, action, requestId]() mutable {
+        return user_tx_api_->ReqOrderAction(&action, requestId);
+    }, fail);
+    if (0 != result) {
+        fail(result);
+    }
+    return result;
+}
+
+void lueing::CtpTxHandler::SendReplaces() {
+    OrderReplace replace;
+    while (orders_.TakeReplace(replace)) {
+        OrderTicket ticket = OrderAsync(replace.instrument, replace.direction, replace.offset, replace.price,
+                                        replace.volume, std::move(replace.callback));
+        replace.promise->set_value(ticket);
     }
-    spdlog::info(fmt::format("[TX] 合约:{} 数量:{} 成交均价: {}", contract, amt, avg));
-    return avg;
 }
 
 void lueing::CtpTxHandler::OnRtnTrade(CThostFtdcTradeField *pTrade) {
@@ -156,16 +344,29 @@ void lueing::CtpTxHandler::OnRtnTrade(CThostFtdcTradeField *pTrade) {
         return;
     }
     spdlog::info(fmt::format("[TX] 逐笔成交，合约:{} 数量:{} 价格:{}", pTrade->InstrumentID, pTrade->Volume, pTrade->Price));
-    trade_data_[pTrade->OrderRef].push_back(*pTrade);
-    if (trade_data_.contains(pTrade->OrderRef)) {
-        events_.Notify(pTrade->InstrumentID);
+    orders_.OnTrade(*pTrade);
+    if (positions_ready_.load(std::memory_order_acquire)) {
+        lueing::InstrumentHandle handle = config_->instruments->Find(pTrade->InstrumentID);
+        if (INVALID_INSTRUMENT == handle) {
+            handle = config_->instruments->Intern(pTrade->InstrumentID, pTrade->ExchangeID);
+        }
+        positions_.OnTrade(handle, *pTrade);
     }
+    SendReplaces();
 }
 
 void lueing::CtpTxHandler::OnRtnOrder(CThostFtdcOrderField *pOrder) {
-    if (THOST_FTDC_OST_AllTraded == pOrder->OrderStatus) {
-        trade_finish_.emplace(pOrder->OrderRef);
+    if (nullptr == pOrder) {
+        return;
+    }
+    if (THOST_FTDC_OSS_InsertRejected == pOrder->OrderSubmitStatus) {
+        // 拒单回报也会推送给同一账户的其他会话, 只处理本会话的报单
+        orders_.Reject(OrderKey{pOrder->FrontID, pOrder->SessionID, OrderTracker::ParseOrderRef(pOrder->OrderRef)},
+                       0, gbk_to_utf8_converter_.GBK2UTF8(pOrder->StatusMsg));
+    } else {
+        orders_.OnOrder(*pOrder);
     }
+    SendReplaces();
 }
 
 // Empty implementations for all CThostFtdcTraderSpi methods
@@ -173,6 +374,8 @@ void lueing::CtpTxHandler::OnRtnOrder(CThostFtdcOrderField *pOrder) {
 void lueing::CtpTxHandler::OnFrontDisconnected(int nReason)
 {
     spdlog::warn(fmt::format("[TX][交易接口] Front disconnected, reason: {}", nReason));
+    // 断线前发出的查询不会再有响应
+    queries_.AbortAll();
 }
 
 void lueing::CtpTxHandler::OnHeartBeatWarning(int nTimeLapse) {}
@@ -200,7 +403,16 @@ lueing::CtpTxHandler::OnRspGenUserText(CThostFtdcRspGenUserTextField *pRspGenUse
                                        int nRequestID, bool bIsLast) {}
 
 void lueing::CtpTxHandler::OnRspOrderInsert(CThostFtdcInputOrderField *pInputOrder, CThostFtdcRspInfoField *pRspInfo,
-                                            int nRequestID, bool bIsLast) {}
+                                            int nRequestID, bool bIsLast) {
+    // 柜台拒单
+    if (nullptr == pInputOrder || nullptr == pRspInfo || 0 == pRspInfo->ErrorID) {
+        return;
+    }
+    std::string error_msg = gbk_to_utf8_converter_.GBK2UTF8(pRspInfo->ErrorMsg);
+    spdlog::error(fmt::format("[TX] 报单被拒，合约:{} 错误码:{} 错误信息:{}", pInputOrder->InstrumentID,
+                              pRspInfo->ErrorID, error_msg));
+    orders_.Reject(OrderTracker::ParseOrderRef(pInputOrder->OrderRef), pRspInfo->ErrorID, error_msg);
+}
 
 void
 lueing::CtpTxHandler::OnRspParkedOrderInsert(CThostFtdcParkedOrderField *pParkedOrder, CThostFtdcRspInfoField *pRspInfo,
@@ -210,13 +422,133 @@ void lueing::CtpTxHandler::OnRspParkedOrderAction(CThostFtdcParkedOrderActionFie
                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
 
 void lueing::CtpTxHandler::OnRspOrderAction(CThostFtdcInputOrderActionField *pInputOrderAction,
-                                            CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                            CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    // 柜台拒绝撤单
+    if (nullptr == pInputOrderAction || nullptr == pRspInfo || 0 == pRspInfo->ErrorID) {
+        return;
+    }
+    std::string error_msg = gbk_to_utf8_converter_.GBK2UTF8(pRspInfo->ErrorMsg);
+    spdlog::error(fmt::format("[TX] 撤单被拒，合约:{} 错误码:{} 错误信息:{}", pInputOrderAction->InstrumentID,
+                              pRspInfo->ErrorID, error_msg));
+    orders_.ActionFailed(OrderKey{pInputOrderAction->FrontID, pInputOrderAction->SessionID,
+                                  OrderTracker::ParseOrderRef(pInputOrderAction->OrderRef)},
+                         pRspInfo->ErrorID, error_msg);
+}
 
 void lueing::CtpTxHandler::OnRspQryMaxOrderVolume(CThostFtdcQryMaxOrderVolumeField *pQryMaxOrderVolume,
-                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pQryMaxOrderVolume, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    // 结算单确认后才能查询持仓; 持仓与成交按合约乘数计算成本, 合约数据就绪后再查询
+    LoadInstruments([this]() { QueryPositions(); });
+}
+
+void lueing::CtpTxHandler::LoadInstruments(std::function<void()> ready) {
+    if (trading_day_.empty() || master_.TradingDay() == trading_day_) {
+        ready();
+        return;
+    }
+    if (master_.Load(trading_day_)) {
+        for (InstrumentHandle handle = 0; handle < config_->instruments->Size(); handle++) {
+            ApplyInstrument(handle);
+        }
+        ready();
+        return;
+    }
+    if (nullptr != sim_tx_api_) {
+        // 模拟柜台没有合约数据, 不能查询, 也不能把空结果写入与实盘共用的缓存; 交易所按行情、成交登记的为准
+        spdlog::warn(fmt::format("[TX] 模拟交易没有交易日:{} 的合约缓存, 合约乘数按 1、价格不按最小变动价位取整",
+                                 trading_day_));
+        ready();
+        return;
+    }
+    // 当日首次启动, 查询全部合约并写入缓存
+    std::string trading_day = trading_day_;
+    Query(CThostFtdcQryInstrumentField{}, [this, trading_day, ready](int error_id, const std::string &error,
+                                                                      std::vector<CThostFtdcInstrumentField> &rows) {
+        if (0 != error_id) {
+            spdlog::error(fmt::format("[TX] 合约查询失败，错误码:{} 错误信息:{}", error_id, error));
+            ready();
+            return;
+        }
+        master_.Update(trading_day, rows);
+        spdlog::info(fmt::format("[TX] 合约查询完成，交易日:{} 合约数:{}", trading_day, master_.Size()));
+        for (InstrumentHandle handle = 0; handle < config_->instruments->Size(); handle++) {
+            ApplyInstrument(handle);
+        }
+        ready();
+    });
+}
+
+void lueing::CtpTxHandler::ApplyInstrument(InstrumentHandle handle) {
+    const InstrumentInfo *info = master_.Find(handle);
+    if (nullptr == info) {
+        return;
+    }
+    if (info->volume_multiple > 0) {
+        positions_.SetMultiplier(handle, info->volume_multiple);
+    }
+    // 主数据加载前登记或预热的合约可能缺少交易所
+    if (0 == config_->instruments->Exchange(handle)[0]) {
+        config_->instruments->Intern(info->instrument, info->exchange);
+    }
+    if (templates_.Warmed(handle) && 0 == templates_.Exchange(handle)[0]) {
+        templates_.Warm(handle, info->exchange, info->instrument);
+    }
+}
+
+void lueing::CtpTxHandler::QueryPositions() {
+    CThostFtdcQryInvestorPositionField query{};
+    strcpy(query.BrokerID, config_->m_userPrincipal.BrokerID);
+    strcpy(query.InvestorID, config_->m_userPrincipal.reserve1);
+    positions_ready_.store(false, std::memory_order_release);
+    // 查询让位于报单, 启动时的持仓查询不会与报单争抢流控; 按请求编号匹配响应, 用户发起的持仓查询不会重复累加持仓
+    Query(query, [this](int error_id, const std::string &error, std::vector<CThostFtdcInvestorPositionField> &rows) {
+        if (0 != error_id) {
+            spdlog::error(fmt::format("[TX] 持仓查询失败，错误码:{} 错误信息:{}", error_id, error));
+            return;
+        }
+        SeedPositions(rows);
+    });
+}
+
+void lueing::CtpTxHandler::SeedPositions(const std::vector<CThostFtdcInvestorPositionField> &rows) {
+    positions_.Reset();
+    std::vector<InstrumentHandle> handles;
+    for (const CThostFtdcInvestorPositionField &row: rows) {
+        if (0 == row.InstrumentID[0]) {
+            continue;
+        }
+        lueing::InstrumentHandle handle = config_->instruments->Find(row.InstrumentID);
+        if (INVALID_INSTRUMENT == handle) {
+            handle = config_->instruments->Intern(row.InstrumentID, row.ExchangeID);
+        }
+        ApplyInstrument(handle);
+        positions_.Seed(handle, row);
+        handles.push_back(handle);
+    }
+    // 风控的持仓额度从已有持仓开始计算, 止损止盈保护登录前已有的持仓
+    PositionSummary summary{};
+    for (InstrumentHandle handle: handles) {
+        if (!positions_.Read(handle, summary)) {
+            continue;
+        }
+        double multiplier = positions_.Multiplier(handle);
+        const char directions[2] = {THOST_FTDC_D_Buy, THOST_FTDC_D_Sell};
+        for (int side = POSITION_LONG; side <= POSITION_SHORT; side++) {
+            int32_t volume = summary.volume[side][POSITION_TODAY] + summary.volume[side][POSITION_YESTERDAY];
+            risk_.SetPosition(handle, directions[side], volume);
+            // 今仓成本按开仓价, 昨仓按昨结算价, 止损止盈以两者的均价为基准
+            double cost = summary.cost[side][POSITION_TODAY] + summary.cost[side][POSITION_YESTERDAY];
+            stops_.SetPosition(handle, directions[side], volume, volume > 0 ? cost / (volume * multiplier) : 0);
+        }
+    }
+    positions_ready_.store(true, std::memory_order_release);
+    spdlog::info(fmt::format("[TX] 持仓查询完成，记录数:{}", rows.size()));
+}
 
 void lueing::CtpTxHandler::OnRspRemoveParkedOrder(CThostFtdcRemoveParkedOrderField *pRemoveParkedOrder,
                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
@@ -254,259 +586,415 @@ void lueing::CtpTxHandler::OnRspCombActionInsert(CThostFtdcInputCombActionField
                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
 
 void lueing::CtpTxHandler::OnRspQryOrder(CThostFtdcOrderField *pOrder, CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                         bool bIsLast) {}
+                                         bool bIsLast) {
+    Respond(pOrder, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryTrade(CThostFtdcTradeField *pTrade, CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                         bool bIsLast) {}
+                                         bool bIsLast) {
+    Respond(pTrade, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInvestorPosition(CThostFtdcInvestorPositionField *pInvestorPosition,
-                                                    CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                    CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pInvestorPosition, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryTradingAccount(CThostFtdcTradingAccountField *pTradingAccount,
-                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pTradingAccount, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInvestor(CThostFtdcInvestorField *pInvestor, CThostFtdcRspInfoField *pRspInfo,
-                                            int nRequestID, bool bIsLast) {}
+                                            int nRequestID, bool bIsLast) {
+    Respond(pInvestor, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryTradingCode(CThostFtdcTradingCodeField *pTradingCode, CThostFtdcRspInfoField *pRspInfo,
-                                          int nRequestID, bool bIsLast) {}
+                                          int nRequestID, bool bIsLast) {
+    Respond(pTradingCode, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInstrumentMarginRate(CThostFtdcInstrumentMarginRateField *pInstrumentMarginRate,
                                                         CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                        bool bIsLast) {}
+                                                        bool bIsLast) {
+    Respond(pInstrumentMarginRate, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInstrumentCommissionRate(
         CThostFtdcInstrumentCommissionRateField *pInstrumentCommissionRate, CThostFtdcRspInfoField *pRspInfo,
-        int nRequestID, bool bIsLast) {}
+        int nRequestID, bool bIsLast) {
+    Respond(pInstrumentCommissionRate, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryExchange(CThostFtdcExchangeField *pExchange, CThostFtdcRspInfoField *pRspInfo,
-                                            int nRequestID, bool bIsLast) {}
+                                            int nRequestID, bool bIsLast) {
+    Respond(pExchange, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryProduct(CThostFtdcProductField *pProduct, CThostFtdcRspInfoField *pRspInfo,
-                                           int nRequestID, bool bIsLast) {}
+                                           int nRequestID, bool bIsLast) {
+    Respond(pProduct, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInstrument(CThostFtdcInstrumentField *pInstrument, CThostFtdcRspInfoField *pRspInfo,
-                                              int nRequestID, bool bIsLast) {}
+                                              int nRequestID, bool bIsLast) {
+    Respond(pInstrument, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryDepthMarketData(CThostFtdcDepthMarketDataField *pDepthMarketData,
-                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pDepthMarketData, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryTraderOffer(CThostFtdcTraderOfferField *pTraderOffer, CThostFtdcRspInfoField *pRspInfo,
-                                          int nRequestID, bool bIsLast) {}
+                                          int nRequestID, bool bIsLast) {
+    Respond(pTraderOffer, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySettlementInfo(CThostFtdcSettlementInfoField *pSettlementInfo,
-                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pSettlementInfo, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryTransferBank(CThostFtdcTransferBankField *pTransferBank, CThostFtdcRspInfoField *pRspInfo,
-                                           int nRequestID, bool bIsLast) {}
+                                           int nRequestID, bool bIsLast) {
+    Respond(pTransferBank, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryInvestorPositionDetail(CThostFtdcInvestorPositionDetailField *pInvestorPositionDetail,
-                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pInvestorPositionDetail, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryNotice(CThostFtdcNoticeField *pNotice, CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                     bool bIsLast) {}
+                                     bool bIsLast) {
+    Respond(pNotice, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm,
                                                          CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                         bool bIsLast) {}
+                                                         bool bIsLast) {
+    Respond(pSettlementInfoConfirm, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInvestorPositionCombineDetail(
         CThostFtdcInvestorPositionCombineDetailField *pInvestorPositionCombineDetail, CThostFtdcRspInfoField *pRspInfo,
-        int nRequestID, bool bIsLast) {}
+        int nRequestID, bool bIsLast) {
+    Respond(pInvestorPositionCombineDetail, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryCFMMCTradingAccountKey(CThostFtdcCFMMCTradingAccountKeyField *pCFMMCTradingAccountKey,
-                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pCFMMCTradingAccountKey, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryEWarrantOffset(CThostFtdcEWarrantOffsetField *pEWarrantOffset,
-                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pEWarrantOffset, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInvestorProductGroupMargin(
         CThostFtdcInvestorProductGroupMarginField *pInvestorProductGroupMargin, CThostFtdcRspInfoField *pRspInfo,
-        int nRequestID, bool bIsLast) {}
+        int nRequestID, bool bIsLast) {
+    Respond(pInvestorProductGroupMargin, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryExchangeMarginRate(CThostFtdcExchangeMarginRateField *pExchangeMarginRate,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pExchangeMarginRate, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryExchangeMarginRateAdjust(
         CThostFtdcExchangeMarginRateAdjustField *pExchangeMarginRateAdjust, CThostFtdcRspInfoField *pRspInfo,
-        int nRequestID, bool bIsLast) {}
+        int nRequestID, bool bIsLast) {
+    Respond(pExchangeMarginRateAdjust, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryExchangeRate(CThostFtdcExchangeRateField *pExchangeRate, CThostFtdcRspInfoField *pRspInfo,
-                                           int nRequestID, bool bIsLast) {}
+                                           int nRequestID, bool bIsLast) {
+    Respond(pExchangeRate, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySecAgentACIDMap(CThostFtdcSecAgentACIDMapField *pSecAgentACIDMap,
-                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pSecAgentACIDMap, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryProductExchRate(CThostFtdcProductExchRateField *pProductExchRate,
-                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pProductExchRate, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryProductGroup(CThostFtdcProductGroupField *pProductGroup, CThostFtdcRspInfoField *pRspInfo,
-                                           int nRequestID, bool bIsLast) {}
+                                           int nRequestID, bool bIsLast) {
+    Respond(pProductGroup, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryMMInstrumentCommissionRate(
         CThostFtdcMMInstrumentCommissionRateField *pMMInstrumentCommissionRate, CThostFtdcRspInfoField *pRspInfo,
-        int nRequestID, bool bIsLast) {}
+        int nRequestID, bool bIsLast) {
+    Respond(pMMInstrumentCommissionRate, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryMMOptionInstrCommRate(CThostFtdcMMOptionInstrCommRateField *pMMOptionInstrCommRate,
                                                          CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                         bool bIsLast) {}
+                                                         bool bIsLast) {
+    Respond(pMMOptionInstrCommRate, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryInstrumentOrderCommRate(CThostFtdcInstrumentOrderCommRateField *pInstrumentOrderCommRate,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pInstrumentOrderCommRate, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySecAgentTradingAccount(CThostFtdcTradingAccountField *pTradingAccount,
                                                           CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                          bool bIsLast) {}
+                                                          bool bIsLast) {
+    Respond(pTradingAccount, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySecAgentCheckMode(CThostFtdcSecAgentCheckModeField *pSecAgentCheckMode,
-                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pSecAgentCheckMode, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySecAgentTradeInfo(CThostFtdcSecAgentTradeInfoField *pSecAgentTradeInfo,
-                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pSecAgentTradeInfo, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryOptionInstrTradeCost(CThostFtdcOptionInstrTradeCostField *pOptionInstrTradeCost,
                                                         CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                        bool bIsLast) {}
+                                                        bool bIsLast) {
+    Respond(pOptionInstrTradeCost, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryOptionInstrCommRate(CThostFtdcOptionInstrCommRateField *pOptionInstrCommRate,
                                                        CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                       bool bIsLast) {}
+                                                       bool bIsLast) {
+    Respond(pOptionInstrCommRate, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryExecOrder(CThostFtdcExecOrderField *pExecOrder, CThostFtdcRspInfoField *pRspInfo,
-                                             int nRequestID, bool bIsLast) {}
+                                             int nRequestID, bool bIsLast) {
+    Respond(pExecOrder, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryForQuote(CThostFtdcForQuoteField *pForQuote, CThostFtdcRspInfoField *pRspInfo,
-                                            int nRequestID, bool bIsLast) {}
+                                            int nRequestID, bool bIsLast) {
+    Respond(pForQuote, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryQuote(CThostFtdcQuoteField *pQuote, CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                         bool bIsLast) {}
+                                         bool bIsLast) {
+    Respond(pQuote, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryOptionSelfClose(CThostFtdcOptionSelfCloseField *pOptionSelfClose,
-                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pOptionSelfClose, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInvestUnit(CThostFtdcInvestUnitField *pInvestUnit, CThostFtdcRspInfoField *pRspInfo,
-                                              int nRequestID, bool bIsLast) {}
+                                              int nRequestID, bool bIsLast) {
+    Respond(pInvestUnit, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySPBMFutureParameter(CThostFtdcSPBMFutureParameterField *pSPBMFutureParameter,
                                                        CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                       bool bIsLast) {}
+                                                       bool bIsLast) {
+    Respond(pSPBMFutureParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySPBMOptionParameter(CThostFtdcSPBMOptionParameterField *pSPBMOptionParameter,
                                                        CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                       bool bIsLast) {}
+                                                       bool bIsLast) {
+    Respond(pSPBMOptionParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySPBMIntraParameter(CThostFtdcSPBMIntraParameterField *pSPBMIntraParameter,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pSPBMIntraParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySPBMInterParameter(CThostFtdcSPBMInterParameterField *pSPBMInterParameter,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pSPBMInterParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySPBMPortfDefinition(CThostFtdcSPBMPortfDefinitionField *pSPBMPortfDefinition,
                                                        CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                       bool bIsLast) {}
+                                                       bool bIsLast) {
+    Respond(pSPBMPortfDefinition, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySPBMInvestorPortfDef(CThostFtdcSPBMInvestorPortfDefField *pSPBMInvestorPortfDef,
                                                         CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                        bool bIsLast) {}
+                                                        bool bIsLast) {
+    Respond(pSPBMInvestorPortfDef, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInvestorPortfMarginRatio(
         CThostFtdcInvestorPortfMarginRatioField *pInvestorPortfMarginRatio, CThostFtdcRspInfoField *pRspInfo,
-        int nRequestID, bool bIsLast) {}
+        int nRequestID, bool bIsLast) {
+    Respond(pInvestorPortfMarginRatio, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryInvestorProdSPBMDetail(CThostFtdcInvestorProdSPBMDetailField *pInvestorProdSPBMDetail,
-                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pInvestorProdSPBMDetail, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInvestorCommoditySPMMMargin(
         CThostFtdcInvestorCommoditySPMMMarginField *pInvestorCommoditySPMMMargin, CThostFtdcRspInfoField *pRspInfo,
-        int nRequestID, bool bIsLast) {}
+        int nRequestID, bool bIsLast) {
+    Respond(pInvestorCommoditySPMMMargin, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryInvestorCommodityGroupSPMMMargin(
         CThostFtdcInvestorCommodityGroupSPMMMarginField *pInvestorCommodityGroupSPMMMargin,
-        CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+        CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pInvestorCommodityGroupSPMMMargin, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySPMMInstParam(CThostFtdcSPMMInstParamField *pSPMMInstParam,
-                                                 CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                 CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pSPMMInstParam, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQrySPMMProductParam(CThostFtdcSPMMProductParamField *pSPMMProductParam,
-                                                    CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                    CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pSPMMProductParam, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQrySPBMAddOnInterParameter(CThostFtdcSPBMAddOnInterParameterField *pSPBMAddOnInterParameter,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pSPBMAddOnInterParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryRCAMSCombProductInfo(CThostFtdcRCAMSCombProductInfoField *pRCAMSCombProductInfo,
                                                         CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                        bool bIsLast) {}
+                                                        bool bIsLast) {
+    Respond(pRCAMSCombProductInfo, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryRCAMSInstrParameter(CThostFtdcRCAMSInstrParameterField *pRCAMSInstrParameter,
                                                        CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                       bool bIsLast) {}
+                                                       bool bIsLast) {
+    Respond(pRCAMSInstrParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryRCAMSIntraParameter(CThostFtdcRCAMSIntraParameterField *pRCAMSIntraParameter,
                                                        CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                       bool bIsLast) {}
+                                                       bool bIsLast) {
+    Respond(pRCAMSIntraParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryRCAMSInterParameter(CThostFtdcRCAMSInterParameterField *pRCAMSInterParameter,
                                                        CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                       bool bIsLast) {}
+                                                       bool bIsLast) {
+    Respond(pRCAMSInterParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryRCAMSShortOptAdjustParam(
         CThostFtdcRCAMSShortOptAdjustParamField *pRCAMSShortOptAdjustParam, CThostFtdcRspInfoField *pRspInfo,
-        int nRequestID, bool bIsLast) {}
+        int nRequestID, bool bIsLast) {
+    Respond(pRCAMSShortOptAdjustParam, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryRCAMSInvestorCombPosition(
         CThostFtdcRCAMSInvestorCombPositionField *pRCAMSInvestorCombPosition, CThostFtdcRspInfoField *pRspInfo,
-        int nRequestID, bool bIsLast) {}
+        int nRequestID, bool bIsLast) {
+    Respond(pRCAMSInvestorCombPosition, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryInvestorProdRCAMSMargin(CThostFtdcInvestorProdRCAMSMarginField *pInvestorProdRCAMSMargin,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pInvestorProdRCAMSMargin, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryRULEInstrParameter(CThostFtdcRULEInstrParameterField *pRULEInstrParameter,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pRULEInstrParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryRULEIntraParameter(CThostFtdcRULEIntraParameterField *pRULEIntraParameter,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pRULEIntraParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryRULEInterParameter(CThostFtdcRULEInterParameterField *pRULEInterParameter,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pRULEInterParameter, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryInvestorProdRULEMargin(CThostFtdcInvestorProdRULEMarginField *pInvestorProdRULEMargin,
-                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pInvestorProdRULEMargin, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryCombInstrumentGuard(CThostFtdcCombInstrumentGuardField *pCombInstrumentGuard,
                                                        CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                       bool bIsLast) {}
+                                                       bool bIsLast) {
+    Respond(pCombInstrumentGuard, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryCombAction(CThostFtdcCombActionField *pCombAction, CThostFtdcRspInfoField *pRspInfo,
-                                              int nRequestID, bool bIsLast) {}
+                                              int nRequestID, bool bIsLast) {
+    Respond(pCombAction, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryTransferSerial(CThostFtdcTransferSerialField *pTransferSerial,
-                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                  CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pTransferSerial, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryAccountregister(CThostFtdcAccountregisterField *pAccountregister,
-                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                   CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pAccountregister, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspError(CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
 
 // void lueing::CtpTxHandler::OnRtnOrder(CThostFtdcOrderField *pOrder) {}
 // void lueing::CtpTxHandler::OnRtnTrade(CThostFtdcTradeField *pTrade) {}
 void
-lueing::CtpTxHandler::OnErrRtnOrderInsert(CThostFtdcInputOrderField *pInputOrder, CThostFtdcRspInfoField *pRspInfo) {}
+lueing::CtpTxHandler::OnErrRtnOrderInsert(CThostFtdcInputOrderField *pInputOrder, CThostFtdcRspInfoField *pRspInfo) {
+    // 交易所拒单
+    if (nullptr == pInputOrder || nullptr == pRspInfo || 0 == pRspInfo->ErrorID) {
+        return;
+    }
+    orders_.Reject(OrderTracker::ParseOrderRef(pInputOrder->OrderRef), pRspInfo->ErrorID,
+                   gbk_to_utf8_converter_.GBK2UTF8(pRspInfo->ErrorMsg));
+}
 
 void
-lueing::CtpTxHandler::OnErrRtnOrderAction(CThostFtdcOrderActionField *pOrderAction, CThostFtdcRspInfoField *pRspInfo) {}
+lueing::CtpTxHandler::OnErrRtnOrderAction(CThostFtdcOrderActionField *pOrderAction, CThostFtdcRspInfoField *pRspInfo) {
+    // 交易所拒绝撤单, 常见于报单已全部成交或已撤销
+    if (nullptr == pOrderAction || nullptr == pRspInfo || 0 == pRspInfo->ErrorID) {
+        return;
+    }
+    std::string error_msg = gbk_to_utf8_converter_.GBK2UTF8(pRspInfo->ErrorMsg);
+    spdlog::error(fmt::format("[TX] 撤单错误，合约:{} 错误码:{} 错误信息:{}", pOrderAction->InstrumentID,
+                              pRspInfo->ErrorID, error_msg));
+    orders_.ActionFailed(OrderKey{pOrderAction->FrontID, pOrderAction->SessionID,
+                                  OrderTracker::ParseOrderRef(pOrderAction->OrderRef)},
+                         pRspInfo->ErrorID, error_msg);
+}
 
 void lueing::CtpTxHandler::OnRtnInstrumentStatus(CThostFtdcInstrumentStatusField *pInstrumentStatus) {}
 
@@ -558,28 +1046,42 @@ void lueing::CtpTxHandler::OnErrRtnCombActionInsert(CThostFtdcInputCombActionFie
 
 void
 lueing::CtpTxHandler::OnRspQryContractBank(CThostFtdcContractBankField *pContractBank, CThostFtdcRspInfoField *pRspInfo,
-                                           int nRequestID, bool bIsLast) {}
+                                           int nRequestID, bool bIsLast) {
+    Respond(pContractBank, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryParkedOrder(CThostFtdcParkedOrderField *pParkedOrder, CThostFtdcRspInfoField *pRspInfo,
-                                          int nRequestID, bool bIsLast) {}
+                                          int nRequestID, bool bIsLast) {
+    Respond(pParkedOrder, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryParkedOrderAction(CThostFtdcParkedOrderActionField *pParkedOrderAction,
-                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                     CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pParkedOrderAction, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryTradingNotice(CThostFtdcTradingNoticeField *pTradingNotice,
-                                                 CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                 CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pTradingNotice, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryBrokerTradingParams(CThostFtdcBrokerTradingParamsField *pBrokerTradingParams,
                                                        CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                       bool bIsLast) {}
+                                                       bool bIsLast) {
+    Respond(pBrokerTradingParams, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryBrokerTradingAlgos(CThostFtdcBrokerTradingAlgosField *pBrokerTradingAlgos,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pBrokerTradingAlgos, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQueryCFMMCTradingAccountToken(
         CThostFtdcQueryCFMMCTradingAccountTokenField *pQueryCFMMCTradingAccountToken, CThostFtdcRspInfoField *pRspInfo,
-        int nRequestID, bool bIsLast) {}
+        int nRequestID, bool bIsLast) {
+    Respond(pQueryCFMMCTradingAccountToken, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRtnFromBankToFutureByBank(CThostFtdcRspTransferField *pRspTransfer) {}
 
@@ -638,15 +1140,23 @@ void lueing::CtpTxHandler::OnRtnChangeAccountByBank(CThostFtdcChangeAccountField
 
 void lueing::CtpTxHandler::OnRspQryClassifiedInstrument(CThostFtdcInstrumentField *pInstrument,
                                                         CThostFtdcRspInfoField *pRspInfo, int nRequestID,
-                                                        bool bIsLast) {}
+                                                        bool bIsLast) {
+    Respond(pInstrument, pRspInfo, nRequestID, bIsLast);
+}
 
 void lueing::CtpTxHandler::OnRspQryCombPromotionParam(CThostFtdcCombPromotionParamField *pCombPromotionParam,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pCombPromotionParam, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryRiskSettleInvstPosition(CThostFtdcRiskSettleInvstPositionField *pRiskSettleInvstPosition,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pRiskSettleInvstPosition, pRspInfo, nRequestID, bIsLast);
+}
 
 void
 lueing::CtpTxHandler::OnRspQryRiskSettleProductStatus(CThostFtdcRiskSettleProductStatusField *pRiskSettleProductStatus,
-                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {}
+                                                      CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast) {
+    Respond(pRiskSettleProductStatus, pRspInfo, nRequestID, bIsLast);
+}